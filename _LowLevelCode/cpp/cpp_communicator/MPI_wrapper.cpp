@@ -1,5 +1,7 @@
 #include "MPI_wrapper.h"
 #include "input_parser.h"
+#include "../serialiser/cpp_serialise.hpp"
+#include <memory>
 #include <tuple> 
 
 // static data message tag, used by MPI wrapper to distinguish data messages and process them differently.
@@ -421,14 +423,22 @@ void MPI_wrapper::labProbe(const std::vector<int32_t>& data_address, const std::
 }
 
 /* Create outputs for labReceive and return pointers to the arrays locations for copying results
-into these outputs  */
-std::tuple<char*, void*, int32_t*> create_plhs_for_labReceive(mxArray* plhs[], int nlhs, int data_size, int cell_size) {
+into these outputs. If the message is deserialised, the message contents are set by deserialise_received
+and only an empty message gets its (empty) output here */
+std::tuple<char*, void*, int32_t*> create_plhs_for_labReceive(mxArray* plhs[], int nlhs, int data_size, int cell_size,
+    bool deserialise_message = false) {
 
 
-    plhs[(int)labReceive_Out::mess_contents] = mxCreateNumericMatrix(1, data_size, mxUINT8_CLASS, mxREAL);
+    char* pBuff(nullptr);
+    if (!deserialise_message) {
+        plhs[(int)labReceive_Out::mess_contents] = mxCreateNumericMatrix(1, data_size, mxUINT8_CLASS, mxREAL);
+        pBuff = reinterpret_cast<char*>(mxGetData(plhs[(int)labReceive_Out::mess_contents]));
+    }
+    else if (data_size == 0) {
+        plhs[(int)labReceive_Out::mess_contents] = mxCreateNumericMatrix(0, 0, mxDOUBLE_CLASS, mxREAL);
+    }
     plhs[(int)labReceive_Out::data_celarray] = mxCreateNumericMatrix(1, cell_size, mxCELL_CLASS, mxREAL);
 
-    char* pBuff = reinterpret_cast<char*>(mxGetData(plhs[(int)labReceive_Out::mess_contents]));
     void* pCell = reinterpret_cast<void*>(mxGetData(plhs[(int)labReceive_Out::data_celarray]));
     int32_t* pSourceAddress(nullptr);
     if (nlhs >= (int)labReceive_Out::real_source_address) {
@@ -442,6 +452,12 @@ std::tuple<char*, void*, int32_t*> create_plhs_for_labReceive(mxArray* plhs[], i
 
     return std::make_tuple(pBuff, pCell, pSourceAddress);
 }
+/* Deserialise the message straight from the buffer it has been received into and return the result
+as the message contents, so the serialised message never becomes a Matlab array */
+void deserialise_received(mxArray* plhs[], const void* pBuff, size_t message_size) {
+    size_t memPtr(0);
+    plhs[(int)labReceive_Out::mess_contents] = deserialise(reinterpret_cast<const uint8_t*>(pBuff), memPtr, message_size, 0);
+}
 
 /** receive message from another MPI worker
 Inputs:
@@ -451,14 +467,18 @@ isSynchronous   -- if true, block the program execution until requested message
                    If false and message is not present, return empty result
 nlhs            -- The number of output arguments. Should be larger or equal than
                    labReceive_Out::N_OUTPUT_Arguments -1
+deserialise_message -- if true, the message is deserialised from the buffer MPI has received it into and
+                   the deserialised message is returned instead of its serialised contents
 Output:
 mxArray* plhs[]   -- on input array of Matlab pointers to output parameters of mex routine
                      on output:
                      element labReceive_Out::mess_contents keeps pointer to received message contents
+                     (or to the deserialised message, empty if no message is received)
                      element labReceive_Out::data_celarray pointer to cellarray of pointers to large data
                      when appropriate message with tag equal data_tag is received.
 */
-void MPI_wrapper::labReceive(int source_address, int source_data_tag, bool isSynchronous, mxArray* plhs[], int nlhs) {
+void MPI_wrapper::labReceive(int source_address, int source_data_tag, bool isSynchronous, mxArray* plhs[], int nlhs,
+    bool deserialise_message) {
 
     if (source_data_tag == -1)source_data_tag = MPI_ANY_TAG;
     if (source_address == -1) { // not allowed in our framework
@@ -522,26 +542,34 @@ void MPI_wrapper::labReceive(int source_address, int source_data_tag, bool isSyn
 
         // if no message exist, return empty matrices.
         if (!pMess) {
-            create_plhs_for_labReceive(plhs, nlhs, 0, 0);
+            create_plhs_for_labReceive(plhs, nlhs, 0, 0, deserialise_message);
             return;
         }
         pMess->theRequest = (MPI_Request)1; // mark the message as received
 
         message_size = (int)pMess->mess_body.size();
-        outPtrs = create_plhs_for_labReceive(plhs, nlhs, message_size, 0);
+        outPtrs = create_plhs_for_labReceive(plhs, nlhs, message_size, 0, deserialise_message);
         char* pBuff = std::get<0>(outPtrs);
-        for (int i = 0; i < message_size; i++) {
+        for (int i = 0; pBuff && i < message_size; i++) {
             pBuff[i] = pMess->mess_body[i];
         }
         source_address = pMess->destination;
         source_data_tag = pMess->mess_tag;
+        // the message is deserialised from its body, which is moved out first if the next message replaces it
+        const std::vector<uint8_t>* pBody = &pMess->mess_body;
+        std::vector<uint8_t> received;
         // we buffer data messages in test mode, so synchronous message is the only case when this can happen
         if (!pMess->test_sync_mess_list.empty()) {
+            received.swap(pMess->mess_body);
+            pBody = &received;
             auto nextMess = std::move(pMess->test_sync_mess_list.front());
             pMess->test_sync_mess_list.pop_front();
             nextMess.test_sync_mess_list.swap(pMess->test_sync_mess_list);
             SyncMessHolder[source_address] = std::move(nextMess);
         }
+        if (deserialise_message) {
+            deserialise_received(plhs, pBody->data(), pBody->size());
+        }
     }
     else {  // real receive
         MPI_Status status;
@@ -552,7 +580,7 @@ void MPI_wrapper::labReceive(int source_address, int source_data_tag, bool isSyn
             int mess_exist;
             MPI_Iprobe(source_address, source_data_tag, MPI_COMM_WORLD, &mess_exist, &status);
             if (!mess_exist) {
-                create_plhs_for_labReceive(plhs, nlhs, 0, 0);
+                create_plhs_for_labReceive(plhs, nlhs, 0, 0, deserialise_message);
                 return;
             }
 
@@ -561,12 +589,21 @@ void MPI_wrapper::labReceive(int source_address, int source_data_tag, bool isSyn
         source_data_tag = status.MPI_TAG;
         MPI_Get_count(&status, MPI_CHAR, &message_size);
         if (isSynchronous || (source_data_tag == MPI_ANY_TAG)) {
-            outPtrs = create_plhs_for_labReceive(plhs, nlhs, message_size, 0);
+            outPtrs = create_plhs_for_labReceive(plhs, nlhs, message_size, 0, deserialise_message);
 
             char* pBuff = std::get<0>(outPtrs);
+            // a message to deserialise is received into a plain (not zero-filled) buffer instead of the Matlab array
+            std::unique_ptr<char[]> Buf;
+            if (deserialise_message) {
+                Buf.reset(new char[message_size]);
+                pBuff = Buf.get();
+            }
             auto err = MPI_Recv(pBuff, message_size, MPI_CHAR, source_address, source_data_tag, MPI_COMM_WORLD, &status);
             if (err != MPI_SUCCESS)throw_error("MPI_MEX_COMMUNICATOR:runtime_error",
                 "Error receiving message");
+            if (deserialise_message) {
+                deserialise_received(plhs, pBuff, message_size);
+            }
         }
         else { // receive all subsequent messages of the same kind
             std::vector<char> Buf(message_size);
@@ -585,10 +622,15 @@ void MPI_wrapper::labReceive(int source_address, int source_data_tag, bool isSyn
                     "Error receiving message");
                 MPI_Iprobe(source_address, source_data_tag, MPI_COMM_WORLD, &mess_exist, &status);
             }
-            outPtrs = create_plhs_for_labReceive(plhs, nlhs, message_size, 0);
+            outPtrs = create_plhs_for_labReceive(plhs, nlhs, message_size, 0, deserialise_message);
             char* pOut = std::get<0>(outPtrs);
-            for (size_t i = 0; i < message_size; i++)
-                pOut[i] = Buf[i];
+            if (deserialise_message) {
+                deserialise_received(plhs, &Buf[0], message_size);
+            }
+            else {
+                for (size_t i = 0; i < message_size; i++)
+                    pOut[i] = Buf[i];
+            }
         }
     }
     // return information about real data source, if requested
@@ -62,9 +62,12 @@ Inputs:
   4  -- tag -- the message tag (id) to receive (-1 -- any tag)
   5  -- is_synchronous -- should message be received synchronously (blocking operation until received) or
         asynchronously (return nothing if no message present).
+  6  -- deserialise -- optional. If true, the message is deserialised straight from the buffer it is received
+        into and output 2 is the deserialised message (empty if no message present), so the serialised message
+        is never copied into a Matlab array.
 Outputs:
   1 -- pointer to  new the MPI framework, performing asynchronous operation
-  2 -- pointer to Matlab array, containing serialized message body
+  2 -- pointer to Matlab array, containing serialized message body (or the deserialised message)
   3 -- optional (for synchronous messages) -- the pointer to Matlab cellarray containing large data -- not yet implemented
   4 -- optional -- pointer to the 2-element array containing real source address and source tag for the message, been received
 
@@ -160,7 +163,8 @@ void mexFunction(int nlhs, mxArray* plhs[], int nrhs, const mxArray* prhs[])
         break;
     }
     case(labReceive): {
-        pCommunicatorHolder->class_ptr->labReceive(data_addresses[0], data_tag[0], is_synchronous, plhs, nlhs);
+        pCommunicatorHolder->class_ptr->labReceive(data_addresses[0], data_tag[0], is_synchronous, plhs, nlhs,
+            InitPar.deserialise_message);
         break;
     }
     case(labProbe): {
@@ -176,9 +176,9 @@ class_handle<MPI_wrapper>* parse_inputs(int nlhs, int nrhs, const mxArray* prhs[
     retrieve_string(prhs[0], mex_mode, "MPI mode description");
 
     if (mex_mode.compare("labReceive") == 0) {
-        if (nrhs < (int)ReceiveInputs::N_INPUT_Arguments) {
+        if (nrhs < (int)ReceiveInputs::N_INPUT_Arguments - 1) {
             std::stringstream err;
-            err << " labReceive needs " << (int)ReceiveInputs::N_INPUT_Arguments <<
+            err << " labReceive needs " << (int)ReceiveInputs::N_INPUT_Arguments - 1 << " or " << (int)ReceiveInputs::N_INPUT_Arguments <<
                 " inputs but got " << nrhs << " input parameters\n";
             throw_error("MPI_MEX_COMMUNICATOR:invalid_argument", err.str().c_str());
         }
@@ -191,6 +191,10 @@ class_handle<MPI_wrapper>* parse_inputs(int nlhs, int nrhs, const mxArray* prhs[
         data_tag[0] = (int32_t)retrieve_value<mxInt32>("labReceive: source tag", prhs[(int)ReceiveInputs::tag]);
         // if the transfer is synchroneous or not
         is_synchronous = (bool)retrieve_value<mxUint8>("labReceive: is synchronous", prhs[(int)ReceiveInputs::is_synchronous]);
+        // if the message should be deserialised from the receive buffer
+        if (nrhs > (int)ReceiveInputs::deserialise) {
+            AddPar.deserialise_message = (bool)retrieve_value<mxUint8>("labReceive: deserialise", prhs[(int)ReceiveInputs::deserialise]);
+        }
     }
     else if (mex_mode.compare("labSend") == 0) {
         if (nrhs < (int)SendInputs::N_INPUT_Arguments - 1) {
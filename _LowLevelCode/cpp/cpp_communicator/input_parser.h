@@ -55,6 +55,7 @@ enum class ReceiveInputs : int { // all input arguments for receive procedure
     source_id,
     tag,
     is_synchronous,
+    deserialise, // optional -- return the deserialised message instead of its serialised contents
     N_INPUT_Arguments
 };
 
@@ -69,7 +70,7 @@ enum class CloseOrInfoInputs : int { // all input arguments for close IO procedu
 //--------------   Outputs:
 enum class labReceive_Out :int { // output arguments for labReceive procedure
     comm_ptr,   // the pointer to class responsible for MPI communications
-    mess_contents, //the pointer to the array of serialized message contents
+    mess_contents, //the pointer to the array of serialized message contents or to the deserialised message
     data_celarray, // the pointer to the cellarray with the large data.
     real_source_address, // optional pointer to the array with real source address and source tag received
 
@@ -100,8 +101,10 @@ struct InitParamHolder {
     int interrupt_tag;    // the tag of an interrupt message, to process intermittently with any other type of messages.
     int32_t debug_frmwk_param[2] = { 0,1 }; // in debug mode, this array contains fake labIndex and numLabs, 
                               // used for testing framework in serial mode.
+    bool deserialise_message; // labReceive returns the deserialised message rather than its serialised contents
     InitParamHolder() :
-        is_tested(false), async_queue_length(10), data_message_tag(8), interrupt_tag(100)
+        is_tested(false), async_queue_length(10), data_message_tag(8), interrupt_tag(100),
+        deserialise_message(false)
     {}
 };
 
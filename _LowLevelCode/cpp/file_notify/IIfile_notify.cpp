@@ -0,0 +1,145 @@
+#include "file_notify.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/vfs.h>
+#include <unistd.h>
+#endif
+
+namespace {
+/* the folder the file is in */
+std::string folder_of(std::string const &file_name)
+{
+    const size_t pos = file_name.find_last_of("/\\");
+    if(pos==std::string::npos)return ".";
+    if(pos==0)return file_name.substr(0,1);
+    return file_name.substr(0,pos);
+}
+
+#ifdef __linux__
+/*!
+*   inotify watch of a folder for the files written or moved into it and for the removal of the folder
+*/
+class folder_watch{
+public:
+    explicit folder_watch(std::string const &folder):fd(-1){
+        if(is_network_folder(folder))return;
+        fd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+        if(fd<0)return;
+        if(inotify_add_watch(fd,folder.c_str(),IN_CLOSE_WRITE|IN_CREATE|IN_MOVED_TO|IN_DELETE_SELF|IN_MOVE_SELF)<0){
+            close(fd);
+            fd = -1;
+        }
+    }
+    ~folder_watch(){
+        if(fd>=0)close(fd);
+    }
+    bool active()const{return fd>=0;}
+    /* wait for the events for at most timeout seconds; false if the folder has been removed or moved */
+    bool wait(double timeout){
+        pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        const int ms = static_cast<int>(std::min(std::ceil(timeout*1000.),2147483647.));
+        int rc = poll(&pfd,1,ms);
+        if(rc<0&&errno==EINTR)return true;
+        if(rc<=0)return rc==0;
+        // drain the events; the name of the file does not matter as the sentinel is checked anyway
+        alignas(inotify_event) char buf[4096];
+        bool folder_present(true);
+        ssize_t len;
+        while((len=read(fd,buf,sizeof(buf)))>0){
+            for(char *ptr=buf;ptr<buf+len;){
+                const inotify_event *event = reinterpret_cast<const inotify_event *>(ptr);
+                if(event->mask&(IN_DELETE_SELF|IN_MOVE_SELF|IN_IGNORED))folder_present = false;
+                ptr += sizeof(inotify_event)+event->len;
+            }
+        }
+        return folder_present;
+    }
+private:
+    int fd;
+    folder_watch(folder_watch const &);
+    folder_watch &operator=(folder_watch const &);
+};
+#endif
+} // namespace
+
+long long file_sequence(std::string const &file_name)
+{
+    std::FILE *fh = std::fopen(file_name.c_str(),"rb");
+    if(!fh)return -1;
+    long long seq(-1);
+    if(std::fseek(fh,0,SEEK_END)==0)seq = static_cast<long long>(std::ftell(fh));
+    std::fclose(fh);
+    return seq;
+}
+
+bool is_network_folder(std::string const &folder)
+{
+#ifdef __linux__
+    struct statfs info;
+    if(statfs(folder.c_str(),&info)!=0)return false;
+    switch(static_cast<unsigned int>(info.f_type)){
+    case 0x6969u:     // NFS
+    case 0x517Bu:     // SMB
+    case 0xFF534D42u: // CIFS
+    case 0xFE534D42u: // SMB2
+    case 0x5346414Fu: // AFS
+    case 0x73757245u: // CODA
+    case 0x0BD00BD0u: // Lustre
+    case 0x47504653u: // GPFS
+    case 0x00C36400u: // CEPH
+    case 0x19830326u: // BeeGFS
+    case 0xAAD7AAEAu: // PanFS
+    case 0x01021997u: // 9P
+    case 0x65735546u: // FUSE, e.g. sshfs
+        return true;
+    default:
+        return false;
+    }
+#else
+    (void)folder;
+    return true;
+#endif
+}
+
+long long wait_for_change(std::string const &file_name,long long last_seq,double timeout,
+                          double poll_interval,bool *notified)
+{
+    typedef std::chrono::steady_clock clock;
+    typedef std::chrono::duration<double> seconds;
+    const clock::time_point deadline = clock::now()+
+        std::chrono::duration_cast<clock::duration>(seconds(timeout>0 ? timeout:0));
+    if(!(poll_interval>0))poll_interval = 0.1;
+    if(notified)*notified = false;
+#ifdef __linux__
+    // the watch is set before the sequence is checked, so a change made in between is not missed
+    folder_watch watch(folder_of(file_name));
+    if(notified)*notified = watch.active();
+#endif
+    long long seq = file_sequence(file_name);
+    while(seq==last_seq){
+        const clock::time_point now = clock::now();
+        if(now>=deadline)break;
+        const double left = std::chrono::duration_cast<seconds>(deadline-now).count();
+#ifdef __linux__
+        if(watch.active()){
+            const bool folder_present = watch.wait(left);
+            seq = file_sequence(file_name);
+            if(!folder_present)break;
+            continue;
+        }
+#endif
+        std::this_thread::sleep_for(seconds(std::min(left,poll_interval)));
+        seq = file_sequence(file_name);
+    }
+    return seq;
+}
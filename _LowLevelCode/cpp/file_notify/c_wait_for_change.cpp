@@ -0,0 +1,107 @@
+// c_wait_for_change.cpp : Defines the exported functions for the DLL application.
+//
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mex.h>
+#include "file_notify.h"
+#include "../utility/version.h"
+/*! \file c_wait_for_change.cpp
+*
+*  \brief     [seq,notified] = c_wait_for_change(file_name,last_seq,timeout,[poll_interval]) waits until
+*             the sequence (size) of a sentinel file differs from the sequence seen last
+*
+* usage:
+*\code
+* [seq,notified] = c_wait_for_change(file_name,last_seq,timeout,[poll_interval])
+*
+* input arguments:
+*	file_name     -- the name of the sentinel file, which writers append a byte to on every event
+*	last_seq      -- the sequence of the file seen last: its size or -1 if the file did not exist
+*	timeout       -- the longest time to wait, in seconds
+*	poll_interval -- optional time between the checks of the file where the kernel does not notify
+*	                 about its changes (0.1 sec by default)
+*
+* output parameters:
+*	seq      -- the sequence of the file on return, equal to last_seq on timeout
+*	notified -- true if the folder was watched with inotify and false if the file was polled
+*
+* The call also returns when the folder of the file is removed.
+*/
+
+enum inputs{
+    iFileName,
+    iLastSeq,
+    iTimeout,
+    iNumInputs
+};
+enum outputs{
+    iSeq,
+    iNotified,
+    iNumOutputs
+};
+
+/*! get the string from Matlab; false if the array is not a row string */
+static bool
+get_mx_string(const mxArray *pString,std::string &value)
+{
+    if(!mxIsChar(pString)||mxGetM(pString)!=1)return false;
+    std::vector<char> Buf(mxGetN(pString)+1);
+    if(mxGetString(pString,&Buf[0],Buf.size()))return false;
+    value.assign(&Buf[0]);
+    return true;
+}
+/*! check the argument is a real double scalar */
+static bool
+is_real_scalar(const mxArray *pArray)
+{
+    return mxIsDouble(pArray)&&!mxIsComplex(pArray)&&!mxIsSparse(pArray)&&mxGetNumberOfElements(pArray)==1;
+}
+
+/*! \brief interface function between the code and Matlab */
+void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
+  std::stringstream   buf;  // buffer to report errors;
+  std::string file_name;
+  double poll_interval(0.1);
+  long long seq(-1);
+  bool notified(false);
+
+  if (nrhs == 0 && (nlhs == 0 || nlhs == 1)) {
+        plhs[0] = mxCreateString(Herbert::VERSION);
+        return;
+  }
+  if(nrhs<iNumInputs||nrhs>iNumInputs+1){
+      buf<<"function needs "<<iNumInputs<<" or "<<iNumInputs+1<<" input arguments but got "<<nrhs<<std::endl; goto error;
+  }
+  if(nlhs>iNumOutputs){
+      buf<<"function returns at most "<<iNumOutputs<<" output arguments but "<<nlhs<<" requested\n"; goto error;
+  }
+  if(!get_mx_string(prhs[iFileName],file_name)||file_name.empty()){
+      buf<<"first parameter has to be the name of the sentinel file\n";                  goto error;
+  }
+  if(!is_real_scalar(prhs[iLastSeq])||mxGetScalar(prhs[iLastSeq])<-1){
+      buf<<"second parameter has to be the last sequence of the file, a number not smaller than -1\n"; goto error;
+  }
+  if(!is_real_scalar(prhs[iTimeout])||!(mxGetScalar(prhs[iTimeout])>=0)){
+      buf<<"third parameter has to be the non-negative time to wait, in seconds\n";       goto error;
+  }
+  if(nrhs>iNumInputs){
+      if(!is_real_scalar(prhs[iNumInputs])||!(mxGetScalar(prhs[iNumInputs])>0)){
+          buf<<"fourth parameter has to be the positive interval between the checks of the file\n"; goto error;
+      }
+      poll_interval = mxGetScalar(prhs[iNumInputs]);
+  }
+
+  seq = wait_for_change(file_name,static_cast<long long>(mxGetScalar(prhs[iLastSeq])),
+                        mxGetScalar(prhs[iTimeout]),poll_interval,&notified);
+  plhs[iSeq] = mxCreateDoubleScalar(static_cast<double>(seq));
+  if(nlhs>iNotified){
+      plhs[iNotified] = mxCreateLogicalScalar(notified);
+  }
+  return;
+error:
+  std::string err_msg("-->ERROR:: ");
+  err_msg.append(buf.str());
+
+  mexErrMsgTxt(err_msg.c_str());
+}
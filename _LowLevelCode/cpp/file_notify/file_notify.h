@@ -0,0 +1,32 @@
+#ifndef H_FILE_NOTIFY
+#define H_FILE_NOTIFY
+#include <string>
+
+/*!
+*   Waiting for the change of a sentinel file, which writers append a byte to every time they want to
+*   wake the readers of a folder, e.g. when a filebased message is sent. The size of the sentinel file
+*   is the sequence number of the events, so a reader has to remember the last sequence it has seen
+*   and checks one file instead of listing the folder.
+*/
+
+/* the sequence number of the sentinel file: its size in bytes or -1 if the file does not exist.
+   The file is opened to get its size, which revalidates the cached attributes of files on NFS */
+long long file_sequence(std::string const &file_name);
+
+/* true if the folder is on a network file system (NFS, SMB, Lustre, GPFS...), where the kernel does
+   not notify about the changes made by other hosts */
+bool is_network_folder(std::string const &folder);
+
+/*!
+*   Wait until the sequence of the sentinel file differs from last_seq or timeout seconds have passed
+*   and return the sequence of the file.
+*
+*   On Linux, the folder of a file on a local file system is watched with inotify, so the call returns
+*   as soon as the file is written or the folder is removed. Otherwise (other systems or network folders)
+*   the sequence is checked every poll_interval seconds.
+*   If notified is not NULL, it is set to true when the wait used the notifications of the kernel.
+*/
+long long wait_for_change(std::string const &file_name,long long last_seq,double timeout,
+                          double poll_interval,bool *notified=NULL);
+
+#endif
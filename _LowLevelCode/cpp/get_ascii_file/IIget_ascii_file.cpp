@@ -3,7 +3,14 @@
 #define _CRT_SECURE_NO_WARNINGS
 #endif
 
-#define BUF_SIZE 1024
+#include "mapped_file.h"
+#include "parse_double.h"
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
 #define SPE_DATA_BLOCK_SIZE  8   // format of the data, written in SPE files (8 columns);
 
 //
@@ -11,14 +18,40 @@
 //
 // $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
 //
-// the buffer specified here in static mainly for throwing meaningfull error messages;
-// It would be better to specify static stringstream for that but some compuilers crash on its initialisation
-// As it is here anyway, it also used as the working buffer for some functions below
-static char BUF[BUF_SIZE];
+static inline bool
+is_field_space(char symbol)
+{
+    return symbol==' '||symbol=='\t'||symbol=='\r';
+}
+/*!
+*  parse the number at the start of the field [p,end) as sscanf("%g") would: leading spaces are
+*  skipped and anything after the number is ignored. Returns false if there is no number.
+*/
+static inline bool
+parse_field(const char *p,const char *end,double &value)
+{
+    while(p<end&&is_field_space(*p))p++;
+    return parse_double(p,end,value)!=p;
+}
+/*!
+*  parse one fixed width field of SPE data block; fields which are not numbers but contain NaN
+*  are NaN, as written by some of the data reduction programs
+*/
+static inline bool
+parse_spe_field(const char *p,const char *end,double &value)
+{
+    if(p>=end)return false;
+    if(parse_field(p,end,value))return true;
+    if(std::string(p,end).find("NaN")!=std::string::npos){
+        value = std::numeric_limits<double>::quiet_NaN();
+        return true;
+    }
+    return false;
+}
 /*!
 *  function calculates number of changes from space to a symbol and vise versa. It used to identify the number of
 *  data fields in an space-separated ascii file. */
-int 
+static int
 count_changes(const char *const Buf,int buf_size)
 {
     bool is_symbol(false),is_space(true);
@@ -57,7 +90,7 @@ count_changes(const char *const Buf,int buf_size)
 /*! The function reads line from inout stream and puts it into buffer. 
 *   It behaves like std::ifstream getline but the later reads additional symbol from a row in a Unix file under windows;
 */
-int 
+static int
 get_my_line(std::ifstream &in, char buf[], int buf_size,char DELIM)
 {
     int i;
@@ -70,6 +103,16 @@ get_my_line(std::ifstream &in, char buf[], int buf_size,char DELIM)
     buf[buf_size-1]=0;
     return buf_size;
 }
+ascii_file_parser::ascii_file_parser()
+{
+    _descriptor.Type                = iNumFileTypes;
+    _descriptor.data_start_position = 0;
+    _descriptor.nData_records       = 0;
+    _descriptor.nData_blocks        = 0;
+    _descriptor.line_end            = 0x0A;
+    _buf[0]     = 0;
+    _discard[0] = 0;
+}
 /*!
  *  The function loads ASCII file header and tries to identify the type of the header.
  *  Possible types are
@@ -79,14 +122,19 @@ get_my_line(std::ifstream &in, char buf[], int buf_size,char DELIM)
  *  it also returns the FileTypeDescriptor, which identifyes the position of the data in correcponding ASCII file 
  *  plus characteristics of the data extracted from correspondent data header. 
 */
-FileTypeDescriptor 
-get_ASCII_header(std::string const &fileName, std::ifstream &data_stream)
+FileTypeDescriptor const &
+ascii_file_parser::open(std::string const &fileName)
 {
-    FileTypeDescriptor file_descriptor;
+    std::ifstream      &data_stream     = _stream;
+    FileTypeDescriptor &file_descriptor = _descriptor;
+    char               *BUF             = _buf;
     file_descriptor.Type = iNumFileTypes; // set the autotype to invalid
 
+    if(data_stream.is_open())data_stream.close();
+    data_stream.clear();
+    _fileName = fileName;
     data_stream.open(fileName.c_str(),std::ios_base::in|std::ios_base::binary);
-    if(!data_stream.is_open()){		throw(" Can not open existing input data file\n");
+    if(!data_stream.is_open()){		throw ascii_file_error(" Can not open existing input data file\n");
     }
     // let's identify the EOL symbol; As the file may have been prepared on different OS, from where you are reading it 
     // and no conversion have been performed; 
@@ -107,7 +155,7 @@ get_ASCII_header(std::string const &fileName, std::ifstream &data_stream)
     }else if(symbol==0x0A){   // unix file. 
         EOL=0x0A;
     }else{
-        throw(" Error reading the first row of the input ASCII data file, it contains unprintable characters (binary file? UNICODE?)\n");
+        throw ascii_file_error(" Error reading the first row of the input ASCII data file, it contains unprintable characters (binary file? UNICODE?)\n");
     }
 
     file_descriptor.line_end=EOL;
@@ -115,7 +163,7 @@ get_ASCII_header(std::string const &fileName, std::ifstream &data_stream)
 
 
     get_my_line(data_stream,BUF,BUF_SIZE,EOL);
-    if(!data_stream.good()){   		throw(" Error reading the first row of the input data file, It may be bigger then 1024 symbols\n");
+    if(!data_stream.good()){   		throw ascii_file_error(" Error reading the first row of the input data file, It may be bigger then 1024 symbols\n");
     }
 
     //let's find if there is one or more groups of symbols inside of the buffer;
@@ -124,14 +172,14 @@ get_ASCII_header(std::string const &fileName, std::ifstream &data_stream)
         int nDataRecords,nDataBlocks;
         int nDatas = sscanf(BUF," %d %d ",&nDataRecords,&nDataBlocks);
         if(nDatas!=2){
-            throw(" File iterpreted as SPE but does not have two numbers in the first row\n");
+            throw ascii_file_error(" File iterpreted as SPE but does not have two numbers in the first row\n");
         }else{
             file_descriptor.nData_records= nDataRecords;
             file_descriptor.nData_blocks = nDataBlocks;
         }
         file_descriptor.Type=iSPE_type;
         get_my_line(data_stream,BUF,BUF_SIZE,EOL);
-        if(BUF[0]!='#'){ 			throw(" File iterpreted as SPE does not have symbol # in the second row\n");
+        if(BUF[0]!='#'){ 			throw ascii_file_error(" File iterpreted as SPE does not have symbol # in the second row\n");
         }
         file_descriptor.data_start_position = data_stream.tellg(); // if it is SPE file then the data begin after the second line;
         }else{
@@ -150,7 +198,7 @@ get_ASCII_header(std::string const &fileName, std::ifstream &data_stream)
                 file_descriptor.Type=iPHX_type;
                 file_descriptor.nData_blocks = space_to_symbol_change;
         }else{   // something unclear or damaged
-            throw(" can not identify format of the input data file\n");
+            throw ascii_file_error(" can not identify format of the input data file\n");
         }
 
     }
@@ -161,68 +209,57 @@ get_ASCII_header(std::string const &fileName, std::ifstream &data_stream)
  *  the file should be already opened and the FILE_TYPE structure properly defined using
  *  get_ASCII_header function
 */
-void 
-load_plain(std::ifstream &stream,double *pData,FileTypeDescriptor const &FILE_TYPE)
+void
+ascii_file_parser::load_plain(double *pData)
 {
+    std::ifstream            &stream    = _stream;
+    FileTypeDescriptor const &FILE_TYPE = _descriptor;
+    char                     *BUF       = _buf;
 
-    char par_format[]=" %g %g %g %g %g";
-    char phx_format[]=" %g %g %g %g %g %g";
-    float data_buf[7];
-    char *format;
     int BlockSize;
     char EOL = FILE_TYPE.line_end;
 
     switch(FILE_TYPE.Type){
         case(iPAR_type):{
-            format = par_format;
             BlockSize=5;
             break;
                         }
         case(iPHX_type):{
-            format = phx_format;
             BlockSize=6;
             break;
                         }
         default:{
-            throw(" trying to load par or phx data but the data type is not recognized\n");
+            throw ascii_file_error(" trying to load par or phx data but the data type is not recognized\n");
         }
     }
     //Data.resize(BlockSize*FILE_TYPE.nData_records);
 
     stream.seekg(FILE_TYPE.data_start_position,std::ios_base::beg);
     if(!stream.good()){		
-        throw(" trying to load data but the data type is not recognized\n");
+        throw ascii_file_error(" trying to load data but the data type is not recognized\n");
     }
 
     int nRead_Data(0);
     for(unsigned int i=0;i<FILE_TYPE.nData_records;i++){
         stream.getline(BUF,BUF_SIZE,EOL);
         if(!stream.good()){	
-            throw(" error reading input file");
-        }
-
-        switch(FILE_TYPE.Type){
-            case(iPAR_type):{
-                nRead_Data= sscanf(BUF,format,data_buf,data_buf+1,data_buf+2,data_buf+3,data_buf+4);
-                break;
-                            }
-            case(iPHX_type):{
-                nRead_Data= sscanf(BUF,format,data_buf,data_buf+1,data_buf+2,data_buf+3,data_buf+4,data_buf+5);
-                break;
-                            }
-            default:{
-                  throw("data type has not been identified");
-            }
+            throw ascii_file_error(" error reading input file");
+        }
+
+        // space separated numbers, anything after the last one is ignored
+        const char *p   = BUF;
+        const char *end = BUF+strlen(BUF);
+        double *pRow    = pData+size_t(i)*BlockSize;
+        for(nRead_Data=0;nRead_Data<BlockSize;nRead_Data++){
+            while(p<end&&(is_field_space(*p)||*p=='\n'))p++;
+            const char *number_end = parse_double(p,end,pRow[nRead_Data]);
+            if(number_end==p)break;
+            p = number_end;
         }
         if(nRead_Data!=BlockSize){
             std::stringstream err_buf;
             err_buf<<" Error reading data at file, row "<<i+1<<" column "<<nRead_Data<<" from total "<<FILE_TYPE.nData_records<<" rows, "<<BlockSize<<" columns\n";
-
-            strcpy(BUF,err_buf.str().c_str());
-            throw(const_cast<const char *>(BUF));
-        }
-        for(int j=0;j<nRead_Data;j++){
-            pData[i*BlockSize+j]=(double)data_buf[j];
+            throw ascii_file_error(err_buf.str());
         }
 
     }
@@ -233,30 +270,28 @@ load_plain(std::ifstream &stream,double *pData,FileTypeDescriptor const &FILE_TY
  *  get_ASCII_header function
  *  tr_spaces -- number of traling spaces in a data file. 
 */
-
-bool 
-read_SPEdata_block(std::ifstream &stream,double *pBlock,size_t DataSize,size_t block_size,int spe_field_width,int tr_spaces,
-                   std::stringstream &err_message,char EOL,bool buf_empty=true)
+template<class U>
+bool
+ascii_file_parser::read_SPEdata_block(U *pBlock,size_t DataSize,size_t block_size,int spe_field_width,int tr_spaces,
+                                      std::stringstream &err_message,bool buf_empty)
 {
-    size_t i,j,nBlock_Data;
-    float data_buf;
-    char *DataStart = BUF+tr_spaces;
-    
+    std::ifstream &stream = _stream;
+    char          *BUF    = _buf;
+    const char     EOL    = _descriptor.line_end;
+    size_t i,j;
+    const char *DataStart = BUF+tr_spaces;
 
-    char format[]="%10g";    // format string to read each data in a block
     if(spe_field_width<10||spe_field_width>99){
-        sprintf(BUF," Unexpected spe field width of %d symbols has been identified; can not interpret SPE data\n",spe_field_width);
-        throw(BUF);
+        std::stringstream err;
+        err<<" Unexpected spe field width of "<<spe_field_width<<" symbols has been identified; can not interpret SPE data\n";
+        throw ascii_file_error(err.str());
     }
-	// redefine format to read data (in case it takes, say, 11 or 12 symbols)
-    sprintf(format+1,"%2d",spe_field_width);
-    format[3]='g';
 
     // spe block consists of number of rows, last row can be incomplete
     size_t nRows = DataSize/block_size; // block size -- number of data in a row;
     if(nRows*block_size!=DataSize)nRows++;
 
-    int nRead_Data(0);
+    size_t nRead_Data(0);
     for(i=0;i<nRows;i++){
         if(buf_empty){
             get_my_line(stream,BUF,BUF_SIZE,EOL);
@@ -266,26 +301,18 @@ read_SPEdata_block(std::ifstream &stream,double *pBlock,size_t DataSize,size_t b
             err_message<<" error obtaining string No "<<i+1<<" from the file\n";
             return false;
         }
+        const char *line_end = BUF+strlen(BUF);
         for(j=0;j<block_size;j++){
-//			nBlock_Data= sscanf(BUF+j*spe_data_width,%g10",&data_buf); --> C  format e.g. %g10 or %g11, the number has to correspond to  spe_data_width
-            nBlock_Data= sscanf(DataStart+j*spe_field_width,format,&data_buf);
-
-            if(nBlock_Data!=1){
-                if(nRead_Data==DataSize){
-                    return true;
-                }else{
-                    std::string field_val(DataStart+j*spe_field_width,spe_field_width);
-                    size_t pos=field_val.find("NaN");
-                    if(pos == std::string::npos){
-                        err_message<<" Error interpreting data block, row "<<i+1<<" column "<<j+1<<" from total "<<nRows<<" rows, "<<block_size<<" columns\n";
-                        return false;
-                    }else{
-                        pBlock[nRead_Data]=std::numeric_limits<double>::quiet_NaN();
-                    }
-                }
-            }else{
-                pBlock[nRead_Data]=(double)data_buf;
+            const char *field     = DataStart+j*spe_field_width;
+            const char *field_end = field+spe_field_width;
+            if(field_end>line_end)field_end=line_end;
+
+            double value;
+            if(!parse_spe_field(field,field_end,value)){
+                err_message<<" Error interpreting data block, row "<<i+1<<" column "<<j+1<<" from total "<<nRows<<" rows, "<<block_size<<" columns\n";
+                return false;
             }
+            pBlock[nRead_Data] = static_cast<U>(value);
             nRead_Data++;
             if(nRead_Data==DataSize)return true;
 
@@ -316,19 +343,20 @@ parse_spe_row(char *buf,int buf_size,int spe_block_size, int &spe_field_width, i
 
 }
 /*!
- *  function to load SPE file
- *  the file should be already opened and the FILE_TYPE structure properly defined using
- *  get_ASCII_header function
+ *  function to load the energy bin boundaries of SPE file, skipping the phi grid before them.
+ *  The file should be already opened by open. The stream is left at the first detector block
 */
-
-void load_spe(std::ifstream &stream,double *data_S,double *data_ERR,double * data_en, FileTypeDescriptor const &FILE_TYPE){
-    char BUF_RUB[BUF_SIZE];
+void
+ascii_file_parser::load_spe_energies(double *data_en){
+    std::ifstream            &stream    = _stream;
+    FileTypeDescriptor const &FILE_TYPE = _descriptor;
+    char                     *BUF       = _buf;
+    char                     *BUF_RUB   = _discard;
     std::stringstream err_message;
-    mwSize i,j;
-    bool buf_empty;
+    mwSize i;
 
     stream.seekg(FILE_TYPE.data_start_position,std::ios_base::beg);
-    if(!stream.good()){		throw(" can not rewind the file to the initial position where the data begin\n");
+    if(!stream.good()){		throw ascii_file_error(" can not rewind the file to the initial position where the data begin\n");
     }
     mwSize  NDET = FILE_TYPE.nData_records;
     mwSize  NE   = FILE_TYPE.nData_blocks;
@@ -339,8 +367,7 @@ void load_spe(std::ifstream &stream,double *data_S,double *data_ERR,double * dat
 
     // any spe data block supposetly occupy 8 columns in a block, which is specified by SPE_DATA_BLOCK_SIZE
     int trailing_spaces(0);
-    int spe_field_width(10); // format of the data, written in SPE files -- one symbol occupies 10 positions, if it changes here,
-                             // the format specified in the read_SPEdata_block (%g10) also has to change.
+    int spe_field_width(10); // format of the data, written in SPE files -- one symbol usually occupies 10 positions
     // analyse spe row to identify true field size
     parse_spe_row(BUF,BUF_SIZE,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces);
 
@@ -349,29 +376,61 @@ void load_spe(std::ifstream &stream,double *data_S,double *data_ERR,double * dat
     if(nRows*SPE_DATA_BLOCK_SIZE!=(NDET+1))nRows++;
     for(i=1;i<nRows;i++){
         get_my_line(stream,BUF,BUF_SIZE,EOL);// read and discard Phi Grid for the time being	
-        if(!stream.good()){	throw(" error skiping the Phi Grid in the input file\n");
+        if(!stream.good()){	throw ascii_file_error(" error skiping the Phi Grid in the input file\n");
         }
     }
     get_my_line(stream,BUF_RUB,BUF_SIZE,EOL);  // discard ###
 //  energy bins
-    if(!read_SPEdata_block(stream,data_en,NE+1,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces,err_message,EOL)){
+    if(!read_SPEdata_block(data_en,NE+1,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces,err_message)){
         err_message<<"          when reading the energy bins\n";
-		strcpy(BUF,err_message.str().c_str());		
-		throw(const_cast<const char *>(BUF));		
+        throw ascii_file_error(err_message.str());
     }
+}
+/*!
+ *  function to load SPE file
+ *  the file should be already opened and the FILE_TYPE structure properly defined using
+ *  get_ASCII_header function
+*/
+void
+ascii_file_parser::load_spe(double *data_S,double *data_ERR,double * data_en){
+    this->read_spe(data_S,data_ERR,data_en);
+}
+void
+ascii_file_parser::load_spe(float *data_S,float *data_ERR,double * data_en){
+    this->read_spe(data_S,data_ERR,data_en);
+}
+/*!
+ *  load SPE file into the signal and error arrays of type U
+*/
+template<class U>
+void
+ascii_file_parser::read_spe(U *data_S,U *data_ERR,double * data_en){
+    std::ifstream            &stream    = _stream;
+    FileTypeDescriptor const &FILE_TYPE = _descriptor;
+    char                     *BUF       = _buf;
+    char                     *BUF_RUB   = _discard;
+    std::stringstream err_message;
+    mwSize j;
+    bool buf_empty;
+    mwSize  NDET = FILE_TYPE.nData_records;
+    mwSize  NE   = FILE_TYPE.nData_blocks;
+    char    EOL  = FILE_TYPE.line_end;
+
+    this->load_spe_energies(data_en);
 
 // identify the block size for intensities + errors
     get_my_line(stream,BUF_RUB,BUF_SIZE,EOL);  // discard ###
     get_my_line(stream,BUF,BUF_SIZE,EOL);  // get data row;
     // analyse data row to identify true field size
+    int trailing_spaces(0);
+    int spe_field_width(10);
 	int nDataPointsInRow = SPE_DATA_BLOCK_SIZE;
 	// if there are too few energy points, then there is only one row with such many energy points and this row is short
 	if(nDataPointsInRow>NE)nDataPointsInRow=NE;
     parse_spe_row(BUF,BUF_SIZE,nDataPointsInRow,spe_field_width,trailing_spaces);
     if(spe_field_width<10||spe_field_width>99){
         err_message<<" wrong spe data field width="<<spe_field_width<<" identified when parsing first row of signal in spe file\n";
-		strcpy(BUF,err_message.str().c_str());		
-		throw(const_cast<const char *>(BUF));		
+        throw ascii_file_error(err_message.str());
     }
 
 
@@ -381,17 +440,15 @@ void load_spe(std::ifstream &stream,double *data_S,double *data_ERR,double * dat
         if(buf_empty){
             get_my_line(stream,BUF_RUB,BUF_SIZE,EOL);  // discard ###
         }
-        if(!read_SPEdata_block(stream,data_S +j*NE, NE,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces,err_message,EOL,buf_empty)){
+        if(!read_SPEdata_block(data_S +j*NE, NE,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces,err_message,buf_empty)){
             err_message<<"          when reading signal, block N: "<<j+1<<std::endl;
-			strcpy(BUF,err_message.str().c_str());		
-			throw(const_cast<const char *>(BUF));		
+            throw ascii_file_error(err_message.str());
         }
         buf_empty=true;
         get_my_line(stream,BUF_RUB,BUF_SIZE,EOL);  // discard ###
-        if(!read_SPEdata_block(stream,data_ERR+j*NE,NE,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces,err_message,EOL)){
+        if(!read_SPEdata_block(data_ERR+j*NE,NE,SPE_DATA_BLOCK_SIZE,spe_field_width,trailing_spaces,err_message)){
             err_message<<"          when reading errors, block N: "<<j+1<<std::endl;
-			strcpy(BUF,err_message.str().c_str());		
-			throw(const_cast<const char *>(BUF));		
+            throw ascii_file_error(err_message.str());
         }
 
     }
@@ -399,3 +456,479 @@ void load_spe(std::ifstream &stream,double *data_S,double *data_ERR,double * dat
 }
 
 
+
+//------------------------------------------------------------------------------------------------------------
+// Memory mapped SPE loader
+//------------------------------------------------------------------------------------------------------------
+/*! find the end of the line starting at p: the EOL symbol or the end of the data */
+static inline const char *
+find_line_end(const char *p,const char *end,char EOL)
+{
+    const char *eol = static_cast<const char *>(memchr(p,EOL,static_cast<size_t>(end-p)));
+    return eol ? eol:end;
+}
+/*! move nLines lines forward from p; returns NULL if the data end earlier */
+static inline const char *
+skip_lines(const char *p,const char *end,size_t nLines,char EOL)
+{
+    for(size_t i=0;i<nLines&&p;i++){
+        const char *eol = find_line_end(p,end,EOL);
+        p = (eol==end) ? NULL:eol+1;
+    }
+    return p;
+}
+/*!
+*  parse n values of SPE data block, starting from value first, where the block is written in rows of block_size
+*  fields starting at p. Rows before the one holding the value first are skipped.
+*  returns the position after the last row parsed or NULL and the error message if the block can not be parsed
+*/
+template<class U>
+static const char *
+parse_SPEdata_block(const char *p,const char *end,U *pBlock,size_t first,size_t n,size_t block_size,
+                    int spe_field_width,int tr_spaces,char EOL,std::string &err_message)
+{
+    size_t first_row = first/block_size;
+    size_t nRows     = (first+n)/block_size;
+    if(nRows*block_size!=first+n)nRows++;
+    p = skip_lines(p,end,first_row,EOL);
+
+    size_t nRead_Data(0);
+    for(size_t i=first_row;i<nRows;i++){
+        if(p==NULL||p>=end){
+            std::stringstream err;
+            err<<" error obtaining string No "<<i+1<<" from the file\n";
+            err_message = err.str();
+            return NULL;
+        }
+        const char *line_end = find_line_end(p,end,EOL);
+        size_t j = (i==first_row) ? first%block_size:0;
+        for(;j<block_size&&nRead_Data<n;j++,nRead_Data++){
+            const char *field     = p+tr_spaces+j*spe_field_width;
+            const char *field_end = field+spe_field_width;
+            if(field_end>line_end)field_end=line_end;
+            double value;
+            if(!parse_spe_field(field,field_end,value)){
+                std::stringstream err;
+                err<<" Error interpreting data block, row "<<i+1<<" column "<<j+1<<" from total "<<nRows<<" rows, "<<block_size<<" columns\n";
+                err_message = err.str();
+                return NULL;
+            }
+            pBlock[nRead_Data] = static_cast<U>(value);
+        }
+        p = (line_end==end) ? end:line_end+1;
+    }
+    return p;
+}
+/*! field width and leading symbols of the SPE row starting at p, as parse_spe_row */
+static void
+parse_mapped_spe_row(const char *p,const char *end,char EOL,int spe_block_size,int &spe_field_width,int &trailing_spaces)
+{
+    size_t len = static_cast<size_t>(find_line_end(p,end,EOL)-p);
+    if(len>=BUF_SIZE)len = BUF_SIZE-1;
+    char row[BUF_SIZE];
+    memcpy(row,p,len);
+    row[len]=0;
+    parse_spe_row(row,BUF_SIZE,spe_block_size,spe_field_width,trailing_spaces);
+}
+/*!
+*  positions and format of the data in a mapped SPE file
+*/
+struct spe_layout{
+    const char *en_start;          //> first row of the energy bins
+    int         en_field_width,en_trailing_spaces;
+    const char *blocks;            //> ### line before the signal of the first detector
+    int         field_width,trailing_spaces;
+    size_t      nBlockRows;        //> rows in the signal or error block of a detector
+};
+/*!
+*  identify the layout of the SPE data starting at p (FILE_TYPE.data_start_position of the mapping)
+*/
+static void
+find_spe_layout(const char *p,const char *end,FileTypeDescriptor const &FILE_TYPE,spe_layout &layout)
+{
+    if(p>=end){		throw ascii_file_error(" can not rewind the file to the initial position where the data begin\n");
+    }
+    const size_t NDET = FILE_TYPE.nData_records;
+    const size_t NE   = FILE_TYPE.nData_blocks;
+    const char   EOL  = FILE_TYPE.line_end;
+
+    // first Phi Grid line identifies the format of the energy bins
+    parse_mapped_spe_row(p,end,EOL,SPE_DATA_BLOCK_SIZE,layout.en_field_width,layout.en_trailing_spaces);
+    if(layout.en_field_width<10||layout.en_field_width>99){
+        std::stringstream err;
+        err<<" Unexpected spe field width of "<<layout.en_field_width<<" symbols has been identified; can not interpret SPE data\n";
+        throw ascii_file_error(err.str());
+    }
+
+    size_t nRows = (NDET+1)/SPE_DATA_BLOCK_SIZE;
+    if(nRows*SPE_DATA_BLOCK_SIZE!=(NDET+1))nRows++;
+    p = skip_lines(p,end,nRows+1,EOL);   // Phi Grid and ### line
+    if(!p){		throw ascii_file_error(" error skiping the Phi Grid in the input file\n");
+    }
+    layout.en_start = p;
+    size_t nEnRows = (NE+1)/SPE_DATA_BLOCK_SIZE;
+    if(nEnRows*SPE_DATA_BLOCK_SIZE!=(NE+1))nEnRows++;
+    p = skip_lines(p,end,nEnRows,EOL);
+    if(!p){
+        throw ascii_file_error(" error obtaining energy bins from the file\n          when reading the energy bins\n");
+    }
+
+    // first row of signal identifies the format of the data blocks
+    int nDataPointsInRow = SPE_DATA_BLOCK_SIZE;
+    if(static_cast<size_t>(nDataPointsInRow)>NE)nDataPointsInRow=static_cast<int>(NE);
+    const char *first_row = (p<end) ? skip_lines(p,end,1,EOL):NULL;
+    if(!first_row){
+        throw ascii_file_error(" error obtaining string No 1 from the file\n          when reading signal, block N: 1\n");
+    }
+    parse_mapped_spe_row(first_row,end,EOL,nDataPointsInRow,layout.field_width,layout.trailing_spaces);
+    if(layout.field_width<10||layout.field_width>99){
+        std::stringstream err;
+        err<<" wrong spe data field width="<<layout.field_width<<" identified when parsing first row of signal in spe file\n";
+        throw ascii_file_error(err.str());
+    }
+    layout.blocks     = p;
+    layout.nBlockRows = NE/SPE_DATA_BLOCK_SIZE;
+    if(layout.nBlockRows*SPE_DATA_BLOCK_SIZE!=NE)layout.nBlockRows++;
+}
+/*!
+*  find the first rows of signal and error blocks of the detectors [first_det,first_det+n_det).
+*
+*  SPE files are written in fixed width rows, so all detectors usually occupy the same number of bytes and
+*  the blocks are found from the length of the first one without reading the file in between. If a block
+*  is not found at the calculated position, the blocks are located by scanning the file from the first detector.
+*  A missing block gets NULL and is reported when it is parsed.
+*/
+static void
+index_spe_blocks(spe_layout const &layout,const char *end,char EOL,size_t NDET,size_t first_det,size_t n_det,
+                 std::vector<const char *> &signal_start,std::vector<const char *> &error_start)
+{
+    signal_start.assign(n_det,NULL);
+    error_start.assign(n_det,NULL);
+    const char *blocks = layout.blocks;
+    const size_t data_size = static_cast<size_t>(end-blocks);
+
+    const char *first_error = skip_lines(blocks,end,1+layout.nBlockRows,EOL);
+    const char *next_block  = skip_lines(first_error,end,1+layout.nBlockRows,EOL);
+    if(first_error&&(next_block||NDET==1)){
+        const size_t error_offset = static_cast<size_t>(first_error-blocks);
+        const size_t stride       = next_block ? static_cast<size_t>(next_block-blocks):0;
+        bool uniform(true);
+        for(size_t j=0;j<n_det&&uniform;j++){
+            const size_t offset = (first_det+j)*stride;
+            uniform = offset+error_offset<data_size;
+            if(!uniform)break;
+            const char *block = blocks+offset;
+            uniform = block[0]=='#'&&block[-1]==EOL&&block[error_offset]=='#'&&block[error_offset-1]==EOL;
+            if(uniform){
+                signal_start[j] = skip_lines(block,end,1,EOL);
+                error_start[j]  = skip_lines(block+error_offset,end,1,EOL);
+            }
+        }
+        if(uniform)return;
+    }
+
+    const char *p = blocks;
+    for(size_t j=0;j<first_det+n_det;j++){
+        const char *signal = (p<end) ? skip_lines(p,end,1,EOL):NULL;           // discard ###
+        p = skip_lines(signal,end,layout.nBlockRows,EOL);
+        const char *error  = (p&&p<end) ? skip_lines(p,end,1,EOL):NULL;        // discard ###
+        if(j>=first_det){
+            signal_start[j-first_det] = signal;
+            error_start[j-first_det]  = error;
+        }
+        if(j+1<NDET){
+            p = skip_lines(error,end,layout.nBlockRows,EOL);
+        }
+        if(!p)p = end;
+    }
+}
+/*!
+*  parse energy bins [first_en,first_en+n_en) of signal and error blocks located by index_spe_blocks
+*  into the arrays of n_en values per detector, on n_threads threads (0 -- choose by the data size).
+*  Detectors are numbered from first_det in error messages.
+*/
+template<class U>
+static void
+parse_spe_blocks(std::vector<const char *> const &signal_start,std::vector<const char *> const &error_start,
+                 const char *end,spe_layout const &layout,char EOL,size_t first_det,size_t first_en,size_t n_en,
+                 U *data_S,U *data_ERR,unsigned int n_threads)
+{
+    const size_t n_det = signal_start.size();
+    // contiguous range of detectors per thread
+    if(n_threads==0){ // small files are not worth starting threads for
+        const size_t MIN_VALUES_PER_THREAD = 1<<16;
+        size_t max_threads = 2*n_det*n_en/MIN_VALUES_PER_THREAD;
+        n_threads = std::thread::hardware_concurrency();
+        if(n_threads>max_threads)n_threads=static_cast<unsigned int>(max_threads);
+    }
+    if(n_threads>n_det)n_threads=static_cast<unsigned int>(n_det);
+    if(n_threads<1)n_threads=1;
+
+    std::vector<std::string> errors(n_threads);
+    std::vector<size_t>      failed_block(n_threads,n_det);
+    auto parse_range = [&](unsigned int thread){
+        size_t first = n_det*thread/n_threads;
+        size_t last  = n_det*(thread+1)/n_threads;
+        for(size_t j=first;j<last;j++){
+            if(!parse_SPEdata_block(signal_start[j],end,data_S+j*n_en,first_en,n_en,SPE_DATA_BLOCK_SIZE,
+                                    layout.field_width,layout.trailing_spaces,EOL,errors[thread])){
+                errors[thread] += "          when reading signal, block N: ";
+                failed_block[thread] = j;
+                return;
+            }
+            if(!parse_SPEdata_block(error_start[j],end,data_ERR+j*n_en,first_en,n_en,SPE_DATA_BLOCK_SIZE,
+                                    layout.field_width,layout.trailing_spaces,EOL,errors[thread])){
+                errors[thread] += "          when reading errors, block N: ";
+                failed_block[thread] = j;
+                return;
+            }
+        }
+    };
+    if(n_threads==1){
+        parse_range(0);
+    }else{
+        std::vector<std::thread> workers;
+        for(unsigned int thread=0;thread<n_threads;thread++){
+            workers.push_back(std::thread(parse_range,thread));
+        }
+        for(size_t i=0;i<workers.size();i++)workers[i].join();
+    }
+    // report the error in the first failed block, as the sequential loader would
+    for(unsigned int thread=0;thread<n_threads;thread++){
+        if(failed_block[thread]<n_det){
+            std::stringstream err;
+            err<<errors[thread]<<first_det+failed_block[thread]+1<<std::endl;
+            throw ascii_file_error(err.str());
+        }
+    }
+}
+/*!
+ *  function to load SPE file from memory mapping of the file
+ *  the file has to be opened by open
+ *
+ *  The signal and error blocks of every detector are located (see index_spe_blocks), then the blocks
+ *  are parsed on n_threads threads (0 -- number of hardware threads).
+ *  returns false without loading anything if the file can not be mapped into memory.
+*/
+bool
+ascii_file_parser::load_spe_mapped(double *data_S,double *data_ERR,double * data_en,unsigned int n_threads)
+{
+    return this->read_spe_range(data_S,data_ERR,data_en,0,_descriptor.nData_records,0,_descriptor.nData_blocks,n_threads);
+}
+bool
+ascii_file_parser::load_spe_mapped(float *data_S,float *data_ERR,double * data_en,unsigned int n_threads)
+{
+    return this->read_spe_range(data_S,data_ERR,data_en,0,_descriptor.nData_records,0,_descriptor.nData_blocks,n_threads);
+}
+/*!
+ *  function to load detectors [first_det,first_det+n_det) and energy bins [first_en,first_en+n_en) of SPE file
+ *  from memory mapping of the file. Only the rows holding these bins are read from the detector blocks.
+ *  data_S and data_ERR get n_en values per detector and data_en n_en+1 bin boundaries.
+ *  returns false without loading anything if the file can not be mapped into memory.
+*/
+bool
+ascii_file_parser::load_spe_range(double *data_S,double *data_ERR,double * data_en,size_t first_det,size_t n_det,
+                                  size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    return this->read_spe_range(data_S,data_ERR,data_en,first_det,n_det,first_en,n_en,n_threads);
+}
+bool
+ascii_file_parser::load_spe_range(float *data_S,float *data_ERR,double * data_en,size_t first_det,size_t n_det,
+                                  size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    return this->read_spe_range(data_S,data_ERR,data_en,first_det,n_det,first_en,n_en,n_threads);
+}
+/*!
+ *  load the ranges of SPE file into the signal and error arrays of type U
+*/
+template<class U>
+bool
+ascii_file_parser::read_spe_range(U *data_S,U *data_ERR,double * data_en,size_t first_det,size_t n_det,
+                                  size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    FileTypeDescriptor const &FILE_TYPE = _descriptor;
+    const size_t NDET = FILE_TYPE.nData_records;
+    const size_t NE   = FILE_TYPE.nData_blocks;
+    const char   EOL  = FILE_TYPE.line_end;
+    if(FILE_TYPE.Type!=iSPE_type){
+        throw ascii_file_error(" trying to load spe data but the data type is not recognized\n");
+    }
+    if(n_det==0||first_det+n_det>NDET||n_en==0||first_en+n_en>NE){
+        std::stringstream err;
+        err<<" requested detectors "<<first_det+1<<":"<<first_det+n_det<<" and energy bins "<<first_en+1<<":"<<first_en+n_en
+           <<" are outside of the file with "<<NDET<<" detectors and "<<NE<<" energy bins\n";
+        throw ascii_file_error(err.str());
+    }
+
+    mapped_file file;
+    if(!file.open(_fileName))return false;
+    const char *end = file.data()+file.size();
+
+    spe_layout layout;
+    find_spe_layout(file.data()+static_cast<size_t>(FILE_TYPE.data_start_position),end,FILE_TYPE,layout);
+    std::string err_message;
+    if(!parse_SPEdata_block(layout.en_start,end,data_en,first_en,n_en+1,SPE_DATA_BLOCK_SIZE,
+                            layout.en_field_width,layout.en_trailing_spaces,EOL,err_message)){
+        throw ascii_file_error(err_message+"          when reading the energy bins\n");
+    }
+
+    std::vector<const char *> signal_start,error_start;
+    index_spe_blocks(layout,end,EOL,NDET,first_det,n_det,signal_start,error_start);
+    parse_spe_blocks(signal_start,error_start,end,layout,EOL,first_det,first_en,n_en,data_S,data_ERR,n_threads);
+    return true;
+}
+/*!
+ *  load the opened file into the arrays get_ascii_file returns for its type
+*/
+void
+ascii_file_parser::load(double *const data[],unsigned int n_threads)
+{
+    ascii_output out;
+    for(int i=0;i<3;i++)out.data[i] = data[i];
+    this->load(out,n_threads);
+}
+/*!
+ *  load the opened file into the arrays get_ascii_file returns for its type, the signal and error of SPE file
+ *  into the single precision arrays, if they are given
+*/
+void
+ascii_file_parser::load(ascii_output const &out,unsigned int n_threads)
+{
+    switch(_descriptor.Type){
+        case(iPAR_type):
+        case(iPHX_type):{
+            this->load_plain(out.data[0]);
+            break;
+                        }
+        case(iSPE_type):{
+            if(out.single[0]){
+                if(!this->load_spe_mapped(out.single[0],out.single[1],out.data[2],n_threads)){ // file can not be mapped into memory
+                    this->load_spe(out.single[0],out.single[1],out.data[2]);
+                }
+            }else if(!this->load_spe_mapped(out.data[0],out.data[1],out.data[2],n_threads)){
+                this->load_spe(out.data[0],out.data[1],out.data[2]);
+            }
+            break;
+                        }
+        default:{
+            throw ascii_file_error(" trying to load data but the data type is not recognized\n");
+        }
+    }
+}
+
+int
+ascii_num_arrays(fileTypes type)
+{
+    return (type==iSPE_type||type==iMAP_type) ? 3:1;
+}
+
+size_t
+ascii_array_size(FileTypeDescriptor const &FILE_TYPE,int array_num)
+{
+    switch(FILE_TYPE.Type){
+        case(iPAR_type): return 5*FILE_TYPE.nData_records;
+        case(iPHX_type): return 6*FILE_TYPE.nData_records;
+        case(iSPE_type):{
+            if(array_num==2)return FILE_TYPE.nData_blocks+1;
+            return FILE_TYPE.nData_blocks*FILE_TYPE.nData_records;
+        }
+        case(iMAP_type): return array_num==1 ? FILE_TYPE.nData_blocks:FILE_TYPE.nData_records;
+        case(iMSK_type): return FILE_TYPE.nData_records;
+        default: return 0;
+    }
+}
+//------------------------------------------------------------------------------------------------------------
+// Loading of several files
+//------------------------------------------------------------------------------------------------------------
+/*!
+ *  run load_file(parser,i,spe_threads) for the files i=0..nFiles-1 on a pool of n_threads threads (0 -- number
+ *  of hardware threads), each taking the next file from the list when it has finished the previous one.
+ *  Each thread has its own parser. spe_threads is the number of threads to parse SPE blocks of a file with.
+*/
+template<class Loader>
+static void
+run_file_pool(size_t nFiles,unsigned int n_threads,Loader const &load_file)
+{
+    if(n_threads==0)n_threads = std::thread::hardware_concurrency();
+    if(n_threads>nFiles)n_threads = static_cast<unsigned int>(nFiles);
+    if(n_threads<1)n_threads = 1;
+    // the pool is busy with the other files, so SPE blocks of a file are not parsed in parallel
+    const unsigned int spe_threads = n_threads>1 ? 1:0;
+
+    std::atomic<size_t> next_file(0);
+    auto worker = [&](){
+        ascii_file_parser parser;
+        for(size_t i=next_file++;i<nFiles;i=next_file++){
+            load_file(parser,i,spe_threads);
+            parser.close();
+        }
+    };
+    if(n_threads==1){
+        worker();
+    }else{
+        std::vector<std::thread> workers;
+        for(unsigned int thread=0;thread<n_threads;thread++){
+            workers.push_back(std::thread(worker));
+        }
+        for(size_t i=0;i<workers.size();i++)workers[i].join();
+    }
+}
+/*!
+ *  load the files on a pool of n_threads threads (see run_file_pool).
+ *  A file which can not be loaded has its error set and the others are still loaded.
+ *  If header_only is true, only the file descriptors and the energy bins of SPE files are loaded.
+*/
+std::vector<ascii_file_data>
+load_ascii_files(std::vector<std::string> const &fileNames,unsigned int n_threads,bool header_only)
+{
+    std::vector<ascii_file_data> files(fileNames.size());
+    run_file_pool(files.size(),n_threads,[&](ascii_file_parser &parser,size_t i,unsigned int spe_threads){
+        ascii_file_data &file = files[i];
+        file.fileName = fileNames[i];
+        try{
+            file.descriptor = parser.open(fileNames[i]);
+            if(header_only){
+                if(file.descriptor.Type==iSPE_type){
+                    file.data[2].resize(ascii_array_size(file.descriptor,2));
+                    parser.load_spe_energies(file.data[2].data());
+                }
+                return;
+            }
+            double *data[3];
+            for(int j=0;j<ascii_num_arrays(file.descriptor.Type);j++){
+                file.data[j].resize(ascii_array_size(file.descriptor,j));
+                data[j] = file.data[j].data();
+            }
+            parser.load(data,spe_threads);
+        }catch(const std::exception &err){
+            for(int j=0;j<3;j++)std::vector<double>().swap(file.data[j]);
+            file.error = err.what();
+        }
+    });
+    return files;
+}
+/*!
+ *  load the files on a pool of n_threads threads (see run_file_pool) straight into the arrays out allocated
+ *  by the caller for the descriptors the files had when they were opened before.
+ *  A file which can not be loaded, or whose header has changed since, has its error set and the others are
+ *  still loaded.
+*/
+std::vector<std::string>
+load_ascii_files(std::vector<std::string> const &fileNames,std::vector<FileTypeDescriptor> const &descriptors,
+                 std::vector<ascii_output> const &out,unsigned int n_threads)
+{
+    std::vector<std::string> errors(fileNames.size());
+    run_file_pool(fileNames.size(),n_threads,[&](ascii_file_parser &parser,size_t i,unsigned int spe_threads){
+        try{
+            FileTypeDescriptor const &FILE_TYPE = parser.open(fileNames[i]);
+            if(FILE_TYPE.Type!=descriptors[i].Type||FILE_TYPE.nData_records!=descriptors[i].nData_records||
+               FILE_TYPE.nData_blocks!=descriptors[i].nData_blocks){
+                throw ascii_file_error(" the header of the file has changed while the file was loaded\n");
+            }
+            parser.load(out[i],spe_threads);
+        }catch(const std::exception &err){
+            errors[i] = err.what();
+        }
+    });
+    return errors;
+}
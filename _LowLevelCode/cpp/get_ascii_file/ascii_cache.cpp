@@ -0,0 +1,216 @@
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "ascii_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+using namespace ascii_cache_detail;
+
+static const char CACHE_MAGIC[8] = {'H','E','R','B','A','S','C','C'};
+
+/*!
+ *  FNV-1a hash of a block of bytes, continuing from the hash value provided
+*/
+static uint64_t
+fnv1a(const char *p,size_t n,uint64_t hash)
+{
+    for(size_t i=0;i<n;i++){
+        hash ^= static_cast<unsigned char>(p[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/*!
+ *  modification time of the file in nanoseconds where the file system keeps them, so a file
+ *  rewritten within the same second is identified by its time too
+*/
+static int64_t
+mtime_ns(struct stat const &fileInfo)
+{
+#if defined(__APPLE__)
+    return static_cast<int64_t>(fileInfo.st_mtimespec.tv_sec)*1000000000+fileInfo.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    return static_cast<int64_t>(fileInfo.st_mtim.tv_sec)*1000000000+fileInfo.st_mtim.tv_nsec;
+#else
+    return static_cast<int64_t>(fileInfo.st_mtime)*1000000000;
+#endif
+}
+/*!
+ *  hash n bytes of the file from position pos, continuing from the hash value provided
+*/
+static bool
+hash_file_block(std::ifstream &in,uint64_t pos,size_t n,std::vector<char> &block,uint64_t &hash)
+{
+    in.seekg(static_cast<std::streamoff>(pos),std::ios_base::beg);
+    in.read(&block[0],n);
+    if(static_cast<size_t>(in.gcount())!=n)return false;
+    hash = fnv1a(&block[0],n,hash);
+    return true;
+}
+
+bool
+get_source_signature(std::string const &fileName,source_signature &signature)
+{
+    struct stat fileInfo;
+    if(stat(fileName.c_str(),&fileInfo)!=0)return false;
+    signature.size  = static_cast<uint64_t>(fileInfo.st_size);
+    signature.mtime = mtime_ns(fileInfo);
+
+    // the ends of the file hold the dimensions and the last data, which change with the contents
+    std::ifstream in(fileName.c_str(),std::ios_base::in|std::ios_base::binary);
+    if(!in.is_open())return false;
+    std::vector<char> block(CACHE_HASH_SPAN);
+    uint64_t hash = 14695981039346656037ULL;
+
+    const uint64_t head = std::min<uint64_t>(signature.size,CACHE_HASH_SPAN);
+    if(!hash_file_block(in,0,static_cast<size_t>(head),block,hash))return false;
+    if(signature.size<=CACHE_HASH_SPAN){
+        signature.hash = hash;
+        return true;
+    }
+    const uint64_t tail = std::min<uint64_t>(signature.size-CACHE_HASH_SPAN,CACHE_HASH_SPAN);
+
+    // the data between the ends: all of them in smaller files, blocks spread evenly over larger ones
+    const uint64_t middle_start = head;
+    const uint64_t middle_size  = signature.size-head-tail;
+    uint64_t n_samples = (middle_size+CACHE_SAMPLE_SPAN-1)/CACHE_SAMPLE_SPAN;
+    uint64_t stride    = CACHE_SAMPLE_SPAN;
+    if(n_samples>CACHE_HASH_SAMPLES){
+        n_samples = CACHE_HASH_SAMPLES;
+        stride    = middle_size/CACHE_HASH_SAMPLES;
+    }
+    for(uint64_t k=0;k<n_samples;k++){
+        const uint64_t pos = middle_start+k*stride;
+        const size_t   n   = static_cast<size_t>(std::min<uint64_t>(CACHE_SAMPLE_SPAN,middle_start+middle_size-pos));
+        if(!hash_file_block(in,pos,n,block,hash))return false;
+    }
+
+    if(!hash_file_block(in,signature.size-tail,static_cast<size_t>(tail),block,hash))return false;
+    signature.hash = hash;
+    return true;
+}
+
+std::string
+cache_file_name(std::string const &fileName)
+{
+    return fileName+CACHE_EXTENSION;
+}
+
+/*!
+ *  offset of the cached array array_num from the beginning of the cache file
+*/
+static size_t
+array_offset(FileTypeDescriptor const &FILE_TYPE,int array_num)
+{
+    size_t offset = sizeof(cache_header);
+    for(int i=0;i<array_num;i++){
+        offset += ascii_array_size(FILE_TYPE,i)*sizeof(double);
+    }
+    return offset;
+}
+
+ascii_cache::ascii_cache():_source_valid(false)
+{
+    _descriptor.Type                = iNumFileTypes;
+    _descriptor.data_start_position = 0;
+    _descriptor.nData_records       = 0;
+    _descriptor.nData_blocks        = 0;
+    _descriptor.line_end            = '\n';
+}
+
+bool
+ascii_cache::open(std::string const &fileName)
+{
+    this->close();
+    _fileName     = fileName;
+    _source_valid = get_source_signature(fileName,_source);
+    if(!_source_valid)return false;
+    if(!_cache.open(cache_file_name(fileName)))return false;
+
+    cache_header header;
+    if(_cache.size()<sizeof(header)){
+        this->close();
+        return false;
+    }
+    memcpy(&header,_cache.data(),sizeof(header));
+    if(memcmp(header.magic,CACHE_MAGIC,sizeof(CACHE_MAGIC))!=0||header.version!=CACHE_VERSION||
+       header.type>=iNumFileTypes||
+       header.source_size!=_source.size||header.source_mtime!=_source.mtime||header.source_hash!=_source.hash){
+        this->close();
+        return false;
+    }
+    _descriptor.Type          = static_cast<fileTypes>(header.type);
+    _descriptor.nData_records = static_cast<size_t>(header.nData_records);
+    _descriptor.nData_blocks  = static_cast<size_t>(header.nData_blocks);
+    // a cache truncated by an interrupted write
+    if(_cache.size()!=array_offset(_descriptor,ascii_num_arrays(_descriptor.Type))){
+        this->close();
+        return false;
+    }
+    return true;
+}
+
+void
+ascii_cache::read(int array_num,double *pData)const
+{
+    memcpy(pData,_cache.data()+array_offset(_descriptor,array_num),
+           ascii_array_size(_descriptor,array_num)*sizeof(double));
+}
+
+const double *
+ascii_cache::array(int array_num)const
+{
+    return reinterpret_cast<const double *>(_cache.data()+array_offset(_descriptor,array_num));
+}
+
+bool
+ascii_cache::write(FileTypeDescriptor const &FILE_TYPE,const double *const data[])const
+{
+    if(!_source_valid)return false;
+
+    cache_header header;
+    memset(&header,0,sizeof(header));
+    memcpy(header.magic,CACHE_MAGIC,sizeof(CACHE_MAGIC));
+    header.version       = CACHE_VERSION;
+    header.type          = static_cast<uint32_t>(FILE_TYPE.Type);
+    header.source_size   = _source.size;
+    header.source_mtime  = _source.mtime;
+    header.source_hash   = _source.hash;
+    header.nData_records = FILE_TYPE.nData_records;
+    header.nData_blocks  = FILE_TYPE.nData_blocks;
+
+    // write a private file and rename it, so other sessions never map a partially written cache
+    const std::string cacheName = cache_file_name(_fileName);
+    std::stringstream tmpName;
+    tmpName<<cacheName<<'.'<<std::hash<std::thread::id>()(std::this_thread::get_id())
+           <<'_'<<std::chrono::steady_clock::now().time_since_epoch().count()<<".tmp";
+    {
+        std::ofstream out(tmpName.str().c_str(),std::ios_base::out|std::ios_base::binary|std::ios_base::trunc);
+        if(!out.is_open())return false;
+        out.write(reinterpret_cast<const char *>(&header),sizeof(header));
+        for(int i=0;i<ascii_num_arrays(FILE_TYPE.Type);i++){
+            out.write(reinterpret_cast<const char *>(data[i]),
+                      static_cast<std::streamsize>(ascii_array_size(FILE_TYPE,i)*sizeof(double)));
+        }
+        out.close();
+        if(out.fail()){
+            std::remove(tmpName.str().c_str());
+            return false;
+        }
+    }
+#ifdef _WIN32
+    std::remove(cacheName.c_str()); // rename does not replace existing files on Windows
+#endif
+    if(std::rename(tmpName.str().c_str(),cacheName.c_str())!=0){
+        std::remove(tmpName.str().c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+#ifndef H_ASCII_CACHE
+#define H_ASCII_CACHE
+#include <cstdint>
+#include <string>
+#include "get_ascii_file.h"
+#include "mapped_file.h"
+/*!
+*   Binary cache of parsed PAR, PHX and SPE files.
+*
+*   The cache is a sidecar file next to the ASCII file (fileName+CACHE_EXTENSION), which holds
+*   a 64 byte header followed by the arrays returned by get_ascii_file, as raw native doubles
+*   in their Matlab order (par(5,ndet); phx(6,ndet); S(ne,ndet), ERR(ne,ndet), en(ne+1)).
+*
+*   The header records the size and modification time (in nanoseconds, where the file system
+*   keeps them) of the ASCII file and a hash of its contents. The hash covers the first and last
+*   CACHE_HASH_SPAN bytes and the data between them, all of it in files up to about 1.1MB and
+*   CACHE_HASH_SAMPLES blocks of CACHE_SAMPLE_SPAN bytes spread evenly over larger files.
+*   The cache is used only while all three match the file, so it is rebuilt after the ASCII file
+*   has been changed or replaced. An edit of a large file falling between the sampled blocks,
+*   which keeps the size of the file and its modification time, is not detected.
+*/
+namespace ascii_cache_detail{
+    struct cache_header{
+        char     magic[8];
+        uint32_t version;
+        uint32_t type;           //> fileTypes value of the cached file
+        uint64_t source_size;
+        int64_t  source_mtime;   //> nanoseconds
+        uint64_t source_hash;
+        uint64_t nData_records;
+        uint64_t nData_blocks;
+        uint64_t reserved;       //> keeps the header 64 bytes long, so the arrays are aligned
+    };
+}
+static const char     CACHE_EXTENSION[] = ".hcache";
+static const uint32_t CACHE_VERSION     = 2;
+static const size_t   CACHE_HASH_SPAN   = 65536;
+static const size_t   CACHE_SAMPLE_SPAN = 4096;
+static const size_t   CACHE_HASH_SAMPLES = 256;
+
+/*!
+*   Identification of the contents of an ASCII file, stored in its cache
+*/
+struct source_signature{
+    uint64_t size;
+    int64_t  mtime;   //> nanoseconds
+    uint64_t hash;
+};
+// size, modification time and hash of the file; false if the file can not be read
+bool get_source_signature(std::string const &fileName,source_signature &signature);
+// name of the cache file for the ASCII file fileName
+std::string cache_file_name(std::string const &fileName);
+
+class ascii_cache{
+public:
+    ascii_cache();
+    /* map the cache of the ASCII file fileName. Returns false if there is no cache or it is
+       not valid for the current contents of the file, which then has to be parsed */
+    bool open(std::string const &fileName);
+    // descriptor of the cached file; nData_records, nData_blocks and Type are defined
+    FileTypeDescriptor const &descriptor()const{return _descriptor;}
+    // copy cached array (0 -- par/phx or S, 1 -- ERR, 2 -- en) into pData
+    void read(int array_num,double *pData)const;
+    // cached array array_num, valid until the cache is closed
+    const double *array(int array_num)const;
+    /* write the cache for the file, opened (unsuccessfully) by open. The arrays are the loader
+       outputs for FILE_TYPE. Returns false if the cache can not be written (e.g. the folder
+       is read-only); the cache is optional so the failure is not an error */
+    bool write(FileTypeDescriptor const &FILE_TYPE,const double *const data[])const;
+    void close(){_cache.close();}
+private:
+    std::string        _fileName;
+    source_signature   _source;     //> the signature of the file at open
+    bool               _source_valid;
+    mapped_file        _cache;
+    FileTypeDescriptor _descriptor;
+};
+
+#endif
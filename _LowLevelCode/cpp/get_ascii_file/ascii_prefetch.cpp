@@ -0,0 +1,170 @@
+#include "ascii_prefetch.h"
+
+ascii_prefetch::ascii_prefetch(unsigned int n_threads):
+_n_threads(n_threads),_max_bytes(0),_bytes_held(0),_stop(false)
+{
+    _worker = std::thread(&ascii_prefetch::work,this);
+}
+
+ascii_prefetch::~ascii_prefetch()
+{
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _stop = true;
+        _queue.clear();
+    }
+    _wake.notify_all();
+    _worker.join();
+}
+
+size_t
+ascii_prefetch::start(std::vector<std::string> const &fileNames,size_t max_bytes)
+{
+    size_t n_queued(0);
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _max_bytes = max_bytes;
+        for(size_t i=0;i<fileNames.size();i++){
+            if(_entries.count(fileNames[i]))continue;
+            entry &item = _entries[fileNames[i]];
+            item.state = QUEUED;
+            item.bytes = 0;
+            _queue.push_back(fileNames[i]);
+            n_queued++;
+        }
+    }
+    if(n_queued>0)_wake.notify_all();
+    return n_queued;
+}
+
+bool
+ascii_prefetch::take(std::string const &fileName,ascii_file_data &file)
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    std::map<std::string,entry>::iterator it = _entries.find(fileName);
+    if(it==_entries.end())return false;
+    if(it->second.state==QUEUED){ // the caller parses it at once, faster than the worker
+        for(std::deque<std::string>::iterator q=_queue.begin();q!=_queue.end();q++){
+            if(*q==fileName){
+                _queue.erase(q);
+                break;
+            }
+        }
+        _entries.erase(it);
+        return false;
+    }
+    while(it->second.state==PARSING){
+        _parsed.wait(guard);
+        it = _entries.find(fileName);
+        if(it==_entries.end())return false;   // dropped by the worker or cleared
+    }
+    if(it->second.state!=READY)return false;
+    entry item;
+    std::swap(item,it->second);
+    _entries.erase(it);
+    _bytes_held -= item.bytes;
+    guard.unlock();
+
+    source_signature current;
+    if(!get_source_signature(fileName,current)||current.size!=item.signature.size||
+       current.mtime!=item.signature.mtime||current.hash!=item.signature.hash){
+        return false;   // the file has changed since it was parsed
+    }
+    std::swap(file,item.file);
+    return true;
+}
+
+void
+ascii_prefetch::clear()
+{
+    std::unique_lock<std::mutex> guard(_lock);
+    _queue.clear();
+    std::string parsing;
+    for(std::map<std::string,entry>::iterator it=_entries.begin();it!=_entries.end();){
+        if(it->second.state==PARSING){ // not READY any more, so the worker drops it when it is parsed
+            parsing = it->first;
+            it->second.state = QUEUED;
+            it++;
+            continue;
+        }
+        _bytes_held -= it->second.bytes;
+        _entries.erase(it++);
+    }
+    while(!parsing.empty()&&_entries.count(parsing)>0)_parsed.wait(guard);
+}
+
+size_t
+ascii_prefetch::n_files()const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _entries.size();
+}
+
+size_t
+ascii_prefetch::bytes_held()const
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    return _bytes_held;
+}
+
+/*!
+ *  the worker: parse the queued files one by one, reserving the memory of a file from its header
+*/
+void
+ascii_prefetch::work()
+{
+    ascii_file_parser parser;
+    std::unique_lock<std::mutex> guard(_lock);
+    for(;;){
+        while(!_stop&&_queue.empty())_wake.wait(guard);
+        if(_stop)return;
+        const std::string fileName = _queue.front();
+        _queue.pop_front();
+        _entries[fileName].state = PARSING;
+        guard.unlock();
+
+        ascii_file_data  file;
+        source_signature signature;
+        size_t bytes(0);
+        bool   fits(false),parsed(false);
+        try{
+            if(get_source_signature(fileName,signature)){
+                file.fileName   = fileName;
+                file.descriptor = parser.open(fileName);
+                for(int j=0;j<ascii_num_arrays(file.descriptor.Type);j++){
+                    bytes += ascii_array_size(file.descriptor,j)*sizeof(double);
+                }
+                {
+                    std::lock_guard<std::mutex> reserve(_lock);
+                    fits = _bytes_held+bytes<=_max_bytes;
+                    if(fits)_bytes_held += bytes;
+                }
+                if(fits){
+                    double *data[3];
+                    for(int j=0;j<ascii_num_arrays(file.descriptor.Type);j++){
+                        file.data[j].resize(ascii_array_size(file.descriptor,j));
+                        data[j] = file.data[j].data();
+                    }
+                    parser.load(data,_n_threads);
+                    parsed = true;
+                }
+            }
+        }catch(const std::exception &){
+            parsed = false;
+        }
+        parser.close();
+
+        guard.lock();
+        std::map<std::string,entry>::iterator it = _entries.find(fileName);
+        if(parsed&&it!=_entries.end()&&it->second.state==PARSING){
+            it->second.state     = READY;
+            it->second.bytes     = bytes;
+            it->second.signature = signature;
+            std::swap(it->second.file,file);
+        }else{
+            if(fits)_bytes_held -= bytes;
+            if(it!=_entries.end())_entries.erase(it);
+        }
+        _parsed.notify_all();
+    }
+}
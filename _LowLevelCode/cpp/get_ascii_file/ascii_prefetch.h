@@ -0,0 +1,69 @@
+#ifndef H_ASCII_PREFETCH
+#define H_ASCII_PREFETCH
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "get_ascii_file.h"
+#include "ascii_cache.h"
+
+/*!
+*   Store of ASCII files parsed in the background ahead of their use.
+*
+*   The files queued by start() are parsed in order by a worker thread, which uses n_threads
+*   threads for the detector blocks of SPE files (1 by default, so the work of the caller on the
+*   current run keeps the other cores). The parsed arrays stay in the store until take() hands
+*   them over; they are given only while the file has the size, modification time and hash of
+*   its ends it had when it was parsed.
+*
+*   The data held (parsed or being parsed) never exceed the limit given to start(): a file, which
+*   does not fit in it when the worker gets to it, is dropped and has to be loaded by the caller.
+*   Files, which fail to parse, are dropped too, so the caller reports the errors.
+*   All methods are thread-safe.
+*/
+class ascii_prefetch{
+public:
+    explicit ascii_prefetch(unsigned int n_threads=1);
+    ~ascii_prefetch();
+    /* queue the files for parsing; the files already queued or held are skipped.
+       max_bytes replaces the limit of the data held. Returns the number of files queued */
+    size_t start(std::vector<std::string> const &fileNames,size_t max_bytes);
+    /* move the data of the file out of the store into file, waiting if the file is being parsed.
+       Returns false if the file is not in the store; a file still in the queue is removed from it */
+    bool take(std::string const &fileName,ascii_file_data &file);
+    // drop the queue and all data held, waiting for the file being parsed
+    void clear();
+    // number of files queued or held and the bytes of the data held
+    size_t n_files()const;
+    size_t bytes_held()const;
+private:
+    ascii_prefetch(const ascii_prefetch &);
+    ascii_prefetch &operator=(const ascii_prefetch &);
+
+    enum entry_state{
+        QUEUED,
+        PARSING,
+        READY
+    };
+    struct entry{
+        entry_state      state;
+        size_t           bytes;
+        source_signature signature;
+        ascii_file_data  file;
+    };
+    void work();
+
+    unsigned int                  _n_threads;
+    size_t                        _max_bytes,_bytes_held;
+    std::map<std::string,entry>   _entries;
+    std::deque<std::string>       _queue;
+    bool                          _stop;
+    mutable std::mutex            _lock;
+    std::condition_variable       _wake,_parsed;
+    std::thread                   _worker;
+};
+
+#endif
@@ -1,26 +1,62 @@
 // get_ascii_file.cpp : Defines the exported functions for the DLL application.
 //
 #include "get_ascii_file.h"
+#include "ascii_cache.h"
+#include "ascii_prefetch.h"
+#include "map_file.h"
+#include "../utility/mx_range.h"
 #include "../utility/version.h"
 /*! \file get_ascii_file.cpp
 *
-*  \brief     result=get_ascii_file(fileName,[file_type]) function reads par, phx or spx - ASCII
+*  \brief     result=get_ascii_file(fileName,[file_type],[keys]) function reads par, phx or spx - ASCII
 *             files depending on the output arguments specified and the file format itself
 *
 * usage:
 *\code
-* [result] = get_ascii_file(fileName,[file_type])
+* [result] = get_ascii_file(fileName,[file_type],['-cache'],['-detectors',[first,last]],['-energies',[first,last]],['-single'])
+* info     = get_ascii_file(fileName,[file_type],'-info')
+* n_queued = get_ascii_file(fileName,[file_type],'-prefetch',max_bytes)
 *
 *
 * input arguments:
 *	file_name -- a string which specifies the name of the input data file.
 *	             The file has to be an ascii file of format specified below
+*	             If it is a cell array of file names, the files are loaded concurrently and
+*	             each output is a cell array of the same shape, holding the results for every file
 *	file_type -- optional string, defining the file format
-*	             three values for this string are currently possible:
-*				 spe, par,  phx or nothing
+*	             five values for this string are currently possible:
+*				 spe, par,  phx, map, msk or nothing
 *				 if omitted, the program tries to identify the file type by itself
+*				 (map and msk files are read only if their type is requested)
 *				 if the option is specified and the file format differs from the requested,
 *				 the error is returned
+*	'-cache'  -- optional key. If present, the parsed file is kept in the binary file
+*	             fileName.hcache next to it and later calls with this key copy the data from
+*	             there, while the cache is valid for the current contents of the file. The cache is
+*	             identified by the size and modification time of the file and a hash of its ends and
+*	             of blocks sampled over the rest of it, so an edit which keeps the size and the time
+*	             (to the resolution of the file system) and falls between the sampled blocks of a file
+*	             larger than about 1.1MB is not noticed. Delete the .hcache file after such edits.
+*	'-detectors',[first,last] -- optional key and range. Load only detectors first:last of SPE file.
+*	             The detector blocks are found from the length of the first one, so the rest of the
+*	             file is not read
+*	'-energies',[first,last]  -- optional key and range. Load only energy bins first:last of SPE
+*	             file; en contains the last-first+2 boundaries of these bins
+*	'-single' -- optional key. Return the signal and error of SPE file (requested as file type 'spe')
+*	             as single precision arrays; the values are converted while they are parsed or copied
+*	             from the cache, so double precision copies of them are never held. The energy bins
+*	             remain double precision. The cache holds double precision data, so valid caches are
+*	             read with this key, but the files parsed are not written to the cache
+*	'-info'   -- optional key. Read only the file headers (and the energy grid of SPE files) and return
+*	             the structure (structure array of the shape of the cell array of files) with fields:
+*	             file_type   -- 'par', 'phx' or 'spe'
+*	             n_detectors -- number of detectors in the file
+*	             n_energies  -- number of energy bins of SPE file (0 for PAR and PHX files)
+*	             en          -- (n_energies+1,1) energy bin boundaries of SPE file (empty for PAR and PHX files)
+*	'-prefetch',max_bytes -- optional key and size. Queue the files for parsing by a background thread and
+*	             return the number of files queued at once. The parsed data are kept while they occupy at most
+*	             max_bytes and are taken by the next calls loading these files (whole, without ranges) while
+*	             the files are unchanged. max_bytes=0 drops all prefetched data
 *
 *output parameters:    three forms are possible:
 *
@@ -67,6 +103,23 @@
 *     data_ERR(ne,ndet)       "
 *     en(ne+1,1)          energy bin boundaries
 *
+*-----------------------------------------------------------------------
+*4) an ASCII map file (or the old VMS map file), as read by IX_map
+*
+*     Syntax:
+*     >> [ns, s, wkno] = get_ascii_file(filename,'map')
+*
+*     ns(1,nw)            number of spectra in each of nw workspaces
+*     s(1,sum(ns))        spectrum numbers of all workspaces, concatenated together
+*     wkno(1,nw)          workspace numbers; zeros(1,0) for the VMS format, which does not contain them
+*
+*-----------------------------------------------------------------------
+*5) an ASCII mask file, as read by IX_mask
+*
+*     Syntax:
+*     >> msk = get_ascii_file(filename,'msk')
+*
+*     msk(1,nmsk)         masked spectra in the order they are listed in the file
 *
 *-----------------------------------------------------------------------
 *
@@ -82,24 +135,241 @@ enum inputs{
     iFileType,
     iNumInputs
 };
+static const char CACHE_OPTION[]     = "-cache";
+static const char DETECTORS_OPTION[] = "-detectors";
+static const char ENERGIES_OPTION[]  = "-energies";
+static const char INFO_OPTION[]      = "-info";
+static const char SINGLE_OPTION[]    = "-single";
+static const char PREFETCH_OPTION[]  = "-prefetch";
+static const char *INFO_FIELDS[]     = {"file_type","n_detectors","n_energies","en"};
+static const char *fileTypesAccepted[iNumFileTypes+1] = {"par","phx","spe","map","msk","undefined"};
+
+/*! check the ranges requested are inside of the SPE file */
+static bool
+check_ranges(FileTypeDescriptor const &FILE_TYPE,data_range const &detectors,data_range const &energies,std::stringstream &buf)
+{
+    if(!detectors.defined&&!energies.defined)return true;
+    if(FILE_TYPE.Type!=iSPE_type){
+        buf<<" ranges of detectors and energy bins can be requested for SPE files only\n";
+        return false;
+    }
+    if(detectors.defined&&detectors.last>FILE_TYPE.nData_records){
+        buf<<" requested detectors "<<detectors.first<<":"<<detectors.last<<" but the file contains "<<FILE_TYPE.nData_records<<" detectors\n";
+        return false;
+    }
+    if(energies.defined&&energies.last>FILE_TYPE.nData_blocks){
+        buf<<" requested energy bins "<<energies.first<<":"<<energies.last<<" but the file contains "<<FILE_TYPE.nData_blocks<<" energy bins\n";
+        return false;
+    }
+    return true;
+}
+/*! check the file is of the type requested (if any) */
+static bool
+check_requested_type(FileTypeDescriptor const &FILE_TYPE,fileTypes requestedType,std::string const &fileName,std::stringstream &buf)
+{
+    if(requestedType!=iNumFileTypes&&FILE_TYPE.Type!=requestedType){
+        buf<<" it is requested to open a <"<<fileTypesAccepted[requestedType]<<"> file, but the internal file format of file: "<<fileName
+           <<" identified as <"<<fileTypesAccepted[FILE_TYPE.Type]<<"> file\n";
+        return false;
+    }
+    return true;
+}
+/*! check the file is of the type requested (if any) and the number of outputs suits it */
+static bool
+check_file_type(FileTypeDescriptor const &FILE_TYPE,fileTypes requestedType,int nlhs,std::string const &fileName,std::stringstream &buf)
+{
+    if(!check_requested_type(FILE_TYPE,requestedType,fileName,buf))return false;
+    switch(FILE_TYPE.Type){
+        case(iPAR_type):
+        case(iPHX_type):{
+            if(nlhs!=1){
+                buf<<" this program request one output parameter when loading "<<(FILE_TYPE.Type==iPAR_type ? "PAR":"PHX")<<" files\n";
+                return false;
+            }
+            return true;
+                        }
+        case(iSPE_type):{
+            if(nlhs!=3){
+                buf<<" this program request three output parameters when loading SPE files\n";
+                buf<<" ------- [data_S, data_E, en] = get_ascii_file(filename,['spe'])\n";
+                return false;
+            }
+            return true;
+                        }
+        default:{
+            buf<<" can not identify format of the input data file: "<<fileName<<std::endl;
+            return false;
+        }
+    }
+}
+/*! create the output arrays for the file (the ranges requested of SPE file) and return pointers to their data;
+    the signal and error of SPE file are single precision if single_precision is set */
+static void
+create_outputs(FileTypeDescriptor const &FILE_TYPE,data_range const &detectors,data_range const &energies,
+               bool single_precision,mxArray *out[],ascii_output &data)
+{
+    const size_t n_det = detectors.size(FILE_TYPE.nData_records);
+    const size_t n_en  = energies.size(FILE_TYPE.nData_blocks);
+    switch(FILE_TYPE.Type){
+        case(iPAR_type):{
+            out[0]=mxCreateDoubleMatrix(5,FILE_TYPE.nData_records,mxREAL);
+            break;
+                        }
+        case(iPHX_type):{
+            out[0]=mxCreateDoubleMatrix(6,FILE_TYPE.nData_records,mxREAL);
+            break;
+                        }
+        case(iMAP_type):{
+            out[0]=mxCreateDoubleMatrix(1,FILE_TYPE.nData_records,mxREAL);
+            out[1]=mxCreateDoubleMatrix(1,FILE_TYPE.nData_blocks,mxREAL);
+            out[2]=mxCreateDoubleMatrix(1,FILE_TYPE.nData_records,mxREAL);
+            break;
+                        }
+        case(iMSK_type):{
+            out[0]=mxCreateDoubleMatrix(1,FILE_TYPE.nData_records,mxREAL);
+            break;
+                        }
+        default:{
+            mxClassID S_class = single_precision ? mxSINGLE_CLASS:mxDOUBLE_CLASS;
+            out[0]=mxCreateNumericMatrix(n_en,n_det,S_class,mxREAL);
+            out[1]=mxCreateNumericMatrix(n_en,n_det,S_class,mxREAL);
+            out[2]=mxCreateDoubleMatrix(n_en+1,1,mxREAL);
+        }
+    }
+    data = ascii_output();
+    for(int i=0;i<ascii_num_arrays(FILE_TYPE.Type);i++){
+        if(i<2&&mxIsSingle(out[i])){
+            data.single[i] = static_cast<float *>(mxGetData(out[i]));
+        }else{
+            data.data[i]   = mxGetPr(out[i]);
+        }
+    }
+}
+/*! copy n values into the output array_num from position pos, converting the signal and error into single precision
+    if the output is single precision */
+static void
+copy_values(ascii_output const &data,int array_num,size_t pos,const double *values,size_t n)
+{
+    if(array_num<2&&data.single[array_num]){
+        float *dst = data.single[array_num]+pos;
+        for(size_t i=0;i<n;i++)dst[i] = static_cast<float>(values[i]);
+    }else{
+        memcpy(data.data[array_num]+pos,values,n*sizeof(double));
+    }
+}
+/*! copy the ranges requested from the full arrays of SPE file */
+static void
+copy_spe_ranges(FileTypeDescriptor const &FILE_TYPE,data_range const &detectors,data_range const &energies,
+                const double *const full[],ascii_output const &data)
+{
+    const size_t NE        = FILE_TYPE.nData_blocks;
+    const size_t first_det = detectors.start(FILE_TYPE.nData_records);
+    const size_t n_det     = detectors.size(FILE_TYPE.nData_records);
+    const size_t first_en  = energies.start(NE);
+    const size_t n_en      = energies.size(NE);
+    for(size_t j=0;j<n_det;j++){
+        for(int i=0;i<2;i++){
+            copy_values(data,i,j*n_en,full[i]+(first_det+j)*NE+first_en,n_en);
+        }
+    }
+    copy_values(data,2,0,full[2]+first_en,n_en+1);
+}
+
+/*! the files parsed in the background; kept until the mex file is cleared */
+static ascii_prefetch *prefetcher = NULL;
+static void
+delete_prefetcher()
+{
+    delete prefetcher;
+    prefetcher = NULL;
+}
+
+/*! load map or mask file (from its cache, if use_cache is set) into the outputs */
+static void
+load_map_or_mask(std::string const &fileName,fileTypes requestedType,bool use_cache,mxArray *out[])
+{
+    data_range   all;
+    ascii_output data;
+    ascii_cache  cache;
+    if(use_cache&&cache.open(fileName)){
+        FileTypeDescriptor const &FILE_TYPE = cache.descriptor();
+        std::stringstream buf;
+        if(!check_requested_type(FILE_TYPE,requestedType,fileName,buf))throw ascii_file_error(buf.str());
+        create_outputs(FILE_TYPE,all,all,false,out,data);
+        for(int j=0;j<ascii_num_arrays(FILE_TYPE.Type);j++){
+            cache.read(j,data.data[j]);
+        }
+    }else{
+        FileTypeDescriptor FILE_TYPE;
+        FILE_TYPE.Type                = requestedType;
+        FILE_TYPE.data_start_position = 0;
+        FILE_TYPE.line_end            = '\n';
+        map_file_data map;
+        if(requestedType==iMAP_type){
+            load_map_file(fileName,map);
+            FILE_TYPE.nData_records = map.ns.size();
+            FILE_TYPE.nData_blocks  = map.s.size();
+        }else{
+            load_mask_file(fileName,map.s);
+            FILE_TYPE.nData_records = map.s.size();
+            FILE_TYPE.nData_blocks  = 0;
+        }
+        create_outputs(FILE_TYPE,all,all,false,out,data);
+        if(requestedType==iMAP_type){
+            memcpy(data.data[0],map.ns.data(),map.ns.size()*sizeof(double));
+            memcpy(data.data[1],map.s.data(),map.s.size()*sizeof(double));
+            memcpy(data.data[2],map.wkno.data(),map.wkno.size()*sizeof(double));
+        }else{
+            memcpy(data.data[0],map.s.data(),map.s.size()*sizeof(double));
+        }
+        if(use_cache){ // a failure to write the cache only means it is not used next time
+            cache.write(FILE_TYPE,data.data);
+        }
+    }
+    if(requestedType==iMAP_type){ // the VMS format does not contain workspace numbers
+        const double  *wkno = mxGetPr(out[2]);
+        const size_t   nw   = mxGetNumberOfElements(out[2]);
+        bool vms_format(nw>0);
+        for(size_t i=0;i<nw&&vms_format;i++)vms_format = wkno[i]==0;
+        if(vms_format){
+            mxDestroyArray(out[2]);
+            out[2] = mxCreateDoubleMatrix(1,0,mxREAL);
+        }
+    }
+}
+
+/*! fill element i of the info structure array with the header of the file */
+static void
+set_info(mxArray *pInfo,size_t i,ascii_file_data const &file)
+{
+    FileTypeDescriptor const &FILE_TYPE = file.descriptor;
+    const bool is_spe = FILE_TYPE.Type==iSPE_type;
+    mxSetFieldByNumber(pInfo,i,0,mxCreateString(fileTypesAccepted[FILE_TYPE.Type]));
+    mxSetFieldByNumber(pInfo,i,1,mxCreateDoubleScalar(static_cast<double>(FILE_TYPE.nData_records)));
+    mxSetFieldByNumber(pInfo,i,2,mxCreateDoubleScalar(is_spe ? static_cast<double>(FILE_TYPE.nData_blocks):0.));
+    mxArray *pEn = mxCreateDoubleMatrix(is_spe ? file.data[2].size():0,is_spe ? 1:0,mxREAL);
+    if(is_spe)memcpy(mxGetPr(pEn),file.data[2].data(),file.data[2].size()*sizeof(double));
+    mxSetFieldByNumber(pInfo,i,3,pEn);
+}
+
 /*! \brief interface function between the code and Matlab */
 void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
   std::stringstream buf;  // buffer to report errors;
-  char *Buf;              // buffer to get string data from Matlab
 
-  mwSize fileName_Length;
-  std::string inputFileName,inputFileType;
-  fileTypes   currentFileType;
-  char fileType[4];
-  std::ifstream data_stream;
-  FileTypeDescriptor FILE_TYPE;   // file descriptor will tell which file we have opened and some additional information about it
-
-
-  std::string fileTypesAccepted[iNumFileTypes+1];
-  fileTypesAccepted[iPAR_type]    ="par";
-  fileTypesAccepted[iPHX_type]    ="phx";
-  fileTypesAccepted[iSPE_type]    ="spe";
-  fileTypesAccepted[iNumFileTypes]="undefined";
+  std::vector<std::string> inputFileNames;
+  std::string inputFileType;
+  fileTypes   requestedFileType;
+  bool        batch(false);  // list of files in a cell array
+  bool        use_cache(false);
+  bool        info_only(false);
+  bool        single_precision(false);
+  bool        prefetch(false);
+  double      prefetch_bytes(0);
+  data_range  detectors,energies;
+  std::vector<ascii_file_data> loaded;
+  std::vector<size_t>          to_load;  // files, which have to be parsed
+  mxArray    *out[3];
+  ascii_output data;
 
   //--------->  ANALYSE INPUT PARAMETERS;
   if (nrhs == 0 && (nlhs == 0 || nlhs == 1)) {
@@ -107,127 +377,302 @@ void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
         return;
   }
 
+  // keys follow the file name and type
+  for(int i=iFileType;i<nrhs;i++){
+      std::string key;
+      if(!get_mx_string(prhs[i],key)||key.empty()||key[0]!='-')continue;
+      int nPositional = i;
+      for(;i<nrhs;i++){
+          if(!get_mx_string(prhs[i],key)){
+              buf<<"parameter N"<<i+1<<" has to be one of the keys: "<<CACHE_OPTION<<", "<<INFO_OPTION<<", "<<SINGLE_OPTION<<", "
+                 <<PREFETCH_OPTION<<", "<<DETECTORS_OPTION<<" or "<<ENERGIES_OPTION<<std::endl; goto error;
+          }
+          if(key==CACHE_OPTION){
+              use_cache = true;
+          }else if(key==INFO_OPTION){
+              info_only = true;
+          }else if(key==SINGLE_OPTION){
+              single_precision = true;
+          }else if(key==PREFETCH_OPTION){
+              if(i+1>=nrhs||!mxIsNumeric(prhs[i+1])||mxGetNumberOfElements(prhs[i+1])!=1||!(mxGetScalar(prhs[i+1])>=0)){
+                  buf<<"key "<<key<<" has to be followed by the non-negative number of bytes the prefetched files may occupy\n";  goto error;
+              }
+              prefetch       = true;
+              prefetch_bytes = mxGetScalar(prhs[i+1]);
+              i++;
+          }else if(key==DETECTORS_OPTION||key==ENERGIES_OPTION){
+              data_range &range = (key==DETECTORS_OPTION) ? detectors:energies;
+              if(i+1>=nrhs||!get_mx_range(prhs[i+1],range)){
+                  buf<<"key "<<key<<" has to be followed by the range [first,last] with 1<=first<=last\n";  goto error;
+              }
+              i++;
+          }else{
+              buf<<"unknown key: "<<key<<std::endl;  goto error;
+          }
+      }
+      nrhs = nPositional;
+  }
   if(nrhs!=iNumInputs&&nrhs!=iNumInputs-1) {
         buf<<"function needs one or two arguments but got "<<(short)nrhs<<" input arguments\n";	goto error;
   }
-  if(!mxIsChar(prhs[iFileName])||(mxGetM(prhs[iFileName]))!=1){  // not a file name
-      buf<<"first parameter has to be a scalar string, which specify a filename\n";	            goto error;
-  }else{                                                         // get file name
-      fileName_Length = mxGetN(prhs[iFileName])+1;
-      Buf = new char[fileName_Length];
-      if(!Buf){
-          buf<<"auxilary memory allocation error (wrong file name?)\n";	                       goto error;
-      }
-      if(mxGetString(prhs[iFileName], Buf, fileName_Length)){
-          buf<<"can not obtain input file_name correctly\n";			 					   goto error;
-      }
-      inputFileName.reserve(fileName_Length);
-      inputFileName.assign(Buf);
-      delete [] Buf; Buf=NULL;
-//----------> INPUT PARAMETERS: does the file exist
+  batch = mxIsCell(prhs[iFileName]);
+  if(batch&&(detectors.defined||energies.defined)){
+      buf<<"ranges of detectors and energy bins can be requested when loading a single file only\n"; goto error;
+  }
+  if(batch){
+      size_t nFiles = mxGetNumberOfElements(prhs[iFileName]);
+      inputFileNames.resize(nFiles);
+      for(size_t i=0;i<nFiles;i++){
+          const mxArray *pName = mxGetCell(prhs[iFileName],i);
+          if(!pName||!get_mx_string(pName,inputFileNames[i])){
+              buf<<"element "<<i+1<<" of the list of files has to be a string, which specify a filename\n"; goto error;
+          }
+      }
+  }else{
+      inputFileNames.resize(1);
+      if(!get_mx_string(prhs[iFileName],inputFileNames[0])){
+          buf<<"first parameter has to be a scalar string, which specify a filename, or a cell array of filenames\n"; goto error;
+      }
+  }
+//----------> INPUT PARAMETERS: do the files exist
+  for(size_t i=0;i<inputFileNames.size();i++){
         struct stat stFileInfo;
-        if(stat(inputFileName.c_str(),&stFileInfo)!=0){ // we are not able to obtain the file info; the file probably not exist
-            buf<<"file: "<<inputFileName<<" can not be found\n";							     goto error;
+        if(stat(inputFileNames[i].c_str(),&stFileInfo)!=0){ // we are not able to obtain the file info; the file probably not exist
+            buf<<"file: "<<inputFileNames[i]<<" can not be found\n";							     goto error;
         }
   }
 
 //----------> INPUT PARAMETERS: Analyze, which file type is requested
-  currentFileType=iNumFileTypes; // set the current file type to the value, which it can never have for a valid file type;
+  requestedFileType=iNumFileTypes; // set the current file type to the value, which it can never have for a valid file type;
   if(nrhs==iNumInputs){          // second parameter is present and we should analyze it
-      if(!mxIsChar(prhs[iFileType])||(mxGetM(prhs[iFileType]))!=1){  // not a file type
+      if(!get_mx_string(prhs[iFileType],inputFileType)){  // not a file type
             buf<<"second parameter, if present has to be a scalar string, which specify a file type\n";      goto error;
-      }else{                                                         // get file type
-            std::size_t fileType_Length = mxGetN(prhs[iFileType])+1;
-            if(fileType_Length!=4){	buf<<"second parameter has to be a string of 3 ASCII symbols\n";	   	goto error;
-            }
-            if(mxGetString(prhs[iFileType], fileType, fileType_Length)){
-                buf<<" can not obtain file_type properly\n";	   						goto error;
-            }
-            inputFileType.assign(fileType);
-
-            // and now we should see if the parameter is among accepted
-            for(int i=0;i<iNumFileTypes;i++){
-                if(inputFileType.compare(fileTypesAccepted[i])==0){
-                    currentFileType=(fileTypes)i;
-                    break;
-                }
-            }
-            if(currentFileType==iNumFileTypes){
-                buf<<"the file type parameter, specified in the program call is: " <<inputFileType<<std::endl;
-                buf<<"---------  it is not among filetypes accepted\n";                       goto error;
-            }
+      }
+      if(inputFileType.size()!=3){	buf<<"second parameter has to be a string of 3 ASCII symbols\n";	   	goto error;
+      }
+      // and now we should see if the parameter is among accepted
+      for(int i=0;i<iNumFileTypes;i++){
+          if(inputFileType.compare(fileTypesAccepted[i])==0){
+              requestedFileType=(fileTypes)i;
+              break;
+          }
+      }
+      if(requestedFileType==iNumFileTypes){
+          buf<<"the file type parameter, specified in the program call is: " <<inputFileType<<std::endl;
+          buf<<"---------  it is not among filetypes accepted\n";                       goto error;
       }
   }  // second parameter is present and have been identified;
+  if(single_precision&&(requestedFileType!=iSPE_type||info_only)){
+      buf<<"the key "<<SINGLE_OPTION<<" can be used only when loading the data of the files of requested type spe\n"; goto error;
+  }
 
-//----------> INPUT PARAMETERS: open file and analyze,  it its type is the same as the type requested plus get other service information;
-    try{
-        FILE_TYPE=get_ASCII_header(inputFileName,data_stream);
-    }catch(const char *Error){
-        buf<<Error<<std::endl;  goto error;
-    }
-    if(currentFileType!=iNumFileTypes){  // then a file type requested is specified and we have to check if the real file type corresponds to the requested
-        if(FILE_TYPE.Type!=currentFileType){
-            buf<<" it is requested to open a <"<<inputFileType<<"> file, but the internal file format identified as <"<<fileTypesAccepted[FILE_TYPE.Type]<<"> file\n";
-            goto error;
-        }
-    }
-    currentFileType= FILE_TYPE.Type;
-
-
-    try{
-        switch(currentFileType){
-            case(iPAR_type):{
-                if(nlhs!=1){
-                    buf<<" this program request one output parameter when loading PAR files\n";
-                    goto error;
-                }
-                plhs[0]=mxCreateDoubleMatrix(5,FILE_TYPE.nData_records,mxREAL);
-                double *pData=mxGetPr(plhs[0]);
-                load_plain(data_stream,pData,FILE_TYPE);
-                break;
-                            }
-            case(iPHX_type):{
-                if(nlhs!=1){
-                    buf<<" this program request one output parameter when loading PHX files\n";
-                    goto error;
-                }
-                plhs[0]=mxCreateDoubleMatrix(6,FILE_TYPE.nData_records,mxREAL);
-                double *pData=mxGetPr(plhs[0]);
-                load_plain(data_stream,pData,FILE_TYPE);
-                break;
-                            }
-            case(iSPE_type):{
-                if(nlhs!=3){
-                    buf<<" this program request three output parameters when loading SPE files\n";
-                    buf<<" ------- [data_S, data_E, en] = get_ascii_file(filename,['spe'])\n";
-                    goto error;
-                }
-
-                plhs[0]=mxCreateDoubleMatrix(FILE_TYPE.nData_blocks,FILE_TYPE.nData_records,mxREAL);
-                plhs[1]=mxCreateDoubleMatrix(FILE_TYPE.nData_blocks,FILE_TYPE.nData_records,mxREAL);
-                plhs[2]=mxCreateDoubleMatrix(FILE_TYPE.nData_blocks+1,1,mxREAL);
-                double *data_S   = mxGetPr(plhs[0]);
-                double *data_ERR = mxGetPr(plhs[1]);
-                double *data_en  = mxGetPr(plhs[2]);
-
-                load_spe(data_stream,data_S,data_ERR,data_en,FILE_TYPE);
-                break;
-                            }
+//----------> queue the files for parsing in the background
+  if(prefetch){
+      if(info_only||single_precision||detectors.defined||energies.defined||requestedFileType==iMAP_type||requestedFileType==iMSK_type){
+          buf<<"the key "<<PREFETCH_OPTION<<" can not be combined with other keys and is used for par, phx and spe files only\n"; goto error;
+      }
+      if(nlhs>1){
+          buf<<"the key "<<PREFETCH_OPTION<<" returns one output parameter, but "<<(short)nlhs<<" are requested\n"; goto error;
+      }
+      size_t n_queued(0);
+      try{
+          if(prefetch_bytes==0){
+              if(prefetcher)prefetcher->clear();
+          }else{
+              if(!prefetcher){
+                  prefetcher = new ascii_prefetch();
+                  mexAtExit(delete_prefetcher);
+              }
+              n_queued = prefetcher->start(inputFileNames,static_cast<size_t>(std::min(prefetch_bytes,1.e18)));
+          }
+      }catch(const std::exception &Error){
+          buf<<Error.what()<<std::endl;  goto error;
+      }
+      plhs[0] = mxCreateDoubleScalar(static_cast<double>(n_queued));
+      return;
+  }
 
-        }
-        data_stream.close();
-    }catch(const char *Error){
-         buf<<Error<<std::endl;  goto error;
-    }
+//----------> map and mask files are parsed by their own readers
+  if(requestedFileType==iMAP_type||requestedFileType==iMSK_type){
+      if(info_only||detectors.defined||energies.defined){
+          buf<<"keys "<<INFO_OPTION<<", "<<DETECTORS_OPTION<<" and "<<ENERGIES_OPTION<<" can not be used when loading "<<inputFileType<<" files\n"; goto error;
+      }
+      if(nlhs!=ascii_num_arrays(requestedFileType)){
+          if(requestedFileType==iMAP_type){
+              buf<<" this program request three output parameters when loading MAP files\n";
+              buf<<" ------- [ns, s, wkno] = get_ascii_file(filename,'map')\n";
+          }else{
+              buf<<" this program request one output parameter when loading MSK files\n";
+          }
+          goto error;
+      }
+      if(batch){
+          for(int i=0;i<nlhs;i++){
+              plhs[i] = mxCreateCellArray(mxGetNumberOfDimensions(prhs[iFileName]),mxGetDimensions(prhs[iFileName]));
+          }
+      }
+      for(size_t i=0;i<inputFileNames.size();i++){
+          try{
+              load_map_or_mask(inputFileNames[i],requestedFileType,use_cache,batch ? out:plhs);
+          }catch(const std::exception &Error){
+              buf<<Error.what()<<"          when loading file: "<<inputFileNames[i]<<std::endl;  goto error;
+          }
+          if(batch){
+              for(int j=0;j<nlhs;j++)mxSetCell(plhs[j],i,out[j]);
+          }
+      }
+      return;
+  }
+
+//----------> only the headers of the files are requested
+  if(info_only){
+      if(detectors.defined||energies.defined){
+          buf<<"ranges of detectors and energy bins can not be requested together with the key "<<INFO_OPTION<<std::endl; goto error;
+      }
+      if(nlhs>1){
+          buf<<"the key "<<INFO_OPTION<<" returns one output parameter, but "<<(short)nlhs<<" are requested\n"; goto error;
+      }
+      try{
+          loaded = load_ascii_files(inputFileNames,0,true);
+      }catch(const std::exception &Error){
+          buf<<Error.what()<<std::endl;  goto error;
+      }
+      mxArray *pInfo = batch ? mxCreateStructArray(mxGetNumberOfDimensions(prhs[iFileName]),mxGetDimensions(prhs[iFileName]),4,INFO_FIELDS)
+                             : mxCreateStructMatrix(1,1,4,INFO_FIELDS);
+      plhs[0] = pInfo;
+      for(size_t k=0;k<loaded.size();k++){
+          if(!loaded[k].error.empty()){
+              buf<<loaded[k].error<<"          when reading the header of file: "<<loaded[k].fileName<<std::endl; goto error;
+          }
+          if(!check_requested_type(loaded[k].descriptor,requestedFileType,loaded[k].fileName,buf))goto error;
+          set_info(pInfo,k,loaded[k]);
+      }
+      return;
+  }
+  if(batch){
+      for(int i=0;i<nlhs;i++){
+          plhs[i] = mxCreateCellArray(mxGetNumberOfDimensions(prhs[iFileName]),mxGetDimensions(prhs[iFileName]));
+      }
+  }
+
+//----------> copy the files parsed in the background and the files with valid caches
+  for(size_t i=0;i<inputFileNames.size();i++){
+      ascii_file_data prefetched;
+      if(prefetcher&&!detectors.defined&&!energies.defined&&prefetcher->take(inputFileNames[i],prefetched)){
+          FileTypeDescriptor const &FILE_TYPE = prefetched.descriptor;
+          if(!check_file_type(FILE_TYPE,requestedFileType,nlhs,inputFileNames[i],buf))goto error;
+          ascii_cache cache;
+          if(use_cache&&!cache.open(inputFileNames[i])){ // a failure to write the cache only means it is not used next time
+              const double *full[] = {prefetched.data[0].data(),prefetched.data[1].data(),prefetched.data[2].data()};
+              cache.write(FILE_TYPE,full);
+          }
+          create_outputs(FILE_TYPE,detectors,energies,single_precision,batch ? out:plhs,data);
+          for(int j=0;j<ascii_num_arrays(FILE_TYPE.Type);j++){
+              copy_values(data,j,0,prefetched.data[j].data(),prefetched.data[j].size());
+              std::vector<double>().swap(prefetched.data[j]);
+              if(batch)mxSetCell(plhs[j],i,out[j]);
+          }
+          continue;
+      }
+      ascii_cache cache;
+      if(!use_cache||!cache.open(inputFileNames[i])){
+          to_load.push_back(i);
+          continue;
+      }
+      FileTypeDescriptor const &FILE_TYPE = cache.descriptor();
+      if(!check_file_type(FILE_TYPE,requestedFileType,nlhs,inputFileNames[i],buf))goto error;
+      if(!check_ranges(FILE_TYPE,detectors,energies,buf))goto error;
+      create_outputs(FILE_TYPE,detectors,energies,single_precision,batch ? out:plhs,data);
+      if(detectors.defined||energies.defined){
+          const double *full[] = {cache.array(0),cache.array(1),cache.array(2)};
+          copy_spe_ranges(FILE_TYPE,detectors,energies,full,data);
+          continue;
+      }
+      for(int j=0;j<ascii_num_arrays(FILE_TYPE.Type);j++){
+          copy_values(data,j,0,cache.array(j),ascii_array_size(FILE_TYPE,j));
+          if(batch)mxSetCell(plhs[j],i,out[j]);
+      }
+  }
+  if(to_load.empty())return;
 
+//----------> load the other files directly into the outputs; single precision data are not cached
+  if(single_precision)use_cache = false;
+  if(!batch){
+      ascii_file_parser parser;
+      ascii_cache       cache;
+      try{
+          FileTypeDescriptor const &FILE_TYPE = parser.open(inputFileNames[0]);
+          if(!check_file_type(FILE_TYPE,requestedFileType,nlhs,inputFileNames[0],buf))goto error;
+          if(!check_ranges(FILE_TYPE,detectors,energies,buf))goto error;
+          create_outputs(FILE_TYPE,detectors,energies,single_precision,plhs,data);
+          if(detectors.defined||energies.defined){ // a part of the file is not cached
+              const size_t NDET = FILE_TYPE.nData_records;
+              const size_t NE   = FILE_TYPE.nData_blocks;
+              bool mapped = single_precision ?
+                  parser.load_spe_range(data.single[0],data.single[1],data.data[2],detectors.start(NDET),detectors.size(NDET),
+                                        energies.start(NE),energies.size(NE)):
+                  parser.load_spe_range(data.data[0],data.data[1],data.data[2],detectors.start(NDET),detectors.size(NDET),
+                                        energies.start(NE),energies.size(NE));
+              if(!mapped){ // file can not be mapped into memory
+                  std::vector<double> S(NE*NDET),ERR(NE*NDET),en(NE+1);
+                  parser.load_spe(&S[0],&ERR[0],&en[0]);
+                  const double *full[] = {&S[0],&ERR[0],&en[0]};
+                  copy_spe_ranges(FILE_TYPE,detectors,energies,full,data);
+              }
+              return;
+          }
+          if(use_cache)cache.open(inputFileNames[0]); // identifies the file before it is parsed
+          parser.load(data);
+          parser.close();
+          if(use_cache){ // a failure to write the cache only means it is not used next time
+              cache.write(FILE_TYPE,data.data);
+          }
+      }catch(const std::exception &Error){
+          buf<<Error.what()<<std::endl;  goto error;
+      }
+      return;
+  }
+  {   // the headers are read here to create the outputs, which the files are parsed into concurrently
+      std::vector<std::string>        fileNames;
+      std::vector<FileTypeDescriptor> descriptors;
+      std::vector<ascii_output>       outputs;
+      std::vector<std::string>        errors;
+      std::vector<ascii_cache>        caches(use_cache ? to_load.size():0);
+      ascii_file_parser parser;
+      for(size_t k=0;k<to_load.size();k++){
+          fileNames.push_back(inputFileNames[to_load[k]]);
+          if(use_cache)caches[k].open(fileNames[k]);
+          try{
+              descriptors.push_back(parser.open(fileNames[k]));
+              parser.close();
+          }catch(const std::exception &Error){
+              buf<<Error.what()<<"          when loading file: "<<fileNames[k]<<std::endl; goto error;
+          }
+          FileTypeDescriptor const &FILE_TYPE = descriptors[k];
+          if(!check_file_type(FILE_TYPE,requestedFileType,nlhs,fileNames[k],buf))goto error;
+          create_outputs(FILE_TYPE,detectors,energies,single_precision,out,data);
+          outputs.push_back(data);
+          for(int j=0;j<ascii_num_arrays(FILE_TYPE.Type);j++){
+              mxSetCell(plhs[j],to_load[k],out[j]);
+          }
+      }
+      try{
+          errors = load_ascii_files(fileNames,descriptors,outputs);
+      }catch(const std::exception &Error){
+          buf<<Error.what()<<std::endl;  goto error;
+      }
+      for(size_t k=0;k<errors.size();k++){
+          if(!errors[k].empty()){
+              buf<<errors[k]<<"          when loading file: "<<fileNames[k]<<std::endl; goto error;
+          }
+          if(use_cache)caches[k].write(descriptors[k],outputs[k].data);
+      }
+  }
   return;
 error:
   std::string err_msg("-->ERROR:: ");
   err_msg.append(buf.str());
-  if(Buf)delete [] Buf;
-  data_stream.close();
 
   mexErrMsgTxt(err_msg.c_str());
 
 }
-
@@ -8,6 +8,9 @@
 #include <sys/stat.h>
 #include <stdio.h>
 #include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <mex.h> // llget_ascii_file uses only the definition of mwSize from mex.h
 				// if the function has to be used independently on Matlab, it should just typedef mwSize
 #include "matrix.h"
@@ -19,6 +22,8 @@ enum fileTypes{
 	iPAR_type,
 	iPHX_type,
 	iSPE_type,
+	iMAP_type, // map and mask files are loaded only when requested, they are never identified by ascii_file_parser
+	iMSK_type,
 	iNumFileTypes
 };
 /*!
@@ -29,16 +34,117 @@ struct FileTypeDescriptor{
 	std::streampos data_start_position; //> the position in the file where the data structure starts
 	size_t 	  nData_records,       //> number of data records -- actually nDetectors
 		      nData_blocks;        //> nEnergy bins for SPE file, 5 or 6 for PAR file and 7 for PHX file
+		                           //> (for MAP file nData_records is the number of workspaces and nData_blocks the number of spectra)
 	char      line_end ;              //> the character which ends line in current ASCII file 0x0A (LF)
 	    //Unix, 0x0D (CR) Mac and 0x0D 0x0A (CR LF) Win, but the last is interpreted as 0x0A here 
 };
 
-// load file header and identify which file (PHX,PAR or SPE) it belongs to. It also identifies the position of the begining of the data
-FileTypeDescriptor get_ASCII_header(std::string const &fileName, std::ifstream &data_stream);
-// load PAR or PHX file
-void load_plain(std::ifstream &stream,double *pData,FileTypeDescriptor const &FILE_TYPE);
-// load SPE file
-void load_spe(std::ifstream &stream,double *data_S,double *data_ERR,double * data_en, FileTypeDescriptor const &FILE_TYPE);
+#define BUF_SIZE 1024 //> the longest header or data line the parser accepts
+
+/*!
+*   Error in the format or contents of an ASCII data file
+*/
+class ascii_file_error: public std::runtime_error{
+public:
+	explicit ascii_file_error(std::string const &message):std::runtime_error(message){}
+};
+
+/*!
+*   Arrays a file is loaded into, of the sizes given by ascii_array_size for its type.
+*   If single[0] is set, the signal and error of SPE file are converted into single precision
+*   while they are parsed and go to single[0] and single[1] instead of data[0] and data[1]
+*/
+struct ascii_output{
+	double *data[3];
+	float  *single[2];
+	ascii_output(){
+		for(int i=0;i<3;i++)data[i]   = NULL;
+		for(int i=0;i<2;i++)single[i] = NULL;
+	}
+};
+
+/*!
+*   Reader of PAR, PHX and SPE files.
+*
+*   All state (the file stream and line buffers) belongs to the object, so different readers
+*   can load files concurrently. A single reader is not thread-safe.
+*   Errors are reported by throwing ascii_file_error.
+*/
+class ascii_file_parser{
+public:
+	ascii_file_parser();
+	// open the file, identify which file (PHX,PAR or SPE) it is and the position of the begining of the data
+	FileTypeDescriptor const &open(std::string const &fileName);
+	FileTypeDescriptor const &descriptor()const{return _descriptor;}
+	// load PAR or PHX file
+	void load_plain(double *pData);
+	// load SPE file
+	void load_spe(double *data_S,double *data_ERR,double * data_en);
+	// the same, converting the signal and error into single precision while they are read
+	void load_spe(float *data_S,float *data_ERR,double * data_en);
+	// load the energy bin boundaries of SPE file only, reading the header and skipping the phi grid
+	void load_spe_energies(double * data_en);
+	// load SPE file from memory mapping of the file, parsing detector blocks on n_threads threads (0 -- all hardware threads).
+	// Returns false if the file can not be mapped, so it has to be read by load_spe
+	bool load_spe_mapped(double *data_S,double *data_ERR,double * data_en,unsigned int n_threads=0);
+	bool load_spe_mapped(float *data_S,float *data_ERR,double * data_en,unsigned int n_threads=0);
+	// load detectors [first_det,first_det+n_det) and energy bins [first_en,first_en+n_en) of SPE file from its
+	// memory mapping, seeking to the blocks of these detectors. Returns false if the file can not be mapped
+	bool load_spe_range(double *data_S,double *data_ERR,double * data_en,size_t first_det,size_t n_det,
+	                    size_t first_en,size_t n_en,unsigned int n_threads=0);
+	bool load_spe_range(float *data_S,float *data_ERR,double * data_en,size_t first_det,size_t n_det,
+	                    size_t first_en,size_t n_en,unsigned int n_threads=0);
+	// load the opened file of any type into the arrays of sizes given by ascii_array_size
+	void load(double *const data[],unsigned int n_threads=0);
+	void load(ascii_output const &out,unsigned int n_threads=0);
+	void close(){_stream.close();}
+private:
+	ascii_file_parser(const ascii_file_parser &);
+	ascii_file_parser &operator=(const ascii_file_parser &);
+
+	template<class U>
+	bool read_SPEdata_block(U *pBlock,size_t DataSize,size_t block_size,int spe_field_width,int tr_spaces,
+	                        std::stringstream &err_message,bool buf_empty=true);
+	template<class U>
+	void read_spe(U *data_S,U *data_ERR,double * data_en);
+	template<class U>
+	bool read_spe_range(U *data_S,U *data_ERR,double * data_en,size_t first_det,size_t n_det,
+	                    size_t first_en,size_t n_en,unsigned int n_threads);
+
+	std::string        _fileName;
+	std::ifstream      _stream;
+	FileTypeDescriptor _descriptor;
+	char               _buf[BUF_SIZE];     //> current line
+	char               _discard[BUF_SIZE]; //> lines which are skipped
+};
+
+// number of arrays get_ascii_file returns for the file type
+int    ascii_num_arrays(fileTypes type);
+// number of elements in the output array_num (par(5,ndet); phx(6,ndet); S(ne,ndet), ERR(ne,ndet), en(ne+1);
+// ns(nw), s(nspec), wkno(nw); msk(nmsk))
+size_t ascii_array_size(FileTypeDescriptor const &FILE_TYPE,int array_num);
+
+/*!
+*   A file loaded by load_ascii_files; if loading has failed, error is not empty
+*/
+struct ascii_file_data{
+	std::string         fileName;
+	FileTypeDescriptor  descriptor;
+	std::vector<double> data[3];
+	std::string         error;
+};
+// load the files concurrently on n_threads threads (0 -- all hardware threads); with header_only, the descriptors and
+// the energy bins of SPE files only, leaving the other arrays empty
+std::vector<ascii_file_data> load_ascii_files(std::vector<std::string> const &fileNames,unsigned int n_threads=0,
+                                              bool header_only=false);
+// load the files concurrently into the arrays out, allocated by the caller for the descriptors of the files read by
+// open before. Returns the error of every file, empty if the file has been loaded
+std::vector<std::string> load_ascii_files(std::vector<std::string> const &fileNames,
+                                          std::vector<FileTypeDescriptor> const &descriptors,
+                                          std::vector<ascii_output> const &out,unsigned int n_threads=0);
+
+// identify field width and number of leading symbols of a row of SPE data
+void parse_spe_row(char *buf,int buf_size,int spe_block_size, int &spe_field_width, int &trailing_spaces);
 #endif
 
 #ifndef _CRT_SECURE_NO_WARNINGS
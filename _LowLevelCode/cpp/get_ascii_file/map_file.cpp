@@ -0,0 +1,339 @@
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif
+#include "map_file.h"
+#include "mapped_file.h"
+#include "parse_double.h"
+#include <cstring>
+
+//
+// parsers of the map and mask files, following get_map.m and get_mask.m of IX_map and IX_mask
+// and str_to_iarray.m, which they use to read lists of integers
+//
+static const double    MAX_MASKED_SPECTRA = 1e8;   //> more masked spectra are considered a syntax error in the file
+static const long long MAX_INTEGER = 100000000000000LL; //> integers are not accumulated further, to avoid overflow
+
+static inline bool
+is_delimiter(char symbol)
+{
+    return symbol==' '||symbol=='\t'||symbol==','||symbol=='\r';
+}
+/*!
+*  a line of the file without its comment and trailing delimiters
+*/
+struct text_line{
+    const char *begin,*end;
+    bool empty()const{return begin==end;}
+};
+/*!
+*  get the next line starting at p, moving p to the start of the line after it.
+*  Returns false at the end of the text
+*/
+static bool
+next_line(const char *&p,const char *end,text_line &line)
+{
+    if(p>=end)return false;
+    const char *eol = static_cast<const char *>(memchr(p,'\n',end-p));
+    if(!eol)eol = end;
+    line.begin = p;
+    line.end   = eol;
+    for(const char *c=line.begin;c<line.end;c++){
+        if(*c=='!'||*c=='%'){
+            line.end = c;
+            break;
+        }
+    }
+    while(line.begin<line.end&&is_delimiter(*line.begin))line.begin++;
+    while(line.end>line.begin&&is_delimiter(*(line.end-1)))line.end--;
+    p = eol<end ? eol+1:end;
+    return true;
+}
+/*!
+*  read consecutive integers from [p,end) as sscanf("%d") does and return their number.
+*  The first of them is returned in value
+*/
+static int
+scan_integers(const char *p,const char *end,long long &value)
+{
+    int count(0);
+    while(p<end){
+        bool negative(false);
+        if(*p=='+'||*p=='-'){
+            negative = *p=='-';
+            p++;
+        }
+        if(p>=end||*p<'0'||*p>'9')break;
+        long long val(0);
+        while(p<end&&*p>='0'&&*p<='9'){
+            if(val<MAX_INTEGER)val = 10*val+(*p-'0');
+            p++;
+        }
+        if(count==0)value = negative ? -val:val;
+        count++;
+    }
+    return count;
+}
+/*!
+*  range of integers described by a token: n integers from first with step +1 or -1
+*/
+struct int_range{
+    long long first;
+    long long step;
+    long long n;
+};
+/*!
+*  find the separator sep in the token [p,end); returns end if it is not there
+*/
+static const char *
+find_separator(const char *p,const char *end,const char *sep)
+{
+    const size_t len = strlen(sep);
+    for(;p+len<=end;p++){
+        if(memcmp(p,sep,len)==0)return p;
+    }
+    return end;
+}
+/*!
+*  parse the range with the limits [p,sep) and [sep+sep_len,end). Throws if either limit is not
+*  a single integer; the range is empty if it does not go in the direction requested
+*  (direction 0 -- in any direction)
+*/
+static int_range
+parse_range(const char *p,const char *sep,size_t sep_len,const char *end,int direction)
+{
+    long long lo(0),hi(0);
+    if(scan_integers(p,sep,lo)!=1||scan_integers(sep+sep_len,end,hi)!=1){
+        throw ascii_file_error("Check format of string contents");
+    }
+    int_range range = {lo,hi>=lo ? 1:-1,0};
+    if(direction==0||(direction>0&&hi>=lo)||(direction<0&&hi<=lo)){
+        range.n = (hi>=lo ? hi-lo:lo-hi)+1;
+    }
+    return range;
+}
+/*!
+*  parse a token: a single integer or a range mmm-nnn, mmm:nnn, mmm:1:nnn or mmm:-1:nnn.
+*  A token which is not an integer is ignored (the range is empty)
+*/
+static int_range
+parse_token(const char *p,const char *end)
+{
+    const char *sep = find_separator(p,end,":-1:");
+    if(sep!=end)return parse_range(p,sep,4,end,-1);
+    sep = find_separator(p,end,":1:");
+    if(sep!=end)return parse_range(p,sep,3,end,1);
+    sep = find_separator(p,end,":");
+    if(sep!=end)return parse_range(p,sep,1,end,1);
+    sep = (p<end) ? find_separator(p+1,end,"-"):end;
+    if(sep!=end)return parse_range(p,sep,1,end,0);
+
+    int_range single = {0,1,0};
+    if(scan_integers(p,end,single.first)==1)single.n = 1;
+    return single;
+}
+/*!
+*  append the integers of the line to the list. Returns false if the list would contain more
+*  than n_max integers
+*/
+static bool
+read_integers(text_line const &line,double n_max,std::vector<double> &list)
+{
+    const char *p = line.begin;
+    while(p<line.end){
+        while(p<line.end&&is_delimiter(*p))p++;
+        const char *token = p;
+        while(p<line.end&&!is_delimiter(*p))p++;
+        if(p==token)break;
+        int_range range = parse_token(token,p);
+        if(static_cast<double>(list.size())+static_cast<double>(range.n)>n_max)return false;
+        for(long long i=0;i<range.n;i++)list.push_back(static_cast<double>(range.first+i*range.step));
+    }
+    return true;
+}
+/*!
+*  number of values read from the line by sscanf with the format '%d %g %g %g' (up to 4);
+*  the first of them is returned in value
+*/
+static int
+scan_workspace_header(text_line const &line,long long &value)
+{
+    const char *p = line.begin;
+    bool negative(false);
+    if(p<line.end&&(*p=='+'||*p=='-')){
+        negative = *p=='-';
+        p++;
+    }
+    if(p>=line.end||*p<'0'||*p>'9')return 0;
+    value = 0;
+    while(p<line.end&&*p>='0'&&*p<='9'){
+        if(value<MAX_INTEGER)value = 10*value+(*p-'0');
+        p++;
+    }
+    if(negative)value = -value;
+
+    int count(1);
+    for(;count<4;count++){
+        while(p<line.end&&(*p==' '||*p=='\t'||*p=='\r'))p++;
+        double dummy;
+        const char *next = parse_double(p,line.end,dummy);
+        if(next==p)break;
+        p = next;
+    }
+    return count;
+}
+static std::string
+workspace_error(const char *message,double workspace)
+{
+    std::stringstream buf;
+    buf<<message<<workspace;
+    return buf.str();
+}
+
+void
+parse_map(const char *p,const char *end,map_file_data &map)
+{
+    if(p>=end)throw ascii_file_error("Data file is empty");
+    map.ns.clear();
+    map.s.clear();
+    map.wkno.clear();
+
+    text_line line;
+    size_t nw(0);
+    // the number of workspaces
+    while(next_line(p,end,line)){
+        if(line.empty())continue;
+        std::vector<double> values;
+        read_integers(line,MAX_MASKED_SPECTRA,values);
+        if(values.empty())continue;
+        if(values.size()>1)throw ascii_file_error("Check format of map file");
+        if(values[0]<1)throw ascii_file_error("Check number of workspaces declared in first non-comment line");
+        nw = static_cast<size_t>(values[0]);
+        break;
+    }
+    if(nw==0)throw ascii_file_error("Check number of workspaces declared in first non-comment line");
+    map.ns.assign(nw,0.);
+    map.wkno.assign(nw,0.);
+
+    bool   vms_format(false),format_known(false);
+    bool   ns_read(false);     // the number of spectra of the current workspace has been read
+    bool   have_line(false);   // the line has been read but not processed yet
+    size_t iw(0);              // current workspace (from 0)
+    double nrem(0);            // spectra remaining to read for the current workspace
+    for(;;){
+        if(!have_line){
+            if(!next_line(p,end,line))break;
+            have_line = true;
+        }
+        if(ns_read&&map.ns[iw]==0){ // workspace without spectra: the line belongs to the next one
+            iw++;
+            ns_read = false;
+            continue;
+        }
+        have_line = false;
+        if(line.empty())continue;
+        if(ns_read){
+            const size_t n_read = map.s.size();
+            if(!read_integers(line,static_cast<double>(n_read)+nrem,map.s)){
+                throw ascii_file_error(workspace_error("Check number of spectra declared for workspace ",map.wkno[iw]));
+            }
+            nrem -= static_cast<double>(map.s.size()-n_read);
+            if(nrem==0){
+                iw++;
+                ns_read = false;
+            }
+            continue;
+        }
+        long long value(0);
+        int count = scan_workspace_header(line,value);
+        if(count==0)continue;
+        if(!format_known){
+            if(count==1){
+                vms_format = false;
+            }else if(count==4){
+                vms_format = true;
+            }else{
+                throw ascii_file_error("Check format of .map file");
+            }
+            format_known = true;
+        }
+        if(iw>=nw)throw ascii_file_error("Check format of .map file: excess uncommented information at bottom of file");
+        if(!vms_format&&map.wkno[iw]==0){
+            if(value<=0)throw ascii_file_error("Workspace number must be greater or equal to 1");
+            map.wkno[iw] = static_cast<double>(value);
+            continue;
+        }
+        if(vms_format)map.wkno[iw] = static_cast<double>(iw+1);
+        if(value<0)throw ascii_file_error(workspace_error("Check number of spectra declared for workspace ",map.wkno[iw]));
+        map.ns[iw] = static_cast<double>(value);
+        nrem       = map.ns[iw];
+        ns_read    = true;
+    }
+    // the last workspace may have no spectra
+    if(ns_read&&map.ns[iw]==0&&iw+1==nw){
+        iw++;
+        ns_read = false;
+    }
+    if(iw<nw){
+        std::stringstream buf;
+        if(ns_read){
+            buf<<"Not all spectra are present for workspace number "<<map.wkno[iw];
+        }else{
+            buf<<"File contains data only up to workspace "<<iw<<" of "<<nw;
+        }
+        throw ascii_file_error(buf.str());
+    }
+    if(vms_format)std::fill(map.wkno.begin(),map.wkno.end(),0.);
+}
+
+void
+parse_mask(const char *p,const char *end,std::vector<double> &msk)
+{
+    if(p>=end)throw ascii_file_error("Data file is empty");
+    msk.clear();
+    text_line line;
+    while(next_line(p,end,line)){
+        if(line.empty())continue;
+        if(!read_integers(line,MAX_MASKED_SPECTRA,msk)){
+            throw ascii_file_error("More than 100000000 masked spectra encountered - probably a syntax error in the file");
+        }
+    }
+}
+/*!
+*  the contents of the file; mapped into memory or, if it can not be mapped, read into text
+*/
+static void
+read_text(std::string const &fileName,mapped_file &mapping,std::string &text,const char *&begin,const char *&end)
+{
+    if(mapping.open(fileName)){
+        begin = mapping.data();
+        end   = begin+mapping.size();
+        return;
+    }
+    std::ifstream stream(fileName.c_str(),std::ios_base::in|std::ios_base::binary);
+    if(!stream.is_open())throw ascii_file_error("Can not open file: "+fileName);
+    std::stringstream contents;
+    contents<<stream.rdbuf();
+    text  = contents.str();
+    begin = text.data();
+    end   = begin+text.size();
+}
+
+void
+load_map_file(std::string const &fileName,map_file_data &map)
+{
+    mapped_file mapping;
+    std::string text;
+    const char *begin,*end;
+    read_text(fileName,mapping,text,begin,end);
+    parse_map(begin,end,map);
+}
+
+void
+load_mask_file(std::string const &fileName,std::vector<double> &msk)
+{
+    mapped_file mapping;
+    std::string text;
+    const char *begin,*end;
+    read_text(fileName,mapping,text,begin,end);
+    parse_mask(begin,end,msk);
+}
@@ -0,0 +1,31 @@
+#ifndef H_MAP_FILE
+#define H_MAP_FILE
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "get_ascii_file.h"
+/*!
+*   Parsers of ASCII map (.map) and mask (.msk) files, returning the arrays read from these files by
+*   the Matlab functions get_map and get_mask of IX_map and IX_mask.
+*
+*   The data are lists of integers separated by spaces, tabs or commas. An element of a list is an
+*   integer or a range of integers: mmm-nnn (in either direction), mmm:nnn, mmm:1:nnn or mmm:-1:nnn
+*   (Matlab ranges, empty if their direction is wrong). Blank lines are skipped and everything after
+*   the comment symbols ! or % is ignored.
+*   Errors in the format of a file are reported by throwing ascii_file_error.
+*/
+struct map_file_data{
+    std::vector<double> ns;   //> number of spectra in every workspace
+    std::vector<double> s;    //> spectra of all workspaces, concatenated together
+    std::vector<double> wkno; //> workspace numbers; zeros for the old VMS format, which does not hold them
+};
+// parse the text [p,end) of a map file (the current format or the old VMS format)
+void parse_map(const char *p,const char *end,map_file_data &map);
+// parse the text [p,end) of a mask file into the list of masked spectra (in the order of the file)
+void parse_mask(const char *p,const char *end,std::vector<double> &msk);
+// read and parse a map file
+void load_map_file(std::string const &fileName,map_file_data &map);
+// read and parse a mask file
+void load_mask_file(std::string const &fileName,std::vector<double> &msk);
+
+#endif
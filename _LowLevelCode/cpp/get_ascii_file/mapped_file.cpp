@@ -0,0 +1,88 @@
+#include "mapped_file.h"
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+mapped_file::mapped_file():_data(NULL),_size(0),_file(INVALID_HANDLE_VALUE),_mapping(NULL)
+{}
+
+bool
+mapped_file::open(std::string const &fileName)
+{
+    this->close();
+    _file = CreateFileA(fileName.c_str(),GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN,NULL);
+    if(_file==INVALID_HANDLE_VALUE)return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(_file,&fileSize)||fileSize.QuadPart==0){
+        this->close();
+        return false;
+    }
+    _mapping = CreateFileMappingA(_file,NULL,PAGE_READONLY,0,0,NULL);
+    if(_mapping==NULL){
+        this->close();
+        return false;
+    }
+    _data = static_cast<const char *>(MapViewOfFile(_mapping,FILE_MAP_READ,0,0,0));
+    if(_data==NULL){
+        this->close();
+        return false;
+    }
+    _size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void
+mapped_file::close()
+{
+    if(_data)UnmapViewOfFile(_data);
+    if(_mapping)CloseHandle(_mapping);
+    if(_file!=INVALID_HANDLE_VALUE)CloseHandle(_file);
+    _data   = NULL;
+    _size   = 0;
+    _mapping= NULL;
+    _file   = INVALID_HANDLE_VALUE;
+}
+#else
+mapped_file::mapped_file():_data(NULL),_size(0),_fd(-1)
+{}
+
+bool
+mapped_file::open(std::string const &fileName)
+{
+    this->close();
+    _fd = ::open(fileName.c_str(),O_RDONLY);
+    if(_fd<0)return false;
+
+    struct stat fileInfo;
+    if(fstat(_fd,&fileInfo)!=0||fileInfo.st_size==0){
+        this->close();
+        return false;
+    }
+    void *mapping = mmap(NULL,static_cast<size_t>(fileInfo.st_size),PROT_READ,MAP_PRIVATE,_fd,0);
+    if(mapping==MAP_FAILED){
+        this->close();
+        return false;
+    }
+    // the file is read front to back, mostly once
+    madvise(mapping,static_cast<size_t>(fileInfo.st_size),MADV_SEQUENTIAL);
+    _data = static_cast<const char *>(mapping);
+    _size = static_cast<size_t>(fileInfo.st_size);
+    return true;
+}
+
+void
+mapped_file::close()
+{
+    if(_data)munmap(const_cast<char *>(_data),_size);
+    if(_fd>=0)::close(_fd);
+    _data = NULL;
+    _size = 0;
+    _fd   = -1;
+}
+#endif
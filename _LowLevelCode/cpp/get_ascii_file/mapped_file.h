@@ -0,0 +1,39 @@
+#ifndef H_MAPPED_FILE
+#define H_MAPPED_FILE
+#include <string>
+#include <cstddef>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+/*!
+*   Read-only memory mapping of a whole file.
+*
+*   The file contents are available through data() and size() between a successful open
+*   and close (or destruction). The mapping is not copyable.
+*/
+class mapped_file{
+public:
+	mapped_file();
+	~mapped_file(){this->close();}
+	// map the file; returns false if the file can not be opened or mapped (e.g. it is empty)
+	bool open(std::string const &fileName);
+	void close();
+	const char *data()const{return _data;}
+	size_t      size()const{return _size;}
+	bool        is_open()const{return _data!=NULL;}
+private:
+	mapped_file(const mapped_file &);
+	mapped_file &operator=(const mapped_file &);
+
+	const char *_data;
+	size_t      _size;
+#ifdef _WIN32
+	HANDLE _file,_mapping;
+#else
+	int    _fd;
+#endif
+};
+#endif
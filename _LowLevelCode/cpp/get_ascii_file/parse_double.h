@@ -0,0 +1,149 @@
+#ifndef H_PARSE_DOUBLE
+#define H_PARSE_DOUBLE
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+/*!
+*   Decimal text to double conversion for the ASCII data files.
+*
+*   parse_double behaves like std::from_chars(first,last,value) for the general format:
+*   it reads an optionally signed decimal number with optional fraction and exponent
+*   (or nan/inf, in any case) starting exactly at first, never reads past last and
+*   returns the position after the number, or first if there is no number there.
+*   The result is correctly rounded and does not depend on the C locale.
+*
+*   Numbers of up to 15 significant digits with moderate exponents -- everything found in
+*   PAR, PHX and SPE files -- are converted exactly from an integer mantissa and a power of 10.
+*   Longer numbers are passed to a stream imbued with the classic locale.
+*/
+namespace parse_double_detail{
+    // powers of 10 exactly representable as doubles
+    static const double POW10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                   1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    static const uint64_t MAX_EXACT_MANTISSA = uint64_t(1)<<53;
+
+    inline bool
+    matches_nocase(const char *p,const char *last,const char *word)
+    {
+        for(;*word;p++,word++){
+            if(p==last||(*p|0x20)!=*word)return false;
+        }
+        return true;
+    }
+
+    inline double
+    parse_slow(const char *first,const char *last)
+    {
+        std::istringstream in(std::string(first,last));
+        in.imbue(std::locale::classic());
+        double value(0);
+        in>>value;
+        if(in.fail()){ // out of range
+            std::string text(first,last);
+            bool negative = (text[0]=='-');
+            bool tiny     = text.find_first_of("eE")!=std::string::npos&&
+                            text.find('-',text.find_first_of("eE"))!=std::string::npos;
+            value = tiny ? 0.:std::numeric_limits<double>::infinity();
+            if(negative)value = -value;
+        }
+        return value;
+    }
+}
+
+inline const char *
+parse_double(const char *first,const char *last,double &value)
+{
+    using namespace parse_double_detail;
+    const char *p = first;
+
+    bool negative(false);
+    if(p<last&&(*p=='+'||*p=='-')){
+        negative = (*p=='-');
+        p++;
+    }
+    if(matches_nocase(p,last,"nan")){
+        value = std::numeric_limits<double>::quiet_NaN();
+        return p+3;
+    }
+    if(matches_nocase(p,last,"inf")){
+        value = negative ? -std::numeric_limits<double>::infinity():std::numeric_limits<double>::infinity();
+        return matches_nocase(p,last,"infinity") ? p+8:p+3;
+    }
+
+    uint64_t mantissa(0);
+    int  nDigits(0),nSignificant(0),exp10(0);
+    bool truncated(false);  // significant digits have been dropped from the mantissa
+    for(;p<last&&*p>='0'&&*p<='9';p++,nDigits++){
+        if(nSignificant<19){
+            mantissa = mantissa*10+(*p-'0');
+            if(mantissa)nSignificant++;
+        }else{
+            truncated = truncated||*p!='0';
+            exp10++;
+        }
+    }
+    if(p<last&&*p=='.'){
+        for(p++;p<last&&*p>='0'&&*p<='9';p++,nDigits++){
+            if(nSignificant<19){
+                mantissa = mantissa*10+(*p-'0');
+                if(mantissa)nSignificant++;
+                exp10--;
+            }else{
+                truncated = truncated||*p!='0';
+            }
+        }
+    }
+    if(nDigits==0)return first;
+
+    if(p<last&&(*p=='e'||*p=='E')){
+        const char *exp_start = p++;
+        bool exp_negative(false);
+        if(p<last&&(*p=='+'||*p=='-')){
+            exp_negative = (*p=='-');
+            p++;
+        }
+        if(p<last&&*p>='0'&&*p<='9'){
+            int exponent(0);
+            for(;p<last&&*p>='0'&&*p<='9';p++){
+                if(exponent<100000)exponent = exponent*10+(*p-'0');
+            }
+            exp10 += exp_negative ? -exponent:exponent;
+        }else{
+            p = exp_start; // not an exponent, the number ends before 'e'
+        }
+    }
+
+    if(!truncated&&mantissa<=MAX_EXACT_MANTISSA){
+        // exact mantissa and power of 10 give the correctly rounded result
+        double result = static_cast<double>(mantissa);
+        bool exact(true);
+        if(mantissa==0){
+            result = 0.;
+        }else if(exp10<0&&exp10>=-22){
+            result /= POW10[-exp10];
+        }else if(exp10>=0&&exp10<=22){
+            result *= POW10[exp10];
+        }else if(exp10>22&&exp10<=22+15){
+            // move part of the power into the mantissa while it stays exact
+            int shift = exp10-22;
+            if(mantissa<=MAX_EXACT_MANTISSA/static_cast<uint64_t>(POW10[shift])){
+                result *= POW10[shift];
+                result *= POW10[22];
+            }else{
+                exact = false;
+            }
+        }else{
+            exact = false;
+        }
+        if(exact){
+            value = negative ? -result:result;
+            return p;
+        }
+    }
+    value = parse_slow(first,p);
+    return p;
+}
+#endif
@@ -0,0 +1,354 @@
+#include "get_nxspe.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#if H5_VERSION_GE(1,10,2)
+#define NXSPE_READ_CHUNKS // raw chunks can be read by H5Dread_chunk
+#endif
+
+static const double NULL_DATA_LIMIT  = -1.e29;   //> signal below this is the null data of SPE files
+static const size_t CHUNK_BATCH_SIZE = 1<<26;    //> compressed bytes read before they are decompressed
+
+namespace{
+/*! switches off printing of the HDF5 error stack while the reader works, as the errors are thrown */
+class h5_quiet{
+public:
+    h5_quiet(){
+        H5Eget_auto2(H5E_DEFAULT,&_func,&_data);
+        H5Eset_auto2(H5E_DEFAULT,NULL,NULL);
+    }
+    ~h5_quiet(){H5Eset_auto2(H5E_DEFAULT,_func,_data);}
+private:
+    H5E_auto2_t _func;
+    void       *_data;
+};
+/*! HDF5 identifier, closed when it goes out of scope */
+class h5_id{
+public:
+    h5_id(hid_t id,herr_t (*close)(hid_t)):_id(id),_close(close){}
+    ~h5_id(){if(_id>=0)_close(_id);}
+    operator hid_t()const{return _id;}
+private:
+    h5_id(const h5_id &);
+    h5_id &operator=(const h5_id &);
+    hid_t   _id;
+    herr_t (*_close)(hid_t);
+};
+}
+
+/*! convert the null data of the signal block into NaN, zeroing the errors of these points */
+template<class U>
+static inline void
+convert_nulls(U *S,U *ERR,size_t n)
+{
+    for(size_t i=0;i<n;i++){
+        if(S[i]<static_cast<U>(NULL_DATA_LIMIT)){
+            S[i]   = std::numeric_limits<U>::quiet_NaN();
+            ERR[i] = 0;
+        }
+    }
+}
+/*! HDF5 memory type of the output arrays */
+static inline hid_t
+native_type(const double *){return H5T_NATIVE_DOUBLE;}
+static inline hid_t
+native_type(const float *){return H5T_NATIVE_FLOAT;}
+
+nxspe_reader::nxspe_reader():
+_file(-1),_signal(-1),_error(-1),_energy(-1),_n_det(0),_n_en(0)
+{}
+
+void
+nxspe_reader::close()
+{
+    if(_energy>=0)H5Dclose(_energy);
+    if(_error>=0) H5Dclose(_error);
+    if(_signal>=0)H5Dclose(_signal);
+    if(_file>=0)  H5Fclose(_file);
+    _file = _signal = _error = _energy = -1;
+    _n_det = _n_en = 0;
+}
+/*!
+ *  open the file and the signal, error and energy datasets of the NXSPE entry, checking their shapes agree
+*/
+void
+nxspe_reader::open(std::string const &fileName,std::string const &root_folder)
+{
+    h5_quiet quiet;
+    this->close();
+    _fileName = fileName;
+    _file = H5Fopen(fileName.c_str(),H5F_ACC_RDONLY,H5P_DEFAULT);
+    if(_file<0){
+        throw nxspe_error(" Can not open file: "+fileName+" as an HDF5 file\n");
+    }
+    const char *names[] = {"/data/data","/data/error","/data/energy"};
+    hid_t      *ids[]   = {&_signal,&_error,&_energy};
+    for(int i=0;i<3;i++){
+        *ids[i] = H5Dopen2(_file,(root_folder+names[i]).c_str(),H5P_DEFAULT);
+        if(*ids[i]<0){
+            throw nxspe_error(" Can not open dataset: "+root_folder+names[i]+" in file: "+fileName+"\n");
+        }
+    }
+    hsize_t dims[2][2];
+    for(int i=0;i<2;i++){
+        h5_id space(H5Dget_space(*ids[i]),H5Sclose);
+        if(space<0||H5Sget_simple_extent_ndims(space)!=2){
+            throw nxspe_error(" Dataset: "+root_folder+names[i]+" has to be a 2-dimensional array\n");
+        }
+        H5Sget_simple_extent_dims(space,dims[i],NULL);
+    }
+    if(dims[0][0]!=dims[1][0]||dims[0][1]!=dims[1][1]){
+        throw nxspe_error(" Signal and error datasets of file: "+fileName+" have different sizes\n");
+    }
+    _n_det = static_cast<size_t>(dims[0][0]);
+    _n_en  = static_cast<size_t>(dims[0][1]);
+
+    h5_id space(H5Dget_space(_energy),H5Sclose);
+    hsize_t n_bins(0);
+    if(space<0||H5Sget_simple_extent_ndims(space)!=1||H5Sget_simple_extent_dims(space,&n_bins,NULL)<0||n_bins!=_n_en+1){
+        std::stringstream err;
+        err<<" Energy dataset of file: "<<fileName<<" has to contain "<<_n_en+1<<" bin boundaries\n";
+        throw nxspe_error(err.str());
+    }
+}
+void
+nxspe_reader::load_energies(double *en,size_t first_en,size_t n_en)
+{
+    h5_quiet quiet;
+    hsize_t start = first_en,count = n_en+1;
+    h5_id file_space(H5Dget_space(_energy),H5Sclose);
+    h5_id mem_space(H5Screate_simple(1,&count,NULL),H5Sclose);
+    if(H5Sselect_hyperslab(file_space,H5S_SELECT_SET,&start,NULL,&count,NULL)<0||
+       H5Dread(_energy,H5T_NATIVE_DOUBLE,mem_space,file_space,H5P_DEFAULT,en)<0){
+        throw nxspe_error(" Can not read the energy bins of file: "+_fileName+"\n");
+    }
+}
+void
+nxspe_reader::load_data(double *S,double *ERR,size_t first_det,size_t n_det,size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    this->load_values(S,ERR,first_det,n_det,first_en,n_en,n_threads);
+}
+void
+nxspe_reader::load_data(float *S,float *ERR,size_t first_det,size_t n_det,size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    this->load_values(S,ERR,first_det,n_det,first_en,n_en,n_threads);
+}
+template<class U>
+void
+nxspe_reader::load_values(U *S,U *ERR,size_t first_det,size_t n_det,size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    if(first_det+n_det>_n_det||first_en+n_en>_n_en){
+        std::stringstream err;
+        err<<" requested detectors "<<first_det+1<<":"<<first_det+n_det<<" and energy bins "<<first_en+1<<":"<<first_en+n_en
+           <<" but the file contains "<<_n_det<<" detectors and "<<_n_en<<" energy bins\n";
+        throw nxspe_error(err.str());
+    }
+    if(n_det==0||n_en==0)return;
+    h5_quiet quiet;
+    // errors first, so the null signal can zero them as it is read
+    this->read_dataset<U>(_error, "errors",ERR,NULL,first_det,n_det,first_en,n_en,n_threads);
+    this->read_dataset(_signal,"signal",S,  ERR, first_det,n_det,first_en,n_en,n_threads);
+}
+
+#ifdef NXSPE_READ_CHUNKS
+//------------------------------------------------------------------------------------------------------------
+// Parallel decompression of chunks
+//------------------------------------------------------------------------------------------------------------
+namespace{
+/*! storage of a chunked dataset, which raw chunks can be decoded here */
+struct chunk_layout{
+    hsize_t  chunk[2];
+    size_t   type_size;          //> 4 or 8 -- native float or double
+    int      filters[8];
+    int      n_filters;
+};
+/*! a raw chunk read from the file */
+struct raw_chunk{
+    hsize_t                    offset[2];
+    uint32_t                   filter_mask;
+    std::vector<unsigned char> bytes;
+};
+}
+/*! identify if the chunks of the dataset can be decoded here: native floating point, deflate and shuffle filters only */
+static bool
+get_chunk_layout(hid_t dataset,chunk_layout &layout)
+{
+    h5_id plist(H5Dget_create_plist(dataset),H5Pclose);
+    if(plist<0||H5Pget_layout(plist)!=H5D_CHUNKED)return false;
+    if(H5Pget_chunk(plist,2,layout.chunk)!=2)return false;
+
+    h5_id type(H5Dget_type(dataset),H5Tclose);
+    if(H5Tequal(type,H5T_NATIVE_DOUBLE)>0){
+        layout.type_size = sizeof(double);
+    }else if(H5Tequal(type,H5T_NATIVE_FLOAT)>0){
+        layout.type_size = sizeof(float);
+    }else{
+        return false;
+    }
+    layout.n_filters = H5Pget_nfilters(plist);
+    if(layout.n_filters<0||layout.n_filters>8)return false;
+    for(int i=0;i<layout.n_filters;i++){
+        unsigned int flags,values[8];
+        size_t       n_values = 8;
+        layout.filters[i] = H5Pget_filter2(plist,i,&flags,&n_values,values,0,NULL,NULL);
+        if(layout.filters[i]!=H5Z_FILTER_DEFLATE&&layout.filters[i]!=H5Z_FILTER_SHUFFLE)return false;
+    }
+    return true;
+}
+/*! undo the filters applied to the chunk; returns the decoded chunk (one of the buffers) or NULL on failure */
+static const unsigned char *
+decode_chunk(raw_chunk const &raw,chunk_layout const &layout,std::vector<unsigned char> &buf1,
+             std::vector<unsigned char> &buf2,std::string &error)
+{
+    const size_t n_elements  = static_cast<size_t>(layout.chunk[0]*layout.chunk[1]);
+    const size_t chunk_bytes = n_elements*layout.type_size;
+    const unsigned char *data = raw.bytes.data();
+    size_t               size = raw.bytes.size();
+    for(int i=layout.n_filters-1;i>=0;i--){
+        if(raw.filter_mask&(1u<<i))continue;    // the filter has been skipped for this chunk
+        std::vector<unsigned char> &out = (data==buf1.data()) ? buf2:buf1;
+        out.resize(chunk_bytes);
+        if(layout.filters[i]==H5Z_FILTER_DEFLATE){
+            uLongf out_size = static_cast<uLongf>(chunk_bytes);
+            if(uncompress(out.data(),&out_size,data,static_cast<uLong>(size))!=Z_OK||out_size!=chunk_bytes){
+                error = " can not decompress a chunk of the dataset";
+                return NULL;
+            }
+        }else{                                  // shuffle: the bytes of element j are type_size planes apart
+            if(size!=chunk_bytes){
+                error = " wrong size of a shuffled chunk of the dataset";
+                return NULL;
+            }
+            for(size_t b=0;b<layout.type_size;b++){
+                const unsigned char *plane = data+b*n_elements;
+                for(size_t j=0;j<n_elements;j++)out[j*layout.type_size+b] = plane[j];
+            }
+        }
+        data = out.data();
+        size = chunk_bytes;
+    }
+    if(size!=chunk_bytes){
+        error = " wrong size of a chunk of the dataset";
+        return NULL;
+    }
+    return data;
+}
+/*! copy the part of the decoded chunk inside of the selection into the (n_en,n_det) array */
+template<class T,class U>
+static void
+copy_chunk(const T *chunk,chunk_layout const &layout,hsize_t const offset[2],size_t first_det,size_t n_det,
+           size_t first_en,size_t n_en,U *data,U *ERR)
+{
+    const size_t det0 = std::max<size_t>(first_det,offset[0]);
+    const size_t det1 = std::min<size_t>(first_det+n_det,offset[0]+layout.chunk[0]);
+    const size_t en0  = std::max<size_t>(first_en,offset[1]);
+    const size_t en1  = std::min<size_t>(first_en+n_en,offset[1]+layout.chunk[1]);
+    for(size_t det=det0;det<det1;det++){
+        const T *row = chunk+(det-offset[0])*layout.chunk[1]+(en0-offset[1]);
+        U       *out = data+(det-first_det)*n_en+(en0-first_en);
+        for(size_t i=0;i<en1-en0;i++)out[i] = static_cast<U>(row[i]);
+        if(ERR)convert_nulls(out,ERR+(out-data),en1-en0);
+    }
+}
+/*!
+ *  read the chunks covering the selection in batches: the calling thread reads the raw chunks of a batch
+ *  and they are decoded and copied into the output on n_threads threads.
+ *  Returns false if a chunk is not allocated in the file (holds the fill value), so the dataset has to be
+ *  read by the library
+*/
+template<class U>
+static bool
+read_chunks(hid_t dataset,chunk_layout const &layout,U *data,U *ERR,size_t first_det,size_t n_det,
+            size_t first_en,size_t n_en,unsigned int n_threads)
+{
+    const hsize_t det_chunk0 = first_det/layout.chunk[0],det_chunk1 = (first_det+n_det-1)/layout.chunk[0]+1;
+    const hsize_t en_chunk0  = first_en/layout.chunk[1], en_chunk1  = (first_en+n_en-1)/layout.chunk[1]+1;
+    const size_t  n_chunks   = static_cast<size_t>((det_chunk1-det_chunk0)*(en_chunk1-en_chunk0));
+    if(n_threads==0)n_threads = std::thread::hardware_concurrency();
+    if(n_threads>n_chunks)n_threads = static_cast<unsigned int>(n_chunks);
+    if(n_threads<1)n_threads = 1;
+
+    std::vector<raw_chunk> batch;
+    size_t next_chunk(0);
+    while(next_chunk<n_chunks){
+        size_t batch_bytes(0);
+        batch.clear();
+        for(;next_chunk<n_chunks&&batch_bytes<CHUNK_BATCH_SIZE;next_chunk++){
+            batch.push_back(raw_chunk());
+            raw_chunk &chunk = batch.back();
+            chunk.offset[0] = (det_chunk0+next_chunk/(en_chunk1-en_chunk0))*layout.chunk[0];
+            chunk.offset[1] = (en_chunk0 +next_chunk%(en_chunk1-en_chunk0))*layout.chunk[1];
+            hsize_t size(0);
+            if(H5Dget_chunk_storage_size(dataset,chunk.offset,&size)<0||size==0)return false;
+            chunk.bytes.resize(static_cast<size_t>(size));
+            if(H5Dread_chunk(dataset,H5P_DEFAULT,chunk.offset,&chunk.filter_mask,chunk.bytes.data())<0){
+                throw nxspe_error(" can not read a chunk of the dataset");
+            }
+            batch_bytes += chunk.bytes.size();
+        }
+
+        std::atomic<size_t>      next_job(0);
+        std::vector<std::string> errors(n_threads);
+        auto decode = [&](unsigned int thread){
+            std::vector<unsigned char> buf1,buf2;
+            for(size_t i=next_job++;i<batch.size();i=next_job++){
+                const unsigned char *chunk = decode_chunk(batch[i],layout,buf1,buf2,errors[thread]);
+                if(!chunk)return;
+                if(layout.type_size==sizeof(double)){
+                    copy_chunk(reinterpret_cast<const double *>(chunk),layout,batch[i].offset,first_det,n_det,first_en,n_en,data,ERR);
+                }else{
+                    copy_chunk(reinterpret_cast<const float *>(chunk),layout,batch[i].offset,first_det,n_det,first_en,n_en,data,ERR);
+                }
+            }
+        };
+        const unsigned int n_workers = std::min<unsigned int>(n_threads,static_cast<unsigned int>(batch.size()));
+        std::vector<std::thread> workers;
+        for(unsigned int thread=1;thread<n_workers;thread++){
+            workers.push_back(std::thread(decode,thread));
+        }
+        decode(0);
+        for(size_t i=0;i<workers.size();i++)workers[i].join();
+        for(unsigned int thread=0;thread<n_threads;thread++){
+            if(!errors[thread].empty())throw nxspe_error(errors[thread]);
+        }
+    }
+    return true;
+}
+#endif
+
+/*!
+ *  read the (n_en,n_det) block of the dataset; if ERR is not NULL, the dataset is the signal and its null
+ *  data are converted, zeroing the errors at the same points
+*/
+template<class U>
+void
+nxspe_reader::read_dataset(hid_t dataset,const char *name,U *data,U *ERR,size_t first_det,size_t n_det,
+                           size_t first_en,size_t n_en,unsigned int n_threads)
+{
+#ifdef NXSPE_READ_CHUNKS
+    chunk_layout layout;
+    if(get_chunk_layout(dataset,layout)){
+        try{
+            if(read_chunks(dataset,layout,data,ERR,first_det,n_det,first_en,n_en,n_threads))return;
+        }catch(const nxspe_error &err){
+            throw nxspe_error(std::string(err.what())+" of "+name+" in file: "+_fileName+"\n");
+        }
+    }
+#endif
+    hsize_t start[2] = {first_det,first_en};
+    hsize_t count[2] = {n_det,n_en};
+    h5_id file_space(H5Dget_space(dataset),H5Sclose);
+    h5_id mem_space(H5Screate_simple(2,count,NULL),H5Sclose);
+    if(H5Sselect_hyperslab(file_space,H5S_SELECT_SET,start,NULL,count,NULL)<0||
+       H5Dread(dataset,native_type(data),mem_space,file_space,H5P_DEFAULT,data)<0){
+        throw nxspe_error(std::string(" Can not read the ")+name+" of file: "+_fileName+"\n");
+    }
+    if(ERR)convert_nulls(data,ERR,n_det*n_en);
+}
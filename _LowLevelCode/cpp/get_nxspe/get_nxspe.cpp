@@ -0,0 +1,140 @@
+// get_nxspe.cpp : Defines the exported functions for the DLL application.
+//
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mex.h>
+#include "get_nxspe.h"
+#include "../utility/mx_range.h"
+#include "../utility/version.h"
+/*! \file get_nxspe.cpp
+*
+*  \brief     [S,ERR,en] = get_nxspe(fileName,root_folder,[keys]) function reads the signal, error and
+*             energy bins of an NXSPE file
+*
+* usage:
+*\code
+* [S,ERR,en] = get_nxspe(fileName,root_folder,['-detectors',[first,last]],['-energies',[first,last]],['-single'])
+*
+* input arguments:
+*	file_name   -- a string which specifies the name of the NXSPE file
+*	root_folder -- the name of the NXSPE entry in the file, e.g. '/11014.spe'
+*	'-detectors',[first,last] -- optional key and range. Load only detectors first:last
+*	'-energies',[first,last]  -- optional key and range. Load only energy bins first:last;
+*	             en contains the last-first+2 boundaries of these bins
+*	'-single'   -- optional key. Return the signal and error as single precision arrays, converting
+*	             the values while they are read, so no double precision copy of the data is created
+*
+* output parameters:
+*	S(ne,ndet)    signal; ndet=no. detectors, ne=no. energy bins. Values below -1e29 (null data) are NaN
+*	ERR(ne,ndet)  errors; 0 where the signal is null data
+*	en(ne+1,1)    energy bin boundaries
+*
+* Only the detectors and energy bins requested are read from the file. Compressed chunks of the datasets
+* are decompressed on all hardware threads.
+*/
+
+enum inputs{
+    iFileName,
+    iRootFolder,
+    iNumInputs
+};
+enum outputs{
+    iSignal,
+    iError,
+    iEnergies,
+    iNumOutputs
+};
+static const char DETECTORS_OPTION[] = "-detectors";
+static const char ENERGIES_OPTION[]  = "-energies";
+static const char SINGLE_OPTION[]    = "-single";
+
+/*! create the (n_en,n_det) signal or error array of the class requested */
+static mxArray *
+create_data_array(size_t n_en,size_t n_det,bool single_precision)
+{
+    if(single_precision){
+        return mxCreateNumericMatrix(n_en,n_det,mxSINGLE_CLASS,mxREAL);
+    }
+    return mxCreateDoubleMatrix(n_en,n_det,mxREAL);
+}
+
+/*! \brief interface function between the code and Matlab */
+void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
+  std::stringstream buf;  // buffer to report errors;
+  std::string fileName,rootFolder;
+  data_range  detectors,energies;
+  bool        single_precision(false);
+
+  if (nrhs == 0 && (nlhs == 0 || nlhs == 1)) {
+        plhs[0] = mxCreateString(Herbert::VERSION);
+        return;
+  }
+  if(nlhs>iNumOutputs){
+      buf<<"function returns up to three output parameters but "<<(short)nlhs<<" are requested\n"; goto error;
+  }
+  if(nrhs<iNumInputs){
+      buf<<"function needs a file name and the NXSPE root folder but got "<<(short)nrhs<<" input arguments\n"; goto error;
+  }
+  if(!get_mx_string(prhs[iFileName],fileName)){
+      buf<<"first parameter has to be a scalar string, which specify a filename\n"; goto error;
+  }
+  if(!get_mx_string(prhs[iRootFolder],rootFolder)){
+      buf<<"second parameter has to be a scalar string, which specify the NXSPE root folder\n"; goto error;
+  }
+  for(int i=iNumInputs;i<nrhs;i++){
+      std::string key;
+      if(!get_mx_string(prhs[i],key)||(key!=DETECTORS_OPTION&&key!=ENERGIES_OPTION&&key!=SINGLE_OPTION)){
+          buf<<"parameter N"<<i+1<<" has to be one of the keys: "<<DETECTORS_OPTION<<", "<<ENERGIES_OPTION
+             <<" or "<<SINGLE_OPTION<<std::endl; goto error;
+      }
+      if(key==SINGLE_OPTION){
+          single_precision = true;
+          continue;
+      }
+      data_range &range = (key==DETECTORS_OPTION) ? detectors:energies;
+      if(i+1>=nrhs||!get_mx_range(prhs[i+1],range)){
+          buf<<"key "<<key<<" has to be followed by the range [first,last] with 1<=first<=last\n";  goto error;
+      }
+      i++;
+  }
+
+  try{
+      nxspe_reader reader;
+      reader.open(fileName,rootFolder);
+      const size_t NDET = reader.n_detectors();
+      const size_t NE   = reader.n_energies();
+      if((detectors.defined&&detectors.last>NDET)||(energies.defined&&energies.last>NE)){
+          buf<<" requested detectors "<<detectors.start(NDET)+1<<":"<<detectors.start(NDET)+detectors.size(NDET)
+             <<" and energy bins "<<energies.start(NE)+1<<":"<<energies.start(NE)+energies.size(NE)
+             <<" but the file contains "<<NDET<<" detectors and "<<NE<<" energy bins\n"; goto error;
+      }
+      const size_t n_det = detectors.size(NDET);
+      const size_t n_en  = energies.size(NE);
+      plhs[iSignal] = create_data_array(n_en,n_det,single_precision);
+      mxArray *pError = create_data_array(n_en,n_det,single_precision);
+      if(single_precision){
+          reader.load_data(static_cast<float *>(mxGetData(plhs[iSignal])),static_cast<float *>(mxGetData(pError)),
+                           detectors.start(NDET),n_det,energies.start(NE),n_en);
+      }else{
+          reader.load_data(mxGetPr(plhs[iSignal]),mxGetPr(pError),detectors.start(NDET),n_det,energies.start(NE),n_en);
+      }
+      if(nlhs>iError){
+          plhs[iError] = pError;
+      }else{
+          mxDestroyArray(pError);
+      }
+      if(nlhs>iEnergies){
+          plhs[iEnergies] = mxCreateDoubleMatrix(n_en+1,1,mxREAL);
+          reader.load_energies(mxGetPr(plhs[iEnergies]),energies.start(NE),n_en);
+      }
+  }catch(const std::exception &Error){
+      buf<<Error.what()<<std::endl;  goto error;
+  }
+  return;
+error:
+  std::string err_msg("-->ERROR:: ");
+  err_msg.append(buf.str());
+
+  mexErrMsgTxt(err_msg.c_str());
+}
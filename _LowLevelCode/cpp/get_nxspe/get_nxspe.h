@@ -0,0 +1,56 @@
+#ifndef H_GET_NXSPE
+#define H_GET_NXSPE
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <hdf5.h>
+
+/*!
+*   Error in the structure or contents of an NXSPE file
+*/
+class nxspe_error: public std::runtime_error{
+public:
+    explicit nxspe_error(std::string const &message):std::runtime_error(message){}
+};
+
+/*!
+*   Reader of the signal, error and energy bins of an NXSPE file.
+*
+*   The datasets are read through hyperslab selections of the detectors and energy bins requested.
+*   Chunked datasets compressed by the deflate (and shuffle) filters have their raw chunks read by
+*   the calling thread and decompressed on n_threads threads (0 -- all hardware threads); other
+*   layouts are read by the HDF5 library. A single reader is not thread-safe.
+*   Errors are reported by throwing nxspe_error.
+*/
+class nxspe_reader{
+public:
+    nxspe_reader();
+    ~nxspe_reader(){this->close();}
+    // open the file and the datasets of the NXSPE entry root_folder (e.g. "/11014.spe")
+    void open(std::string const &fileName,std::string const &root_folder);
+    size_t n_detectors()const{return _n_det;}
+    size_t n_energies()const{return _n_en;}
+    // load the boundaries of energy bins [first_en,first_en+n_en), i.e. n_en+1 values
+    void load_energies(double *en,size_t first_en,size_t n_en);
+    /* load signal and error of detectors [first_det,first_det+n_det) and energy bins [first_en,first_en+n_en)
+       as (n_en,n_det) arrays. Signal below -1e29 (the null data of SPE files) is set to NaN and its error to 0 */
+    void load_data(double *S,double *ERR,size_t first_det,size_t n_det,size_t first_en,size_t n_en,unsigned int n_threads=0);
+    // the same, converting the values into single precision while they are read
+    void load_data(float *S,float *ERR,size_t first_det,size_t n_det,size_t first_en,size_t n_en,unsigned int n_threads=0);
+    void close();
+private:
+    nxspe_reader(const nxspe_reader &);
+    nxspe_reader &operator=(const nxspe_reader &);
+
+    template<class U>
+    void load_values(U *S,U *ERR,size_t first_det,size_t n_det,size_t first_en,size_t n_en,unsigned int n_threads);
+    template<class U>
+    void read_dataset(hid_t dataset,const char *name,U *data,U *ERR,size_t first_det,size_t n_det,
+                      size_t first_en,size_t n_en,unsigned int n_threads);
+
+    std::string _fileName;
+    hid_t       _file,_signal,_error,_energy;
+    size_t      _n_det,_n_en;
+};
+
+#endif
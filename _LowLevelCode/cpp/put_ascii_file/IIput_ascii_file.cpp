@@ -0,0 +1,261 @@
+#include "put_ascii_file.h"
+#include "format_double.h"
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+static const double SPE_BIG_DATA        = 1.e30;  //> larger values do not fit the SPE field
+static const double SPE_SMALL_DATA      = 1.e-30; //> smaller values are written as 0
+static const int    SPE_VALUES_PER_LINE = 8;
+static const int    SPE_FIELD_WIDTH     = 10;
+static const size_t CHUNK_TEXT_SIZE     = 1<<20;  //> text a thread formats before it is written
+
+/*! Matlab fprintf writes non-finite values as NaN, Inf or -Inf whatever the numeric format is */
+static char *
+format_non_finite(double value,char *out)
+{
+    const char *text = std::isnan(value) ? "NaN":(value<0 ? "-Inf":"Inf");
+    size_t n = strlen(text);
+    memcpy(out,text,n);
+    return out+n;
+}
+/*! value in the field of the printf format %[-]<width>.<precision>G (or g) */
+static inline char *
+field_g(double value,int width,int precision,bool left,bool upper_case,char *out)
+{
+    char text[64];
+    char *end = std::isfinite(value) ? format_g(value,precision,text,upper_case):format_non_finite(value,text);
+    return pad_field(text,end,width,left,out);
+}
+/*! value in the field of the printf format %<width>.<decimals>f */
+static inline char *
+field_f(double value,int width,int decimals,char *out)
+{
+    char text[64];
+    char *end = std::isfinite(value) ? format_f(value,decimals,text):format_non_finite(value,text);
+    return pad_field(text,end,width,false,out);
+}
+/*! value in the field of the printf format %[-]<width>d */
+static inline char *
+field_d(long long value,int width,bool left,char *out)
+{
+    char text[32];
+    char *end = format_d(value,text);
+    return pad_field(text,end,width,left,out);
+}
+/*!
+*  append n values in the SPE format of write_spe_: lines of 8 %-10.4G fields, the last line ended
+*  even if it is not full. If clamp is true, the values are limited to the range the format can hold
+*/
+static void
+append_spe_values(const double *values,size_t n,bool clamp,std::string &text)
+{
+    char line[SPE_VALUES_PER_LINE*64+1];
+    for(size_t i=0;i<n;i+=SPE_VALUES_PER_LINE){
+        const size_t last = std::min(i+SPE_VALUES_PER_LINE,n);
+        char *p = line;
+        for(size_t j=i;j<last;j++){
+            double value = values[j];
+            if(clamp){
+                if(value>SPE_BIG_DATA)value = SPE_BIG_DATA;
+                if(std::fabs(value)<SPE_SMALL_DATA)value = 0;
+            }
+            p = field_g(value,SPE_FIELD_WIDTH,4,true,true,p);
+        }
+        *p++ = '\n';
+        text.append(line,p-line);
+    }
+}
+/*!
+*  format items [0,n_items) in chunks of chunk_size items by format_chunk(first,last,text) on n_threads
+*  threads (0 -- number of hardware threads) and write the text of the chunks to the stream in order
+*/
+static void
+write_chunks(std::ostream &out,size_t n_items,size_t chunk_size,
+             std::function<void(size_t,size_t,std::string &)> const &format_chunk,unsigned int n_threads)
+{
+    const size_t n_chunks = (n_items+chunk_size-1)/chunk_size;
+    if(n_threads==0)n_threads = std::thread::hardware_concurrency();
+    if(n_threads>n_chunks)n_threads = static_cast<unsigned int>(n_chunks);
+    if(n_threads<1)n_threads = 1;
+
+    std::vector<std::string>        texts(n_threads);
+    std::vector<std::exception_ptr> errors(n_threads);
+    for(size_t round_start=0;round_start<n_chunks;round_start+=n_threads){
+        const unsigned int n_round = static_cast<unsigned int>(std::min<size_t>(n_threads,n_chunks-round_start));
+        auto format = [&](unsigned int i){
+            try{
+                size_t first = (round_start+i)*chunk_size;
+                texts[i].clear();
+                format_chunk(first,std::min(first+chunk_size,n_items),texts[i]);
+            }catch(...){
+                errors[i] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> workers;
+        for(unsigned int i=1;i<n_round;i++){
+            workers.push_back(std::thread(format,i));
+        }
+        format(0);
+        for(size_t i=0;i<workers.size();i++)workers[i].join();
+        for(unsigned int i=0;i<n_round;i++){
+            if(errors[i])std::rethrow_exception(errors[i]);
+            out.write(texts[i].data(),texts[i].size());
+        }
+    }
+}
+/*! open the file for writing in text mode, as Matlab fopen(file,'wt') does */
+static void
+open_output(std::ofstream &out,std::string const &fileName)
+{
+    out.open(fileName.c_str());
+    if(!out.is_open()){
+        throw ascii_write_error("can not open file: "+fileName+" for writing\n");
+    }
+}
+static void
+close_output(std::ofstream &out,std::string const &fileName)
+{
+    out.close();
+    if(out.fail()){
+        throw ascii_write_error("error writing file: "+fileName+"\n");
+    }
+}
+/*! check the group numbers are integers, as they are written by %d format */
+static void
+check_groups(const double *data,size_t n_columns,size_t ndet)
+{
+    for(size_t j=0;j<ndet;j++){
+        double group = data[j*n_columns+n_columns-1];
+        if(!(std::fabs(group)<9.e15)||group!=std::floor(group)){
+            std::stringstream err;
+            err<<"detector group has to be an integer but for detector N "<<j+1<<" it is "<<group<<std::endl;
+            throw ascii_write_error(err.str());
+        }
+    }
+}
+
+/*!
+*  write SPE file in the format of write_spe_: the numbers of detectors and energy bins, the
+*  (unused) phi grid, the energy grid rounded to 1e-5 and the signal and error blocks of every detector
+*/
+void
+write_spe(std::string const &fileName,const double *S,const double *ERR,const double *en,
+          size_t ne,size_t ndet,unsigned int n_threads)
+{
+    std::ofstream out;
+    open_output(out,fileName);
+
+    std::string text;
+    char line[64];
+    char *p = field_d(static_cast<long long>(ndet),8,true,line);
+    *p++ = ' ';
+    p = field_d(static_cast<long long>(ne),8,true,p);
+    *p++ = ' ';
+    *p++ = '\n';
+    text.append(line,p-line);
+
+    text += "### Phi Grid\n";
+    std::vector<double> grid(ndet+1,0.);
+    append_spe_values(&grid[0],grid.size(),false,text);
+
+    text += "### Energy Grid\n";
+    grid.resize(ne+1);
+    for(size_t i=0;i<=ne;i++){
+        grid[i] = std::round(en[i]*1e5)/1e5;
+    }
+    append_spe_values(&grid[0],grid.size(),false,text);
+    out.write(text.data(),text.size());
+
+    const size_t block_size = 2*(ne*SPE_FIELD_WIDTH+ne/SPE_VALUES_PER_LINE+1)+48;
+    const size_t chunk_size = std::max<size_t>(1,CHUNK_TEXT_SIZE/block_size);
+    auto format_detectors = [&](size_t first,size_t last,std::string &chunk){
+        chunk.reserve((last-first)*block_size);
+        for(size_t j=first;j<last;j++){
+            chunk += "### S(Phi,w) (det N ";
+            char number[32];
+            chunk.append(number,format_d(static_cast<long long>(j+1),number)-number);
+            chunk += ")\n";
+            append_spe_values(S+j*ne,ne,true,chunk);
+            chunk += "### Errors\n";
+            append_spe_values(ERR+j*ne,ne,true,chunk);
+        }
+    };
+    write_chunks(out,ndet,chunk_size,format_detectors,n_threads);
+    close_output(out,fileName);
+}
+/*!
+*  write PAR file in the format of put_parObject: the number of detectors followed by the lines
+*  %10.4f %10.4f %10.4f %10.4f %10.4f %8d
+*/
+void
+write_par(std::string const &fileName,const double *par,size_t ndet,unsigned int n_threads)
+{
+    const size_t N_COLUMNS = 6;
+    check_groups(par,N_COLUMNS,ndet);
+    std::ofstream out;
+    open_output(out,fileName);
+    out<<ndet<<" \n";
+
+    const size_t line_size  = 5*11+9+2;
+    auto format_detectors = [&](size_t first,size_t last,std::string &chunk){
+        chunk.reserve((last-first)*line_size);
+        char line[6*64];
+        for(size_t j=first;j<last;j++){
+            const double *row = par+j*N_COLUMNS;
+            char *p = line;
+            for(size_t i=0;i<5;i++){
+                p = field_f(row[i],10,4,p);
+                *p++ = ' ';
+            }
+            p = field_d(static_cast<long long>(row[5]),8,false,p);
+            *p++ = ' ';
+            *p++ = '\n';
+            chunk.append(line,p-line);
+        }
+    };
+    write_chunks(out,ndet,std::max<size_t>(1,CHUNK_TEXT_SIZE/line_size),format_detectors,n_threads);
+    close_output(out,fileName);
+}
+/*!
+*  write PHX file in the format of put_phxObject: the number of detectors followed by the lines
+*  %5.3g %5.3g %10.4f %10.4f %10.4f %10.4f %8d
+*/
+void
+write_phx(std::string const &fileName,const double *phx,size_t ndet,unsigned int n_threads)
+{
+    const size_t N_COLUMNS = 7;
+    check_groups(phx,N_COLUMNS,ndet);
+    std::ofstream out;
+    open_output(out,fileName);
+    out<<ndet<<" \n";
+
+    const size_t line_size  = 2*6+4*11+9+2;
+    auto format_detectors = [&](size_t first,size_t last,std::string &chunk){
+        chunk.reserve((last-first)*line_size);
+        char line[7*64];
+        for(size_t j=first;j<last;j++){
+            const double *row = phx+j*N_COLUMNS;
+            char *p = line;
+            for(size_t i=0;i<2;i++){
+                p = field_g(row[i],5,3,false,false,p);
+                *p++ = ' ';
+            }
+            for(size_t i=2;i<6;i++){
+                p = field_f(row[i],10,4,p);
+                *p++ = ' ';
+            }
+            p = field_d(static_cast<long long>(row[6]),8,false,p);
+            *p++ = ' ';
+            *p++ = '\n';
+            chunk.append(line,p-line);
+        }
+    };
+    write_chunks(out,ndet,std::max<size_t>(1,CHUNK_TEXT_SIZE/line_size),format_detectors,n_threads);
+    close_output(out,fileName);
+}
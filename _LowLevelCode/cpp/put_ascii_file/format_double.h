@@ -0,0 +1,179 @@
+#ifndef H_FORMAT_DOUBLE
+#define H_FORMAT_DOUBLE
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+/*!
+*   Double to decimal text conversion for the ASCII data files.
+*
+*   format_g and format_f write exactly the text printf("%.<precision>G") and printf("%.<decimals>f")
+*   would, without the locale and format string processing of printf. The digits are obtained
+*   from the value scaled by an exact power of 10; values whose rounding can not be decided this
+*   way (very close to a half, out of the range of the exact powers or not finite) are passed to
+*   snprintf. All functions return the position after the text written, which is not terminated.
+*/
+namespace format_double_detail{
+    static const double FPOW10[] = {1e0,1e1,1e2,1e3,1e4,1e5,1e6,1e7,1e8,1e9,1e10,1e11,
+                                    1e12,1e13,1e14,1e15,1e16,1e17,1e18,1e19,1e20,1e21,1e22};
+    static const int    MAX_POW10 = 22;
+    // values scaled to integers above this are not exact enough to round
+    static const double MAX_SCALED = 4503599627370496.; // 2^52
+
+    inline char *
+    format_printf(char *out,const char *format,int precision,double value)
+    {
+        char text[64];
+        int n = snprintf(text,sizeof(text),format,precision,value);
+        memcpy(out,text,n);
+        return out+n;
+    }
+    /* scale a by 10^k and round it to an integer. Returns false if the result is not
+       certainly the correctly rounded value */
+    inline bool
+    scale_round(double a,int k,double &rounded,double &scaled)
+    {
+        if(k>MAX_POW10||k<-MAX_POW10)return false;
+        scaled = (k>=0) ? a*FPOW10[k]:a/FPOW10[-k];
+        if(scaled>=MAX_SCALED)return false;
+        rounded = std::floor(scaled+0.5);
+        // the scaling error is within a few ulps; ties and near ties are left to printf
+        double distance_to_half = std::fabs(scaled-std::floor(scaled)-0.5);
+        return distance_to_half>scaled*1e-14+1e-300;
+    }
+    // write the decimal digits of integer value n (n < 2^53) to out, returning the end
+    inline char *
+    write_digits(uint64_t n,char *out)
+    {
+        char digits[24];
+        int  nDigits(0);
+        do{
+            digits[nDigits++] = static_cast<char>('0'+n%10);
+            n /= 10;
+        }while(n);
+        while(nDigits)*out++ = digits[--nDigits];
+        return out;
+    }
+}
+
+/*! write value as printf("%.<precision>G"), or "%.<precision>g" if upper_case is false; 1 <= precision <= 15 */
+inline char *
+format_g(double value,int precision,char *out,bool upper_case=true)
+{
+    using namespace format_double_detail;
+    const char *printf_format = upper_case ? "%.*G":"%.*g";
+    if(!std::isfinite(value))return format_printf(out,printf_format,precision,value);
+    if(std::signbit(value))*out++ = '-';
+    const double a = std::fabs(value);
+    if(a==0){
+        *out++ = '0';
+        return out;
+    }
+    // decimal exponent of the value rounded to precision digits
+    int    exp10 = static_cast<int>(std::floor(std::log10(a)));
+    double rounded,scaled;
+    const double lowest  = FPOW10[precision-1];
+    const double highest = FPOW10[precision];
+    for(int attempt=0;;attempt++){
+        if(attempt==3||!scale_round(a,precision-1-exp10,rounded,scaled)){
+            if(std::signbit(value))out--;
+            return format_printf(out,printf_format,precision,value);
+        }
+        if(scaled>=highest){             // log10 has underestimated the exponent
+            exp10++;
+        }else if(rounded<lowest){        // or overestimated it
+            exp10--;
+        }else{
+            break;
+        }
+    }
+    if(rounded>=highest){                // rounding carries into the next digit
+        rounded = lowest;
+        exp10++;
+    }
+    char digits[24];
+    char *digits_end = write_digits(static_cast<uint64_t>(rounded),digits);
+    while(digits_end>digits+1&&digits_end[-1]=='0')digits_end--;   // %G drops trailing zeros
+    const int nDigits = static_cast<int>(digits_end-digits);
+
+    if(exp10<-4||exp10>=precision){      // exponent style
+        *out++ = digits[0];
+        if(nDigits>1){
+            *out++ = '.';
+            memcpy(out,digits+1,nDigits-1);
+            out += nDigits-1;
+        }
+        *out++ = upper_case ? 'E':'e';
+        *out++ = exp10<0 ? '-':'+';
+        int e = exp10<0 ? -exp10:exp10;
+        if(e<10)*out++ = '0';
+        return write_digits(static_cast<uint64_t>(e),out);
+    }
+    if(exp10<0){                         // 0.000ddd
+        *out++ = '0';
+        *out++ = '.';
+        for(int i=0;i<-exp10-1;i++)*out++ = '0';
+        memcpy(out,digits,nDigits);
+        return out+nDigits;
+    }
+    const int nInteger = exp10+1;        // ddd[.ddd]
+    for(int i=0;i<nInteger;i++){
+        *out++ = i<nDigits ? digits[i]:'0';
+    }
+    if(nDigits>nInteger){
+        *out++ = '.';
+        memcpy(out,digits+nInteger,nDigits-nInteger);
+        out += nDigits-nInteger;
+    }
+    return out;
+}
+
+/*! write value as printf("%.<decimals>f"), 0 <= decimals <= 15 */
+inline char *
+format_f(double value,int decimals,char *out)
+{
+    using namespace format_double_detail;
+    double rounded,scaled;
+    if(!std::isfinite(value)||!scale_round(std::fabs(value),decimals,rounded,scaled)){
+        return format_printf(out,"%.*f",decimals,value);
+    }
+    if(std::signbit(value))*out++ = '-';
+    const uint64_t n     = static_cast<uint64_t>(rounded);
+    const uint64_t scale = static_cast<uint64_t>(FPOW10[decimals]);
+    out = write_digits(n/scale,out);
+    if(decimals>0){
+        *out++ = '.';
+        uint64_t fraction = n%scale;
+        for(int i=decimals-1;i>=0;i--){
+            out[i] = static_cast<char>('0'+fraction%10);
+            fraction /= 10;
+        }
+        out += decimals;
+    }
+    return out;
+}
+
+/*! write value as printf("%d") */
+inline char *
+format_d(long long value,char *out)
+{
+    using namespace format_double_detail;
+    if(value<0){
+        *out++ = '-';
+        return write_digits(static_cast<uint64_t>(-(value+1))+1,out);
+    }
+    return write_digits(static_cast<uint64_t>(value),out);
+}
+
+/*! copy the text [first,last) to out in a field of width symbols, aligned to the left or right */
+inline char *
+pad_field(const char *first,const char *last,int width,bool left,char *out)
+{
+    int n = static_cast<int>(last-first);
+    if(!left)for(;n<width;width--)*out++ = ' ';
+    memcpy(out,first,n);
+    out += n;
+    if(left)for(;n<width;width--)*out++ = ' ';
+    return out;
+}
+#endif
@@ -0,0 +1,152 @@
+// put_ascii_file.cpp : Defines the exported functions for the DLL application.
+//
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mex.h>
+#include "put_ascii_file.h"
+#include "../utility/version.h"
+/*! \file put_ascii_file.cpp
+*
+*  \brief     put_ascii_file(fileName,file_type,data...) function writes spe, par or phx ASCII files
+*             in the formats, written by the Matlab functions of Herbert
+*
+* usage:
+*\code
+* put_ascii_file(fileName,'spe',data_S,data_ERR,en)
+* put_ascii_file(fileName,'par',par)
+* put_ascii_file(fileName,'phx',phx)
+*
+* input arguments:
+*	file_name -- a string which specifies the name of the output file. An existing file is overwritten
+*	file_type -- string, defining the file format: spe, par or phx
+*
+*1) SPE file, written as write_spe_ does
+*     data_S(ne,ndet)     signal; ndet=no. detectors, ne=no. energy bins
+*     data_ERR(ne,ndet)   errors
+*     en(ne+1)            energy bin boundaries, written rounded to 1e-5
+*
+*     Signal and error values larger than 1e30 are written as 1e30 and values smaller than 1e-30 by modulo as 0.
+*     NaN values are expected to be replaced by the null data value -1e30 before the call, as put_spe does
+*-----------------------------------------------------------------------
+*2) PAR file, written as put_parObject does
+*     par(6,ndet)         columns of the file: [x2;phi;azim;width;height;group]
+*                         (azim has the sign of the file, reversed relative to the parObject)
+*-----------------------------------------------------------------------
+*3) PHX file, written as put_phxObject does
+*     phx(7,ndet)         columns of the file: [10;0;phi;azim;dphi;danght;group]
+*
+*     The detector groups (the last column) of PAR and PHX files have to be integers
+*-----------------------------------------------------------------------
+*
+* The text of the detector blocks is formatted on all hardware threads and written in order.
+*/
+
+enum inputs{
+    iFileName,
+    iFileType,
+    iData
+};
+enum fileTypes{
+    iPAR_type,
+    iPHX_type,
+    iSPE_type,
+    iNumFileTypes
+};
+static const char *fileTypesAccepted[iNumFileTypes] = {"par","phx","spe"};
+
+/*! get the string from Matlab; false if the array is not a row string */
+static bool
+get_mx_string(const mxArray *pString,std::string &value)
+{
+    if(!mxIsChar(pString)||mxGetM(pString)!=1)return false;
+    std::vector<char> Buf(mxGetN(pString)+1);
+    if(mxGetString(pString,&Buf[0],Buf.size()))return false;
+    value.assign(&Buf[0]);
+    return true;
+}
+/*! check the argument is a real double array */
+static bool
+is_real_double(const mxArray *pArray)
+{
+    return mxIsDouble(pArray)&&!mxIsComplex(pArray)&&!mxIsSparse(pArray);
+}
+
+/*! \brief interface function between the code and Matlab */
+void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
+  std::stringstream buf;  // buffer to report errors;
+  std::string fileName,inputFileType;
+  fileTypes   fileType(iNumFileTypes);
+
+  if (nrhs == 0 && (nlhs == 0 || nlhs == 1)) {
+        plhs[0] = mxCreateString(Herbert::VERSION);
+        return;
+  }
+  if(nlhs>0){
+      buf<<"this function does not return any output parameters\n";                 goto error;
+  }
+  if(nrhs<iData+1){
+      buf<<"function needs a file name, a file type and the data to write, but got "<<(short)nrhs<<" input arguments\n"; goto error;
+  }
+  if(!get_mx_string(prhs[iFileName],fileName)){
+      buf<<"first parameter has to be a scalar string, which specify a filename\n"; goto error;
+  }
+  if(!get_mx_string(prhs[iFileType],inputFileType)){
+      buf<<"second parameter has to be a scalar string, which specify a file type\n"; goto error;
+  }
+  for(int i=0;i<iNumFileTypes;i++){
+      if(inputFileType.compare(fileTypesAccepted[i])==0){
+          fileType=(fileTypes)i;
+          break;
+      }
+  }
+  if(fileType==iNumFileTypes){
+      buf<<"the file type parameter, specified in the program call is: " <<inputFileType<<std::endl;
+      buf<<"---------  it is not among filetypes accepted\n";                           goto error;
+  }
+  for(int i=iData;i<nrhs;i++){
+      if(!is_real_double(prhs[i])){
+          buf<<"parameter N"<<i+1<<" has to be a real double array\n";                 goto error;
+      }
+  }
+
+  try{
+      switch(fileType){
+          case(iSPE_type):{
+              if(nrhs!=iData+3){
+                  buf<<"writing SPE file needs three data arrays: data_S, data_ERR and en\n"; goto error;
+              }
+              const size_t ne   = mxGetM(prhs[iData]);
+              const size_t ndet = mxGetNumberOfElements(prhs[iData])/(ne>0 ? ne:1);
+              if(mxGetM(prhs[iData+1])!=ne||mxGetNumberOfElements(prhs[iData+1])!=ne*ndet){
+                  buf<<"data_ERR has to be the array of the size of data_S ("<<ne<<"x"<<ndet<<")\n"; goto error;
+              }
+              if(mxGetNumberOfElements(prhs[iData+2])!=ne+1){
+                  buf<<"en has to contain "<<ne+1<<" energy bin boundaries but it has "<<mxGetNumberOfElements(prhs[iData+2])<<" elements\n"; goto error;
+              }
+              write_spe(fileName,mxGetPr(prhs[iData]),mxGetPr(prhs[iData+1]),mxGetPr(prhs[iData+2]),ne,ndet);
+              break;
+                          }
+          default:{
+              const size_t nRows = (fileType==iPAR_type) ? 6:7;
+              if(nrhs!=iData+1||mxGetM(prhs[iData])!=nRows){
+                  buf<<"writing "<<inputFileType<<" file needs one ("<<nRows<<",ndet) array of the file columns\n"; goto error;
+              }
+              const size_t ndet = mxGetN(prhs[iData]);
+              if(fileType==iPAR_type){
+                  write_par(fileName,mxGetPr(prhs[iData]),ndet);
+              }else{
+                  write_phx(fileName,mxGetPr(prhs[iData]),ndet);
+              }
+          }
+      }
+  }catch(const std::exception &Error){
+      buf<<Error.what()<<std::endl;  goto error;
+  }
+  return;
+error:
+  std::string err_msg("-->ERROR:: ");
+  err_msg.append(buf.str());
+
+  mexErrMsgTxt(err_msg.c_str());
+}
@@ -0,0 +1,32 @@
+#ifndef H_PUT_ASCII_FILE
+#define H_PUT_ASCII_FILE
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+/*!
+*   Error when writing an ASCII data file
+*/
+class ascii_write_error: public std::runtime_error{
+public:
+    explicit ascii_write_error(std::string const &message):std::runtime_error(message){}
+};
+
+/*!
+*   Writers of SPE, PAR and PHX files, producing the text written by the Matlab functions
+*   write_spe_, put_parObject and put_phxObject.
+*
+*   The text of the detector blocks is formatted on n_threads threads (0 -- choose by the data size)
+*   into memory buffers, which are written to the file in order.
+*   Errors are reported by throwing ascii_write_error.
+*/
+// write SPE file of ndet detectors with ne energy bins; S and ERR are (ne,ndet) arrays, en holds ne+1 bin boundaries.
+// Signal and error values above 1e30 are written as 1e30, and values smaller than 1e-30 by modulo as 0
+void write_spe(std::string const &fileName,const double *S,const double *ERR,const double *en,
+               size_t ne,size_t ndet,unsigned int n_threads=0);
+// write PAR file from (6,ndet) array of rows [x2;phi;azim;width;height;group] as they appear in the file
+void write_par(std::string const &fileName,const double *par,size_t ndet,unsigned int n_threads=0);
+// write PHX file from (7,ndet) array of rows [10;0;phi;azim;dphi;danght;group] as they appear in the file
+void write_phx(std::string const &fileName,const double *phx,size_t ndet,unsigned int n_threads=0);
+
+#endif
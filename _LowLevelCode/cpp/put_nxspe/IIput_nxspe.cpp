@@ -0,0 +1,377 @@
+#include "put_nxspe.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <sstream>
+#include <thread>
+#include <zlib.h>
+
+#if H5_VERSION_GE(1,10,2)
+#define NXSPE_WRITE_CHUNKS // filtered chunks can be written by H5Dwrite_chunk
+#endif
+
+static const size_t CHUNK_BYTES      = 1<<20;    //> default size of a chunk of the signal and error datasets
+static const size_t CHUNK_BATCH_SIZE = 1<<26;    //> bytes of the chunks filtered before they are written
+static const char   NEXUS_VERSION[]  = "4.3.0 "; //> NeXus version written by save_nxspe_internal
+
+namespace{
+/*! switches off printing of the HDF5 error stack while the writer works, as the errors are thrown */
+class h5_quiet{
+public:
+    h5_quiet(){
+        H5Eget_auto2(H5E_DEFAULT,&_func,&_data);
+        H5Eset_auto2(H5E_DEFAULT,NULL,NULL);
+    }
+    ~h5_quiet(){H5Eset_auto2(H5E_DEFAULT,_func,_data);}
+private:
+    H5E_auto2_t _func;
+    void       *_data;
+};
+/*! HDF5 identifier, closed when it goes out of scope */
+class h5_id{
+public:
+    h5_id(hid_t id,herr_t (*close)(hid_t)):_id(id),_close(close){}
+    ~h5_id(){if(_id>=0)_close(_id);}
+    operator hid_t()const{return _id;}
+private:
+    h5_id(const h5_id &);
+    h5_id &operator=(const h5_id &);
+    hid_t   _id;
+    herr_t (*_close)(hid_t);
+};
+/*! a part of the signal or error of a run, written by one call: a chunk or the whole dataset */
+struct write_job{
+    size_t run;
+    int    dataset;     //> 0 -- signal, 1 -- error
+    size_t first_det,n_det;
+    bool   last;        //> the last job of the run, after which its file is closed
+};
+/*! a chunk with the filters applied, as it is stored in the file */
+struct encoded_chunk{
+    uint32_t                   filter_mask;
+    std::vector<unsigned char> bytes;
+};
+}
+
+/*! check the result of an HDF5 call, throwing if it has failed */
+template<class T>
+static T
+checked(T status,const char *what,std::string const &fileName)
+{
+    if(status<0)throw nxspe_write_error(std::string(" Can not write ")+what+" of file: "+fileName+"\n");
+    return status;
+}
+static void
+write_string_attribute(hid_t loc,const char *name,std::string const &value,std::string const &fileName)
+{
+    h5_id type(checked(H5Tcopy(H5T_C_S1),name,fileName),H5Tclose);
+    checked(H5Tset_size(type,std::max<size_t>(value.size(),1)),name,fileName);
+    h5_id space(checked(H5Screate(H5S_SCALAR),name,fileName),H5Sclose);
+    h5_id attr(checked(H5Acreate2(loc,name,type,space,H5P_DEFAULT,H5P_DEFAULT),name,fileName),H5Aclose);
+    checked(H5Awrite(attr,type,value.c_str()),name,fileName);
+}
+/*! create the group with the NX_class attribute */
+static hid_t
+create_group(hid_t loc,const char *name,const char *nx_class,std::string const &fileName)
+{
+    hid_t group = checked(H5Gcreate2(loc,name,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT),name,fileName);
+    try{
+        write_string_attribute(group,"NX_class",nx_class,fileName);
+    }catch(...){
+        H5Gclose(group);
+        throw;
+    }
+    return group;
+}
+/*! string dataset with an attribute, as written by write_string_sign.m */
+static void
+write_string_dataset(hid_t loc,const char *name,std::string const &contents,const char *attr_name,
+                     std::string const &attr_value,std::string const &fileName)
+{
+    const size_t size = std::max<size_t>(contents.size(),1);
+    h5_id file_type(checked(H5Tcopy(H5T_FORTRAN_S1),name,fileName),H5Tclose);
+    checked(H5Tset_size(file_type,size),name,fileName);
+    h5_id mem_type(checked(H5Tcopy(H5T_C_S1),name,fileName),H5Tclose);
+    checked(H5Tset_size(mem_type,size),name,fileName);
+    const hsize_t dims = 1;
+    h5_id space(checked(H5Screate_simple(1,&dims,&dims),name,fileName),H5Sclose);
+    h5_id dataset(checked(H5Dcreate2(loc,name,file_type,space,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT),name,fileName),H5Dclose);
+    std::vector<char> text(contents.begin(),contents.end());
+    text.resize(size,'\0');
+    checked(H5Dwrite(dataset,mem_type,H5S_ALL,H5S_ALL,H5P_DEFAULT,text.data()),name,fileName);
+    write_string_attribute(dataset,attr_name,attr_value,fileName);
+}
+/*! one dimensional dataset of n values of the native type, with the units attribute if units are not NULL */
+static void
+write_vector(hid_t loc,const char *name,hid_t type,const void *values,size_t n,const char *units,
+             std::string const &fileName)
+{
+    const hsize_t dims = n;
+    h5_id space(checked(H5Screate_simple(1,&dims,&dims),name,fileName),H5Sclose);
+    h5_id dataset(checked(H5Dcreate2(loc,name,type,space,H5P_DEFAULT,H5P_DEFAULT,H5P_DEFAULT),name,fileName),H5Dclose);
+    checked(H5Dwrite(dataset,type,H5S_ALL,H5S_ALL,H5P_DEFAULT,values),name,fileName);
+    if(units)write_string_attribute(dataset,"units",units,fileName);
+}
+static std::string
+current_time()
+{
+    std::time_t now = std::time(NULL);
+    char buf[32];
+    std::strftime(buf,sizeof(buf),"%Y-%m-%dT%H:%M:%S+00:00",std::gmtime(&now)); // e.g. 2011-06-23T09:12:44+00:00
+    return buf;
+}
+
+namespace{
+/*!
+*   NXSPE file being written: all its contents are written by create() except the signal and error,
+*   which are written by chunks or as whole datasets before the file is closed
+*/
+class nxspe_file{
+public:
+    nxspe_file():_file(-1),_data(-1){_datasets[0] = _datasets[1] = -1;}
+    ~nxspe_file(){this->release();}
+    bool is_open()const{return _file>=0;}
+    void create(nxspe_run const &run,hsize_t chunk_det,nxspe_write_options const &options);
+    // write the signal (i=0) or error (i=1) dataset from the (ne,ndet) array
+    void write_dataset(int i,const double *values);
+    // write the filtered chunk of the signal or error, which starts at the detector first_det
+    void write_chunk(int i,hsize_t first_det,encoded_chunk const &chunk);
+    void close();
+private:
+    nxspe_file(const nxspe_file &);
+    nxspe_file &operator=(const nxspe_file &);
+    // close the identifiers; returns false if the file has not been closed properly
+    bool release();
+
+    std::string _fileName;
+    hid_t       _file,_data,_datasets[2];
+};
+
+void
+nxspe_file::create(nxspe_run const &run,hsize_t chunk_det,nxspe_write_options const &options)
+{
+    _fileName = run.fileName;
+    _file = checked(H5Fcreate(_fileName.c_str(),H5F_ACC_TRUNC,H5P_DEFAULT,H5P_DEFAULT),"the header",_fileName);
+    // make this file look like real nexus
+    unsigned int v1,v2,v3;
+    H5get_libversion(&v1,&v2,&v3);
+    std::stringstream hdf_version;
+    hdf_version<<v1<<"."<<v2<<"."<<v3;
+    write_string_attribute(_file,"NeXus_version",NEXUS_VERSION,_fileName);
+    write_string_attribute(_file,"file_name",_fileName,_fileName);
+    write_string_attribute(_file,"HDF5_Version",hdf_version.str(),_fileName);
+    write_string_attribute(_file,"file_time",current_time(),_fileName);
+
+    h5_id entry(create_group(_file,run.root_folder.c_str(),"NXentry",_fileName),H5Gclose);
+    write_string_dataset(entry,"definition","NXSPE","version",run.nxspe_version,_fileName);
+    write_string_dataset(entry,"program_name","herbert","version",run.program_version,_fileName);
+    {
+        h5_id info(create_group(entry,"NXSPE_info","NXcollection",_fileName),H5Gclose);
+        write_vector(info,"fixed_energy",H5T_NATIVE_DOUBLE,&run.efix,1,"meV",_fileName);
+        write_vector(info,"psi",H5T_NATIVE_DOUBLE,&run.psi,1,"degrees",_fileName);
+        const int ki_over_kf_scaling = 1;
+        write_vector(info,"ki_over_kf_scaling",H5T_NATIVE_INT,&ki_over_kf_scaling,1,NULL,_fileName);
+    }
+    _data = create_group(entry,"data","NXdata",_fileName);
+    write_vector(_data,"energy",H5T_NATIVE_DOUBLE,run.en,run.ne+1,"meV",_fileName);
+    {
+        const hsize_t dims[2]  = {run.ndet,run.ne};
+        const hsize_t chunk[2] = {chunk_det,run.ne};
+        h5_id space(checked(H5Screate_simple(2,dims,dims),"data",_fileName),H5Sclose);
+        h5_id plist(checked(H5Pcreate(H5P_DATASET_CREATE),"data",_fileName),H5Pclose);
+        checked(H5Pset_chunk(plist,2,chunk),"data",_fileName);
+        if(options.shuffle)checked(H5Pset_shuffle(plist),"data",_fileName);
+        if(options.deflate>0)checked(H5Pset_deflate(plist,options.deflate),"data",_fileName);
+        const char *names[2] = {"data","error"};
+        for(int i=0;i<2;i++){
+            _datasets[i] = checked(H5Dcreate2(_data,names[i],H5T_NATIVE_DOUBLE,space,H5P_DEFAULT,plist,H5P_DEFAULT),
+                                   names[i],_fileName);
+        }
+    }
+    write_vector(_data,"polar",H5T_NATIVE_DOUBLE,run.polar,run.ndet,NULL,_fileName);
+    write_vector(_data,"azimuthal",H5T_NATIVE_DOUBLE,run.azimuthal,run.ndet,NULL,_fileName);
+    write_vector(_data,"distance",H5T_NATIVE_DOUBLE,run.distance,run.ndet,NULL,_fileName);
+    write_vector(_data,"azimuthal_width",H5T_NATIVE_DOUBLE,run.azimuthal_width,run.ndet,NULL,_fileName);
+    write_vector(_data,"polar_width",H5T_NATIVE_DOUBLE,run.polar_width,run.ndet,NULL,_fileName);
+    // other data, typical for NeXus class, placed where save_nxspe_internal places them
+    {
+        h5_id instrument(create_group(entry,"instrument","NXinstrument",_fileName),H5Gclose);
+        write_string_dataset(instrument,"name","NXSPE","short_name","NXS",_fileName);
+        h5_id fermi(create_group(entry,"fermi","NXfermi_chopper",_fileName),H5Gclose);
+        write_vector(instrument,"energy",H5T_NATIVE_DOUBLE,&run.efix,1,NULL,_fileName);
+    }
+    h5_id sample(create_group(entry,"sample","NXsample",_fileName),H5Gclose);
+}
+
+void
+nxspe_file::write_dataset(int i,const double *values)
+{
+    checked(H5Dwrite(_datasets[i],H5T_NATIVE_DOUBLE,H5S_ALL,H5S_ALL,H5P_DEFAULT,values),
+            i==0 ? "data":"error",_fileName);
+}
+
+void
+nxspe_file::write_chunk(int i,hsize_t first_det,encoded_chunk const &chunk)
+{
+#ifdef NXSPE_WRITE_CHUNKS
+    const hsize_t offset[2] = {first_det,0};
+    checked(H5Dwrite_chunk(_datasets[i],H5P_DEFAULT,chunk.filter_mask,offset,chunk.bytes.size(),chunk.bytes.data()),
+            i==0 ? "data":"error",_fileName);
+#else
+    throw nxspe_write_error(" Can not write the raw chunks of file: "+_fileName+"\n");
+#endif
+}
+
+bool
+nxspe_file::release()
+{
+    for(int i=0;i<2;i++){
+        if(_datasets[i]>=0)H5Dclose(_datasets[i]);
+        _datasets[i] = -1;
+    }
+    if(_data>=0)H5Gclose(_data);
+    _data = -1;
+    bool closed(true);
+    if(_file>=0)closed = H5Fclose(_file)>=0;
+    _file = -1;
+    return closed;
+}
+
+void
+nxspe_file::close()
+{
+    if(!this->release())throw nxspe_write_error(" Can not close file: "+_fileName+"\n");
+}
+}
+
+/*!
+ *  apply the filters of the options to the chunk of chunk_values values, n_values of which are given
+ *  (the rest of the edge chunks is zero). Returns false and the message in error if deflate fails
+*/
+static bool
+encode_chunk(const double *values,size_t n_values,size_t chunk_values,nxspe_write_options const &options,
+             encoded_chunk &chunk,std::vector<unsigned char> &buf,std::string &error)
+{
+    const size_t chunk_bytes = chunk_values*sizeof(double);
+    std::vector<unsigned char> &out = chunk.bytes;
+    buf.assign(chunk_bytes,0);
+    std::memcpy(buf.data(),values,n_values*sizeof(double));
+    chunk.filter_mask = 0;
+    if(options.shuffle){    // the bytes of element j are placed chunk_values apart
+        out.resize(chunk_bytes);
+        for(size_t b=0;b<sizeof(double);b++){
+            unsigned char *plane = out.data()+b*chunk_values;
+            for(size_t j=0;j<chunk_values;j++)plane[j] = buf[j*sizeof(double)+b];
+        }
+        buf.swap(out);
+    }
+    if(options.deflate>0){
+        uLongf size = compressBound(static_cast<uLong>(chunk_bytes));
+        out.resize(size);
+        if(compress2(out.data(),&size,buf.data(),static_cast<uLong>(chunk_bytes),options.deflate)!=Z_OK){
+            error = " can not compress a chunk of the dataset";
+            return false;
+        }
+        if(size<chunk_bytes){
+            out.resize(size);
+            return true;
+        }
+        chunk.filter_mask |= 1u<<(options.shuffle ? 1:0); // deflate does not reduce the chunk: skip it
+    }
+    out.swap(buf);
+    return true;
+}
+
+void
+write_nxspe(std::vector<nxspe_run> const &runs,nxspe_write_options const &options,unsigned int n_threads)
+{
+    if(options.deflate<0||options.deflate>9)throw nxspe_write_error(" deflate level has to be from 0 to 9\n");
+    for(size_t i=0;i<runs.size();i++){
+        nxspe_run const &run = runs[i];
+        std::stringstream buf;
+        if(run.fileName.empty()||run.root_folder.empty()){
+            buf<<" run N"<<i+1<<" has no file name or root folder\n";
+        }else if(run.ne==0||run.ndet==0){
+            buf<<" run N"<<i+1<<" has no data to write into file: "<<run.fileName<<"\n";
+        }else if(!run.S||!run.ERR||!run.en||!run.polar||!run.azimuthal||!run.distance||!run.polar_width||!run.azimuthal_width){
+            buf<<" run N"<<i+1<<" does not define all arrays of file: "<<run.fileName<<"\n";
+        }
+        if(!buf.str().empty())throw nxspe_write_error(buf.str());
+    }
+    const size_t target = options.chunk_bytes>0 ? options.chunk_bytes:CHUNK_BYTES;
+#ifdef NXSPE_WRITE_CHUNKS
+    const bool encode_here = options.shuffle||options.deflate>0;
+#else
+    const bool encode_here = false;
+#endif
+    // the jobs: the chunks of the signal and then of the error of every run, or their whole datasets
+    // if there are no filters to apply here
+    std::vector<size_t>    chunk_det(runs.size());
+    std::vector<write_job> jobs;
+    for(size_t r=0;r<runs.size();r++){
+        chunk_det[r] = std::max<size_t>(1,std::min(runs[r].ndet,target/(runs[r].ne*sizeof(double))));
+        for(int d=0;d<2;d++){
+            const size_t step = encode_here ? chunk_det[r]:runs[r].ndet;
+            for(size_t first=0;first<runs[r].ndet;first+=step){
+                write_job job = {r,d,first,std::min(step,runs[r].ndet-first),false};
+                jobs.push_back(job);
+            }
+        }
+        jobs.back().last = true;
+    }
+    if(n_threads==0)n_threads = std::thread::hardware_concurrency();
+    if(n_threads<1)n_threads = 1;
+
+    h5_quiet                   quiet;
+    nxspe_file                 file;
+    std::vector<encoded_chunk> batch;
+    size_t next_job(0);
+    while(next_job<jobs.size()){
+        const size_t first_job = next_job;
+        size_t batch_bytes(0);
+        for(;next_job<jobs.size()&&batch_bytes<CHUNK_BATCH_SIZE;next_job++){
+            batch_bytes += jobs[next_job].n_det*runs[jobs[next_job].run].ne*sizeof(double);
+        }
+        const size_t n_batch = next_job-first_job;
+        if(encode_here){
+            batch.resize(n_batch);
+            std::atomic<size_t>      next_chunk(0);
+            std::vector<std::string> errors(n_threads);
+            auto encode = [&](unsigned int thread){
+                std::vector<unsigned char> buf;
+                for(size_t i=next_chunk++;i<n_batch;i=next_chunk++){
+                    write_job const &job = jobs[first_job+i];
+                    nxspe_run const &run = runs[job.run];
+                    const double *values = (job.dataset==0 ? run.S:run.ERR)+job.first_det*run.ne;
+                    if(!encode_chunk(values,job.n_det*run.ne,chunk_det[job.run]*run.ne,options,batch[i],buf,errors[thread])){
+                        errors[thread] += " of file: "+run.fileName+"\n";
+                        return;
+                    }
+                }
+            };
+            const unsigned int n_workers = std::min<unsigned int>(n_threads,static_cast<unsigned int>(n_batch));
+            std::vector<std::thread> workers;
+            for(unsigned int thread=1;thread<n_workers;thread++){
+                workers.push_back(std::thread(encode,thread));
+            }
+            encode(0);
+            for(size_t i=0;i<workers.size();i++)workers[i].join();
+            for(unsigned int thread=0;thread<n_threads;thread++){
+                if(!errors[thread].empty())throw nxspe_write_error(errors[thread]);
+            }
+        }
+        for(size_t i=0;i<n_batch;i++){
+            write_job const &job = jobs[first_job+i];
+            nxspe_run const &run = runs[job.run];
+            if(!file.is_open())file.create(run,chunk_det[job.run],options);
+            if(encode_here){
+                file.write_chunk(job.dataset,job.first_det,batch[i]);
+                std::vector<unsigned char>().swap(batch[i].bytes);
+            }else{
+                file.write_dataset(job.dataset,job.dataset==0 ? run.S:run.ERR);
+            }
+            if(job.last)file.close();
+        }
+    }
+}
@@ -0,0 +1,176 @@
+// put_nxspe.cpp : Defines the exported functions for the DLL application.
+//
+#include <sstream>
+#include <string>
+#include <vector>
+#include <mex.h>
+#include "put_nxspe.h"
+#include "../utility/version.h"
+/*! \file put_nxspe.cpp
+*
+*  \brief     put_nxspe(runs,[keys]) function writes runs into NXSPE files with the layout written by
+*             the Matlab function save_nxspe_internal
+*
+* usage:
+*\code
+* put_nxspe(runs,['-deflate',level],['-shuffle'],['-chunk',bytes])
+*
+* input arguments:
+*	runs        -- structure or structure array, every element of which describes an NXSPE file
+*	               with the fields:
+*	   file_name       -- the name of the file to write. An existing file is overwritten
+*	   root_folder     -- the name of the NXentry group of the file
+*	   S(ne,ndet)      -- signal; ndet=no. detectors, ne=no. energy bins
+*	   ERR(ne,ndet)    -- errors
+*	   en(ne+1)        -- energy bin boundaries
+*	   polar, azimuthal, distance, polar_width, azimuthal_width
+*	                   -- ndet values each, the detector parameters of the data group of NXSPE
+*	   efix, psi       -- incident energy and the rotation angle of the crystal
+*	   nxspe_version   -- the version of the NXSPE definition, e.g. '1.2'
+*	   program_version -- the version of Herbert
+*	'-deflate',level -- optional key and compression level 1-9. Compress the signal and error
+*	'-shuffle'  -- optional key. Apply the shuffle filter to the signal and error before deflate
+*	'-chunk',bytes -- optional key and approximate size of the chunks of the signal and error (1MB by default)
+*
+* The signal and error are stored in chunks of all energy bins of a block of detectors. The chunks of all
+* runs are compressed on all hardware threads, so writing many small files is done in parallel too.
+*/
+
+enum inputs{
+    iRuns,
+    iNumInputs
+};
+static const char DEFLATE_OPTION[] = "-deflate";
+static const char SHUFFLE_OPTION[] = "-shuffle";
+static const char CHUNK_OPTION[]   = "-chunk";
+
+/*! get the string from Matlab; false if the array is not a row string */
+static bool
+get_mx_string(const mxArray *pString,std::string &value)
+{
+    if(!mxIsChar(pString)||mxGetM(pString)!=1)return false;
+    std::vector<char> Buf(mxGetN(pString)+1);
+    if(mxGetString(pString,&Buf[0],Buf.size()))return false;
+    value.assign(&Buf[0]);
+    return true;
+}
+/*! check the argument is a real double array */
+static bool
+is_real_double(const mxArray *pArray)
+{
+    return pArray&&mxIsDouble(pArray)&&!mxIsComplex(pArray)&&!mxIsSparse(pArray);
+}
+/*! get the non-negative integer scalar from Matlab */
+static bool
+get_mx_count(const mxArray *pValue,size_t &value)
+{
+    if(!is_real_double(pValue)||mxGetNumberOfElements(pValue)!=1)return false;
+    const double val = mxGetScalar(pValue);
+    if(!(val>=0)||val!=static_cast<double>(static_cast<size_t>(val)))return false;
+    value = static_cast<size_t>(val);
+    return true;
+}
+/*!
+*  fill the run from the element i of the structure array; returns false and the description of the
+*  problem in buf if the element is not valid
+*/
+static bool
+get_mx_run(const mxArray *pRuns,size_t i,nxspe_run &run,std::stringstream &buf)
+{
+    const char *strings[] = {"file_name","root_folder","nxspe_version","program_version"};
+    std::string *values[] = {&run.fileName,&run.root_folder,&run.nxspe_version,&run.program_version};
+    for(int j=0;j<4;j++){
+        const mxArray *pField = mxGetField(pRuns,i,strings[j]);
+        if(!pField||!get_mx_string(pField,*values[j])){
+            buf<<"field "<<strings[j]<<" of run N"<<i+1<<" has to be a string\n"; return false;
+        }
+    }
+    const mxArray *pS   = mxGetField(pRuns,i,"S");
+    const mxArray *pERR = mxGetField(pRuns,i,"ERR");
+    if(!is_real_double(pS)||!is_real_double(pERR)){
+        buf<<"signal and error of run N"<<i+1<<" have to be real double arrays\n"; return false;
+    }
+    run.ne   = mxGetM(pS);
+    run.ndet = mxGetNumberOfElements(pS)/(run.ne>0 ? run.ne:1);
+    if(mxGetM(pERR)!=run.ne||mxGetNumberOfElements(pERR)!=run.ne*run.ndet){
+        buf<<"error of run N"<<i+1<<" has to be the array of the size of signal ("<<run.ne<<"x"<<run.ndet<<")\n"; return false;
+    }
+    run.S   = mxGetPr(pS);
+    run.ERR = mxGetPr(pERR);
+
+    const char    *arrays[] = {"en","polar","azimuthal","distance","polar_width","azimuthal_width","efix","psi"};
+    const double **data[]   = {&run.en,&run.polar,&run.azimuthal,&run.distance,&run.polar_width,&run.azimuthal_width};
+    for(int j=0;j<8;j++){
+        const mxArray *pField = mxGetField(pRuns,i,arrays[j]);
+        const size_t n = (j==0) ? run.ne+1:(j<6 ? run.ndet:1);
+        if(!is_real_double(pField)||mxGetNumberOfElements(pField)!=n){
+            buf<<"field "<<arrays[j]<<" of run N"<<i+1<<" has to be a real double array of "<<n<<" elements\n"; return false;
+        }
+        if(j<6){
+            *data[j] = mxGetPr(pField);
+        }else{
+            (j==6 ? run.efix:run.psi) = mxGetScalar(pField);
+        }
+    }
+    return true;
+}
+
+/*! \brief interface function between the code and Matlab */
+void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
+  std::stringstream   buf;  // buffer to report errors;
+  nxspe_write_options options;
+  std::vector<nxspe_run> runs;
+
+  if (nrhs == 0 && (nlhs == 0 || nlhs == 1)) {
+        plhs[0] = mxCreateString(Herbert::VERSION);
+        return;
+  }
+  if(nlhs>0){
+      buf<<"this function does not return any output parameters\n";                 goto error;
+  }
+  if(nrhs<iNumInputs||!mxIsStruct(prhs[iRuns])){
+      buf<<"first parameter has to be a structure or structure array, which describes the files to write\n"; goto error;
+  }
+  for(int i=iNumInputs;i<nrhs;i++){
+      std::string key;
+      if(!get_mx_string(prhs[i],key)||(key!=DEFLATE_OPTION&&key!=SHUFFLE_OPTION&&key!=CHUNK_OPTION)){
+          buf<<"parameter N"<<i+1<<" has to be one of the keys: "<<DEFLATE_OPTION<<", "<<SHUFFLE_OPTION
+             <<" or "<<CHUNK_OPTION<<std::endl; goto error;
+      }
+      if(key==SHUFFLE_OPTION){
+          options.shuffle = true;
+          continue;
+      }
+      size_t value(0);
+      if(i+1>=nrhs||!get_mx_count(prhs[i+1],value)||(key==DEFLATE_OPTION&&value>9)){
+          if(key==DEFLATE_OPTION){
+              buf<<"key "<<key<<" has to be followed by the compression level from 0 to 9\n";
+          }else{
+              buf<<"key "<<key<<" has to be followed by the non-negative size of chunks in bytes\n";
+          }
+          goto error;
+      }
+      if(key==DEFLATE_OPTION){
+          options.deflate = static_cast<int>(value);
+      }else{
+          options.chunk_bytes = value;
+      }
+      i++;
+  }
+  runs.resize(mxGetNumberOfElements(prhs[iRuns]));
+  for(size_t i=0;i<runs.size();i++){
+      if(!get_mx_run(prhs[iRuns],i,runs[i],buf))goto error;
+  }
+
+  try{
+      write_nxspe(runs,options);
+  }catch(const std::exception &Error){
+      buf<<Error.what()<<std::endl;  goto error;
+  }
+  return;
+error:
+  std::string err_msg("-->ERROR:: ");
+  err_msg.append(buf.str());
+
+  mexErrMsgTxt(err_msg.c_str());
+}
@@ -0,0 +1,57 @@
+#ifndef H_PUT_NXSPE
+#define H_PUT_NXSPE
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <hdf5.h>
+
+/*!
+*   Error when writing an NXSPE file
+*/
+class nxspe_write_error: public std::runtime_error{
+public:
+    explicit nxspe_write_error(std::string const &message):std::runtime_error(message){}
+};
+
+/*!
+*   The contents of an NXSPE file: the data of a run with its detectors. The arrays are not owned.
+*/
+struct nxspe_run{
+    std::string   fileName;
+    std::string   root_folder;      //> the name of the NXentry group, e.g. "a_loader"
+    size_t        ne,ndet;
+    const double *S,*ERR;           //> (ne,ndet) signal and error
+    const double *en;               //> ne+1 energy bin boundaries
+    const double *polar,*azimuthal,*distance,*polar_width,*azimuthal_width; //> ndet values each
+    double        efix,psi;
+    std::string   nxspe_version;    //> the version of the NXSPE definition, e.g. "1.2"
+    std::string   program_version;  //> the version of Herbert, written with the program name
+    nxspe_run():ne(0),ndet(0),S(NULL),ERR(NULL),en(NULL),polar(NULL),azimuthal(NULL),distance(NULL),
+        polar_width(NULL),azimuthal_width(NULL),efix(0),psi(0){}
+};
+
+/*!
+*   Storage of the signal and error datasets
+*/
+struct nxspe_write_options{
+    int    deflate;       //> deflate level 1-9; 0 -- the datasets are not compressed
+    bool   shuffle;       //> apply the shuffle filter before deflate
+    size_t chunk_bytes;   //> approximate size of a chunk of the datasets; 0 -- 1MB
+    nxspe_write_options():deflate(0),shuffle(false),chunk_bytes(0){}
+};
+
+/*!
+*   Write the runs into NXSPE files with the layout written by the Matlab function save_nxspe_internal.
+*
+*   The signal and error datasets are chunked along the detectors: every chunk holds all energy bins of
+*   a block of detectors, which is what nxspe_reader decodes on its threads and what loading a range of
+*   detectors needs. With the shuffle or deflate filters requested, the chunks of consecutive runs are
+*   filtered together on n_threads threads (0 -- all hardware threads) and written by the calling thread,
+*   which makes all HDF5 calls, so many small files are compressed in parallel too.
+*   A chunk, which deflate does not make smaller, is stored with the filter skipped.
+*   Existing files are overwritten. Errors are reported by throwing nxspe_write_error.
+*/
+void write_nxspe(std::vector<nxspe_run> const &runs,nxspe_write_options const &options,unsigned int n_threads=0);
+
+#endif
@@ -0,0 +1,130 @@
+#include "rm_masked.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+static const size_t MIN_VALUES_PER_THREAD = 1<<16; //> smaller arrays are processed by one thread
+
+/*! number of threads to process ndet detectors of n_rows values each */
+static unsigned int
+n_threads_used(size_t n_rows,size_t ndet,unsigned int n_threads)
+{
+    if(n_threads==0){
+        n_threads = std::thread::hardware_concurrency();
+        size_t n_max = (n_rows*ndet)/MIN_VALUES_PER_THREAD;
+        if(n_threads>n_max)n_threads = static_cast<unsigned int>(n_max);
+    }
+    if(n_threads>ndet)n_threads = static_cast<unsigned int>(ndet);
+    return n_threads<1 ? 1:n_threads;
+}
+/*! run process(first_det,last_det,i) for the n_threads ranges of detectors of equal size */
+template<class Process>
+static void
+run_on_ranges(size_t ndet,unsigned int n_threads,Process const &process)
+{
+    const size_t range = (ndet+n_threads-1)/n_threads;
+    std::vector<std::thread> workers;
+    for(unsigned int i=1;i<n_threads;i++){
+        size_t first = std::min(ndet,i*range);
+        workers.push_back(std::thread(process,first,std::min(ndet,first+range),i));
+    }
+    process(0,std::min(ndet,range),0u);
+    for(size_t i=0;i<workers.size();i++)workers[i].join();
+}
+/*! true if the column of ne values contains values selected by the mask */
+template<class T>
+static inline bool
+is_masked(const T *column,size_t ne,unsigned int mask)
+{
+    switch(mask&(MASK_NAN|MASK_INF)){
+        case(MASK_NAN|MASK_INF):
+            for(size_t i=0;i<ne;i++){
+                if(!std::isfinite(column[i]))return true;
+            }
+            return false;
+        case(MASK_NAN):
+            for(size_t i=0;i<ne;i++){
+                if(std::isnan(column[i]))return true;
+            }
+            return false;
+        case(MASK_INF):
+            for(size_t i=0;i<ne;i++){
+                if(std::isinf(column[i]))return true;
+            }
+            return false;
+        default:
+            return false;
+    }
+}
+
+template<class T>
+static size_t
+find_unmasked_columns(const T *S,size_t ne,size_t ndet,unsigned int mask,bool *keep,unsigned int n_threads)
+{
+    n_threads = n_threads_used(ne,ndet,n_threads);
+    std::vector<size_t> n_kept(n_threads,0);
+    run_on_ranges(ndet,n_threads,[&](size_t first,size_t last,unsigned int i){
+        size_t n = 0;
+        for(size_t j=first;j<last;j++){
+            keep[j] = !is_masked(S+j*ne,ne,mask);
+            if(keep[j])n++;
+        }
+        n_kept[i] = n;
+    });
+    size_t n_total = 0;
+    for(size_t i=0;i<n_kept.size();i++)n_total+=n_kept[i];
+    return n_total;
+}
+
+template<class T>
+static void
+compact_kept_columns(const T *data,size_t n_rows,size_t ndet,const bool *keep,T *out,unsigned int n_threads)
+{
+    n_threads = n_threads_used(n_rows,ndet,n_threads);
+    const size_t range = (ndet+n_threads-1)/n_threads;
+    // position of the first column of every range in the output
+    std::vector<size_t> out_start(n_threads,0);
+    for(unsigned int i=1;i<n_threads;i++){
+        size_t first = std::min(ndet,(i-1)*range);
+        size_t last  = std::min(ndet,i*range);
+        out_start[i] = out_start[i-1]+static_cast<size_t>(std::count(keep+first,keep+last,true));
+    }
+    run_on_ranges(ndet,n_threads,[&](size_t first,size_t last,unsigned int i){
+        T *dest = out+out_start[i]*n_rows;
+        size_t j = first;
+        while(j<last){
+            // copy contiguous blocks of kept columns at once
+            while(j<last&&!keep[j])j++;
+            size_t block_start = j;
+            while(j<last&&keep[j])j++;
+            size_t n_values = (j-block_start)*n_rows;
+            if(n_values>0){
+                std::memcpy(dest,data+block_start*n_rows,n_values*sizeof(T));
+                dest += n_values;
+            }
+        }
+    });
+}
+
+size_t
+find_unmasked(const double *S,size_t ne,size_t ndet,unsigned int mask,bool *keep,unsigned int n_threads)
+{
+    return find_unmasked_columns(S,ne,ndet,mask,keep,n_threads);
+}
+size_t
+find_unmasked(const float *S,size_t ne,size_t ndet,unsigned int mask,bool *keep,unsigned int n_threads)
+{
+    return find_unmasked_columns(S,ne,ndet,mask,keep,n_threads);
+}
+void
+compact_columns(const double *data,size_t n_rows,size_t ndet,const bool *keep,double *out,unsigned int n_threads)
+{
+    compact_kept_columns(data,n_rows,ndet,keep,out,n_threads);
+}
+void
+compact_columns(const float *data,size_t n_rows,size_t ndet,const bool *keep,float *out,unsigned int n_threads)
+{
+    compact_kept_columns(data,n_rows,ndet,keep,out,n_threads);
+}
@@ -0,0 +1,153 @@
+// c_rm_masked.cpp : Defines the exported functions for the DLL application.
+//
+#include <memory>
+#include <sstream>
+#include <string>
+#include <mex.h>
+#include "rm_masked.h"
+#include "../utility/version.h"
+/*! \file c_rm_masked.cpp
+*
+*  \brief     [S_m,ERR_m,not_masked,det_m...] = c_rm_masked(S,ERR,ignore_nan,ignore_inf,det...) removes
+*             the detectors with failed (NaN or Inf) signal from the signal, error and detector arrays
+*
+* usage:
+*\code
+* [S_m,ERR_m,not_masked,det1_m,det2_m,...] = c_rm_masked(S,ERR,ignore_nan,ignore_inf,det1,det2,...)
+*
+* input arguments:
+*	S(ne,ndet)     signal; ndet=no. detectors, ne=no. energy bins
+*	ERR(ne,ndet)   errors of the same class as the signal (double or single)
+*	ignore_nan     if true, remove the detectors which signal contains NaN
+*	ignore_inf     if true, remove the detectors which signal contains +-Inf
+*	det1,det2,...  optional arrays of detector parameters (e.g. the fields of det_par) with
+*	               ndet values, or (n,ndet) arrays of values per detector
+*
+* output parameters:
+*	S_m(ne,nkept)   signal of the detectors kept, of the class of the input signal
+*	ERR_m(ne,nkept) errors of the detectors kept, of the class of the input errors
+*	not_masked      logical (1,ndet) array, true for the detectors kept
+*	det1_m,...      the detector arrays of the detectors kept, of the orientation of the input
+*
+* The signal is scanned and the arrays are compacted on all hardware threads.
+*/
+
+enum inputs{
+    iSignal,
+    iError,
+    iIgnoreNaN,
+    iIgnoreInf,
+    iNumInputs
+};
+enum outputs{
+    iSignal_m,
+    iError_m,
+    iNotMasked,
+    iNumOutputs
+};
+
+/*! check the argument is a real double array */
+static bool
+is_real_double(const mxArray *pArray)
+{
+    return mxIsDouble(pArray)&&!mxIsComplex(pArray)&&!mxIsSparse(pArray);
+}
+/*! check the argument is a real single or double array */
+static bool
+is_real_float(const mxArray *pArray)
+{
+    return (mxIsDouble(pArray)||mxIsSingle(pArray))&&!mxIsComplex(pArray)&&!mxIsSparse(pArray);
+}
+/*! get the logical value of a scalar argument; false if the argument is not a scalar */
+static bool
+get_mx_flag(const mxArray *pFlag,bool &value)
+{
+    if(mxGetNumberOfElements(pFlag)!=1||!(mxIsLogical(pFlag)||mxIsNumeric(pFlag)))return false;
+    value = mxGetScalar(pFlag)!=0;
+    return true;
+}
+
+/*! \brief interface function between the code and Matlab */
+void mexFunction(int nlhs, mxArray *plhs[ ],int nrhs, const mxArray *prhs[ ]){
+  std::stringstream buf;  // buffer to report errors;
+  bool ignore_nan(true),ignore_inf(true);
+  size_t ne(0),ndet(0);
+
+  if (nrhs == 0 && (nlhs == 0 || nlhs == 1)) {
+        plhs[0] = mxCreateString(Herbert::VERSION);
+        return;
+  }
+  if(nrhs<iNumInputs){
+      buf<<"function needs signal, error, ignore_nan and ignore_inf but got "<<(short)nrhs<<" input arguments\n"; goto error;
+  }
+  if(nlhs>iNumOutputs+nrhs-iNumInputs){
+      buf<<"function returns "<<iNumOutputs<<" output parameters and one per detector array but "<<(short)nlhs<<" are requested\n"; goto error;
+  }
+  for(int i=iSignal;i<=iError;i++){
+      if(!is_real_float(prhs[i])||mxGetNumberOfDimensions(prhs[i])!=2){
+          buf<<"parameter N"<<i+1<<" has to be a real double or single (ne,ndet) array\n"; goto error;
+      }
+  }
+  if(mxGetClassID(prhs[iSignal])!=mxGetClassID(prhs[iError])){
+      buf<<"signal and error arrays have to be of the same class\n"; goto error;
+  }
+  ne   = mxGetM(prhs[iSignal]);
+  ndet = mxGetN(prhs[iSignal]);
+  if(mxGetM(prhs[iError])!=ne||mxGetN(prhs[iError])!=ndet){
+      buf<<"error array has to be the array of the size of signal ("<<ne<<"x"<<ndet<<")\n"; goto error;
+  }
+  if(!get_mx_flag(prhs[iIgnoreNaN],ignore_nan)||!get_mx_flag(prhs[iIgnoreInf],ignore_inf)){
+      buf<<"ignore_nan and ignore_inf have to be logical scalars\n"; goto error;
+  }
+  for(int i=iNumInputs;i<nrhs;i++){
+      size_t n = mxGetNumberOfElements(prhs[i]);
+      if(!is_real_double(prhs[i])||mxGetNumberOfDimensions(prhs[i])!=2||
+         !(mxGetN(prhs[i])==ndet||(mxGetM(prhs[i])==ndet&&n==ndet))){
+          buf<<"parameter N"<<i+1<<" has to be a real double array of "<<ndet<<" detector values\n"; goto error;
+      }
+  }
+
+  try{
+      std::unique_ptr<bool[]> keep(new bool[ndet>0 ? ndet:1]);
+      unsigned int mask = (ignore_nan ? MASK_NAN:0)|(ignore_inf ? MASK_INF:0);
+      const bool single_precision = mxIsSingle(prhs[iSignal]);
+      size_t n_kept;
+      if(single_precision){
+          n_kept = find_unmasked(static_cast<const float *>(mxGetData(prhs[iSignal])),ne,ndet,mask,keep.get());
+      }else{
+          n_kept = find_unmasked(mxGetPr(prhs[iSignal]),ne,ndet,mask,keep.get());
+      }
+
+      for(int i=iSignal_m;i<=iError_m&&i<(nlhs>0 ? nlhs:1);i++){
+          if(single_precision){
+              plhs[i] = mxCreateNumericMatrix(ne,n_kept,mxSINGLE_CLASS,mxREAL);
+              compact_columns(static_cast<const float *>(mxGetData(prhs[iSignal+i])),ne,ndet,keep.get(),
+                              static_cast<float *>(mxGetData(plhs[i])));
+          }else{
+              plhs[i] = mxCreateDoubleMatrix(ne,n_kept,mxREAL);
+              compact_columns(mxGetPr(prhs[iSignal+i]),ne,ndet,keep.get(),mxGetPr(plhs[i]));
+          }
+      }
+      if(nlhs>iNotMasked){
+          plhs[iNotMasked] = mxCreateLogicalMatrix(1,ndet);
+          mxLogical *pNotMasked = mxGetLogicals(plhs[iNotMasked]);
+          for(size_t j=0;j<ndet;j++)pNotMasked[j] = keep[j];
+      }
+      for(int i=iNumOutputs;i<nlhs;i++){
+          const mxArray *pDet = prhs[iNumInputs+i-iNumOutputs];
+          // a detector array of one value per detector keeps its orientation
+          bool   is_column = mxGetN(pDet)!=ndet;
+          size_t n_rows    = is_column ? 1:mxGetM(pDet);
+          plhs[i] = is_column ? mxCreateDoubleMatrix(n_kept,1,mxREAL):mxCreateDoubleMatrix(n_rows,n_kept,mxREAL);
+          compact_columns(mxGetPr(pDet),n_rows,ndet,keep.get(),mxGetPr(plhs[i]));
+      }
+  }catch(const std::exception &Error){
+      buf<<Error.what()<<std::endl;  goto error;
+  }
+  return;
+error:
+  std::string err_msg("-->ERROR:: ");
+  err_msg.append(buf.str());
+
+  mexErrMsgTxt(err_msg.c_str());
+}
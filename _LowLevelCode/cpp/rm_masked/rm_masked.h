@@ -0,0 +1,25 @@
+#ifndef H_RM_MASKED
+#define H_RM_MASKED
+#include <cstddef>
+
+/*!
+*   Removal of the detectors, which signal contains failed (NaN or Inf) values, from the
+*   (n_rows,ndet) column-major arrays of rundata: signal, error and detector parameters.
+*
+*   The detectors are processed on n_threads threads (0 -- all hardware threads for large arrays),
+*   each thread working on a contiguous range of detectors.
+*/
+enum mask_values{
+    MASK_NAN = 1,  //> mask detectors which signal contains NaN
+    MASK_INF = 2   //> mask detectors which signal contains +-Inf
+};
+/* set keep[j] to 1 for the detectors j of the (ne,ndet) signal S which do not contain the values,
+   selected by the combination of mask_values mask, and to 0 otherwise. Returns the number of detectors kept */
+size_t find_unmasked(const double *S,size_t ne,size_t ndet,unsigned int mask,bool *keep,unsigned int n_threads=0);
+size_t find_unmasked(const float *S,size_t ne,size_t ndet,unsigned int mask,bool *keep,unsigned int n_threads=0);
+/* copy the columns of the (n_rows,ndet) array data, which have keep[j] set, in order into out,
+   which has to have space for n_rows*(number of columns kept) values */
+void compact_columns(const double *data,size_t n_rows,size_t ndet,const bool *keep,double *out,unsigned int n_threads=0);
+void compact_columns(const float *data,size_t n_rows,size_t ndet,const bool *keep,float *out,unsigned int n_threads=0);
+
+#endif
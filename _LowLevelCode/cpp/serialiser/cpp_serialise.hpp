@@ -2,7 +2,18 @@
 
 #include <mex.h>
 #include <matrix.h>
+#include <cstring>
 #include <limits>
+#include <vector>
+#include <utility>
+#include "ser_host.hpp"
+
+#if MX_HAS_INTERLEAVED_COMPLEX
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SER_USE_SSE2 1
+#endif
+#endif
 
 enum ser_types{
   SELF_SER,
@@ -157,6 +168,133 @@ enum types{
 };
 
 
+#if MX_HAS_INTERLEAVED_COMPLEX
+/* Complex data in the stream are stored as a block of real parts followed by a block
+ * of imaginary parts, while the R2018a+ API keeps them interleaved in memory.
+ * The kernels below convert between the two layouts. Stream pointers have no alignment
+ * guarantees, so everything goes through unaligned loads/stores or memcpy.
+ * The SIMD paths only move bits around, so they are exact for any 4 or 8 byte component. */
+
+// Generic fallback, used for 1 and 2 byte components and for the tails of the SIMD loops
+template<typename T>
+inline void deinterleave_generic(const uint8_t* cmplx, uint8_t* re, uint8_t* im, size_t nElem) {
+  for (size_t i = 0; i < nElem; i++) {
+    memcpy(re + i*sizeof(T), cmplx + 2*i*sizeof(T), sizeof(T));
+    memcpy(im + i*sizeof(T), cmplx + (2*i+1)*sizeof(T), sizeof(T));
+  }
+}
+
+template<typename T>
+inline void interleave_generic(const uint8_t* re, const uint8_t* im, uint8_t* cmplx, size_t nElem) {
+  for (size_t i = 0; i < nElem; i++) {
+    memcpy(cmplx + 2*i*sizeof(T), re + i*sizeof(T), sizeof(T));
+    memcpy(cmplx + (2*i+1)*sizeof(T), im + i*sizeof(T), sizeof(T));
+  }
+}
+
+inline void deinterleave_double(const uint8_t* cmplx, uint8_t* re, uint8_t* im, size_t nElem) {
+  size_t i = 0;
+#ifdef SER_USE_SSE2
+  const double* src = reinterpret_cast<const double*>(cmplx);
+  double* dRe = reinterpret_cast<double*>(re);
+  double* dIm = reinterpret_cast<double*>(im);
+  for (; i + 2 <= nElem; i += 2) {
+    __m128d a = _mm_loadu_pd(src + 2*i);     // r0 i0
+    __m128d b = _mm_loadu_pd(src + 2*i + 2); // r1 i1
+    _mm_storeu_pd(dRe + i, _mm_unpacklo_pd(a, b));
+    _mm_storeu_pd(dIm + i, _mm_unpackhi_pd(a, b));
+  }
+#endif
+  deinterleave_generic<uint64_t>(cmplx + 2*i*sizeof(double), re + i*sizeof(double), im + i*sizeof(double), nElem - i);
+}
+
+inline void interleave_double(const uint8_t* re, const uint8_t* im, uint8_t* cmplx, size_t nElem) {
+  size_t i = 0;
+#ifdef SER_USE_SSE2
+  const double* dRe = reinterpret_cast<const double*>(re);
+  const double* dIm = reinterpret_cast<const double*>(im);
+  double* dst = reinterpret_cast<double*>(cmplx);
+  for (; i + 2 <= nElem; i += 2) {
+    __m128d r = _mm_loadu_pd(dRe + i); // r0 r1
+    __m128d m = _mm_loadu_pd(dIm + i); // i0 i1
+    _mm_storeu_pd(dst + 2*i, _mm_unpacklo_pd(r, m));
+    _mm_storeu_pd(dst + 2*i + 2, _mm_unpackhi_pd(r, m));
+  }
+#endif
+  interleave_generic<uint64_t>(re + i*sizeof(double), im + i*sizeof(double), cmplx + 2*i*sizeof(double), nElem - i);
+}
+
+inline void deinterleave_single(const uint8_t* cmplx, uint8_t* re, uint8_t* im, size_t nElem) {
+  size_t i = 0;
+#ifdef SER_USE_SSE2
+  const float* src = reinterpret_cast<const float*>(cmplx);
+  float* fRe = reinterpret_cast<float*>(re);
+  float* fIm = reinterpret_cast<float*>(im);
+  for (; i + 4 <= nElem; i += 4) {
+    __m128 a = _mm_loadu_ps(src + 2*i);     // r0 i0 r1 i1
+    __m128 b = _mm_loadu_ps(src + 2*i + 4); // r2 i2 r3 i3
+    _mm_storeu_ps(fRe + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+    _mm_storeu_ps(fIm + i, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+  }
+#endif
+  deinterleave_generic<uint32_t>(cmplx + 2*i*sizeof(float), re + i*sizeof(float), im + i*sizeof(float), nElem - i);
+}
+
+inline void interleave_single(const uint8_t* re, const uint8_t* im, uint8_t* cmplx, size_t nElem) {
+  size_t i = 0;
+#ifdef SER_USE_SSE2
+  const float* fRe = reinterpret_cast<const float*>(re);
+  const float* fIm = reinterpret_cast<const float*>(im);
+  float* dst = reinterpret_cast<float*>(cmplx);
+  for (; i + 4 <= nElem; i += 4) {
+    __m128 r = _mm_loadu_ps(fRe + i); // r0 r1 r2 r3
+    __m128 m = _mm_loadu_ps(fIm + i); // i0 i1 i2 i3
+    _mm_storeu_ps(dst + 2*i, _mm_unpacklo_ps(r, m));
+    _mm_storeu_ps(dst + 2*i + 4, _mm_unpackhi_ps(r, m));
+  }
+#endif
+  interleave_generic<uint32_t>(re + i*sizeof(float), im + i*sizeof(float), cmplx + 2*i*sizeof(float), nElem - i);
+}
+
+// Split nElem interleaved complex values with components of compSize bytes into re and im blocks
+inline void deinterleave(const void* cmplx, uint8_t* re, uint8_t* im, const size_t compSize, const size_t nElem) {
+  const uint8_t* src = static_cast<const uint8_t*>(cmplx);
+  switch (compSize) {
+  case 8:
+    deinterleave_double(src, re, im, nElem);
+    break;
+  case 4:
+    deinterleave_single(src, re, im, nElem);
+    break;
+  case 2:
+    deinterleave_generic<uint16_t>(src, re, im, nElem);
+    break;
+  default:
+    deinterleave_generic<uint8_t>(src, re, im, nElem);
+    break;
+  }
+}
+
+// Merge nElem real and imaginary components of compSize bytes into interleaved complex values
+inline void interleave(const uint8_t* re, const uint8_t* im, void* cmplx, const size_t compSize, const size_t nElem) {
+  uint8_t* dst = static_cast<uint8_t*>(cmplx);
+  switch (compSize) {
+  case 8:
+    interleave_double(re, im, dst, nElem);
+    break;
+  case 4:
+    interleave_single(re, im, dst, nElem);
+    break;
+  case 2:
+    interleave_generic<uint16_t>(re, im, dst, nElem);
+    break;
+  default:
+    interleave_generic<uint8_t>(re, im, dst, nElem);
+    break;
+  }
+}
+#endif
+
 struct tag_type {
   uint8_t type;
   uint8_t dim;
@@ -166,7 +304,66 @@ const size_t TAG_SIZE = 2*types_size[UINT8];
 const size_t NELEMS_SIZE = types_size[UINT32];
 const size_t DIMS_SIZE = types_size[UINT32];
 
-tag_type tag_data(const mxArray* input) {
+/* Element counts, dimensions and sparse nnz are normally written as uint32.
+ * Arrays which do not fit are written with DIM64_FLAG set in the dim byte of the tag
+ * and all these fields as uint64. The flag is never set for arrays which fit, so
+ * ordinary streams are unchanged and streams written before the extension still decode. */
+const uint8_t DIM64_FLAG = 0x80;
+const uint8_t NDIMS_MASK = 0x7F;
+const size_t DIMS64_SIZE = types_size[UINT64];
+
+// Size of a single count or dimension field
+inline size_t dim_field_size(const bool large) {
+  return large ? DIMS64_SIZE : DIMS_SIZE;
+}
+
+// Whether a dense array header has to be written in the 64-bit form
+inline bool needs_dim64(const size_t nElem) {
+  return nElem > DIM_MAX;
+}
+
+// Whether a sparse array header has to be written in the 64-bit form
+inline bool needs_dim64(const mwSize* dims, const size_t nnz) {
+  return dims[0] > DIM_MAX || dims[1] > DIM_MAX || nnz > DIM_MAX;
+}
+
+// Size of the tag plus element count or dimensions of a dense array, as written by write_header
+inline size_t header_size(const size_t nElem, const mwSize* dims, const size_t nDims) {
+  const size_t dimSize = dim_field_size(needs_dim64(nElem));
+
+  if (nElem == 0) { // Null
+    return TAG_SIZE;
+  }
+  else if (nElem == 1 || (nDims == 2 && dims[0] == 1)) { // Scalar or list
+    return TAG_SIZE + dimSize;
+  }
+  else { // General array
+    return TAG_SIZE + nDims*dimSize;
+  }
+}
+
+// Size of the sparse array header: tag, both dimensions and nnz
+inline size_t sparse_header_size(const mwSize* dims, const size_t nnz) {
+  return TAG_SIZE + 3*dim_field_size(needs_dim64(dims, nnz));
+}
+
+/* Sparse arrays are written in the MATLAB native compressed sparse column form when
+ * SPARSE_CSC_FLAG is set in the dim byte of the tag: the ncols+1 column pointers (jc)
+ * followed by the nnz zero-based row indices (ir), both with the width of the dimension
+ * fields, i.e. uint32 unless the header is in the 64-bit form.
+ * Streams without the flag hold nnz uint64 row and nnz uint64 column indices. */
+const uint8_t SPARSE_CSC_FLAG = 0x40;
+
+inline bool is_sparse_type(const uint8_t type) {
+  return type == SPARSE_LOGICAL || type == SPARSE_DOUBLE || type == SPARSE_COMPLEX_DOUBLE;
+}
+
+// Size of the jc and ir blocks of a sparse array written in CSC form
+inline size_t sparse_index_size(const mwSize* dims, const size_t nnz) {
+  return (dims[1] + 1 + nnz)*dim_field_size(needs_dim64(dims, nnz));
+}
+
+inline tag_type tag_data(const mxArray* input) {
   int category = mxGetClassID(input);
   tag_type tag;
 
@@ -218,10 +415,7 @@ tag_type tag_data(const mxArray* input) {
       if (mxIsClass(input, "function_handle")) {
         tag.type = FUNCTION_HANDLE;
       } else {
-        mxArray* ser_type;
-        mxArray* arr = const_cast<mxArray *>(input);
-        mexCallMATLAB(1, &ser_type, 1, &arr, "get_ser_type");
-        uint8_t a = (uint8_t) mxGetScalar(ser_type);
+        uint8_t a = get_ser_host().ser_type(input);
         // object serializes itself together with dimensions transforming array structure into structure array
         if (a == 0) {
           tag.type = SERIALIZABLE;
@@ -251,3 +445,118 @@ tag_type tag_data(const mxArray* input) {
   }
   return tag;
 }
+
+/* Struct arrays of more than one element with at least one field are written by field
+ * when STRUCT_COLUMNS_FLAG is set in the dim byte of the tag. After the field names,
+ * which are written once for the whole array, every field is written as a column of
+ * its values over all elements, introduced by a column kind byte:
+ * COLUMN_CELL   - the values one after another, as the elements of a cell array;
+ * COLUMN_DENSE  - values of one numeric, logical or char class and shape: the header of
+ *                 one value, then the data of all values (for complex values all real
+ *                 parts, then all imaginary parts);
+ * COLUMN_STRUCT - scalar structs with the same fields: written as one 1xN struct array,
+ *                 so their field names are written once.
+ * Scalar structs keep the struct2cell layout: field values as a nFields x 1 cell.
+ * The flag shares the dim byte with the number of dimensions, so struct arrays of
+ * more than one element are limited to 63 dimensions. */
+const uint8_t STRUCT_COLUMNS_FLAG = 0x40;
+
+enum column_kinds {
+  COLUMN_CELL,
+  COLUMN_DENSE,
+  COLUMN_STRUCT
+};
+
+// Elements of a struct array, or the scalar structs held in one field of a struct array
+typedef std::vector<std::pair<const mxArray*, size_t>> struct_elements;
+
+inline struct_elements all_elements(const mxArray* input) {
+  struct_elements elems(mxGetNumberOfElements(input));
+  for (size_t i = 0; i < elems.size(); i++) elems[i] = std::make_pair(input, i);
+  return elems;
+}
+
+inline const mxArray* field_value(const struct_elements& elems, const size_t obj, const int field) {
+  return mxGetFieldByNumber(elems[obj].first, elems[obj].second, field);
+}
+
+inline struct_elements column_elements(const struct_elements& elems, const int field) {
+  struct_elements column(elems.size());
+  for (size_t i = 0; i < elems.size(); i++) column[i] = std::make_pair(field_value(elems, i, field), (size_t) 0);
+  return column;
+}
+
+// Non-empty full array of a numeric, logical or char class
+inline bool is_dense_value(const mxArray* value) {
+  if (value == nullptr || mxIsSparse(value) || mxGetNumberOfElements(value) == 0) return false;
+  switch (mxGetClassID(value)) {
+  case mxLOGICAL_CLASS:
+  case mxCHAR_CLASS:
+  case mxDOUBLE_CLASS:
+  case mxSINGLE_CLASS:
+  case mxINT8_CLASS:
+  case mxUINT8_CLASS:
+  case mxINT16_CLASS:
+  case mxUINT16_CLASS:
+  case mxINT32_CLASS:
+  case mxUINT32_CLASS:
+  case mxINT64_CLASS:
+  case mxUINT64_CLASS:
+    return true;
+  default:
+    return false;
+  }
+}
+
+inline bool same_dense_type(const mxArray* a, const mxArray* b) {
+  const size_t nDims = mxGetNumberOfDimensions(a);
+  return mxGetClassID(a) == mxGetClassID(b) && mxIsComplex(a) == mxIsComplex(b) &&
+         nDims == mxGetNumberOfDimensions(b) &&
+         memcmp(mxGetDimensions(a), mxGetDimensions(b), nDims*sizeof(mwSize)) == 0;
+}
+
+// Scalar struct with fields, so each value in its column still takes at least one byte
+inline bool is_scalar_struct(const mxArray* value) {
+  return value != nullptr && mxIsStruct(value) && mxGetNumberOfElements(value) == 1 &&
+         mxGetNumberOfFields(value) > 0;
+}
+
+inline bool same_fields(const mxArray* a, const mxArray* b) {
+  const int nFields = mxGetNumberOfFields(a);
+  if (nFields != mxGetNumberOfFields(b)) return false;
+  for (int field = 0; field < nFields; field++) {
+    if (strcmp(mxGetFieldNameByNumber(a, field), mxGetFieldNameByNumber(b, field)) != 0) return false;
+  }
+  return true;
+}
+
+inline uint8_t column_kind(const struct_elements& elems, const int field) {
+  const mxArray* first = field_value(elems, 0, field);
+
+  if (is_dense_value(first)) {
+    for (size_t obj = 1; obj < elems.size(); obj++) {
+      const mxArray* value = field_value(elems, obj, field);
+      if (!is_dense_value(value) || !same_dense_type(first, value)) return COLUMN_CELL;
+    }
+    return COLUMN_DENSE;
+  }
+  if (is_scalar_struct(first)) {
+    for (size_t obj = 1; obj < elems.size(); obj++) {
+      const mxArray* value = field_value(elems, obj, field);
+      if (!is_scalar_struct(value) || !same_fields(first, value)) return COLUMN_CELL;
+    }
+    return COLUMN_STRUCT;
+  }
+  return COLUMN_CELL;
+}
+
+// Nesting deeper than this is treated as a corrupt stream
+const size_t MAX_NESTING_DEPTH = 1024;
+
+// Serialiser core, see serialise.cpp, deserialise.cpp and serial_size.cpp
+void serialise(uint8_t* data, size_t& memPtr, const mxArray* input);
+// 128-bit MurmurHash3 of the stream serialise would write, computed without writing it
+const size_t SER_HASH_SIZE = 16;
+void serial_hash(const mxArray* input, uint8_t hash[SER_HASH_SIZE]);
+mxArray* deserialise(const uint8_t* data, size_t& memPtr, const size_t size, const size_t depth);
+size_t get_size(const mxArray* input);
@@ -0,0 +1,633 @@
+/*=========================================================
+ * deserialise.cpp
+ * Deserialise serialised data back into a MATLAB object.
+ * Core of c_deserialise, independent of the mex gateway.
+ *
+ * Every read is checked against the end of the stream, so truncated
+ * or corrupt data is reported as an error rather than read past.
+ *
+ * See also:
+ * hlp_serialize
+ * hlp_deserialize
+ *=======================================================*/
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include "cpp_serialise.hpp"
+
+inline void corrupt(const char* message) {
+    get_ser_host().error("MATLAB:c_deserialise:corrupt_data", message);
+}
+
+// Fail unless nElem elements of elemSize bytes each remain in the stream
+inline void check_available(const size_t memPtr, const size_t size, const size_t nElem, const size_t elemSize) {
+    if (memPtr > size || (elemSize != 0 && nElem > (size - memPtr) / elemSize)) {
+        corrupt("Serialised data ends before the object it describes");
+    }
+}
+
+template<typename T, typename A>
+inline void deser(const uint8_t* data, size_t& memPtr, const size_t size, std::vector<T, A>& output, const size_t amount) {
+    check_available(memPtr, size, amount, 1);
+    if (amount == 0) return;
+    memcpy(output.data(), &data[memPtr], amount);
+    memPtr += amount;
+}
+
+inline void deser(const uint8_t* data, size_t& memPtr, const size_t size, void* output, const size_t amount) {
+    check_available(memPtr, size, amount, 1);
+    if (amount == 0) return;
+    memcpy(output, &data[memPtr], amount);
+    memPtr += amount;
+}
+
+// Read a count or dimension in the width selected by the header flag
+inline size_t read_dim(const uint8_t* data, size_t& memPtr, const size_t size, const bool large) {
+    if (large) {
+        uint64_t val;
+        deser(data, memPtr, size, &val, DIMS64_SIZE);
+        return (size_t)val;
+    }
+    else {
+        uint32_t val;
+        deser(data, memPtr, size, &val, DIMS_SIZE);
+        return val;
+    }
+}
+
+// Read sparse array indices in the width selected by the header flag
+inline void read_indices(const uint8_t* data, size_t& memPtr, const size_t size, mwIndex* idx, const size_t nIdx, const bool large) {
+    check_available(memPtr, size, nIdx, dim_field_size(large));
+    if (large && sizeof(mwIndex) == DIMS64_SIZE) {
+        deser(data, memPtr, size, idx, nIdx * DIMS64_SIZE);
+    }
+    else {
+        for (size_t i = 0; i < nIdx; i++) idx[i] = (mwIndex)read_dim(data, memPtr, size, large);
+    }
+}
+
+inline void read_data(const uint8_t* data, size_t& memPtr, const size_t size, mxArray* output, const size_t elemSize, const size_t nElem) {
+    check_available(memPtr, size, nElem, elemSize);
+    if (mxIsComplex(output)) {
+        // Size of a complex component is half that of the whole complex
+        size_t compSize = elemSize / 2;
+
+#if MX_HAS_INTERLEAVED_COMPLEX
+        void* toWrite = mxGetData(output);
+        // Stream holds the block of real parts followed by the block of imaginary parts
+        interleave(&data[memPtr], &data[memPtr + nElem * compSize], toWrite, compSize, nElem);
+        memPtr += 2 * nElem * compSize;
+
+#else
+        void* toWrite = mxGetPr(output);
+        deser(data, memPtr, size, toWrite, compSize * nElem);
+        toWrite = mxGetPi(output);
+        deser(data, memPtr, size, toWrite, compSize * nElem);
+
+#endif
+
+    }
+    else {
+        void* toWrite = mxGetData(output);
+        deser(data, memPtr, size, toWrite, elemSize * nElem);
+    }
+}
+
+// Column pointers and row indices must describe a valid MATLAB sparse matrix
+inline bool valid_csc(const mwIndex* ir, const mwIndex* jc, const mwSize* dims, const size_t nnz) {
+    if (jc[0] != 0 || jc[dims[1]] != nnz) return false;
+    for (mwSize col = 0; col < dims[1]; col++) {
+        if (jc[col + 1] < jc[col]) return false;
+    }
+    for (mwSize col = 0; col < dims[1]; col++) {
+        for (mwIndex k = jc[col]; k < jc[col + 1]; k++) {
+            if (ir[k] >= dims[0] || (k > jc[col] && ir[k] <= ir[k - 1])) return false;
+        }
+    }
+    return true;
+}
+
+// Read the dimensions following a dim byte (with any type flag removed) into vDims.
+// Returns the number of elements; null and list arrays get their two dimensions.
+inline size_t read_dims(const uint8_t* data, size_t& memPtr, const size_t size, const uint8_t dim, std::vector<mwSize>& vDims) {
+    const bool large = (dim & DIM64_FLAG) != 0;
+    const size_t nDims = dim & NDIMS_MASK;
+    size_t nElem;
+
+    switch (nDims) {
+    case 0:
+      vDims.assign(2, 0);
+      nElem = 0;
+      break;
+
+    case 1:
+      nElem = read_dim(data, memPtr, size, large);
+      vDims.resize(2);
+      vDims[0] = 1;
+      vDims[1] = nElem;
+      break;
+
+    default:
+      vDims.resize(nDims);
+      nElem = 1;
+
+      for (size_t i = 0; i < nDims; i++) {
+        vDims[i] = read_dim(data, memPtr, size, large);
+        if (vDims[i] != 0 && nElem > std::numeric_limits<size_t>::max() / vDims[i]) {
+          corrupt("Serialised array dimensions overflow");
+        }
+        nElem *= vDims[i];
+      }
+      break;
+    }
+    return nElem;
+}
+
+mxArray* deserialise(const uint8_t* data, size_t& memPtr, const size_t size, const size_t depth);
+
+// Values of one field over all elements of a struct array written by column (see STRUCT_COLUMNS_FLAG)
+void read_struct_column(const uint8_t* data, size_t& memPtr, const size_t size, const size_t depth,
+                        mxArray* output, const uint32_t field) {
+    const size_t nElem = mxGetNumberOfElements(output);
+    uint8_t kind;
+    deser(data, memPtr, size, &kind, types_size[UINT8]);
+
+    switch (kind) {
+    case COLUMN_CELL:
+      for (size_t obj = 0; obj < nElem; obj++) {
+        mxSetFieldByNumber(output, obj, field, deserialise(data, memPtr, size, depth + 1));
+      }
+      break;
+
+    case COLUMN_DENSE:
+      {
+        tag_type tag;
+        deser(data, memPtr, size, &tag.type, types_size[UINT8]);
+        deser(data, memPtr, size, &tag.dim, types_size[UINT8]);
+        if (tag.type > COMPLEX_UINT64 || tag.type == MATLAB_STRING) {
+          corrupt("Serialised struct column has an invalid value type");
+        }
+        std::vector<mwSize> vDims;
+        const size_t nPer = read_dims(data, memPtr, size, tag.dim, vDims);
+        const size_t elemSize = types_size[tag.type];
+        if (nPer == 0 || nElem > std::numeric_limits<size_t>::max() / nPer) {
+          corrupt("Serialised struct column has an invalid value size");
+        }
+        check_available(memPtr, size, nElem * nPer, elemSize);
+
+        // Complex columns hold all real parts, then all imaginary parts
+        const bool cmplx = 12 < tag.type && tag.type < 23;
+        const size_t compSize = cmplx ? elemSize / 2 : elemSize;
+        const uint8_t* real = &data[memPtr];
+        const uint8_t* imag = real + nElem * nPer * compSize;
+
+        for (size_t obj = 0; obj < nElem; obj++) {
+          const uint8_t* in = real + obj * nPer * compSize;
+          mxArray* value;
+          if (tag.type == CHAR) {
+            value = mxCreateCharArray(vDims.size(), vDims.data());
+            mxChar* out = mxGetChars(value);
+            for (size_t i = 0; i < nPer; i++) out[i] = (mxChar)in[i];
+          }
+          else if (tag.type == LOGICAL) {
+            value = mxCreateLogicalArray(vDims.size(), vDims.data());
+            memcpy(mxGetData(value), in, nPer * elemSize);
+          }
+          else {
+            value = mxCreateUninitNumericArray(vDims.size(), vDims.data(), unmap_types[tag.type], (mxComplexity) cmplx);
+            if (cmplx) {
+#if MX_HAS_INTERLEAVED_COMPLEX
+              interleave(in, imag + obj * nPer * compSize, mxGetData(value), compSize, nPer);
+#else
+              memcpy(mxGetPr(value), in, nPer * compSize);
+              memcpy(mxGetPi(value), imag + obj * nPer * compSize, nPer * compSize);
+#endif
+            }
+            else {
+              memcpy(mxGetData(value), in, nPer * elemSize);
+            }
+          }
+          mxSetFieldByNumber(output, obj, field, value);
+        }
+        memPtr += nElem * nPer * elemSize;
+      }
+      break;
+
+    case COLUMN_STRUCT:
+      {
+        mxArray* column = deserialise(data, memPtr, size, depth + 1);
+        if (!mxIsStruct(column) || mxGetNumberOfElements(column) != nElem) {
+          mxDestroyArray(column);
+          corrupt("Serialised struct column does not match the struct array");
+        }
+        // Split the 1xN struct array into the scalar structs it was built from
+        const int nFields = mxGetNumberOfFields(column);
+        std::vector<const char*> names(nFields);
+        for (int i = 0; i < nFields; i++) names[i] = mxGetFieldNameByNumber(column, i);
+
+        for (size_t obj = 0; obj < nElem; obj++) {
+          mxArray* value = mxCreateStructMatrix(1, 1, nFields, names.data());
+          for (int i = 0; i < nFields; i++) {
+            mxSetFieldByNumber(value, 0, i, mxGetFieldByNumber(column, obj, i));
+            mxSetFieldByNumber(column, obj, i, nullptr); // Now owned by the scalar struct
+          }
+          mxSetFieldByNumber(output, obj, field, value);
+        }
+        mxDestroyArray(column);
+      }
+      break;
+
+    default:
+      corrupt("Unknown struct column kind in serialised data");
+    }
+}
+
+mxArray* deserialise(const uint8_t* data, size_t& memPtr, const size_t size, const size_t depth) {
+
+    if (depth > MAX_NESTING_DEPTH) {
+        corrupt("Serialised data is nested too deeply");
+    }
+
+    mxArray* output = nullptr;
+    ser_host& host = get_ser_host();
+
+    tag_type tag;
+    deser(data, memPtr, size, &tag.type, types_size[UINT8]);
+
+    size_t nDims = 2;
+    std::vector<mwSize> vDims(2);
+    size_t nElem;
+    bool large = false;
+    bool csc = false;
+    bool columns = false;
+
+    // Special case as function handles work differently
+    switch (tag.type) {
+    case FUNCTION_HANDLE:
+    case FUNCTION_HANDLE + 64:
+    case FUNCTION_HANDLE + 128:
+    case FUNCTION_HANDLE + 192:
+      {
+        // Function handle always scalar
+        std::fill(vDims.begin(), vDims.end(), 1);
+        nElem = 1;
+        break;
+      }
+    case SERIALIZABLE:
+      {
+        // Object writes its own header after the type tag
+        std::fill(vDims.begin(), vDims.end(), 1);
+        nElem = 1;
+        break;
+      }
+    default:
+      deser(data, memPtr, size, &tag.dim, types_size[UINT8]);
+      if (is_sparse_type(tag.type)) {
+        csc = (tag.dim & SPARSE_CSC_FLAG) != 0;
+        tag.dim &= ~SPARSE_CSC_FLAG;
+      }
+      else if (tag.type == STRUCT) {
+        columns = (tag.dim & STRUCT_COLUMNS_FLAG) != 0;
+        tag.dim &= ~STRUCT_COLUMNS_FLAG;
+      }
+      large = (tag.dim & DIM64_FLAG) != 0;
+      nElem = read_dims(data, memPtr, size, tag.dim, vDims);
+      nDims = vDims.size();
+      break;
+    }
+
+    // C Mex API requires pointer, not vector
+    mwSize* dims = vDims.data();
+
+    switch (tag.type) {
+      // Sparse
+    case SPARSE_LOGICAL:
+    case SPARSE_DOUBLE:
+    case SPARSE_COMPLEX_DOUBLE:
+      {
+        if (nDims != 2) {
+          corrupt("Serialised sparse array is not two dimensional");
+        }
+        size_t nnz = read_dim(data, memPtr, size, large);
+        if (nnz > nElem) {
+          corrupt("Serialised sparse array has more non-zeros than elements");
+        }
+        check_available(memPtr, size, nnz, types_size[tag.type]);
+        if (csc) {
+          check_available(memPtr, size, dims[1] + 1, dim_field_size(large));
+        }
+
+        if (tag.type == SPARSE_LOGICAL) {
+          output = mxCreateSparseLogicalMatrix(dims[0], dims[1], nnz);
+        }
+        else {
+          mxComplexity cmplx = (mxComplexity)(tag.type == SPARSE_COMPLEX_DOUBLE);
+          output = mxCreateSparse(dims[0], dims[1], nnz, cmplx);
+        }
+        mwIndex* ir = mxGetIr(output);
+        mwIndex* jc = mxGetJc(output);
+
+        if (csc) {
+          read_indices(data, memPtr, size, jc, dims[1] + 1, large);
+          read_indices(data, memPtr, size, ir, nnz, large);
+        }
+        else {
+          // Stream written before CSC form: row and column index per element
+          std::vector<uint64_t> map_jc(nnz);
+
+          deser(data, memPtr, size, ir, types_size[UINT64] * nnz);
+          deser(data, memPtr, size, map_jc, types_size[UINT64] * nnz);
+
+          // Unmap Jc (see MATLAB docs on sparse arrays in MEX API)
+          for (const uint64_t& row : map_jc) {
+            if (row >= dims[1]) {
+              mxDestroyArray(output);
+              corrupt("Serialised sparse array has a column index out of range");
+            }
+            jc[row + 1]++;
+          }
+
+          for (mwSize i = 1; i < dims[1] + 1; i++) {
+            jc[i] += jc[i - 1];
+          }
+        }
+
+        if (!valid_csc(ir, jc, dims, nnz)) {
+          mxDestroyArray(output);
+          corrupt("Serialised sparse array has invalid indices");
+        }
+
+        read_data(data, memPtr, size, output, types_size[tag.type], nnz);
+
+      }
+      break;
+    case CHAR:
+      {
+        check_available(memPtr, size, nElem, types_size[CHAR]);
+        // Widen straight from the stream, no intermediate buffer
+        output = mxCreateCharArray(nDims, dims);
+        mxChar* out = mxGetChars(output);
+        const uint8_t* in = &data[memPtr];
+        for (size_t i = 0; i < nElem; i++) {
+          out[i] = (mxChar)in[i];
+        }
+        memPtr += nElem * types_size[CHAR];
+      }
+      break;
+    case LOGICAL:
+      check_available(memPtr, size, nElem, types_size[tag.type]);
+      output = mxCreateLogicalArray(nDims, dims);
+      read_data(data, memPtr, size, output, types_size[tag.type], nElem);
+      break;
+    case INT8:
+    case UINT8:
+    case INT16:
+    case UINT16:
+    case INT32:
+    case UINT32:
+    case INT64:
+    case UINT64:
+    case SINGLE:
+    case DOUBLE:
+    case COMPLEX_INT8:
+    case COMPLEX_UINT8:
+    case COMPLEX_INT16:
+    case COMPLEX_UINT16:
+    case COMPLEX_INT32:
+    case COMPLEX_UINT32:
+    case COMPLEX_INT64:
+    case COMPLEX_UINT64:
+    case COMPLEX_SINGLE:
+    case COMPLEX_DOUBLE:
+      {
+        check_available(memPtr, size, nElem, types_size[tag.type]);
+        // Complex tags are 13-22
+        mxComplexity cmplx = (mxComplexity)(12 < tag.type && tag.type < 23);
+        // Every element is written by read_data, so skip zero-filling the new array.
+        // The data is still copied out of the stream into the new array: MEX arrays can
+        // not adopt parts of the input array or of a shared allocation, as each mxSetData
+        // block has to be a separately mxMalloc'd region owned by a single array.
+        output = mxCreateUninitNumericArray(nDims, dims, unmap_types[tag.type], cmplx);
+        read_data(data, memPtr, size, output, types_size[tag.type], nElem);
+      }
+      break;
+
+    case FUNCTION_HANDLE:
+    case FUNCTION_HANDLE+64:
+      {
+        mxArray* name = deserialise(data, memPtr, size, depth + 1);
+        host.call_matlab(1, &output, 1, &name, "str2func");
+        mxDestroyArray(name);
+      }
+      break;
+    case FUNCTION_HANDLE+128:
+      {
+        mxArray* name = deserialise(data, memPtr, size, depth + 1);
+        mxArray* workspace = deserialise(data, memPtr, size, depth + 1);
+        std::vector<mxArray*> input{ name, workspace };
+        host.call_matlab(1, &output, 2, input.data(), "restore_function");
+        mxDestroyArray(name);
+        mxDestroyArray(workspace);
+      }
+      break;
+    case FUNCTION_HANDLE+192:
+      {
+        mxArray* parentage = deserialise(data, memPtr, size, depth + 1);
+        if (!mxIsCell(parentage) || mxGetNumberOfElements(parentage) == 0) {
+          mxDestroyArray(parentage);
+          corrupt("Serialised function handle has no parentage");
+        }
+        const size_t len = (size_t) mxGetNumberOfElements(parentage);
+
+        // Initial output
+        output = mxDuplicateArray(mxGetCell(parentage, len - 1));
+
+        std::vector<mxArray*> input(3);
+
+        mxArray* stringHandle = mxCreateString("handle");
+        input[0] = stringHandle;
+        input[1] = output;
+        for (int i = len - 2; i >= 0; i--) {
+          input[2] = mxGetCell(parentage, i);
+          host.call_matlab(1, &output, 3, input.data(), "arg_report");
+        }
+        mxDestroyArray(stringHandle);
+        mxDestroyArray(parentage);
+        break;
+      }
+
+    case VALUE_OBJECT:
+      {
+
+        check_available(memPtr, size, 2, 1);
+        memPtr += 2; // Skip name_tag and dim tag
+
+
+        uint32_t nameLen;
+        deser(data, memPtr, size, &nameLen, types_size[UINT32]);
+        check_available(memPtr, size, nameLen, types_size[CHAR]);
+
+        std::string name = std::string(nameLen, ' ');
+
+        deser(data, memPtr, size, &name[0], nameLen * types_size[CHAR]);
+
+        uint8_t ser_tag;
+        deser(data, memPtr, size, &ser_tag, types_size[UINT8]);
+
+        if (name == "MException") {
+          name += "_her";
+          ser_tag = 1;
+        }
+
+        switch (ser_tag) {
+        case SELF_SER:
+          {
+            mxArray* mxName = mxCreateString(name.data());
+            mxArray* mxData = mxCreateUninitNumericMatrix(0, 1, mxUINT8_CLASS, (mxComplexity) 0);
+            void* tmp = mxGetData(mxData);
+            mxSetM(mxData, size - memPtr);
+            mxSetData(mxData, const_cast<uint8_t*>(&data[memPtr]));
+
+            std::vector<mxArray*> results(2);
+            std::vector<mxArray*> input{ mxName, mxData };
+            host.call_matlab(2, results.data(), 2, input.data(), "c_hlp_deserialise_object_self");
+            output = results[0];
+            memPtr += (size_t)mxGetScalar(results[1]);
+            mxDestroyArray(mxName);
+
+            mxSetM(mxData, 0);
+            mxSetData(mxData, tmp);
+            mxDestroyArray(mxData);
+          }
+          break;
+        case SAVEOBJ:
+          {
+            mxArray* mxName = mxCreateString(name.data());
+            mxArray* conts = deserialise(data, memPtr, size, depth + 1);
+            std::vector<mxArray*> input{ mxName, conts };
+            host.call_matlab(1, &output, 2, input.data(), "c_hlp_deserialise_object_loadobj");
+            mxDestroyArray(conts);
+            mxDestroyArray(mxName);
+          }
+          break;
+        case STRUCTED:
+          {
+            output = deserialise(data, memPtr, size, depth + 1);
+            if (!mxIsStruct(output)) {
+              mxDestroyArray(output);
+              corrupt("Serialised object contents are not a struct");
+            }
+            mxSetClassName(output, name.data());
+          }
+          break;
+        default:
+          corrupt("Unknown object serialisation type in serialised data");
+        }
+
+      }
+      break;
+
+    case STRUCT:
+      {
+        if (nElem == 0) { // Null struct carries no field information
+          output = mxCreateStructArray(nDims, dims, 0, nullptr);
+          break;
+        }
+
+        uint32_t nFields;
+        deser(data, memPtr, size, &nFields, types_size[UINT32]);
+        check_available(memPtr, size, nFields, types_size[UINT32]);
+
+        std::vector<uint32_t> fNameLens(nFields);
+        deser(data, memPtr, size, fNameLens, nFields * types_size[UINT32]);
+
+        std::vector<std::vector<char>> fNames(nFields);
+        std::vector<char*> mxData(nFields);
+        for (uint32_t field = 0; field < nFields; field++) {
+          check_available(memPtr, size, fNameLens[field], types_size[CHAR]);
+          fNames[field] = std::vector<char>(fNameLens[field] + 1);
+          mxData[field] = fNames[field].data();
+          fNames[field][fNameLens[field]] = 0;
+          deser(data, memPtr, size, fNames[field], fNameLens[field] * types_size[CHAR]);
+        }
+
+        // Each field value takes at least one byte of the stream
+        check_available(memPtr, size, nElem, nFields);
+        output = mxCreateStructArray(nDims, dims, nFields, (const char**)mxData.data());
+        if (output == nullptr) {
+          corrupt("Serialised struct has invalid field names");
+        }
+        if (nFields == 0) break;
+
+        if (columns) {
+          for (uint32_t field = 0; field < nFields; field++) {
+            read_struct_column(data, memPtr, size, depth, output, field);
+          }
+          break;
+        }
+
+        mxArray* cellData = deserialise(data, memPtr, size, depth + 1);
+        if (!mxIsCell(cellData) || mxGetNumberOfElements(cellData) != nElem * nFields) {
+          mxDestroyArray(cellData);
+          mxDestroyArray(output);
+          corrupt("Serialised struct contents do not match its fields");
+        }
+
+        for (size_t obj = 0, elem = 0; obj < nElem; obj++) {
+          for (uint32_t field = 0; field < nFields; field++, elem++) {
+            mxArray* cellElem = mxGetCell(cellData, elem);
+            mxSetFieldByNumber(output, obj, field, cellElem);
+            mxSetCell(cellData, elem, nullptr); // Now owned by the struct
+          }
+        }
+        mxDestroyArray(cellData);
+
+      }
+      break;
+
+    case CELL:
+      {
+        // Each element takes at least one byte of the stream
+        check_available(memPtr, size, nElem, 1);
+        output = mxCreateCellArray(nDims, dims);
+        for (mwIndex i = 0; i < nElem; i++) {
+          mxArray* elem = deserialise(data, memPtr, size, depth + 1);
+          mxSetCell(output, i, elem);
+        }
+      }
+      break;
+
+    case SERIALIZABLE:
+      {
+
+        memPtr -= types_size[UINT8]; // rewind to the type tag, hlp_deserialise dispatches on it
+
+        mxArray* mxData = mxCreateUninitNumericMatrix(0, 1, mxUINT8_CLASS, (mxComplexity) 0);
+        void* tmp = mxGetData(mxData);
+        mxSetM(mxData, size - memPtr);
+        mxSetData(mxData, const_cast<uint8_t*>(&data[memPtr]));
+
+        std::vector<mxArray*> results(2);
+        host.call_matlab(2, results.data(), 1, &mxData, "hlp_deserialise");
+        output = results[0];
+        memPtr += (size_t) mxGetScalar(results[1]);
+
+        mxSetM(mxData, 0);
+        mxSetData(mxData, tmp);
+        mxDestroyArray(mxData);
+        mxDestroyArray(results[1]);
+
+      }
+      break;
+
+    default:
+      corrupt("Unknown type tag in serialised data");
+    }
+
+    /* Nested arrays are not made persistent: the parent owns them once they are set
+       into it, and until then MATLAB frees them with the other temporary arrays if the
+       stream turns out to be corrupt, rather than leaking them for the session */
+    return output;
+}
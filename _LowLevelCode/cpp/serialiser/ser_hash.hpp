@@ -0,0 +1,100 @@
+#pragma once
+/*=========================================================
+ * ser_hash.hpp
+ * Streaming MurmurHash3 (x64, 128 bit) used to hash objects
+ * while they are walked by the serialiser, without building
+ * the serialised stream.
+ *
+ * Feeding the bytes in any number of pieces gives the same
+ * result as MurmurHash3_x64_128 over the whole stream.
+ * Not a cryptographic hash.
+ *=======================================================*/
+#include <cstdint>
+#include <cstring>
+
+class ser_hash128 {
+public:
+  explicit ser_hash128(const uint64_t seed = 0) : h1(seed), h2(seed), nTail(0), total(0) {}
+
+  void update(const void* data, size_t len) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    total += len;
+
+    if (nTail > 0) { // Complete the block left over from the previous call
+      size_t take = (len < BLOCK - nTail) ? len : BLOCK - nTail;
+      memcpy(tail + nTail, p, take);
+      nTail += take;
+      p += take;
+      len -= take;
+      if (nTail < BLOCK) return;
+      block(tail);
+      nTail = 0;
+    }
+
+    for (; len >= BLOCK; p += BLOCK, len -= BLOCK) block(p);
+
+    if (len > 0) {
+      memcpy(tail, p, len);
+      nTail = len;
+    }
+  }
+
+  // Hash of all bytes seen so far as two 64-bit words, low word first
+  void finalise(uint64_t out[2]) const {
+    uint64_t r1 = h1, r2 = h2;
+    uint64_t k1 = 0, k2 = 0;
+
+    for (size_t i = nTail; i > 8; i--) k2 = (k2 << 8) | tail[i - 1];
+    for (size_t i = (nTail < 8 ? nTail : 8); i > 0; i--) k1 = (k1 << 8) | tail[i - 1];
+
+    if (nTail > 8) {
+      k2 *= C2; k2 = rotl(k2, 33); k2 *= C1; r2 ^= k2;
+    }
+    if (nTail > 0) {
+      k1 *= C1; k1 = rotl(k1, 31); k1 *= C2; r1 ^= k1;
+    }
+
+    r1 ^= total; r2 ^= total;
+    r1 += r2; r2 += r1;
+    r1 = fmix(r1); r2 = fmix(r2);
+    r1 += r2; r2 += r1;
+
+    out[0] = r1;
+    out[1] = r2;
+  }
+
+private:
+  static const size_t BLOCK = 16;
+  static const uint64_t C1 = 0x87c37b91114253d5ULL;
+  static const uint64_t C2 = 0x4cf5ad432745937fULL;
+
+  uint64_t h1, h2;
+  uint8_t tail[BLOCK];
+  size_t nTail;
+  uint64_t total;
+
+  static inline uint64_t rotl(const uint64_t x, const int r) {
+    return (x << r) | (x >> (64 - r));
+  }
+
+  static inline uint64_t fmix(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+  }
+
+  inline void block(const uint8_t* p) {
+    uint64_t k1, k2;
+    memcpy(&k1, p, 8);
+    memcpy(&k2, p + 8, 8);
+
+    k1 *= C1; k1 = rotl(k1, 31); k1 *= C2; h1 ^= k1;
+    h1 = rotl(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= C2; k2 = rotl(k2, 33); k2 *= C1; h2 ^= k2;
+    h2 = rotl(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+  }
+};
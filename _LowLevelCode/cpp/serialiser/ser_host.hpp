@@ -0,0 +1,110 @@
+#pragma once
+/*=========================================================
+ * ser_host.hpp
+ * Access to the MATLAB session used by the serialiser core.
+ *
+ * The mex gateways run the core against the MATLAB session. The C++
+ * tests and benchmarks install a standalone host instead, so the core
+ * can be driven from plain executables linked against libmx only.
+ * Objects and function handles need MATLAB callbacks and are reported
+ * as errors by the standalone host.
+ *=======================================================*/
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <mex.h>
+
+class ser_host {
+public:
+  virtual ~ser_host() {}
+  // Call a MATLAB function, as mexCallMATLAB
+  virtual void call_matlab(int nlhs, mxArray* plhs[], int nrhs, mxArray* prhs[], const char* name) = 0;
+  // Report an error. Must not return.
+  virtual void error(const char* id, const char* message) = 0;
+  // Keep an array alive after the mex function returns. The deserialiser does not
+  // use it: nested arrays stay temporary until their parent owns them, so MATLAB frees
+  // the ones in flight when a corrupt stream is reported.
+  virtual void make_persistent(mxArray* arr) = 0;
+
+  // Serialisation type of an object (see get_ser_type.m). It depends only on the
+  // class, so MATLAB is asked once per class until clear_cache is called.
+  uint8_t ser_type(const mxArray* obj) {
+    const std::string name(mxGetClassName(obj));
+    std::map<std::string, uint8_t>::const_iterator known = ser_types.find(name);
+    if (known != ser_types.end()) return known->second;
+
+    mxArray* result;
+    mxArray* arr = const_cast<mxArray*>(obj);
+    call_matlab(1, &result, 1, &arr, "get_ser_type");
+    const uint8_t type = (uint8_t) mxGetScalar(result);
+    mxDestroyArray(result);
+    ser_types[name] = type;
+    return type;
+  }
+
+  // Forget cached class information; called on entry to each mex function,
+  // as classes may be redefined between calls
+  void clear_cache() {
+    ser_types.clear();
+  }
+
+private:
+  std::map<std::string, uint8_t> ser_types;
+};
+
+// Host used by the mex files
+class mex_ser_host : public ser_host {
+public:
+  void call_matlab(int nlhs, mxArray* plhs[], int nrhs, mxArray* prhs[], const char* name) override {
+    mexCallMATLAB(nlhs, plhs, nrhs, prhs, name);
+  }
+  void error(const char* id, const char* message) override {
+    mexErrMsgIdAndTxt(id, message);
+  }
+  void make_persistent(mxArray* arr) override {
+    mexMakeArrayPersistent(arr);
+  }
+};
+
+// Host for running without MATLAB: errors become std::runtime_error.
+// Arrays made persistent are counted, as each one would outlive the mex call
+// in a MATLAB session unless a parent took it over.
+class standalone_ser_host : public ser_host {
+public:
+  standalone_ser_host() : n_persistent(0) {}
+  void call_matlab(int /*nlhs*/, mxArray* /*plhs*/[], int /*nrhs*/, mxArray* /*prhs*/[], const char* name) override {
+    throw std::runtime_error(std::string("MATLAB:serialise:no_matlab: can not call ") + name + " without MATLAB");
+  }
+  void error(const char* id, const char* message) override {
+    throw std::runtime_error(std::string(id) + ": " + message);
+  }
+  void make_persistent(mxArray* /*arr*/) override {
+    n_persistent++;
+  }
+  size_t persistent_arrays() const {
+    return n_persistent;
+  }
+
+private:
+  size_t n_persistent;
+};
+
+inline ser_host& default_ser_host() {
+  static mex_ser_host host;
+  return host;
+}
+
+inline ser_host*& current_ser_host() {
+  static ser_host* host = &default_ser_host();
+  return host;
+}
+
+inline ser_host& get_ser_host() {
+  return *current_ser_host();
+}
+
+// Install a host for the serialiser core; nullptr restores the MATLAB session host
+inline void set_ser_host(ser_host* host) {
+  current_ser_host() = host ? host : &default_ser_host();
+}
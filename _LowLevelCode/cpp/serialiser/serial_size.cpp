@@ -0,0 +1,209 @@
+/*=========================================================
+ * serial_size.cpp
+ * Calculate the size (in bytes) of Matlab structure, which would be produced by
+ *  hpl_serialize routine. Deduced from hlp_serialise.
+ * Core of c_serial_size, independent of the mex gateway.
+ *
+ * See also:
+ * hlp_serialize
+ * hlp_deserialize
+ *=======================================================*/
+
+#include <iostream>
+#include <cstring>
+#include <string>
+#include <cmath>
+#include <vector>
+#include "cpp_serialise.hpp"
+
+// Size of a struct array as laid out by write_struct in serialise.cpp
+static size_t struct_size(const struct_elements& elems, const mwSize* dims, const size_t nDims) {
+  const size_t nElem = elems.size();
+  size_t size = header_size(nElem, dims, nDims);
+  if (nElem == 0) return size;
+
+  const int nFields = mxGetNumberOfFields(elems[0].first);
+  size += NELEMS_SIZE*(nFields+1); // Nfields + name lens
+  for (int field=0; field < nFields; field++) {
+    size += strlen(mxGetFieldNameByNumber(elems[0].first, field)) * types_size[CHAR];
+  }
+  if (nFields == 0) return size;
+
+  if (nElem == 1) { // Contents as a nFields x 1 cell
+    const mwSize cellDims[] = {(mwSize) nFields, 1};
+    size += header_size(nFields, cellDims, 2);
+    for (int field = 0; field < nFields; field++) {
+      const mxArray* fieldElem = field_value(elems, 0, field);
+      size += (fieldElem == nullptr) ? TAG_SIZE : get_size(fieldElem);
+    }
+    return size;
+  }
+
+  for (int field = 0; field < nFields; field++) {
+    size += types_size[UINT8]; // Column kind
+    switch (column_kind(elems, field)) {
+    case COLUMN_DENSE:
+      {
+        const mxArray* first = field_value(elems, 0, field);
+        const size_t nPer = mxGetNumberOfElements(first);
+        size += header_size(nPer, mxGetDimensions(first), mxGetNumberOfDimensions(first)) +
+                nElem*nPer*types_size[tag_data(first).type];
+      }
+      break;
+    case COLUMN_STRUCT:
+      {
+        const mwSize rowDims[] = {1, nElem};
+        size += struct_size(column_elements(elems, field), rowDims, 2);
+      }
+      break;
+    default:
+      for (size_t obj = 0; obj < nElem; obj++) {
+        const mxArray* fieldElem = field_value(elems, obj, field);
+        size += (fieldElem == nullptr) ? TAG_SIZE : get_size(fieldElem);
+      }
+    }
+  }
+  return size;
+}
+
+size_t get_size(const mxArray *input) {
+  size_t size = 0;
+
+  tag_type tag = tag_data(input);
+
+  switch (tag.type) {
+  case SPARSE_LOGICAL:
+  case SPARSE_COMPLEX_DOUBLE:
+  case SPARSE_DOUBLE:
+    {
+
+      const mwSize* dims = mxGetDimensions(input);
+      // Assume null
+      bool isNotNull = false;
+      for (int i = 0; i < 2; i++) {
+        isNotNull = isNotNull || dims[i] > 0;
+      }
+
+      if (isNotNull) {
+        // Number of non-zeros is the last column pointer
+        size_t nElem = mxGetJc(input)[dims[1]];
+
+        size_t elemSize = types_size[tag.type];
+
+        size += sparse_header_size(dims, nElem) + sparse_index_size(dims, nElem) + nElem*elemSize; // Tag, Dims & nnz; jc & ir; data
+
+      } else {
+
+        size += TAG_SIZE + NELEMS_SIZE; // Tag & Dims;
+      }
+
+    }
+    break;
+  case INT8:
+  case UINT8:
+  case INT16:
+  case UINT16:
+  case INT32:
+  case UINT32:
+  case INT64:
+  case UINT64:
+  case SINGLE:
+  case DOUBLE:
+  case COMPLEX_INT8:
+  case COMPLEX_UINT8:
+  case COMPLEX_INT16:
+  case COMPLEX_UINT16:
+  case COMPLEX_INT32:
+  case COMPLEX_UINT32:
+  case COMPLEX_INT64:
+  case COMPLEX_UINT64:
+  case COMPLEX_SINGLE:
+  case COMPLEX_DOUBLE:
+  case LOGICAL:
+  case CHAR:
+    {
+      size_t nElem = mxGetNumberOfElements(input);
+      const mwSize* dims = mxGetDimensions(input);
+      size_t nDims = mxGetNumberOfDimensions(input);
+
+      size_t elemSize = types_size[tag.type];
+
+      size += header_size(nElem, dims, nDims) + elemSize*nElem;
+    }
+    break;
+
+  case FUNCTION_HANDLE:
+    {
+      mxArray* conts;
+      mxArray* arr = const_cast<mxArray *>(input);
+      get_ser_host().call_matlab(1, &conts, 1, &arr, "hlp_serial_sise");
+      size += (size_t) mxGetPr(conts)[0];
+    }
+    break;
+
+  case VALUE_OBJECT:
+    {
+      std::string name = std::string(mxGetClassName(input));
+      size_t class_name_size = TAG_SIZE + NELEMS_SIZE + name.size() * types_size[CHAR];
+
+
+      mxArray* arr = const_cast<mxArray*>(input);
+      if (get_ser_host().ser_type(input) == 0) { // object serializes itself so has serial_size method
+          mxArray* ser_size(nullptr);
+          get_ser_host().call_matlab(1, &ser_size, 1, &arr, "get_serial_size");
+          size += (size_t)mxGetScalar(ser_size)+ TAG_SIZE + class_name_size + 1;
+          break;
+      }
+
+      size_t nElem = mxGetNumberOfElements(input);
+      const mwSize* dims = mxGetDimensions(input);
+      size_t nDims = mxGetNumberOfDimensions(input);
+
+
+      mxArray* conts;
+      get_ser_host().call_matlab(1, &conts, 1, &arr, "get_object_conts");
+      size_t data_size = get_size(conts);
+
+      size += header_size(nElem, dims, nDims);
+      if (nElem > 0) {
+        size += class_name_size + 1 + data_size;
+      }
+    }
+
+    break;
+
+  case STRUCT:
+    size += struct_size(all_elements(input), mxGetDimensions(input), mxGetNumberOfDimensions(input));
+    break;
+
+  case CELL:
+    {
+      size_t nElem = mxGetNumberOfElements(input);
+      const mwSize* dims = mxGetDimensions(input);
+      size_t nDims = mxGetNumberOfDimensions(input);
+
+      size_t data_size = 0;
+      for (mwIndex i = 0; i < nElem; i++){
+        const mxArray* cellElem = mxGetCell(input, i);
+        data_size += (cellElem == nullptr) ? TAG_SIZE : get_size(cellElem);
+      }
+
+      size += header_size(nElem, dims, nDims) + data_size; // data_size is 0 for null
+
+    }
+    break;
+
+  case SERIALIZABLE:
+    {
+      mxArray* arr = const_cast<mxArray *>(input);
+      mxArray* conts;
+      get_ser_host().call_matlab(1, &conts, 1, &arr, "serial_size");
+      double out = *static_cast<double *>(mxGetData(conts));
+      size += types_size[UINT8] + out;
+    }
+    break;
+
+  }
+  return size;
+
+}
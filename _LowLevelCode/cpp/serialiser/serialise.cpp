@@ -0,0 +1,480 @@
+/*=========================================================
+ * serialise.cpp
+ * Serialise MATLAB object into a uint8 data stream.
+ * Core of c_serialise, independent of the mex gateway.
+ *
+ * The walk over the object is shared by two outputs: the byte
+ * buffer of the serialised stream, and a streaming hash of the
+ * bytes which would have been written (serial_hash).
+ *
+ * See also:
+ * hlp_serialise
+ * hlp_deserialise
+ *=======================================================*/
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <vector>
+#include "cpp_serialise.hpp"
+#include "ser_hash.hpp"
+
+template<typename T>
+inline void ser(uint8_t* data, size_t& memPtr, const std::vector<T>& data_in, const size_t amount) {
+  memcpy(&data[memPtr], data_in.data(), amount);
+  memPtr += amount;
+}
+
+inline void ser(uint8_t* data, size_t& memPtr, const void* const data_in, const size_t amount) {
+  // Write bytes and move memory index
+  memcpy(&data[memPtr], data_in, amount);
+  memPtr += amount;
+}
+
+template<typename T>
+inline void ser(ser_hash128* hash, size_t& memPtr, const std::vector<T>& data_in, const size_t amount) {
+  hash->update(data_in.data(), amount);
+  memPtr += amount;
+}
+
+inline void ser(ser_hash128* hash, size_t& memPtr, const void* const data_in, const size_t amount) {
+  // Hash bytes instead of writing them
+  hash->update(data_in, amount);
+  memPtr += amount;
+}
+
+#if MX_HAS_INTERLEAVED_COMPLEX
+// Write the block of real parts followed by the block of imaginary parts
+inline void write_complex(uint8_t* data, size_t& memPtr, const void* cmplx, const size_t compSize, const size_t nElem) {
+  deinterleave(cmplx, &data[memPtr], &data[memPtr + nElem*compSize], compSize, nElem);
+  memPtr += 2*nElem*compSize;
+}
+
+// Write the real (part 0) or imaginary (part 1) parts of interleaved complex data,
+// split through a small buffer
+template<typename Out>
+inline void write_complex_part(Out data, size_t& memPtr, const void* cmplx, const size_t compSize,
+                               const size_t nElem, const int part) {
+  const size_t CHUNK = 4096;
+  std::vector<uint8_t> re(CHUNK*compSize), im(CHUNK*compSize);
+  const uint8_t* src = static_cast<const uint8_t*>(cmplx);
+
+  for (size_t start = 0; start < nElem; start += CHUNK) {
+    size_t n = (nElem - start < CHUNK) ? nElem - start : CHUNK;
+    deinterleave(src + 2*start*compSize, re.data(), im.data(), compSize, n);
+    ser(data, memPtr, part == 0 ? re.data() : im.data(), n*compSize);
+  }
+}
+
+inline void write_complex(ser_hash128* hash, size_t& memPtr, const void* cmplx, const size_t compSize, const size_t nElem) {
+  // All real parts go to the hash before any imaginary part
+  write_complex_part(hash, memPtr, cmplx, compSize, nElem, 0);
+  write_complex_part(hash, memPtr, cmplx, compSize, nElem, 1);
+}
+#endif
+
+template<typename Out>
+inline void write_data(Out data, size_t& memPtr, const mxArray* const input, const size_t elemSize, const size_t nElem) {
+  if (mxIsComplex(input)) {
+    // Size of a complex component is half that of the whole complex
+    size_t compSize = elemSize/2;
+
+#if MX_HAS_INTERLEAVED_COMPLEX
+    const void* toWrite = mxGetData(input);
+    // Real parts first, imaginary block straight after them
+    write_complex(data, memPtr, toWrite, compSize, nElem);
+
+#else
+    void* toWrite = mxGetPr(input);
+    ser(data, memPtr, toWrite, compSize*nElem);
+    toWrite = mxGetPi(input);
+    ser(data, memPtr, toWrite, compSize*nElem);
+
+#endif
+
+  } else {
+    void* toWrite = mxGetData(input);
+    ser(data, memPtr, toWrite, elemSize*nElem);
+  }
+}
+
+// Write a count or dimension in the width selected for the current header
+template<typename Out>
+inline void write_dim(Out data, size_t& memPtr, const size_t value, const bool large) {
+  if (large) {
+    uint64_t val = value;
+    ser(data, memPtr, &val, DIMS64_SIZE);
+  } else {
+    uint32_t val = (uint32_t) value;
+    ser(data, memPtr, &val, DIMS_SIZE);
+  }
+}
+
+// Write sparse array indices in the width selected for the current header
+template<typename Out>
+inline void write_indices(Out data, size_t& memPtr, const mwIndex* idx, const size_t nIdx, const bool large) {
+  if (large && sizeof(mwIndex) == DIMS64_SIZE) {
+    ser(data, memPtr, idx, nIdx*DIMS64_SIZE);
+  } else {
+    for (size_t i = 0; i < nIdx; i++) write_dim(data, memPtr, idx[i], large);
+  }
+}
+
+template<typename Out>
+inline void write_header(Out data, size_t& memPtr, tag_type& tag,
+                         const size_t nElem, const mwSize* dims, const size_t nDims,
+                         const uint8_t typeFlags = 0) {
+
+  const bool large = needs_dim64(nElem);
+  const uint8_t flag = (large ? DIM64_FLAG : 0) | typeFlags;
+
+  if (nElem == 0) { // Null
+    tag.dim = 0;
+    ser(data, memPtr, &tag, TAG_SIZE);
+    // ser(data, memPtr, &nElem, types_size[UINT32]);
+  }
+  else if (nElem == 1) { // Scalar
+    tag.dim = 1 | flag;
+    ser(data, memPtr, &tag, TAG_SIZE);
+    write_dim(data, memPtr, nElem, large);
+  }
+  else if (nDims == 2 && dims[0] == 1) { // List
+    tag.dim = 1 | flag;
+    ser(data, memPtr, &tag, TAG_SIZE);
+    write_dim(data, memPtr, nElem, large);
+  }
+  else { // General array
+    tag.dim = nDims | flag;
+
+    ser(data, memPtr, &tag, TAG_SIZE);
+    for (size_t i = 0; i < nDims; i++) write_dim(data, memPtr, dims[i], large);
+  }
+
+}
+
+
+// Unset cell elements and struct fields are written as empty double, []
+template<typename Out>
+inline void write_empty(Out data, size_t& memPtr) {
+  tag_type tag;
+  tag.type = DOUBLE;
+  tag.dim = 0;
+  ser(data, memPtr, &tag, TAG_SIZE);
+}
+
+template<typename Out>
+void serialise_to(Out data, size_t& memPtr, const mxArray* input);
+
+// Serializable objects are written as the stream their serialize method returns
+inline void write_serializable(uint8_t* data, size_t& memPtr, const mxArray* input) {
+  mxArray* conts;
+  mxArray* arr = const_cast<mxArray*>(input);
+  get_ser_host().call_matlab(1, &conts, 1, &arr, "serialize");
+  ser(data, memPtr, mxGetData(conts), mxGetNumberOfElements(conts)*types_size[UINT8]);
+  mxDestroyArray(conts);
+}
+
+// serializable.serialize returns serialise(to_struct(obj)), so the hash walks the structure
+// to_struct returns rather than having the stream built. A class overloading serialize is
+// hashed by its to_struct too, so its hash is not the hash of its serialised stream.
+inline void write_serializable(ser_hash128* hash, size_t& memPtr, const mxArray* input) {
+  mxArray* conts;
+  mxArray* arr = const_cast<mxArray*>(input);
+  get_ser_host().call_matlab(1, &conts, 1, &arr, "to_struct");
+  serialise_to(hash, memPtr, conts);
+  mxDestroyArray(conts);
+}
+
+template<typename Out>
+void write_struct(Out data, size_t& memPtr, const struct_elements& elems, const mwSize* dims, const size_t nDims);
+
+// Data of one field over all elements of a struct array, which share class and shape
+template<typename Out>
+void write_dense_column(Out data, size_t& memPtr, const struct_elements& elems, const int field,
+                        const size_t elemSize, const size_t nPer) {
+  const size_t nElem = elems.size();
+  const mxArray* first = field_value(elems, 0, field);
+
+  if (mxIsChar(first)) {
+    std::vector<char> arr(nPer + 1);
+    for (size_t obj = 0; obj < nElem; obj++) {
+      mxGetString(field_value(elems, obj, field), arr.data(), nPer + 1);
+      ser(data, memPtr, arr, nPer*types_size[CHAR]);
+    }
+  } else if (mxIsComplex(first)) {
+    const size_t compSize = elemSize/2;
+    for (int part = 0; part < 2; part++) {
+      for (size_t obj = 0; obj < nElem; obj++) {
+        const mxArray* value = field_value(elems, obj, field);
+#if MX_HAS_INTERLEAVED_COMPLEX
+        write_complex_part(data, memPtr, mxGetData(value), compSize, nPer, part);
+#else
+        ser(data, memPtr, part == 0 ? mxGetData(value) : mxGetImagData(value), compSize*nPer);
+#endif
+      }
+    }
+  } else {
+    for (size_t obj = 0; obj < nElem; obj++) {
+      ser(data, memPtr, mxGetData(field_value(elems, obj, field)), elemSize*nPer);
+    }
+  }
+}
+
+// Struct array, or the scalar structs of a COLUMN_STRUCT column as a 1xN struct array
+template<typename Out>
+void write_struct(Out data, size_t& memPtr, const struct_elements& elems, const mwSize* dims, const size_t nDims) {
+  const size_t nElem = elems.size();
+  const uint32_t nFields = (nElem > 0) ? mxGetNumberOfFields(elems[0].first) : 0;
+  const bool columns = nElem > 1 && nFields > 0;
+
+  if (nElem > 1 && nDims >= STRUCT_COLUMNS_FLAG) {
+    get_ser_host().error("MATLAB:serialise:bad_size", "Struct arrays of more than 63 dimensions cannot be serialised.");
+  }
+
+  tag_type tag;
+  tag.type = STRUCT;
+  write_header(data, memPtr, tag, nElem, dims, nDims, columns ? STRUCT_COLUMNS_FLAG : 0);
+  if (nElem == 0) return;
+
+  ser(data, memPtr, &nFields, types_size[UINT32]);
+
+  // All name lengths, then all names
+  const mxArray* names = elems[0].first;
+  for (uint32_t field=0; field < nFields; field++) {
+    uint32_t size = (uint32_t) strlen(mxGetFieldNameByNumber(names, field));
+    ser(data, memPtr, &size, types_size[UINT32]);
+  }
+  for (uint32_t field=0; field < nFields; field++) {
+    const char* name = mxGetFieldNameByNumber(names, field);
+    ser(data, memPtr, name, strlen(name)*types_size[CHAR]);
+  }
+  if (nFields == 0) return;
+
+  if (!columns) {
+    // Contents in the struct2cell layout, walked in place rather than copied by MATLAB
+    tag_type cellTag;
+    cellTag.type = CELL;
+    const mwSize cellDims[] = {nFields, 1};
+    write_header(data, memPtr, cellTag, nFields, cellDims, 2);
+    for (uint32_t field = 0; field < nFields; field++) {
+      const mxArray* fieldElem = field_value(elems, 0, field);
+      if (fieldElem == nullptr) {
+        write_empty(data, memPtr);
+      } else {
+        serialise_to(data, memPtr, fieldElem);
+      }
+    }
+    return;
+  }
+
+  for (uint32_t field = 0; field < nFields; field++) {
+    uint8_t kind = column_kind(elems, field);
+    ser(data, memPtr, &kind, types_size[UINT8]);
+
+    switch (kind) {
+    case COLUMN_DENSE:
+      {
+        const mxArray* first = field_value(elems, 0, field);
+        tag_type elemTag = tag_data(first);
+        const size_t nPer = mxGetNumberOfElements(first);
+        write_header(data, memPtr, elemTag, nPer, mxGetDimensions(first), mxGetNumberOfDimensions(first));
+        write_dense_column(data, memPtr, elems, field, types_size[elemTag.type], nPer);
+      }
+      break;
+    case COLUMN_STRUCT:
+      {
+        const mwSize rowDims[] = {1, nElem};
+        write_struct(data, memPtr, column_elements(elems, field), rowDims, 2);
+      }
+      break;
+    default:
+      for (size_t obj = 0; obj < nElem; obj++) {
+        const mxArray* fieldElem = field_value(elems, obj, field);
+        if (fieldElem == nullptr) {
+          write_empty(data, memPtr);
+        } else {
+          serialise_to(data, memPtr, fieldElem);
+        }
+      }
+    }
+  }
+}
+
+template<typename Out>
+void serialise_to(Out data, size_t& memPtr, const mxArray* input){
+
+
+  tag_type tag = tag_data(input);
+  size_t nElem = mxGetNumberOfElements(input);
+  const mwSize* dims = mxGetDimensions(input);
+  size_t nDims = mxGetNumberOfDimensions(input);
+
+  if (nDims > NDIMS_MASK) {
+    get_ser_host().error("MATLAB:serialise:bad_size", "Number of array dimensions exceeds limit of 127, cannot serialise.");
+  }
+
+
+  switch (tag.type) {
+    // Sparse
+  case SPARSE_LOGICAL:
+  case SPARSE_DOUBLE:
+  case SPARSE_COMPLEX_DOUBLE:
+    {
+
+
+      // Assume null
+      bool isNotNull = false;
+      for (int i = 0; i < nDims; i++) {
+        isNotNull = isNotNull || dims[i] > 0;
+      }
+
+      if (isNotNull) {
+
+        mwIndex* ir = mxGetIr(input);
+        mwIndex* jc = mxGetJc(input);
+        size_t nnz = jc[dims[1]];
+
+        const bool large = needs_dim64(dims, nnz);
+        tag.dim = 2 | SPARSE_CSC_FLAG | (large ? DIM64_FLAG : 0);
+        ser(data, memPtr, &tag, TAG_SIZE);
+        write_dim(data, memPtr, dims[0], large);
+        write_dim(data, memPtr, dims[1], large);
+        write_dim(data, memPtr, nnz, large);
+
+        // Indices go out as MATLAB holds them, narrowed to uint32 when they fit
+        write_indices(data, memPtr, jc, dims[1] + 1, large);
+        write_indices(data, memPtr, ir, nnz, large);
+
+        write_data(data, memPtr, input, types_size[tag.type], nnz);
+
+      } else {
+
+        uint32_t nil = 0;
+
+        tag.dim = 0;
+        ser(data, memPtr, &tag, TAG_SIZE);
+        ser(data, memPtr, &nil, types_size[UINT32]);
+      }
+    }
+    break;
+  case CHAR:
+    {
+
+      write_header(data, memPtr, tag, nElem, dims, nDims);
+      std::vector<char> arr(nElem+1);
+      // Copies with NULL terminator, don't write with
+      mxGetString(input, arr.data(), nElem+1);
+      ser(data, memPtr, arr, nElem*types_size[CHAR]);
+    }
+    break;
+  case INT8:
+  case UINT8:
+  case INT16:
+  case UINT16:
+  case INT32:
+  case UINT32:
+  case INT64:
+  case UINT64:
+  case SINGLE:
+  case DOUBLE:
+  case LOGICAL:
+  case COMPLEX_INT8:
+  case COMPLEX_UINT8:
+  case COMPLEX_INT16:
+  case COMPLEX_UINT16:
+  case COMPLEX_INT32:
+  case COMPLEX_UINT32:
+  case COMPLEX_INT64:
+  case COMPLEX_UINT64:
+  case COMPLEX_SINGLE:
+  case COMPLEX_DOUBLE:
+    {
+
+      write_header(data, memPtr, tag, nElem, dims, nDims);
+      write_data(data, memPtr, input, types_size[tag.type], nElem);
+
+    }
+    break;
+
+  case FUNCTION_HANDLE:
+    {
+      // Fall back to MATLAB
+      mxArray* conts;
+      mxArray* arr = const_cast<mxArray*>(input);
+      get_ser_host().call_matlab(1, &conts, 1, &arr, "hlp_serialise");
+      ser(data, memPtr, mxGetData(conts), mxGetNumberOfElements(conts)*types_size[UINT8]);
+    }
+    break;
+
+  case VALUE_OBJECT:
+    {
+      mxArray* arr = const_cast<mxArray*>(input);
+      const uint8_t ser_type = get_ser_host().ser_type(input);
+
+      if (!ser_type) { // object serializes itself together with dimensions transforming array structure into structure array
+          nElem = 1;
+          nDims = 2;
+      }
+
+      write_header(data, memPtr, tag, nElem, dims, nDims);
+
+      const char* name = mxGetClassName(input);
+      tag_type name_tag;
+      name_tag.type = CHAR;
+      const mwSize name_dim[] = {1, strlen(name)};
+      write_header(data, memPtr, name_tag, name_dim[1], name_dim, 2);
+      ser(data, memPtr, name, name_dim[1]*types_size[CHAR]);
+
+
+      ser(data, memPtr, &ser_type, types_size[UINT8]);
+
+      mxArray* conts;
+      get_ser_host().call_matlab(1, &conts, 1, &arr, "get_object_conts");
+      serialise_to(data, memPtr, conts);
+      mxDestroyArray(conts);
+
+
+    }
+    break;
+
+  case STRUCT:
+    write_struct(data, memPtr, all_elements(input), dims, nDims);
+    break;
+
+  case CELL:
+    {
+
+      write_header(data, memPtr, tag, nElem, dims, nDims);
+      for (mwIndex i = 0; i < nElem; i++){
+        const mxArray* cellElem = mxGetCell(input, i);
+        if (cellElem == nullptr) {
+          write_empty(data, memPtr);
+        } else {
+          serialise_to(data, memPtr, cellElem);
+        }
+      }
+
+    }
+    break;
+  case SERIALIZABLE:
+    {
+      ser(data, memPtr, &tag.type, types_size[UINT8]);
+      write_serializable(data, memPtr, input);
+    }
+    break;
+  }
+}
+
+void serialise(uint8_t* data, size_t& memPtr, const mxArray* input) {
+  serialise_to(data, memPtr, input);
+}
+
+void serial_hash(const mxArray* input, uint8_t hash[SER_HASH_SIZE]) {
+  ser_hash128 hasher;
+  size_t memPtr = 0;
+  serialise_to(&hasher, memPtr, input);
+
+  uint64_t words[2];
+  hasher.finalise(words);
+  memcpy(hash, words, SER_HASH_SIZE);
+}
@@ -2,9 +2,11 @@
 #include "cpp_communicator/input_parser.h"
 #include "cpp_communicator/cpp_communicator.h"
 #include "utility/environment.h"
+#include "test/serialiser.tests/ser_test_arrays.h"
 
 #include <gtest/gtest.h>
 
+#include <stdexcept>
 #include <vector>
 
 using namespace Herbert::Utility;
@@ -1054,6 +1056,63 @@ TEST(TestCPPCommunicator, MPI_wraper_ser_deser_info) {
 
 }
 
+TEST(TestCPPCommunicator, receive_deserialises_from_receive_buffer) {
+    MPI_wrapper::MPI_wrapper_gtested = true;
+    standalone_ser_host host;
+    set_ser_host(&host);
+
+    InitParamHolder init_par;
+    init_par.is_tested = true;
+    init_par.async_queue_length = 4;
+    init_par.data_message_tag = 9;
+    init_par.interrupt_tag = 1010;
+    init_par.debug_frmwk_param[0] = 1;
+    init_par.debug_frmwk_param[1] = 10;
+
+    auto wrap = MPI_wrapper();
+    wrap.init(init_par);
+
+    // two synchronous messages: the second waits in the queue and takes the place of the first one
+    // when the first one is received
+    mxArray* first = ser_test::make_nested_cell(5, 2);
+    mxArray* second = ser_test::make_double(30, 20);
+    std::vector<uint8_t> first_mess = ser_test::serialise_to_vector(first);
+    std::vector<uint8_t> second_mess = ser_test::serialise_to_vector(second);
+    wrap.labSend(9, 3, true, &first_mess[0], first_mess.size());
+    wrap.labSend(9, 3, true, &second_mess[0], second_mess.size());
+
+    mxArray *plhs[(int)labReceive_Out::MAX_N_Outputs];
+    wrap.labReceive(9, 3, false, plhs, (int)labReceive_Out::MAX_N_Outputs, true);
+    auto pAddress = reinterpret_cast<int32_t*>(mxGetData(plhs[(int)labReceive_Out::real_source_address]));
+    EXPECT_EQ(pAddress[0], 9);
+    EXPECT_EQ(pAddress[1], 3);
+    auto out = plhs[(int)labReceive_Out::mess_contents];
+    EXPECT_TRUE(ser_test::same_array(out, first));
+    mxDestroyArray(out);
+
+    wrap.labReceive(9, 3, false, plhs, (int)labReceive_Out::MAX_N_Outputs, true);
+    out = plhs[(int)labReceive_Out::mess_contents];
+    EXPECT_TRUE(ser_test::same_array(out, second));
+    mxDestroyArray(out);
+    ASSERT_FALSE(wrap.any_message_present());
+
+    // no message -- empty output
+    wrap.labReceive(9, 3, false, plhs, (int)labReceive_Out::MAX_N_Outputs, true);
+    out = plhs[(int)labReceive_Out::mess_contents];
+    EXPECT_TRUE(mxIsEmpty(out));
+    mxDestroyArray(out);
+
+    // a corrupt message is reported by the deserialiser
+    second_mess.resize(second_mess.size() / 2);
+    wrap.labSend(9, 4, false, &second_mess[0], second_mess.size());
+    EXPECT_THROW(wrap.labReceive(9, 4, false, plhs, (int)labReceive_Out::MAX_N_Outputs, true), std::runtime_error);
+    EXPECT_EQ(host.persistent_arrays(), 0u);
+
+    mxDestroyArray(first);
+    mxDestroyArray(second);
+    set_ser_host(nullptr);
+}
+
 
 int main(int argc, char** argv) {
     ::testing::InitGoogleTest(&argc, argv);
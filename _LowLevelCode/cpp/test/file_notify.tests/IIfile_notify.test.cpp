@@ -0,0 +1,97 @@
+#include "file_notify/file_notify.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#ifdef __linux__
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+typedef std::chrono::steady_clock test_clock;
+
+// append a byte to the sentinel file, the way the writers notify the readers
+void append_byte(const std::string &file_name) {
+  std::FILE *fh = std::fopen(file_name.c_str(), "ab");
+  ASSERT_TRUE(fh != NULL);
+  std::fputc(1, fh);
+  std::fclose(fh);
+}
+
+double seconds_since(test_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::duration<double>>(test_clock::now() - start)
+      .count();
+}
+} // namespace
+
+TEST(TestFileNotify, sequence_is_size_of_file) {
+  const std::string file_name = ::testing::TempDir() + "file_notify_sequence.seq";
+  std::remove(file_name.c_str());
+  EXPECT_EQ(file_sequence(file_name), -1);
+  append_byte(file_name);
+  EXPECT_EQ(file_sequence(file_name), 1);
+  append_byte(file_name);
+  EXPECT_EQ(file_sequence(file_name), 2);
+  std::remove(file_name.c_str());
+}
+
+TEST(TestFileNotify, returns_at_once_when_changed_and_times_out_otherwise) {
+  const std::string file_name = ::testing::TempDir() + "file_notify_timeout.seq";
+  std::remove(file_name.c_str());
+  append_byte(file_name);
+
+  test_clock::time_point start = test_clock::now();
+  EXPECT_EQ(wait_for_change(file_name, -1, 10., 0.01), 1);
+  EXPECT_LT(seconds_since(start), 5.);
+
+  start = test_clock::now();
+  EXPECT_EQ(wait_for_change(file_name, 1, 0.2, 0.01), 1);
+  EXPECT_GE(seconds_since(start), 0.19);
+  std::remove(file_name.c_str());
+}
+
+TEST(TestFileNotify, wakes_when_other_thread_appends) {
+  const std::string file_name = ::testing::TempDir() + "file_notify_wake.seq";
+  std::remove(file_name.c_str());
+
+  std::thread writer([&file_name]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    append_byte(file_name);
+  });
+  const test_clock::time_point start = test_clock::now();
+  bool notified(false);
+  const long long seq = wait_for_change(file_name, -1, 30., 0.05, &notified);
+  const double elapsed = seconds_since(start);
+  writer.join();
+
+  EXPECT_EQ(seq, 1);
+  EXPECT_LT(elapsed, 10.);
+#ifdef __linux__
+  EXPECT_EQ(notified, !is_network_folder(::testing::TempDir()));
+#endif
+  std::remove(file_name.c_str());
+}
+
+#ifdef __linux__
+TEST(TestFileNotify, returns_when_folder_is_removed) {
+  const std::string folder = ::testing::TempDir() + "file_notify_removed";
+  ASSERT_EQ(mkdir(folder.c_str(), 0700), 0);
+  const std::string file_name = folder + "/arrivals.seq";
+
+  std::thread remover([&folder]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    rmdir(folder.c_str());
+  });
+  const test_clock::time_point start = test_clock::now();
+  EXPECT_EQ(wait_for_change(file_name, -1, 30., 0.05), -1);
+  const double elapsed = seconds_since(start);
+  remover.join();
+  if (!is_network_folder(::testing::TempDir())) {
+    EXPECT_LT(elapsed, 10.);
+  }
+}
+#endif
@@ -1,18 +1,776 @@
+#include "get_ascii_file/ascii_cache.h"
+#include "get_ascii_file/ascii_prefetch.h"
 #include "get_ascii_file/get_ascii_file.h"
+#include "get_ascii_file/map_file.h"
+#include "get_ascii_file/parse_double.h"
 #include "utility/environment.h"
 
 #include <gtest/gtest.h>
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
 #include <iostream>
+#include <random>
 #include <string>
+#include <thread>
+#include <vector>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
 
 using namespace Herbert::Utility;
 
+namespace {
+// SPE file contents loaded by one of the loaders
+struct spe_data {
+  std::vector<double> S, ERR, en;
+};
+
+spe_data load_with_stream(const std::string &file_name) {
+  ascii_file_parser parser;
+  FileTypeDescriptor desc = parser.open(file_name);
+  spe_data data;
+  data.S.resize(desc.nData_blocks * desc.nData_records);
+  data.ERR.resize(data.S.size());
+  data.en.resize(desc.nData_blocks + 1);
+  parser.load_spe(data.S.data(), data.ERR.data(), data.en.data());
+  return data;
+}
+
+spe_data load_with_mapping(const std::string &file_name, unsigned int n_threads) {
+  ascii_file_parser parser;
+  FileTypeDescriptor desc = parser.open(file_name);
+  parser.close();
+  spe_data data;
+  data.S.resize(desc.nData_blocks * desc.nData_records);
+  data.ERR.resize(data.S.size());
+  data.en.resize(desc.nData_blocks + 1);
+  EXPECT_TRUE(parser.load_spe_mapped(data.S.data(), data.ERR.data(),
+                                     data.en.data(), n_threads));
+  return data;
+}
+
+void expect_same(const std::vector<double> &a, const std::vector<double> &b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); i++) {
+    if (std::isnan(a[i])) {
+      EXPECT_TRUE(std::isnan(b[i])) << "at " << i;
+    } else {
+      EXPECT_EQ(a[i], b[i]) << "at " << i;
+    }
+  }
+}
+
+void expect_same(const spe_data &a, const spe_data &b) {
+  expect_same(a.S, b.S);
+  expect_same(a.ERR, b.ERR);
+  expect_same(a.en, b.en);
+}
+
+// Write SPE data in rows of 8 fields of 10 symbols
+void write_block(std::ofstream &out, const std::vector<double> &values,
+                 const char *eol) {
+  char field[32];
+  for (size_t i = 0; i < values.size(); i++) {
+    if (i % 7 == 3 && values.size() > 20) {
+      snprintf(field, sizeof(field), "%-10.3E", values[i]);
+    } else {
+      snprintf(field, sizeof(field), "%-10.4g", values[i]);
+    }
+    out << field;
+    if (i % 8 == 7 || i + 1 == values.size())
+      out << eol;
+  }
+}
+
+std::string write_spe(const std::string &name, size_t ndet, size_t ne,
+                      const char *eol) {
+  const std::string file_name = ::testing::TempDir() + name;
+  std::ofstream out(file_name.c_str(), std::ios_base::binary);
+  out << " " << ndet << "   " << ne << eol << "### Phi Grid" << eol;
+  write_block(out, std::vector<double>(ndet + 1, 57.3), eol);
+  out << "### Energy Grid" << eol;
+  std::vector<double> en(ne + 1);
+  for (size_t i = 0; i <= ne; i++)
+    en[i] = -10. + 0.5 * i;
+  write_block(out, en, eol);
+  std::vector<double> block(ne);
+  for (size_t j = 0; j < ndet; j++) {
+    for (size_t i = 0; i < ne; i++)
+      block[i] = std::sin(0.37 * (i + 1) * (j + 1)) * std::pow(10., (int)(i % 9) - 4);
+    out << "### S(Phi,w)" << eol;
+    write_block(out, block, eol);
+    for (size_t i = 0; i < ne; i++)
+      block[i] = std::fabs(block[i]) * 0.1;
+    out << "### Errors" << eol;
+    write_block(out, block, eol);
+  }
+  return file_name;
+}
+} // namespace
+
 TEST(TestGetAsciiFile, get_ASCII_header_identifies_spe_header_type) {
   const std::string herbert_root{
       Environment::get_env_variable(Environment::HERBERT_ROOT, ".")};
   std::string spe_file{herbert_root + "/_test/common_data/MAP10001.spe"};
-  std::ifstream data_stream;
-  auto file_descriptor{get_ASCII_header(spe_file, data_stream)};
+  ascii_file_parser parser;
+  auto file_descriptor{parser.open(spe_file)};
   ASSERT_EQ(file_descriptor.Type, fileTypes::iSPE_type);
 }
+
+TEST(TestGetAsciiFile, mapped_spe_loader_keeps_NaN_as_stream_loader) {
+  const std::string herbert_root{
+      Environment::get_env_variable(Environment::HERBERT_ROOT, ".")};
+  std::string spe_file{herbert_root + "/_test/common_data/spe_with_NANs.spe"};
+  spe_data mapped = load_with_mapping(spe_file, 1);
+  expect_same(load_with_stream(spe_file), mapped);
+  EXPECT_TRUE(std::isnan(mapped.S[0]));
+  EXPECT_TRUE(std::isnan(mapped.S[1]));
+}
+
+TEST(TestGetAsciiFile, mapped_spe_loader_matches_stream_loader_on_threads) {
+  const char *eols[] = {"\n", "\r\n"};
+  for (const char *eol : eols) {
+    std::string spe_file = write_spe("threads.spe", 517, 37, eol);
+    spe_data expected = load_with_stream(spe_file);
+    expect_same(expected, load_with_mapping(spe_file, 1));
+    expect_same(expected, load_with_mapping(spe_file, 4));
+    std::remove(spe_file.c_str());
+  }
+}
+
+TEST(TestGetAsciiFile, mapped_spe_loader_reports_truncated_file) {
+  std::string spe_file = write_spe("truncated.spe", 20, 12, "\n");
+  std::string contents;
+  {
+    std::ifstream in(spe_file.c_str(), std::ios_base::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(spe_file.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    out << contents.substr(0, contents.size() - 50);
+  }
+  EXPECT_THROW(load_with_mapping(spe_file, 2), ascii_file_error);
+  std::remove(spe_file.c_str());
+}
+
+// Load detectors and energy bins ranges through the mapping
+spe_data load_range(const std::string &file_name, size_t first_det, size_t n_det,
+                    size_t first_en, size_t n_en) {
+  ascii_file_parser parser;
+  parser.open(file_name);
+  parser.close();
+  spe_data data;
+  data.S.resize(n_det * n_en);
+  data.ERR.resize(n_det * n_en);
+  data.en.resize(n_en + 1);
+  EXPECT_TRUE(parser.load_spe_range(data.S.data(), data.ERR.data(), data.en.data(),
+                                    first_det, n_det, first_en, n_en, 2));
+  return data;
+}
+
+// Part of the full data, which load_range should return
+spe_data slice(const spe_data &full, size_t ne, size_t first_det, size_t n_det,
+               size_t first_en, size_t n_en) {
+  spe_data part;
+  for (size_t j = first_det; j < first_det + n_det; j++) {
+    for (size_t i = first_en; i < first_en + n_en; i++) {
+      part.S.push_back(full.S[j * ne + i]);
+      part.ERR.push_back(full.ERR[j * ne + i]);
+    }
+  }
+  part.en.assign(full.en.begin() + first_en, full.en.begin() + first_en + n_en + 1);
+  return part;
+}
+
+TEST(TestGetAsciiFile, spe_range_is_slice_of_the_full_data) {
+  const char *eols[] = {"\n", "\r\n"};
+  const size_t ranges[][4] = {{0, 53, 0, 29}, {10, 7, 3, 12}, {52, 1, 28, 1}, {0, 1, 8, 8}, {20, 33, 5, 24}};
+  for (const char *eol : eols) {
+    std::string spe_file = write_spe("range.spe", 53, 29, eol);
+    spe_data full = load_with_stream(spe_file);
+    for (const auto &range : ranges) {
+      expect_same(slice(full, 29, range[0], range[1], range[2], range[3]),
+                  load_range(spe_file, range[0], range[1], range[2], range[3]));
+    }
+    std::remove(spe_file.c_str());
+  }
+}
+
+TEST(TestGetAsciiFile, spe_range_finds_blocks_of_different_length) {
+  std::string spe_file = write_spe("uneven.spe", 30, 19, "\n");
+  std::string contents;
+  {
+    std::ifstream in(spe_file.c_str(), std::ios_base::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  // a longer separator line in the middle shifts all following blocks
+  size_t pos = 0;
+  for (int i = 0; i < 12; i++)
+    pos = contents.find("### Errors", pos + 1);
+  contents.insert(pos + 10, "   ");
+  {
+    std::ofstream out(spe_file.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    out << contents;
+  }
+  spe_data full = load_with_stream(spe_file);
+  expect_same(slice(full, 19, 20, 6, 2, 9), load_range(spe_file, 20, 6, 2, 9));
+  expect_same(slice(full, 19, 0, 30, 0, 19), load_range(spe_file, 0, 30, 0, 19));
+  std::remove(spe_file.c_str());
+}
+
+TEST(TestGetAsciiFile, spe_range_outside_of_the_file_throws) {
+  std::string spe_file = write_spe("outside.spe", 10, 8, "\n");
+  ascii_file_parser parser;
+  parser.open(spe_file);
+  std::vector<double> S(100), ERR(100), en(100);
+  EXPECT_THROW(parser.load_spe_range(S.data(), ERR.data(), en.data(), 5, 6, 0, 8), ascii_file_error);
+  EXPECT_THROW(parser.load_spe_range(S.data(), ERR.data(), en.data(), 0, 10, 1, 8), ascii_file_error);
+  EXPECT_THROW(parser.load_spe_range(S.data(), ERR.data(), en.data(), 0, 0, 0, 8), ascii_file_error);
+  parser.close();
+  std::remove(spe_file.c_str());
+}
+
+TEST(TestGetAsciiFile, load_ascii_files_loads_files_concurrently) {
+  std::vector<std::string> files;
+  std::vector<spe_data> expected;
+  for (size_t i = 0; i < 6; i++) {
+    files.push_back(write_spe("batch" + std::to_string(i) + ".spe", 40 + 7 * i, 9 + i,
+                              i % 2 ? "\r\n" : "\n"));
+    expected.push_back(load_with_stream(files.back()));
+  }
+  files.insert(files.begin() + 2, ::testing::TempDir() + "missing_batch.spe");
+
+  std::vector<ascii_file_data> loaded = load_ascii_files(files, 3);
+  ASSERT_EQ(loaded.size(), files.size());
+  EXPECT_FALSE(loaded[2].error.empty());
+  EXPECT_TRUE(loaded[2].data[0].empty());
+  for (size_t i = 0, k = 0; i < loaded.size(); i++) {
+    EXPECT_EQ(loaded[i].fileName, files[i]);
+    if (i == 2)
+      continue;
+    ASSERT_TRUE(loaded[i].error.empty()) << loaded[i].error;
+    EXPECT_EQ(loaded[i].descriptor.Type, fileTypes::iSPE_type);
+    expect_same(loaded[i].data[0], expected[k].S);
+    expect_same(loaded[i].data[1], expected[k].ERR);
+    expect_same(loaded[i].data[2], expected[k].en);
+    k++;
+    std::remove(files[i].c_str());
+  }
+}
+
+TEST(TestGetAsciiFile, header_only_load_reads_descriptors_and_energies) {
+  std::vector<std::string> files;
+  files.push_back(write_spe("header0.spe", 53, 11, "\r\n"));
+  files.push_back(::testing::TempDir() + "header1.par");
+  {
+    std::ofstream out(files.back().c_str(), std::ios_base::binary);
+    out << "2\n 4.1 12.3 -0.5 0.0254 0.0125 1\n 4.1 12.3 0.5 0.0254 0.0125 2\n";
+  }
+  spe_data expected = load_with_stream(files[0]);
+
+  std::vector<ascii_file_data> loaded = load_ascii_files(files, 2, true);
+  ASSERT_EQ(loaded.size(), 2u);
+  ASSERT_TRUE(loaded[0].error.empty()) << loaded[0].error;
+  EXPECT_EQ(loaded[0].descriptor.Type, fileTypes::iSPE_type);
+  EXPECT_EQ(loaded[0].descriptor.nData_records, 53u);
+  EXPECT_EQ(loaded[0].descriptor.nData_blocks, 11u);
+  EXPECT_TRUE(loaded[0].data[0].empty());
+  EXPECT_TRUE(loaded[0].data[1].empty());
+  expect_same(loaded[0].data[2], expected.en);
+
+  ASSERT_TRUE(loaded[1].error.empty()) << loaded[1].error;
+  EXPECT_EQ(loaded[1].descriptor.Type, fileTypes::iPAR_type);
+  EXPECT_EQ(loaded[1].descriptor.nData_records, 2u);
+  EXPECT_TRUE(loaded[1].data[0].empty());
+  for (const auto &file : files)
+    std::remove(file.c_str());
+}
+
+// Values of the double precision data converted into single precision
+std::vector<float> to_float(const std::vector<double> &values) {
+  return std::vector<float>(values.begin(), values.end());
+}
+
+void expect_same(const std::vector<float> &a, const std::vector<float> &b) {
+  ASSERT_EQ(a.size(), b.size());
+  for (size_t i = 0; i < a.size(); i++)
+    EXPECT_EQ(a[i], b[i]) << "at " << i;
+}
+
+TEST(TestGetAsciiFile, single_precision_loaders_convert_the_parsed_values) {
+  std::string spe_file = write_spe("single.spe", 37, 21, "\r\n");
+  spe_data full = load_with_stream(spe_file);
+  ascii_file_parser parser;
+  parser.open(spe_file);
+  std::vector<float> S(full.S.size()), ERR(full.S.size());
+  std::vector<double> en(full.en.size());
+
+  parser.load_spe(S.data(), ERR.data(), en.data());
+  expect_same(S, to_float(full.S));
+  expect_same(ERR, to_float(full.ERR));
+  expect_same(en, full.en);
+
+  S.assign(S.size(), 0.f);
+  ERR.assign(ERR.size(), 0.f);
+  EXPECT_TRUE(parser.load_spe_mapped(S.data(), ERR.data(), en.data(), 2));
+  expect_same(S, to_float(full.S));
+  expect_same(ERR, to_float(full.ERR));
+
+  spe_data part = slice(full, 21, 5, 9, 4, 13);
+  S.resize(part.S.size());
+  ERR.resize(part.S.size());
+  EXPECT_TRUE(parser.load_spe_range(S.data(), ERR.data(), en.data(), 5, 9, 4, 13, 2));
+  expect_same(S, to_float(part.S));
+  expect_same(ERR, to_float(part.ERR));
+  en.resize(part.en.size());
+  expect_same(en, part.en);
+  parser.close();
+  std::remove(spe_file.c_str());
+}
+
+TEST(TestGetAsciiFile, load_ascii_files_parses_into_the_outputs_given) {
+  std::vector<std::string> files;
+  files.push_back(write_spe("into0.spe", 23, 12, "\n"));
+  files.push_back(write_spe("into1.spe", 41, 7, "\r\n"));
+  files.push_back(::testing::TempDir() + "into2.par");
+  {
+    std::ofstream out(files.back().c_str(), std::ios_base::binary);
+    out << "2\n 4.1 12.3 -0.5 0.0254 0.0125 1\n 4.1 12.3 0.5 0.0254 0.0125 2\n";
+  }
+  files.push_back(write_spe("into3.spe", 10, 5, "\n"));
+  std::vector<FileTypeDescriptor> descriptors;
+  ascii_file_parser parser;
+  for (const auto &file : files) {
+    descriptors.push_back(parser.open(file));
+    parser.close();
+  }
+  spe_data expected0 = load_with_stream(files[0]);
+  spe_data expected1 = load_with_stream(files[1]);
+  write_spe("into3.spe", 11, 5, "\n"); // the header differs from the one the outputs are made for
+
+  // the first file into single precision signal and error, the others into double precision arrays
+  std::vector<float> S0(expected0.S.size()), ERR0(expected0.S.size());
+  std::vector<double> en0(expected0.en.size());
+  std::vector<double> S1(expected1.S.size()), ERR1(expected1.S.size()), en1(expected1.en.size());
+  std::vector<double> par(10), S3(50), ERR3(50), en3(6);
+  std::vector<ascii_output> outputs(files.size());
+  outputs[0].single[0] = S0.data();
+  outputs[0].single[1] = ERR0.data();
+  outputs[0].data[2] = en0.data();
+  outputs[1].data[0] = S1.data();
+  outputs[1].data[1] = ERR1.data();
+  outputs[1].data[2] = en1.data();
+  outputs[2].data[0] = par.data();
+  outputs[3].data[0] = S3.data();
+  outputs[3].data[1] = ERR3.data();
+  outputs[3].data[2] = en3.data();
+
+  std::vector<std::string> errors = load_ascii_files(files, descriptors, outputs, 2);
+  ASSERT_EQ(errors.size(), files.size());
+  for (size_t i = 0; i < 3; i++)
+    EXPECT_TRUE(errors[i].empty()) << errors[i];
+  EXPECT_NE(errors[3].find("header of the file has changed"), std::string::npos) << errors[3];
+  expect_same(S0, to_float(expected0.S));
+  expect_same(ERR0, to_float(expected0.ERR));
+  expect_same(en0, expected0.en);
+  expect_same(S1, expected1.S);
+  expect_same(ERR1, expected1.ERR);
+  expect_same(en1, expected1.en);
+  EXPECT_EQ(par[7], 0.5);
+  EXPECT_EQ(par[8], 0.0254);
+  for (const auto &file : files)
+    std::remove(file.c_str());
+}
+
+TEST(TestGetAsciiFile, parsers_report_errors_independently) {
+  const std::string bad_file = ::testing::TempDir() + "bad_row.par";
+  {
+    std::ofstream out(bad_file.c_str(), std::ios_base::binary);
+    out << "2\n 4.1 12.3 -0.5 0.0254 0.0125 1\n 4.1 12.3 x\n";
+  }
+  std::vector<std::thread> threads;
+  std::vector<std::string> errors(4);
+  for (size_t i = 0; i < errors.size(); i++) {
+    threads.push_back(std::thread([&bad_file, &errors, i]() {
+      ascii_file_parser parser;
+      parser.open(bad_file);
+      std::vector<double> par(10);
+      try {
+        parser.load_plain(par.data());
+      } catch (const ascii_file_error &err) {
+        errors[i] = err.what();
+      }
+    }));
+  }
+  for (auto &thread : threads)
+    thread.join();
+  for (const auto &error : errors) {
+    EXPECT_EQ(error, errors[0]);
+    EXPECT_NE(error.find("row 2 column 2"), std::string::npos) << error;
+  }
+  std::remove(bad_file.c_str());
+}
+
+TEST(TestParseDouble, matches_strtod) {
+  std::mt19937_64 gen(20211026);
+  std::uniform_real_distribution<double> mantissa(-10., 10.);
+  std::uniform_int_distribution<int> exponent(-40, 40);
+  const char *formats[] = {"%.17g", "%.6g", "%.9e", "%.3f", "%g"};
+  char text[64];
+  for (int i = 0; i < 20000; i++) {
+    const double value = mantissa(gen) * std::pow(10., exponent(gen));
+    snprintf(text, sizeof(text), formats[i % 5], value);
+    const char *last = text + strlen(text);
+    double parsed;
+    ASSERT_EQ(parse_double(text, last, parsed), last) << text;
+    EXPECT_EQ(parsed, strtod(text, nullptr)) << text;
+  }
+}
+
+TEST(TestParseDouble, reads_only_the_number) {
+  double value;
+  const std::string text{"-1.25e+2x"};
+  EXPECT_EQ(parse_double(text.data(), text.data() + text.size(), value), text.data() + 8);
+  EXPECT_EQ(value, -125.);
+  // the range ends inside the number
+  EXPECT_EQ(parse_double(text.data(), text.data() + 3, value), text.data() + 3);
+  EXPECT_EQ(value, -1.);
+
+  const std::string no_exponent{"7.5e-"};
+  EXPECT_EQ(parse_double(no_exponent.data(), no_exponent.data() + no_exponent.size(), value),
+            no_exponent.data() + 3);
+  EXPECT_EQ(value, 7.5);
+
+  const std::string not_number{".e1"};
+  EXPECT_EQ(parse_double(not_number.data(), not_number.data() + not_number.size(), value),
+            not_number.data());
+}
+
+TEST(TestParseDouble, reads_special_values) {
+  double value;
+  const std::string nan{"-NaN"};
+  parse_double(nan.data(), nan.data() + nan.size(), value);
+  EXPECT_TRUE(std::isnan(value));
+  const std::string inf{"-Inf"};
+  parse_double(inf.data(), inf.data() + inf.size(), value);
+  EXPECT_EQ(value, -std::numeric_limits<double>::infinity());
+  const std::string big{"1.5e400"};
+  parse_double(big.data(), big.data() + big.size(), value);
+  EXPECT_EQ(value, std::numeric_limits<double>::infinity());
+}
+
+TEST(TestGetAsciiFile, load_plain_reads_full_double_precision) {
+  const std::string file_name = ::testing::TempDir() + "precision.par";
+  {
+    std::ofstream out(file_name.c_str(), std::ios_base::binary);
+    out << "2\n";
+    out << "  4.123456789  12.345678901 -0.000123456789   0.0254  0.0125  1\n";
+    out << "  6.000000001  1.5E+01      3.3333333333333   2.5e-2  1.25e-2 2\n";
+  }
+  ascii_file_parser parser;
+  FileTypeDescriptor desc = parser.open(file_name);
+  ASSERT_EQ(desc.Type, fileTypes::iPAR_type);
+  std::vector<double> par(5 * desc.nData_records);
+  parser.load_plain(par.data());
+  parser.close();
+  std::remove(file_name.c_str());
+
+  const double expected[] = {4.123456789, 12.345678901, -0.000123456789, 0.0254, 0.0125,
+                             6.000000001, 15., 3.3333333333333, 0.025, 0.0125};
+  for (size_t i = 0; i < par.size(); i++) {
+    EXPECT_EQ(par[i], expected[i]) << "at " << i;
+  }
+}
+
+TEST(TestAsciiCache, cache_returns_the_parsed_spe_data) {
+  std::string spe_file = write_spe("cached.spe", 31, 17, "\n");
+  const std::string cache_file = cache_file_name(spe_file);
+  std::remove(cache_file.c_str());
+
+  ascii_cache cache;
+  ASSERT_FALSE(cache.open(spe_file));
+  ascii_file_parser parser;
+  FileTypeDescriptor desc = parser.open(spe_file);
+  parser.close();
+  spe_data parsed = load_with_stream(spe_file);
+  const double *arrays[] = {parsed.S.data(), parsed.ERR.data(), parsed.en.data()};
+  ASSERT_TRUE(cache.write(desc, arrays));
+
+  ascii_cache reopened;
+  ASSERT_TRUE(reopened.open(spe_file));
+  EXPECT_EQ(reopened.descriptor().Type, fileTypes::iSPE_type);
+  EXPECT_EQ(reopened.descriptor().nData_records, 31u);
+  EXPECT_EQ(reopened.descriptor().nData_blocks, 17u);
+  spe_data cached;
+  cached.S.resize(parsed.S.size());
+  cached.ERR.resize(parsed.ERR.size());
+  cached.en.resize(parsed.en.size());
+  reopened.read(0, cached.S.data());
+  reopened.read(1, cached.ERR.data());
+  reopened.read(2, cached.en.data());
+  expect_same(parsed, cached);
+  reopened.close();
+
+  std::remove(cache_file.c_str());
+  std::remove(spe_file.c_str());
+}
+
+TEST(TestAsciiCache, cache_is_not_used_after_the_file_changes) {
+  const std::string par_file = ::testing::TempDir() + "cached.par";
+  const std::string cache_file = cache_file_name(par_file);
+  {
+    std::ofstream out(par_file.c_str(), std::ios_base::binary);
+    out << "1\n 4.1 12.3 -0.5 0.0254 0.0125 1\n";
+  }
+  ascii_cache cache;
+  ASSERT_FALSE(cache.open(par_file));
+  ascii_file_parser parser;
+  FileTypeDescriptor desc = parser.open(par_file);
+  std::vector<double> par(5);
+  parser.load_plain(par.data());
+  parser.close();
+  const double *arrays[] = {par.data()};
+  ASSERT_TRUE(cache.write(desc, arrays));
+  ASSERT_TRUE(cache.open(par_file));
+  cache.close();
+
+  // same size and, possibly, the same modification time, but different contents
+  {
+    std::ofstream out(par_file.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    out << "1\n 4.1 12.3 -0.7 0.0254 0.0125 1\n";
+  }
+  EXPECT_FALSE(cache.open(par_file));
+
+  // a truncated cache is not used either
+  ASSERT_TRUE(cache.write(desc, arrays));
+  ASSERT_TRUE(cache.open(par_file));
+  cache.close();
+  std::string contents;
+  {
+    std::ifstream in(cache_file.c_str(), std::ios_base::binary);
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  }
+  {
+    std::ofstream out(cache_file.c_str(), std::ios_base::binary | std::ios_base::trunc);
+    out << contents.substr(0, contents.size() - 8);
+  }
+  EXPECT_FALSE(cache.open(par_file));
+
+  std::remove(cache_file.c_str());
+  std::remove(par_file.c_str());
+}
+
+#ifdef __linux__
+TEST(TestAsciiCache, signature_sees_edits_in_the_middle_of_file_within_same_second) {
+  // larger than the head and tail hashed, so the edit is found by the blocks sampled between them
+  std::string spe_file = write_spe("signature.spe", 600, 60, "\n");
+  source_signature before;
+  ASSERT_TRUE(get_source_signature(spe_file, before));
+  ASSERT_GT(before.size, 4 * CACHE_HASH_SPAN);
+  struct stat info;
+  ASSERT_EQ(stat(spe_file.c_str(), &info), 0);
+
+  // change one symbol in the middle and restore the modification time of the file
+  {
+    std::fstream io(spe_file.c_str(), std::ios_base::in | std::ios_base::out | std::ios_base::binary);
+    io.seekg(static_cast<std::streamoff>(before.size / 2 + 1));
+    const char c = static_cast<char>(io.get());
+    io.seekp(static_cast<std::streamoff>(before.size / 2 + 1));
+    io.put(c == '1' ? '2' : '1');
+  }
+  struct timespec times[2] = {info.st_atim, info.st_mtim};
+  ASSERT_EQ(utimensat(AT_FDCWD, spe_file.c_str(), times, 0), 0);
+  source_signature edited;
+  ASSERT_TRUE(get_source_signature(spe_file, edited));
+  EXPECT_EQ(edited.size, before.size);
+  EXPECT_EQ(edited.mtime, before.mtime);
+  EXPECT_NE(edited.hash, before.hash);
+
+  // a time differing by less than a second is a different time
+  times[1].tv_nsec = (times[1].tv_nsec + 500000000) % 1000000000;
+  ASSERT_EQ(utimensat(AT_FDCWD, spe_file.c_str(), times, 0), 0);
+  source_signature touched;
+  ASSERT_TRUE(get_source_signature(spe_file, touched));
+  EXPECT_EQ(touched.hash, edited.hash);
+  EXPECT_NE(touched.mtime, edited.mtime);
+  std::remove(spe_file.c_str());
+}
+#endif
+
+namespace {
+// wait until the prefetch store holds n_files files, for 10s at most
+bool wait_for_files(ascii_prefetch const &prefetch, size_t n_files) {
+  for (int i = 0; i < 1000 && prefetch.n_files() != n_files; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return prefetch.n_files() == n_files;
+}
+// wait until the prefetch store holds data of n_bytes, for 10s at most
+bool wait_for_bytes(ascii_prefetch const &prefetch, size_t n_bytes) {
+  for (int i = 0; i < 1000 && prefetch.bytes_held() != n_bytes; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  return prefetch.bytes_held() == n_bytes;
+}
+} // namespace
+
+TEST(TestAsciiPrefetch, prefetched_files_are_the_parsed_files) {
+  std::vector<std::string> files;
+  size_t n_bytes = 0;
+  for (size_t i = 0; i < 3; i++) {
+    files.push_back(write_spe("prefetch" + std::to_string(i) + ".spe", 30 + 11 * i, 7 + i, "\n"));
+    n_bytes += (2 * (30 + 11 * i) * (7 + i) + 8 + i) * sizeof(double);
+  }
+  ascii_prefetch prefetch;
+  EXPECT_EQ(prefetch.start(files, 1 << 30), 3u);
+  EXPECT_EQ(prefetch.start(files, 1 << 30), 0u); // already queued
+  ASSERT_TRUE(wait_for_bytes(prefetch, n_bytes));
+
+  for (size_t i = 0; i < files.size(); i++) {
+    ascii_file_data file;
+    ASSERT_TRUE(prefetch.take(files[i], file)) << files[i];
+    spe_data expected = load_with_stream(files[i]);
+    EXPECT_EQ(file.descriptor.Type, fileTypes::iSPE_type);
+    expect_same(file.data[0], expected.S);
+    expect_same(file.data[1], expected.ERR);
+    expect_same(file.data[2], expected.en);
+    // the data are handed over once
+    EXPECT_FALSE(prefetch.take(files[i], file));
+  }
+  EXPECT_EQ(prefetch.n_files(), 0u);
+  EXPECT_EQ(prefetch.bytes_held(), 0u);
+  for (size_t i = 0; i < files.size(); i++)
+    std::remove(files[i].c_str());
+}
+
+TEST(TestAsciiPrefetch, files_over_the_memory_limit_are_dropped) {
+  std::vector<std::string> files = {write_spe("limit0.spe", 40, 10, "\n"),
+                                    write_spe("limit1.spe", 40, 10, "\n")};
+  const size_t file_bytes = (2 * 40 * 10 + 11) * sizeof(double);
+  ascii_prefetch prefetch;
+  prefetch.start(files, file_bytes + file_bytes / 2);
+  ASSERT_TRUE(wait_for_files(prefetch, 1));
+  ASSERT_TRUE(wait_for_bytes(prefetch, file_bytes));
+
+  ascii_file_data file;
+  EXPECT_FALSE(prefetch.take(files[1], file));
+  EXPECT_TRUE(prefetch.take(files[0], file));
+  EXPECT_EQ(prefetch.bytes_held(), 0u);
+  for (size_t i = 0; i < files.size(); i++)
+    std::remove(files[i].c_str());
+}
+
+TEST(TestAsciiPrefetch, changed_missing_and_cleared_files_are_not_given) {
+  std::string spe_file = write_spe("changed.spe", 20, 8, "\n");
+  const std::string missing = ::testing::TempDir() + "missing_prefetch.spe";
+  ascii_prefetch prefetch;
+  prefetch.start({missing, spe_file}, 1 << 30);
+  ASSERT_TRUE(wait_for_files(prefetch, 1));
+
+  ascii_file_data file;
+  EXPECT_FALSE(prefetch.take(missing, file));
+  write_spe("changed.spe", 21, 8, "\n");
+  EXPECT_FALSE(prefetch.take(spe_file, file));
+
+  prefetch.start({spe_file}, 1 << 30);
+  ASSERT_TRUE(wait_for_files(prefetch, 1));
+  prefetch.clear();
+  EXPECT_EQ(prefetch.n_files(), 0u);
+  EXPECT_EQ(prefetch.bytes_held(), 0u);
+  EXPECT_FALSE(prefetch.take(spe_file, file));
+  std::remove(spe_file.c_str());
+}
+
+namespace {
+map_file_data parse_map_text(const std::string &text) {
+  map_file_data map;
+  parse_map(text.data(), text.data() + text.size(), map);
+  return map;
+}
+
+std::vector<double> parse_mask_text(const std::string &text) {
+  std::vector<double> msk;
+  parse_mask(text.data(), text.data() + text.size(), msk);
+  return msk;
+}
+} // namespace
+
+TEST(TestMapFile, parse_map_reads_workspaces_and_ranges) {
+  map_file_data map = parse_map_text("! a map file\r\n"
+                                     "3  ! workspaces\r\n"
+                                     "\r\n"
+                                     "10\r\n"
+                                     "4\r\n"
+                                     "1-3, 7\r\n"
+                                     "12\r\n"
+                                     "0\r\n"
+                                     "14\r\n"
+                                     "5\r\n"
+                                     "9:-1:8 20:22 % the last ones\r\n");
+  EXPECT_EQ(map.ns, std::vector<double>({4, 0, 5}));
+  EXPECT_EQ(map.wkno, std::vector<double>({10, 12, 14}));
+  EXPECT_EQ(map.s, std::vector<double>({1, 2, 3, 7, 9, 8, 20, 21, 22}));
+}
+
+TEST(TestMapFile, parse_map_reads_VMS_format) {
+  map_file_data map = parse_map_text("2\n"
+                                     "3 0 0 0\n"
+                                     "5-3\n"
+                                     "2 1.5 -2.5 1e-3\n"
+                                     "-2--1\n");
+  EXPECT_EQ(map.ns, std::vector<double>({3, 2}));
+  EXPECT_EQ(map.wkno, std::vector<double>({0, 0}));
+  EXPECT_EQ(map.s, std::vector<double>({5, 4, 3, -2, -1}));
+}
+
+TEST(TestMapFile, parse_map_accepts_last_workspace_without_spectra) {
+  map_file_data map = parse_map_text("2\n1\n1\n6\n2\n0\n");
+  EXPECT_EQ(map.ns, std::vector<double>({1, 0}));
+  EXPECT_EQ(map.wkno, std::vector<double>({1, 2}));
+  EXPECT_EQ(map.s, std::vector<double>({6}));
+}
+
+TEST(TestMapFile, parse_map_reports_format_errors) {
+  EXPECT_THROW(parse_map_text(""), ascii_file_error);
+  // workspaces
+  EXPECT_THROW(parse_map_text("0\n"), ascii_file_error);
+  EXPECT_THROW(parse_map_text("2 3\n1\n1\n1\n"), ascii_file_error);
+  // too many spectra for the workspace
+  EXPECT_THROW(parse_map_text("1\n1\n2\n1 2 3\n"), ascii_file_error);
+  // not all spectra or workspaces
+  EXPECT_THROW(parse_map_text("1\n1\n3\n1 2\n"), ascii_file_error);
+  EXPECT_THROW(parse_map_text("2\n1\n1\n5\n"), ascii_file_error);
+  // excess information
+  EXPECT_THROW(parse_map_text("1\n1\n1\n5\n2\n"), ascii_file_error);
+  // invalid range
+  EXPECT_THROW(parse_map_text("1\n1\n2\n1-x\n"), ascii_file_error);
+  // first workspace header with two values
+  EXPECT_THROW(parse_map_text("1\n1 2\n1\n1\n"), ascii_file_error);
+}
+
+TEST(TestMapFile, parse_mask_reads_all_lines) {
+  std::vector<double> msk = parse_mask_text("11:14,3-1\t8 ! comment 99\n"
+                                            "%  100-200\n"
+                                            "\n"
+                                            "5:3 20:1:21 abc 7\n");
+  EXPECT_EQ(msk, std::vector<double>({11, 12, 13, 14, 3, 2, 1, 8, 20, 21, 7}));
+  EXPECT_THROW(parse_mask_text(""), ascii_file_error);
+  EXPECT_THROW(parse_mask_text("1:x\n"), ascii_file_error);
+}
+
+TEST(TestMapFile, load_map_file_reads_file) {
+  const std::string map_file = ::testing::TempDir() + "test_map.map";
+  {
+    std::ofstream out(map_file.c_str(), std::ios_base::binary);
+    out << "2\n1\n2\n1 2\n2\n2\n3 4";
+  }
+  map_file_data map;
+  load_map_file(map_file, map);
+  EXPECT_EQ(map.ns, std::vector<double>({2, 2}));
+  EXPECT_EQ(map.s, std::vector<double>({1, 2, 3, 4}));
+  std::remove(map_file.c_str());
+
+  EXPECT_THROW(load_map_file(map_file, map), ascii_file_error);
+}
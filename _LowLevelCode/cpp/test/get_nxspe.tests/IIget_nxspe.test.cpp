@@ -0,0 +1,177 @@
+#include "get_nxspe/get_nxspe.h"
+#include "utility/environment.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace Herbert::Utility;
+
+namespace {
+// signal, error and energies of an NXSPE file with ndet detectors and ne energy bins
+struct nxspe_data {
+  size_t ndet, ne;
+  std::vector<double> S, ERR, en;
+};
+
+nxspe_data make_data(size_t ndet, size_t ne) {
+  nxspe_data data;
+  data.ndet = ndet;
+  data.ne = ne;
+  for (size_t j = 0; j < ndet; j++) {
+    for (size_t i = 0; i < ne; i++) {
+      data.S.push_back((i + j) % 11 == 3 ? -1.e30 : std::sin(0.37 * (i + 1) * (j + 1)));
+      data.ERR.push_back(0.5 + 0.001 * i + j);
+    }
+  }
+  for (size_t i = 0; i <= ne; i++)
+    data.en.push_back(-10. + 0.25 * i);
+  return data;
+}
+
+void write_dataset(hid_t group, const char *name, const std::vector<double> &values,
+                   const hsize_t *dims, int rank, hid_t file_type, const hsize_t *chunk) {
+  hid_t space = H5Screate_simple(rank, dims, NULL);
+  hid_t plist = H5Pcreate(H5P_DATASET_CREATE);
+  if (chunk) {
+    H5Pset_chunk(plist, rank, chunk);
+    H5Pset_shuffle(plist);
+    H5Pset_deflate(plist, 4);
+  }
+  hid_t dataset = H5Dcreate2(group, name, file_type, space, H5P_DEFAULT, plist, H5P_DEFAULT);
+  H5Dwrite(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+  H5Dclose(dataset);
+  H5Pclose(plist);
+  H5Sclose(space);
+}
+
+// write the data in the layout of NXSPE file, compressed in chunks if chunk is not NULL
+std::string write_nxspe(const std::string &name, nxspe_data const &data, hid_t file_type,
+                        const hsize_t *chunk) {
+  const std::string file_name = ::testing::TempDir() + name;
+  hid_t file = H5Fcreate(file_name.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t root = H5Gcreate2(file, "/run.spe", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  hid_t group = H5Gcreate2(root, "data", H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+  const hsize_t dims[] = {data.ndet, data.ne};
+  write_dataset(group, "data", data.S, dims, 2, file_type, chunk);
+  write_dataset(group, "error", data.ERR, dims, 2, file_type, chunk);
+  const hsize_t n_bins = data.ne + 1;
+  write_dataset(group, "energy", data.en, &n_bins, 1, H5T_IEEE_F64LE, NULL);
+  H5Gclose(group);
+  H5Gclose(root);
+  H5Fclose(file);
+  return file_name;
+}
+
+// check the loaded block of detectors and energy bins against the data written
+template <class U>
+void expect_block(nxspe_data const &data, const std::vector<U> &S,
+                  const std::vector<U> &ERR, size_t first_det, size_t n_det,
+                  size_t first_en, size_t n_en, double accuracy) {
+  for (size_t j = 0; j < n_det; j++) {
+    for (size_t i = 0; i < n_en; i++) {
+      const size_t in = (first_det + j) * data.ne + first_en + i;
+      const size_t out = j * n_en + i;
+      if (data.S[in] < -1.e29) {
+        EXPECT_TRUE(std::isnan(S[out])) << "detector " << j << " bin " << i;
+        EXPECT_EQ(ERR[out], U(0)) << "detector " << j << " bin " << i;
+      } else {
+        EXPECT_NEAR(S[out], data.S[in], accuracy) << "detector " << j << " bin " << i;
+        EXPECT_NEAR(ERR[out], data.ERR[in], accuracy * 10) << "detector " << j << " bin " << i;
+      }
+    }
+  }
+}
+} // namespace
+
+TEST(TestGetNxspe, reads_the_nxspe_test_file) {
+  const std::string herbert_root{
+      Environment::get_env_variable(Environment::HERBERT_ROOT, ".")};
+  nxspe_reader reader;
+  reader.open(herbert_root + "/_test/common_data/nxspe_version1_0.nxspe", "/11014.spe");
+  ASSERT_EQ(reader.n_detectors(), 5u);
+  ASSERT_EQ(reader.n_energies(), 30u);
+  std::vector<double> S(150), ERR(150), en(31);
+  reader.load_data(S.data(), ERR.data(), 0, 5, 0, 30);
+  reader.load_energies(en.data(), 0, 30);
+  for (size_t i = 1; i < en.size(); i++)
+    EXPECT_GT(en[i], en[i - 1]);
+}
+
+TEST(TestGetNxspe, contiguous_dataset_is_read_by_hyperslab) {
+  nxspe_data data = make_data(37, 23);
+  std::string file_name = write_nxspe("contiguous.nxspe", data, H5T_IEEE_F64LE, NULL);
+  nxspe_reader reader;
+  reader.open(file_name, "/run.spe");
+  EXPECT_EQ(reader.n_detectors(), 37u);
+  EXPECT_EQ(reader.n_energies(), 23u);
+  std::vector<double> S(37 * 23), ERR(37 * 23), en(24);
+  reader.load_data(S.data(), ERR.data(), 0, 37, 0, 23);
+  expect_block(data, S, ERR, 0, 37, 0, 23, 0.);
+
+  std::vector<double> Sr(10 * 5), ERRr(10 * 5);
+  reader.load_data(Sr.data(), ERRr.data(), 20, 10, 4, 5);
+  expect_block(data, Sr, ERRr, 20, 10, 4, 5, 0.);
+  reader.load_energies(en.data(), 4, 5);
+  for (size_t i = 0; i < 6; i++)
+    EXPECT_EQ(en[i], data.en[4 + i]);
+  reader.close();
+  std::remove(file_name.c_str());
+}
+
+TEST(TestGetNxspe, compressed_chunks_are_decoded_on_threads) {
+  nxspe_data data = make_data(301, 47);
+  const hsize_t chunk[] = {16, 20};
+  std::string f64 = write_nxspe("chunked64.nxspe", data, H5T_IEEE_F64LE, chunk);
+  std::string f32 = write_nxspe("chunked32.nxspe", data, H5T_IEEE_F32LE, chunk);
+  for (const std::string &file_name : {f64, f32}) {
+    const double accuracy = file_name == f64 ? 0. : 1.e-5;
+    nxspe_reader reader;
+    reader.open(file_name, "/run.spe");
+    std::vector<double> S(301 * 47), ERR(301 * 47);
+    reader.load_data(S.data(), ERR.data(), 0, 301, 0, 47, 4);
+    expect_block(data, S, ERR, 0, 301, 0, 47, accuracy);
+
+    // a block, which crosses the boundaries of chunks
+    std::vector<double> Sr(50 * 13), ERRr(50 * 13);
+    reader.load_data(Sr.data(), ERRr.data(), 10, 50, 17, 13, 3);
+    expect_block(data, Sr, ERRr, 10, 50, 17, 13, accuracy);
+    reader.close();
+    std::remove(file_name.c_str());
+  }
+}
+
+TEST(TestGetNxspe, data_are_read_in_single_precision) {
+  nxspe_data data = make_data(301, 47);
+  const hsize_t chunk[] = {16, 20};
+  std::string chunked = write_nxspe("chunked_single.nxspe", data, H5T_IEEE_F32LE, chunk);
+  std::string contiguous = write_nxspe("contiguous_single.nxspe", data, H5T_IEEE_F64LE, NULL);
+  for (const std::string &file_name : {chunked, contiguous}) {
+    nxspe_reader reader;
+    reader.open(file_name, "/run.spe");
+    std::vector<float> S(301 * 47), ERR(301 * 47);
+    reader.load_data(S.data(), ERR.data(), 0, 301, 0, 47, 4);
+    expect_block(data, S, ERR, 0, 301, 0, 47, 1.e-5);
+
+    std::vector<float> Sr(50 * 13), ERRr(50 * 13);
+    reader.load_data(Sr.data(), ERRr.data(), 10, 50, 17, 13, 3);
+    expect_block(data, Sr, ERRr, 10, 50, 17, 13, 1.e-5);
+    reader.close();
+    std::remove(file_name.c_str());
+  }
+}
+
+TEST(TestGetNxspe, missing_entry_and_wrong_range_throw) {
+  nxspe_data data = make_data(4, 3);
+  std::string file_name = write_nxspe("small.nxspe", data, H5T_IEEE_F64LE, NULL);
+  nxspe_reader reader;
+  EXPECT_THROW(reader.open(file_name, "/other.spe"), nxspe_error);
+  reader.open(file_name, "/run.spe");
+  std::vector<double> S(12), ERR(12);
+  EXPECT_THROW(reader.load_data(S.data(), ERR.data(), 2, 3, 0, 3), nxspe_error);
+  reader.close();
+  std::remove(file_name.c_str());
+}
@@ -0,0 +1,200 @@
+#include "put_ascii_file/format_double.h"
+#include "put_ascii_file/put_ascii_file.h"
+#include "get_ascii_file/get_ascii_file.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+std::string read_text(const std::string &file_name) {
+  std::ifstream in(file_name.c_str());
+  std::stringstream text;
+  text << in.rdbuf();
+  return text.str();
+}
+
+// the text fprintf writes for the values in the format applied to each of them
+std::string printf_values(const std::vector<double> &values, const char *format,
+                          size_t per_line) {
+  std::string text;
+  char field[64];
+  for (size_t i = 0; i < values.size(); i++) {
+    snprintf(field, sizeof(field), format, values[i]);
+    text += field;
+    if (i % per_line == per_line - 1 || i + 1 == values.size())
+      text += "\n";
+  }
+  return text;
+}
+
+// the SPE file text, written as write_spe_ writes it
+std::string printf_spe(const std::vector<double> &S, const std::vector<double> &ERR,
+                       const std::vector<double> &en, size_t ne, size_t ndet) {
+  char line[64];
+  snprintf(line, sizeof(line), "%-8d %-8d \n", (int)ndet, (int)ne);
+  std::string text(line);
+  text += "### Phi Grid\n" + printf_values(std::vector<double>(ndet + 1, 0.), "%-10.4G", 8);
+  std::vector<double> en_grid(en);
+  for (size_t i = 0; i < en_grid.size(); i++)
+    en_grid[i] = std::round(en_grid[i] * 1e5) / 1e5;
+  text += "### Energy Grid\n" + printf_values(en_grid, "%-10.4G", 8);
+  for (size_t j = 0; j < ndet; j++) {
+    snprintf(line, sizeof(line), "### S(Phi,w) (det N %d)\n", (int)j + 1);
+    text += line;
+    text += printf_values(std::vector<double>(S.begin() + j * ne, S.begin() + (j + 1) * ne),
+                          "%-10.4G", 8);
+    text += "### Errors\n";
+    text += printf_values(std::vector<double>(ERR.begin() + j * ne, ERR.begin() + (j + 1) * ne),
+                          "%-10.4G", 8);
+  }
+  return text;
+}
+
+struct spe_data {
+  size_t ne, ndet;
+  std::vector<double> S, ERR, en;
+};
+
+spe_data make_spe(size_t ne, size_t ndet) {
+  spe_data data;
+  data.ne = ne;
+  data.ndet = ndet;
+  data.S.resize(ne * ndet);
+  data.ERR.resize(ne * ndet);
+  for (size_t j = 0; j < ndet; j++) {
+    for (size_t i = 0; i < ne; i++) {
+      double value = std::sin(0.37 * (i + 1) * (j + 1)) * std::pow(10., (int)(i % 13) - 6);
+      data.S[j * ne + i] = (i % 17 == 5) ? -1.e30 : value;
+      data.ERR[j * ne + i] = std::fabs(value) * 0.1;
+    }
+  }
+  data.en.resize(ne + 1);
+  for (size_t i = 0; i <= ne; i++)
+    data.en[i] = -10. + 0.123456789 * i;
+  return data;
+}
+} // namespace
+
+TEST(TestFormatDouble, matches_printf) {
+  std::mt19937_64 generator(17);
+  std::uniform_real_distribution<double> exponent(-35., 35.);
+  std::vector<double> values = {0., -0., 1.e30, -1.e30, 1.e-30, 9.9995, 99995., 0.99995,
+                                9999.5, 1.e-5, 1.e-4, 0.00099995, 0.5, 2.5, 123456789012.};
+  for (int i = 0; i < 200000; i++)
+    values.push_back((i % 2 ? -1 : 1) * std::pow(10., exponent(generator)));
+  for (int i = -20000; i < 20000; i++) {
+    values.push_back(i * 0.00005);
+    values.push_back(i * 0.5);
+  }
+  char text[64], expected[64];
+  for (double value : values) {
+    *format_g(value, 4, text) = 0;
+    snprintf(expected, sizeof(expected), "%.4G", value);
+    ASSERT_STREQ(text, expected) << "%.4G of " << value;
+    *format_g(value, 3, text, false) = 0;
+    snprintf(expected, sizeof(expected), "%.3g", value);
+    ASSERT_STREQ(text, expected) << "%.3g of " << value;
+    *format_f(value, 4, text) = 0;
+    snprintf(expected, sizeof(expected), "%.4f", value);
+    ASSERT_STREQ(text, expected) << "%.4f of " << value;
+  }
+}
+
+TEST(TestPutAsciiFile, spe_file_is_written_as_by_fprintf) {
+  spe_data data = make_spe(37, 23);
+  const std::string file_name = ::testing::TempDir() + "written.spe";
+  write_spe(file_name, data.S.data(), data.ERR.data(), data.en.data(), data.ne, data.ndet, 1);
+  EXPECT_EQ(read_text(file_name), printf_spe(data.S, data.ERR, data.en, data.ne, data.ndet));
+  std::remove(file_name.c_str());
+}
+
+TEST(TestPutAsciiFile, spe_file_is_the_same_on_threads) {
+  // the blocks of 2000 detectors do not fit a single chunk of text
+  spe_data data = make_spe(64, 2000);
+  const std::string single = ::testing::TempDir() + "single.spe";
+  const std::string threaded = ::testing::TempDir() + "threaded.spe";
+  write_spe(single, data.S.data(), data.ERR.data(), data.en.data(), data.ne, data.ndet, 1);
+  write_spe(threaded, data.S.data(), data.ERR.data(), data.en.data(), data.ne, data.ndet, 4);
+  EXPECT_EQ(read_text(single), read_text(threaded));
+
+  ascii_file_parser parser;
+  FileTypeDescriptor desc = parser.open(threaded);
+  ASSERT_EQ(desc.Type, fileTypes::iSPE_type);
+  ASSERT_EQ(desc.nData_records, data.ndet);
+  ASSERT_EQ(desc.nData_blocks, data.ne);
+  std::vector<double> S(data.S.size()), ERR(data.ERR.size()), en(data.en.size());
+  parser.load_spe(S.data(), ERR.data(), en.data());
+  parser.close();
+  for (size_t i = 0; i < S.size(); i++) {
+    EXPECT_NEAR(S[i], data.S[i], std::fabs(data.S[i]) * 1.e-3) << "at " << i;
+  }
+  std::remove(single.c_str());
+  std::remove(threaded.c_str());
+}
+
+TEST(TestPutAsciiFile, spe_values_are_limited_to_the_field) {
+  spe_data data = make_spe(3, 1);
+  data.S = {2.e35, -3.e-35, 5.};
+  data.ERR = {1.e-31, 1.e31, 0.};
+  const std::string file_name = ::testing::TempDir() + "limited.spe";
+  write_spe(file_name, data.S.data(), data.ERR.data(), data.en.data(), data.ne, data.ndet);
+  std::vector<double> S = {1.e30, 0., 5.}, ERR = {0., 1.e30, 0.};
+  EXPECT_EQ(read_text(file_name), printf_spe(S, ERR, data.en, data.ne, data.ndet));
+  std::remove(file_name.c_str());
+}
+
+TEST(TestPutAsciiFile, par_and_phx_files_are_written_as_by_fprintf) {
+  const size_t ndet = 1001;
+  std::vector<double> par(6 * ndet), phx(7 * ndet);
+  std::string par_text = std::to_string(ndet) + " \n", phx_text = par_text;
+  char line[256];
+  for (size_t j = 0; j < ndet; j++) {
+    double *p = &par[6 * j], *h = &phx[7 * j];
+    p[0] = 4.0 + 0.001 * j;
+    p[1] = 3.0 + 0.123456 * j;
+    p[2] = -180. + 0.37 * j;
+    p[3] = 0.0254;
+    p[4] = 0.0125 + 1.e-7 * j;
+    p[5] = (double)(j + 1);
+    h[0] = 10.;
+    h[1] = 0.;
+    h[2] = p[1];
+    h[3] = -p[2];
+    h[4] = 0.5;
+    h[5] = 1.25;
+    h[6] = p[5];
+    snprintf(line, sizeof(line), "%10.4f %10.4f %10.4f %10.4f %10.4f %8d \n", p[0], p[1], p[2],
+             p[3], p[4], (int)p[5]);
+    par_text += line;
+    snprintf(line, sizeof(line), "%5.3g %5.3g %10.4f %10.4f %10.4f %10.4f %8d \n", h[0], h[1],
+             h[2], h[3], h[4], h[5], (int)h[6]);
+    phx_text += line;
+  }
+  const std::string par_file = ::testing::TempDir() + "written.par";
+  const std::string phx_file = ::testing::TempDir() + "written.phx";
+  write_par(par_file, par.data(), ndet, 3);
+  write_phx(phx_file, phx.data(), ndet, 3);
+  EXPECT_EQ(read_text(par_file), par_text);
+  EXPECT_EQ(read_text(phx_file), phx_text);
+
+  ascii_file_parser parser;
+  EXPECT_EQ(parser.open(par_file).Type, fileTypes::iPAR_type);
+  parser.close();
+  EXPECT_EQ(parser.open(phx_file).Type, fileTypes::iPHX_type);
+  parser.close();
+  std::remove(par_file.c_str());
+  std::remove(phx_file.c_str());
+}
+
+TEST(TestPutAsciiFile, non_integer_group_throws) {
+  std::vector<double> par = {4., 3., 2., 0.0254, 0.0125, 1.5};
+  const std::string par_file = ::testing::TempDir() + "bad_group.par";
+  EXPECT_THROW(write_par(par_file, par.data(), 1), ascii_write_error);
+}
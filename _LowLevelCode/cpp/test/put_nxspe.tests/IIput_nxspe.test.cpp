@@ -0,0 +1,166 @@
+#include "put_nxspe/put_nxspe.h"
+#include "get_nxspe/get_nxspe.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+// the arrays of an NXSPE file with ndet detectors and ne energy bins
+struct run_arrays {
+  std::vector<double> S, ERR, en, polar, azimuthal, distance, polar_width, azimuthal_width;
+};
+
+nxspe_run make_run(const std::string &name, size_t ndet, size_t ne, double shift,
+                   run_arrays &arrays) {
+  for (size_t j = 0; j < ndet; j++) {
+    for (size_t i = 0; i < ne; i++) {
+      arrays.S.push_back((i + j) % 13 == 5 ? -1.e30 : shift + std::cos(0.21 * (i + 1) * (j + 2)));
+      arrays.ERR.push_back(0.1 * (i % 7) + 0.01 * j);
+    }
+    arrays.polar.push_back(1. + 0.1 * j);
+    arrays.azimuthal.push_back(-0.5 * j);
+    arrays.distance.push_back(6.);
+    arrays.polar_width.push_back(0.3);
+    arrays.azimuthal_width.push_back(0.4);
+  }
+  for (size_t i = 0; i <= ne; i++)
+    arrays.en.push_back(-5. + 0.5 * i);
+
+  nxspe_run run;
+  run.fileName = ::testing::TempDir() + name;
+  run.root_folder = "a_loader";
+  run.ne = ne;
+  run.ndet = ndet;
+  run.S = arrays.S.data();
+  run.ERR = arrays.ERR.data();
+  run.en = arrays.en.data();
+  run.polar = arrays.polar.data();
+  run.azimuthal = arrays.azimuthal.data();
+  run.distance = arrays.distance.data();
+  run.polar_width = arrays.polar_width.data();
+  run.azimuthal_width = arrays.azimuthal_width.data();
+  run.efix = 80.;
+  run.psi = 12.5;
+  run.nxspe_version = "1.2";
+  run.program_version = "3.4.0";
+  return run;
+}
+
+// check the block of detectors, read back by nxspe_reader, against the arrays written
+void expect_written(nxspe_run const &run, size_t first_det, size_t n_det) {
+  nxspe_reader reader;
+  reader.open(run.fileName, "/" + run.root_folder);
+  ASSERT_EQ(reader.n_detectors(), run.ndet);
+  ASSERT_EQ(reader.n_energies(), run.ne);
+  std::vector<double> S(n_det * run.ne), ERR(n_det * run.ne), en(run.ne + 1);
+  reader.load_data(S.data(), ERR.data(), first_det, n_det, 0, run.ne, 3);
+  reader.load_energies(en.data(), 0, run.ne);
+  for (size_t k = 0; k < S.size(); k++) {
+    const size_t in = first_det * run.ne + k;
+    if (run.S[in] < -1.e29) {
+      EXPECT_TRUE(std::isnan(S[k])) << "element " << k;
+    } else {
+      EXPECT_EQ(S[k], run.S[in]) << "element " << k;
+      EXPECT_EQ(ERR[k], run.ERR[in]) << "element " << k;
+    }
+  }
+  for (size_t i = 0; i <= run.ne; i++)
+    EXPECT_EQ(en[i], run.en[i]);
+}
+
+// the chunk dimensions and the number of filters of the signal dataset
+void get_storage(nxspe_run const &run, hsize_t chunk[2], int &n_filters) {
+  hid_t file = H5Fopen(run.fileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  hid_t dataset = H5Dopen2(file, ("/" + run.root_folder + "/data/data").c_str(), H5P_DEFAULT);
+  hid_t plist = H5Dget_create_plist(dataset);
+  EXPECT_EQ(H5Pget_layout(plist), H5D_CHUNKED);
+  H5Pget_chunk(plist, 2, chunk);
+  n_filters = H5Pget_nfilters(plist);
+  H5Pclose(plist);
+  H5Dclose(dataset);
+  H5Fclose(file);
+}
+
+// read the one dimensional double dataset of the file
+std::vector<double> read_values(nxspe_run const &run, const std::string &path) {
+  hid_t file = H5Fopen(run.fileName.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+  hid_t dataset = H5Dopen2(file, ("/" + run.root_folder + path).c_str(), H5P_DEFAULT);
+  hid_t space = H5Dget_space(dataset);
+  std::vector<double> values(static_cast<size_t>(H5Sget_simple_extent_npoints(space)));
+  H5Dread(dataset, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+  H5Sclose(space);
+  H5Dclose(dataset);
+  H5Fclose(file);
+  return values;
+}
+} // namespace
+
+TEST(TestPutNxspe, uncompressed_file_is_chunked_by_detectors) {
+  run_arrays arrays;
+  nxspe_run run = make_run("uncompressed.nxspe", 53, 31, 0., arrays);
+  nxspe_write_options options;
+  options.chunk_bytes = 10 * 31 * sizeof(double);
+  write_nxspe(std::vector<nxspe_run>(1, run), options);
+
+  hsize_t chunk[2];
+  int n_filters(-1);
+  get_storage(run, chunk, n_filters);
+  EXPECT_EQ(chunk[0], 10u);
+  EXPECT_EQ(chunk[1], 31u);
+  EXPECT_EQ(n_filters, 0);
+  expect_written(run, 0, 53);
+  expect_written(run, 17, 21);
+  EXPECT_EQ(read_values(run, "/NXSPE_info/fixed_energy"), std::vector<double>(1, 80.));
+  EXPECT_EQ(read_values(run, "/NXSPE_info/psi"), std::vector<double>(1, 12.5));
+  EXPECT_EQ(read_values(run, "/data/polar"), arrays.polar);
+  EXPECT_EQ(read_values(run, "/data/azimuthal_width"), arrays.azimuthal_width);
+  std::remove(run.fileName.c_str());
+}
+
+TEST(TestPutNxspe, runs_are_compressed_together) {
+  std::vector<run_arrays> arrays(5);
+  std::vector<nxspe_run> runs;
+  for (size_t i = 0; i < arrays.size(); i++) {
+    runs.push_back(make_run("compressed" + std::to_string(i) + ".nxspe", 40 + 7 * i, 25,
+                            double(i), arrays[i]));
+  }
+  // a run of constant signal and error, which deflate makes smaller
+  std::fill(arrays[4].S.begin(), arrays[4].S.end(), 1.);
+  std::fill(arrays[4].ERR.begin(), arrays[4].ERR.end(), 0.);
+  nxspe_write_options options;
+  options.deflate = 4;
+  options.shuffle = true;
+  options.chunk_bytes = 8 * 25 * sizeof(double);
+  write_nxspe(runs, options, 4);
+
+  for (size_t i = 0; i < runs.size(); i++) {
+    hsize_t chunk[2];
+    int n_filters(-1);
+    get_storage(runs[i], chunk, n_filters);
+    EXPECT_EQ(chunk[0], 8u);
+    EXPECT_EQ(n_filters, 2);
+    expect_written(runs[i], 0, runs[i].ndet);
+    // the block crosses the boundaries of chunks and includes the padded edge chunk
+    expect_written(runs[i], 5, runs[i].ndet - 5);
+  }
+  for (size_t i = 0; i < runs.size(); i++)
+    std::remove(runs[i].fileName.c_str());
+}
+
+TEST(TestPutNxspe, incomplete_runs_throw) {
+  run_arrays arrays;
+  nxspe_run run = make_run("incomplete.nxspe", 4, 3, 0., arrays);
+  nxspe_write_options options;
+  run.polar_width = NULL;
+  EXPECT_THROW(write_nxspe(std::vector<nxspe_run>(1, run), options), nxspe_write_error);
+  run.polar_width = arrays.polar_width.data();
+  run.ne = 0;
+  EXPECT_THROW(write_nxspe(std::vector<nxspe_run>(1, run), options), nxspe_write_error);
+  run.ne = 3;
+  options.deflate = 10;
+  EXPECT_THROW(write_nxspe(std::vector<nxspe_run>(1, run), options), nxspe_write_error);
+}
@@ -0,0 +1,127 @@
+#include "rm_masked/rm_masked.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace {
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+const double Inf = std::numeric_limits<double>::infinity();
+
+// the columns of data kept, selected by the straightforward loop
+std::vector<double> expected_columns(const std::vector<double> &data, size_t n_rows,
+                                     const std::vector<bool> &keep) {
+  std::vector<double> result;
+  for (size_t j = 0; j < keep.size(); j++) {
+    if (keep[j])
+      result.insert(result.end(), data.begin() + j * n_rows, data.begin() + (j + 1) * n_rows);
+  }
+  return result;
+}
+} // namespace
+
+TEST(Test_rm_masked, finds_detectors_by_mask) {
+  const size_t ne = 3, ndet = 5;
+  // one detector per line
+  std::vector<double> S = {1,   2,   3,
+                           NaN, 1,   1,
+                           1,   Inf, 1,
+                           1,   1,   -Inf,
+                           4,   5,   6};
+  bool keep[ndet];
+
+  EXPECT_EQ(2u, find_unmasked(&S[0], ne, ndet, MASK_NAN | MASK_INF, keep));
+  EXPECT_TRUE(keep[0]);
+  EXPECT_FALSE(keep[1]);
+  EXPECT_FALSE(keep[2]);
+  EXPECT_FALSE(keep[3]);
+  EXPECT_TRUE(keep[4]);
+
+  EXPECT_EQ(4u, find_unmasked(&S[0], ne, ndet, MASK_NAN, keep));
+  EXPECT_FALSE(keep[1]);
+  EXPECT_TRUE(keep[2]);
+  EXPECT_TRUE(keep[3]);
+
+  EXPECT_EQ(3u, find_unmasked(&S[0], ne, ndet, MASK_INF, keep));
+  EXPECT_TRUE(keep[1]);
+  EXPECT_FALSE(keep[2]);
+  EXPECT_FALSE(keep[3]);
+
+  EXPECT_EQ(ndet, find_unmasked(&S[0], ne, ndet, 0, keep));
+}
+
+TEST(Test_rm_masked, threaded_compaction_matches_serial_selection) {
+  const size_t ne = 17, ndet = 10007;
+  std::mt19937 gen(42);
+  std::uniform_real_distribution<double> value(-1, 1);
+  std::uniform_int_distribution<size_t> position(0, ne * ndet - 1);
+  std::vector<double> S(ne * ndet), ERR(ne * ndet), x2(ndet), phx(7 * ndet);
+  for (size_t i = 0; i < S.size(); i++) {
+    S[i] = value(gen);
+    ERR[i] = value(gen);
+  }
+  for (size_t i = 0; i < ndet / 3; i++) {
+    S[position(gen)] = (i % 2) ? NaN : -Inf;
+  }
+  for (size_t j = 0; j < ndet; j++)
+    x2[j] = static_cast<double>(j);
+  for (size_t i = 0; i < phx.size(); i++)
+    phx[i] = value(gen);
+
+  std::vector<bool> keep_expected(ndet);
+  size_t n_expected = 0;
+  for (size_t j = 0; j < ndet; j++) {
+    keep_expected[j] = true;
+    for (size_t i = 0; i < ne; i++) {
+      if (!std::isfinite(S[j * ne + i]))
+        keep_expected[j] = false;
+    }
+    if (keep_expected[j])
+      n_expected++;
+  }
+  ASSERT_GT(n_expected, 0u);
+  ASSERT_LT(n_expected, ndet);
+
+  for (unsigned int n_threads : {1u, 3u, 8u, 0u}) {
+    std::unique_ptr<bool[]> keep(new bool[ndet]);
+    size_t n_kept = find_unmasked(&S[0], ne, ndet, MASK_NAN | MASK_INF, keep.get(), n_threads);
+    ASSERT_EQ(n_expected, n_kept);
+    for (size_t j = 0; j < ndet; j++)
+      ASSERT_EQ(keep_expected[j], keep[j]) << "detector " << j;
+
+    std::vector<double> S_m(ne * n_kept), ERR_m(ne * n_kept), x2_m(n_kept), phx_m(7 * n_kept);
+    compact_columns(&S[0], ne, ndet, keep.get(), &S_m[0], n_threads);
+    compact_columns(&ERR[0], ne, ndet, keep.get(), &ERR_m[0], n_threads);
+    compact_columns(&x2[0], 1, ndet, keep.get(), &x2_m[0], n_threads);
+    compact_columns(&phx[0], 7, ndet, keep.get(), &phx_m[0], n_threads);
+    EXPECT_EQ(expected_columns(S, ne, keep_expected), S_m);
+    EXPECT_EQ(expected_columns(ERR, ne, keep_expected), ERR_m);
+    EXPECT_EQ(expected_columns(x2, 1, keep_expected), x2_m);
+    EXPECT_EQ(expected_columns(phx, 7, keep_expected), phx_m);
+  }
+}
+
+TEST(Test_rm_masked, single_precision_arrays_are_compacted) {
+  const size_t ne = 2, ndet = 4;
+  const float fNaN = std::numeric_limits<float>::quiet_NaN();
+  const float fInf = std::numeric_limits<float>::infinity();
+  std::vector<float> S = {1, 2,
+                          fNaN, 3,
+                          4, -fInf,
+                          5, 6};
+  std::vector<float> ERR = {0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f, 0.7f, 0.8f};
+  bool keep[ndet];
+
+  ASSERT_EQ(3u, find_unmasked(&S[0], ne, ndet, MASK_INF, keep));
+  EXPECT_FALSE(keep[2]);
+  ASSERT_EQ(2u, find_unmasked(&S[0], ne, ndet, MASK_NAN | MASK_INF, keep));
+  std::vector<float> S_m(ne * 2), ERR_m(ne * 2);
+  compact_columns(&S[0], ne, ndet, keep, &S_m[0]);
+  compact_columns(&ERR[0], ne, ndet, keep, &ERR_m[0]);
+  EXPECT_EQ(std::vector<float>({1, 2, 5, 6}), S_m);
+  EXPECT_EQ(std::vector<float>({0.1f, 0.2f, 0.7f, 0.8f}), ERR_m);
+}
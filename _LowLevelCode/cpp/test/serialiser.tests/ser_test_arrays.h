@@ -0,0 +1,168 @@
+#pragma once
+/* MATLAB arrays of the kinds handled by the serialiser, built and compared
+ * with libmx only, for the serialiser tests and benchmark. */
+#include "serialiser/cpp_serialise.hpp"
+
+#include <cstring>
+#include <vector>
+
+namespace ser_test {
+
+inline mxArray* make_double(size_t m, size_t n, bool cmplx = false) {
+  mxArray* arr = mxCreateNumericMatrix(m, n, mxDOUBLE_CLASS, cmplx ? mxCOMPLEX : mxREAL);
+  double* re = static_cast<double*>(mxGetData(arr));
+  size_t nVals = m * n * (cmplx && MX_HAS_INTERLEAVED_COMPLEX ? 2 : 1);
+  for (size_t i = 0; i < nVals; i++) re[i] = 0.5 * i - 3;
+#if !MX_HAS_INTERLEAVED_COMPLEX
+  if (cmplx) {
+    double* im = mxGetPi(arr);
+    for (size_t i = 0; i < m * n; i++) im[i] = -0.25 * i;
+  }
+#endif
+  return arr;
+}
+
+// Complex m x n array of the numeric class, filled with a byte pattern
+inline mxArray* make_complex(size_t m, size_t n, mxClassID classID) {
+  mxArray* arr = mxCreateNumericMatrix(m, n, classID, mxCOMPLEX);
+  // Bytes of all real (or all imaginary) parts
+#if MX_HAS_INTERLEAVED_COMPLEX
+  const size_t nBytes = m * n * mxGetElementSize(arr) / 2;
+#else
+  const size_t nBytes = m * n * mxGetElementSize(arr);
+#endif
+  uint8_t* re = static_cast<uint8_t*>(mxGetData(arr));
+  for (size_t i = 0; i < nBytes * (MX_HAS_INTERLEAVED_COMPLEX ? 2 : 1); i++) re[i] = (uint8_t) (3 * i + 1);
+#if !MX_HAS_INTERLEAVED_COMPLEX
+  uint8_t* im = static_cast<uint8_t*>(mxGetImagData(arr));
+  for (size_t i = 0; i < nBytes; i++) im[i] = (uint8_t) (5 * i + 2);
+#endif
+  return arr;
+}
+
+inline mxArray* make_char(size_t n) {
+  std::vector<char> text(n + 1, 0);
+  for (size_t i = 0; i < n; i++) text[i] = 'a' + i % 26;
+  return mxCreateString(text.data());
+}
+
+// Banded sparse matrix with nPerCol non-zeros in every column
+inline mxArray* make_sparse(size_t m, size_t n, size_t nPerCol) {
+  if (nPerCol > m) nPerCol = m;
+  mxArray* arr = mxCreateSparse(m, n, n * nPerCol, mxREAL);
+  mwIndex* ir = mxGetIr(arr);
+  mwIndex* jc = mxGetJc(arr);
+  double* pr = static_cast<double*>(mxGetData(arr));
+  size_t k = 0;
+  for (size_t col = 0; col < n; col++) {
+    jc[col] = k;
+    size_t first = (col * 7) % (m - nPerCol + 1);
+    for (size_t r = 0; r < nPerCol; r++, k++) {
+      ir[k] = first + r;
+      pr[k] = 1.0 + k;
+    }
+  }
+  jc[n] = k;
+  return arr;
+}
+
+// Cell holding a mixture of types, nested depth levels deep
+inline mxArray* make_nested_cell(size_t width, size_t depth) {
+  mxArray* cell = mxCreateCellMatrix(1, width);
+  for (size_t i = 0; i < width; i++) {
+    mxArray* elem;
+    if (depth > 0 && i == 0) {
+      elem = make_nested_cell(width, depth - 1);
+    } else if (i % 3 == 0) {
+      elem = make_char(8 + i);
+    } else if (i % 3 == 1) {
+      elem = make_double(1, 4 + i);
+    } else {
+      elem = mxCreateNumericMatrix(2, 2, mxINT32_CLASS, mxREAL);
+    }
+    mxSetCell(cell, i, elem);
+  }
+  return cell;
+}
+
+// Struct array with a numeric, a char and a nested cell field; one field left unset
+inline mxArray* make_struct(size_t n) {
+  const char* names[] = {"signal", "label", "extra", "unset"};
+  mxArray* st = mxCreateStructMatrix(1, n, 4, names);
+  for (size_t i = 0; i < n; i++) {
+    mxSetFieldByNumber(st, i, 0, make_double(1, 10));
+    mxSetFieldByNumber(st, i, 1, make_char(5 + i % 7));
+    mxSetFieldByNumber(st, i, 2, make_nested_cell(3, 1));
+  }
+  return st;
+}
+
+inline std::vector<uint8_t> serialise_to_vector(const mxArray* arr) {
+  std::vector<uint8_t> stream(get_size(arr));
+  size_t memPtr = 0;
+  serialise(stream.data(), memPtr, arr);
+  stream.resize(memPtr);
+  return stream;
+}
+
+// Deep comparison of class, shape and contents
+inline bool same_array(const mxArray* a, const mxArray* b) {
+  if (a == nullptr || b == nullptr) {
+    // Unset cell elements and fields come back as []
+    const mxArray* set = a ? a : b;
+    return set == nullptr || (mxIsDouble(set) && mxIsEmpty(set));
+  }
+  if (mxGetClassID(a) != mxGetClassID(b) || mxIsSparse(a) != mxIsSparse(b) ||
+      mxIsComplex(a) != mxIsComplex(b) ||
+      mxGetNumberOfDimensions(a) != mxGetNumberOfDimensions(b)) {
+    return false;
+  }
+  const size_t nDims = mxGetNumberOfDimensions(a);
+  if (memcmp(mxGetDimensions(a), mxGetDimensions(b), nDims * sizeof(mwSize)) != 0) return false;
+
+  const size_t nElem = mxGetNumberOfElements(a);
+  switch (mxGetClassID(a)) {
+  case mxCELL_CLASS:
+    for (size_t i = 0; i < nElem; i++) {
+      if (!same_array(mxGetCell(a, i), mxGetCell(b, i))) return false;
+    }
+    return true;
+  case mxSTRUCT_CLASS: {
+    const int nFields = mxGetNumberOfFields(a);
+    if (nFields != mxGetNumberOfFields(b)) return false;
+    for (int f = 0; f < nFields; f++) {
+      if (strcmp(mxGetFieldNameByNumber(a, f), mxGetFieldNameByNumber(b, f)) != 0) return false;
+      for (size_t i = 0; i < nElem; i++) {
+        if (!same_array(mxGetFieldByNumber(a, i, f), mxGetFieldByNumber(b, i, f))) return false;
+      }
+    }
+    return true;
+  }
+  case mxCHAR_CLASS:
+    return memcmp(mxGetChars(a), mxGetChars(b), nElem * sizeof(mxChar)) == 0;
+  default:
+    break;
+  }
+
+  size_t nData = nElem;
+  if (mxIsSparse(a)) {
+    const size_t nCols = mxGetN(a);
+    nData = mxGetJc(a)[nCols];
+    if (memcmp(mxGetJc(a), mxGetJc(b), (nCols + 1) * sizeof(mwIndex)) != 0 ||
+        memcmp(mxGetIr(a), mxGetIr(b), nData * sizeof(mwIndex)) != 0) {
+      return false;
+    }
+  }
+  const size_t elemSize = types_size[tag_data(a).type];
+#if MX_HAS_INTERLEAVED_COMPLEX
+  return memcmp(mxGetData(a), mxGetData(b), nData * elemSize) == 0;
+#else
+  if (mxIsComplex(a)) {
+    return memcmp(mxGetData(a), mxGetData(b), nData * elemSize / 2) == 0 &&
+           memcmp(mxGetImagData(a), mxGetImagData(b), nData * elemSize / 2) == 0;
+  }
+  return memcmp(mxGetData(a), mxGetData(b), nData * elemSize) == 0;
+#endif
+}
+
+} // namespace ser_test
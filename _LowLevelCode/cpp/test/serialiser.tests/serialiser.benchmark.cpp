@@ -0,0 +1,99 @@
+/* Serialiser throughput by type mix, run without MATLAB.
+ *
+ * Usage: serialiser.benchmark [n_repeats]
+ *
+ * Reports MB/s of serialised stream for get_size, serialise and deserialise
+ * over dense, sparse, char, nested cell and struct array inputs.
+ *
+ * The last two columns compare the ways cpp_communicator labReceive hands
+ * over a message, with a memcpy standing for MPI_Recv: "uint8 recv" receives
+ * into a uint8 MATLAB array, which is then deserialised (the bytes returned
+ * to MATLAB and passed to c_deserialise); "buf recv" receives into a plain
+ * buffer and deserialises from it (labReceive with deserialise set). */
+#include "ser_test_arrays.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ser_test;
+
+namespace {
+
+struct bench_case {
+  std::string name;
+  mxArray* input;
+};
+
+double mb_per_s(size_t bytes, size_t repeats, double seconds) {
+  return seconds > 0 ? (double) bytes * repeats / seconds / (1024. * 1024.) : 0;
+}
+
+template <typename F>
+double time_repeats(size_t repeats, F&& body) {
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < repeats; i++) body();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+  const size_t repeats = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20;
+
+  standalone_ser_host host;
+  set_ser_host(&host);
+
+  std::vector<bench_case> cases{
+      {"dense double 1000x1000", make_double(1000, 1000)},
+      {"complex double 500x500", make_double(500, 500, true)},
+      {"sparse 100000x10000, 10/col", make_sparse(100000, 10000, 10)},
+      {"char 1e6", make_char(1000000)},
+      {"nested cell 50 wide x 4 deep", make_nested_cell(50, 4)},
+      {"struct array 1x10000", make_struct(10000)},
+  };
+
+  std::printf("%-32s %12s %12s %12s %12s %12s %12s\n", "case", "bytes", "size MB/s", "ser MB/s", "deser MB/s",
+              "uint8 recv", "buf recv");
+  for (auto& bc : cases) {
+    const size_t size = get_size(bc.input);
+    std::vector<uint8_t> stream(size);
+
+    double tSize = time_repeats(repeats, [&]() { get_size(bc.input); });
+    double tSer = time_repeats(repeats, [&]() {
+      size_t memPtr = 0;
+      serialise(stream.data(), memPtr, bc.input);
+    });
+    double tDeser = time_repeats(repeats, [&]() {
+      size_t memPtr = 0;
+      mxDestroyArray(deserialise(stream.data(), memPtr, size, 0));
+    });
+    double tRecvArray = time_repeats(repeats, [&]() {
+      mxArray* received = mxCreateNumericMatrix(1, size, mxUINT8_CLASS, mxREAL);
+      std::memcpy(mxGetData(received), stream.data(), size);
+      size_t memPtr = 0;
+      mxDestroyArray(deserialise(static_cast<const uint8_t*>(mxGetData(received)), memPtr, size, 0));
+      mxDestroyArray(received);
+    });
+    double tRecvBuffer = time_repeats(repeats, [&]() {
+      std::unique_ptr<uint8_t[]> received(new uint8_t[size]);
+      std::memcpy(received.get(), stream.data(), size);
+      size_t memPtr = 0;
+      mxDestroyArray(deserialise(received.get(), memPtr, size, 0));
+    });
+
+    std::printf("%-32s %12zu %12.1f %12.1f %12.1f %12.1f %12.1f\n", bc.name.c_str(), size,
+                mb_per_s(size, repeats, tSize), mb_per_s(size, repeats, tSer),
+                mb_per_s(size, repeats, tDeser), mb_per_s(size, repeats, tRecvArray),
+                mb_per_s(size, repeats, tRecvBuffer));
+    mxDestroyArray(bc.input);
+  }
+
+  set_ser_host(nullptr);
+  return 0;
+}
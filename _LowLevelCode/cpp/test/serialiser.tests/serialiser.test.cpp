@@ -0,0 +1,333 @@
+#include "ser_test_arrays.h"
+#include "serialiser/ser_hash.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+using namespace ser_test;
+
+class TestSerialiser : public ::testing::Test {
+protected:
+  standalone_ser_host host;
+
+  void SetUp() override { set_ser_host(&host); }
+  void TearDown() override { set_ser_host(nullptr); }
+
+  static mxArray* round_trip(const mxArray* input) {
+    std::vector<uint8_t> stream = serialise_to_vector(input);
+    EXPECT_EQ(stream.size(), get_size(input));
+    size_t memPtr = 0;
+    mxArray* output = deserialise(stream.data(), memPtr, stream.size(), 0);
+    EXPECT_EQ(memPtr, stream.size());
+    return output;
+  }
+
+  static void expect_round_trip(mxArray* input) {
+    mxArray* output = round_trip(input);
+    EXPECT_TRUE(same_array(input, output));
+    mxDestroyArray(output);
+    mxDestroyArray(input);
+  }
+
+  // Deserialise must either succeed or report an error; it may not read outside of the stream
+  static bool deserialise_or_throw(const std::vector<uint8_t>& stream) {
+    // Copy to a buffer of exactly the stream size so that overruns are caught by memory checkers
+    std::unique_ptr<uint8_t[]> data(new uint8_t[stream.size()]);
+    std::copy(stream.begin(), stream.end(), data.get());
+    size_t memPtr = 0;
+    try {
+      mxArray* output = deserialise(data.get(), memPtr, stream.size(), 0);
+      mxDestroyArray(output);
+      return true;
+    } catch (const std::runtime_error&) {
+      return false;
+    }
+  }
+};
+
+// Hash of a serialised stream, as 16 bytes
+static std::vector<uint8_t> stream_hash(const std::vector<uint8_t>& stream) {
+  ser_hash128 hasher;
+  hasher.update(stream.data(), stream.size());
+  uint64_t words[2];
+  hasher.finalise(words);
+  std::vector<uint8_t> hash(SER_HASH_SIZE);
+  memcpy(hash.data(), words, SER_HASH_SIZE);
+  return hash;
+}
+
+static std::vector<uint8_t> object_hash(const mxArray* input) {
+  std::vector<uint8_t> hash(SER_HASH_SIZE);
+  serial_hash(input, hash.data());
+  return hash;
+}
+
+TEST(TestSerHash, matches_murmur3_x64_128_reference) {
+  const std::string text{"The quick brown fox jumps over the lazy dog"};
+  ser_hash128 hasher;
+  hasher.update(text.data(), text.size());
+  uint64_t words[2];
+  hasher.finalise(words);
+  EXPECT_EQ(words[0], 0xe34bbc7bbc071b6cULL);
+  EXPECT_EQ(words[1], 0x7a433ca9c49a9347ULL);
+
+  ser_hash128 empty;
+  empty.finalise(words);
+  EXPECT_EQ(words[0], 0u);
+  EXPECT_EQ(words[1], 0u);
+}
+
+TEST(TestSerHash, independent_of_how_input_is_split) {
+  std::vector<uint8_t> bytes(1000);
+  for (size_t i = 0; i < bytes.size(); i++) bytes[i] = (uint8_t) (i * 31 + 7);
+
+  ser_hash128 whole;
+  whole.update(bytes.data(), bytes.size());
+  uint64_t expected[2];
+  whole.finalise(expected);
+
+  for (size_t piece : {1, 3, 15, 16, 17, 100}) {
+    ser_hash128 split;
+    for (size_t start = 0; start < bytes.size(); start += piece) {
+      split.update(&bytes[start], std::min(piece, bytes.size() - start));
+    }
+    uint64_t result[2];
+    split.finalise(result);
+    EXPECT_EQ(result[0], expected[0]) << "piece size " << piece;
+    EXPECT_EQ(result[1], expected[1]) << "piece size " << piece;
+  }
+}
+
+TEST_F(TestSerialiser, serial_hash_is_hash_of_serialised_stream) {
+  std::vector<mxArray*> inputs{make_double(100, 30), make_double(100, 90, true),
+                               make_char(33), make_sparse(50, 20, 4),
+                               make_nested_cell(4, 3), make_struct(5)};
+  for (mxArray* input : inputs) {
+    EXPECT_EQ(object_hash(input), stream_hash(serialise_to_vector(input)));
+    mxDestroyArray(input);
+  }
+}
+
+TEST_F(TestSerialiser, serial_hash_differs_for_different_contents) {
+  mxArray* a = make_struct(3);
+  mxArray* b = make_struct(3);
+  EXPECT_EQ(object_hash(a), object_hash(b));
+
+  double* signal = static_cast<double*>(mxGetData(mxGetFieldByNumber(b, 2, 0)));
+  signal[9] += 1;
+  EXPECT_NE(object_hash(a), object_hash(b));
+
+  mxDestroyArray(a);
+  mxDestroyArray(b);
+}
+
+TEST_F(TestSerialiser, round_trip_dense_double) {
+  expect_round_trip(make_double(100, 30));
+}
+
+TEST_F(TestSerialiser, round_trip_complex_double) {
+  expect_round_trip(make_double(7, 9, true));
+}
+
+TEST_F(TestSerialiser, round_trip_char) {
+  expect_round_trip(make_char(1000));
+}
+
+TEST_F(TestSerialiser, round_trip_sparse) {
+  expect_round_trip(make_sparse(200, 50, 5));
+}
+
+TEST_F(TestSerialiser, round_trip_nested_cell) {
+  expect_round_trip(make_nested_cell(5, 4));
+}
+
+TEST_F(TestSerialiser, round_trip_struct_array) {
+  expect_round_trip(make_struct(6));
+}
+
+TEST_F(TestSerialiser, round_trip_empty_struct) {
+  mwSize dims[] = {0, 0};
+  expect_round_trip(mxCreateStructArray(2, dims, 0, nullptr));
+}
+
+TEST_F(TestSerialiser, scalar_struct_contents_written_as_struct2cell) {
+  // 1x1 struct with 2 fields holds a 2x1 cell of contents
+  const char* names[] = {"a", "bb"};
+  mxArray* st = mxCreateStructMatrix(1, 1, 2, names);
+  std::vector<uint8_t> stream = serialise_to_vector(st);
+  mxDestroyArray(st);
+
+  // struct tag, scalar length, nFields, name lengths, names
+  size_t cellPos = TAG_SIZE + NELEMS_SIZE + 3 * types_size[UINT32] + 3;
+  ASSERT_EQ(stream[0], STRUCT);
+  ASSERT_EQ(stream[1], 1);
+  ASSERT_EQ(stream[cellPos], CELL);
+  ASSERT_EQ(stream[cellPos + 1], 2);
+  uint32_t cellDims[2];
+  memcpy(cellDims, &stream[cellPos + TAG_SIZE], sizeof(cellDims));
+  EXPECT_EQ(cellDims[0], 2u);
+  EXPECT_EQ(cellDims[1], 1u);
+}
+
+TEST_F(TestSerialiser, struct_array_written_by_column) {
+  // 1x3 struct: "a" holds 1x2 doubles in every element, "bb" is never set
+  const char* names[] = {"a", "bb"};
+  mxArray* st = mxCreateStructMatrix(1, 3, 2, names);
+  for (size_t i = 0; i < 3; i++) mxSetFieldByNumber(st, i, 0, make_double(1, 2));
+  std::vector<uint8_t> stream = serialise_to_vector(st);
+
+  size_t colPos = TAG_SIZE + NELEMS_SIZE + 3 * types_size[UINT32] + 3;
+  ASSERT_EQ(stream[0], STRUCT);
+  ASSERT_EQ(stream[1], 1 | STRUCT_COLUMNS_FLAG);
+  // Dense column: kind, header of one value, then the 6 doubles
+  ASSERT_EQ(stream[colPos], COLUMN_DENSE);
+  ASSERT_EQ(stream[colPos + 1], DOUBLE);
+  ASSERT_EQ(stream[colPos + 2], 1);
+  colPos += 1 + TAG_SIZE + NELEMS_SIZE + 6 * types_size[DOUBLE];
+  // Unset values: one empty double per element
+  ASSERT_EQ(stream[colPos], COLUMN_CELL);
+  EXPECT_EQ(stream.size(), colPos + 1 + 3 * TAG_SIZE);
+
+  mxArray* output = round_trip(st);
+  EXPECT_TRUE(same_array(st, output));
+  mxDestroyArray(output);
+  mxDestroyArray(st);
+}
+
+TEST_F(TestSerialiser, round_trip_struct_columns_of_every_kind) {
+  const char* names[] = {"cmplx", "flag", "text", "mixed", "inner"};
+  const char* innerNames[] = {"x", "y"};
+  const size_t n = 5;
+  mxArray* st = mxCreateStructMatrix(n, 2, 5, names);
+  for (size_t i = 0; i < 2 * n; i++) {
+    mxSetFieldByNumber(st, i, 0, make_double(2, 3, true));
+    mxSetFieldByNumber(st, i, 1, mxCreateLogicalMatrix(1, 4));
+    mxSetFieldByNumber(st, i, 2, make_char(8));
+    mxSetFieldByNumber(st, i, 3, (i % 2) ? make_char(3) : make_double(1, 3));
+    mxArray* inner = mxCreateStructMatrix(1, 1, 2, innerNames);
+    mxSetFieldByNumber(inner, 0, 0, make_double(1, 1 + i));
+    mxSetFieldByNumber(inner, 0, 1, make_nested_cell(2, 1));
+    mxSetFieldByNumber(st, i, 4, inner);
+  }
+  expect_round_trip(st);
+}
+
+TEST_F(TestSerialiser, round_trip_struct_columns_of_complex_integers_and_singles) {
+  const char* names[] = {"csingle", "cint16"};
+  const size_t n = 4;
+  mxArray* st = mxCreateStructMatrix(1, n, 2, names);
+  for (size_t i = 0; i < n; i++) {
+    mxSetFieldByNumber(st, i, 0, make_complex(3, 2, mxSINGLE_CLASS));
+    mxSetFieldByNumber(st, i, 1, make_complex(1, 5, mxINT16_CLASS));
+  }
+  std::vector<uint8_t> stream = serialise_to_vector(st);
+  // Both fields are written as dense columns
+  const size_t colPos = TAG_SIZE + NELEMS_SIZE + 3 * types_size[UINT32] + 13;
+  ASSERT_EQ(stream[colPos], COLUMN_DENSE);
+  ASSERT_EQ(stream[colPos + 1], COMPLEX_SINGLE);
+
+  expect_round_trip(st);
+}
+
+TEST_F(TestSerialiser, struct_array_by_column_is_smaller_than_by_element) {
+  // Field names are written once and dense values lose their per-element headers
+  const size_t n = 100;
+  mxArray* st = make_struct(n);
+  const char* names[] = {"signal", "label", "extra", "unset"};
+  size_t elementsSize = 0;
+  for (size_t i = 0; i < n; i++) {
+    mxArray* one = mxCreateStructMatrix(1, 1, 4, names);
+    for (int field = 0; field < 3; field++) {
+      mxSetFieldByNumber(one, 0, field, mxDuplicateArray(mxGetFieldByNumber(st, i, field)));
+    }
+    elementsSize += get_size(one);
+    mxDestroyArray(one);
+  }
+  EXPECT_LT(get_size(st), elementsSize);
+  mxDestroyArray(st);
+}
+
+TEST_F(TestSerialiser, truncated_stream_throws) {
+  mxArray* input = make_struct(2);
+  std::vector<uint8_t> stream = serialise_to_vector(input);
+  mxDestroyArray(input);
+
+  for (size_t len = 0; len < stream.size(); len++) {
+    std::vector<uint8_t> truncated(stream.begin(), stream.begin() + len);
+    EXPECT_FALSE(deserialise_or_throw(truncated)) << "Stream truncated to " << len << " bytes decoded";
+  }
+}
+
+TEST_F(TestSerialiser, corrupt_stream_does_not_crash) {
+  std::vector<mxArray*> inputs{make_struct(3), make_sparse(20, 10, 3),
+                               make_nested_cell(4, 3), make_double(3, 3, true)};
+  std::mt19937 gen(20211018);
+
+  for (mxArray* input : inputs) {
+    std::vector<uint8_t> stream = serialise_to_vector(input);
+    mxDestroyArray(input);
+    std::uniform_int_distribution<size_t> pos(0, stream.size() - 1);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    for (int trial = 0; trial < 2000; trial++) {
+      std::vector<uint8_t> corrupt(stream);
+      const int nFlips = 1 + trial % 4;
+      for (int i = 0; i < nFlips; i++) corrupt[pos(gen)] = (uint8_t) byte(gen);
+      deserialise_or_throw(corrupt);
+    }
+  }
+  // Nothing may outlive a failed call in a MATLAB session
+  EXPECT_EQ(host.persistent_arrays(), 0u);
+}
+
+TEST_F(TestSerialiser, corrupt_sibling_leaves_no_persistent_arrays) {
+  // Function handle with a valid name followed by a corrupt workspace
+  mxArray* name = mxCreateString("f");
+  std::vector<uint8_t> stream = serialise_to_vector(name);
+  mxDestroyArray(name);
+  stream.insert(stream.begin(), (uint8_t) (FUNCTION_HANDLE + 128));
+  stream.push_back(200);
+  EXPECT_FALSE(deserialise_or_throw(stream));
+  EXPECT_EQ(host.persistent_arrays(), 0u);
+}
+
+TEST_F(TestSerialiser, unknown_tag_throws) {
+  std::vector<uint8_t> stream{200, 0};
+  EXPECT_FALSE(deserialise_or_throw(stream));
+}
+
+TEST_F(TestSerialiser, oversized_dimensions_throw_before_allocation) {
+  // 3D double claiming 2^32-1 x 2^32-1 x 2 elements with no data behind it
+  std::vector<uint8_t> stream{DOUBLE, 3};
+  for (int dim = 0; dim < 2; dim++) stream.insert(stream.end(), 4, 0xFF);
+  stream.insert(stream.end(), {2, 0, 0, 0});
+  EXPECT_FALSE(deserialise_or_throw(stream));
+}
+
+TEST_F(TestSerialiser, bad_sparse_indices_throw) {
+  mxArray* input = make_sparse(10, 4, 2);
+  std::vector<uint8_t> stream = serialise_to_vector(input);
+  mxDestroyArray(input);
+
+  // First row index follows tag, dims, nnz and the 5 column pointers
+  const size_t irPos = TAG_SIZE + 3 * DIMS_SIZE + 5 * DIMS_SIZE;
+  stream[irPos] = 10;
+  EXPECT_FALSE(deserialise_or_throw(stream));
+}
+
+TEST_F(TestSerialiser, deep_nesting_throws) {
+  // Chain of 1x1 cells nested beyond the depth limit
+  std::vector<uint8_t> stream;
+  for (size_t i = 0; i < MAX_NESTING_DEPTH + 2; i++) {
+    stream.insert(stream.end(), {CELL, 1, 1, 0, 0, 0});
+  }
+  stream.insert(stream.end(), {DOUBLE, 0});
+  EXPECT_FALSE(deserialise_or_throw(stream));
+}
@@ -0,0 +1,46 @@
+#pragma once
+/*!
+*   Parsing of the string and range arguments shared by the mex gateways which read ranges of
+*   detectors and energy bins (get_ascii_file, get_nxspe), so the rules for the ranges accepted
+*   are the same in all of them.
+*/
+#include <string>
+#include <vector>
+#include <mex.h>
+
+/*!
+* range of detectors or energy bins, requested as [first,last] (numbered from 1)
+*/
+struct data_range{
+    bool   defined;
+    size_t first,last;
+    data_range():defined(false),first(0),last(0){}
+    // first element and number of elements of a dimension of size n
+    size_t start(size_t)const{return defined ? first-1:0;}
+    size_t size(size_t n)const{return defined ? last-first+1:n;}
+};
+
+/*! get the string from Matlab; false if the array is not a row string */
+inline bool
+get_mx_string(const mxArray *pString,std::string &value)
+{
+    if(!mxIsChar(pString)||mxGetM(pString)!=1)return false;
+    std::vector<char> Buf(mxGetN(pString)+1);
+    if(mxGetString(pString,&Buf[0],Buf.size()))return false;
+    value.assign(&Buf[0]);
+    return true;
+}
+/*! get the range [first,last] from Matlab; false if it is not a pair of positive integers in increasing order */
+inline bool
+get_mx_range(const mxArray *pRange,data_range &range)
+{
+    if(!mxIsDouble(pRange)||mxIsComplex(pRange)||mxGetNumberOfElements(pRange)!=2)return false;
+    const double *pValues = mxGetPr(pRange);
+    for(int i=0;i<2;i++){
+        if(!(pValues[i]>=1)||pValues[i]!=static_cast<double>(static_cast<size_t>(pValues[i])))return false;
+    }
+    range.first   = static_cast<size_t>(pValues[0]);
+    range.last    = static_cast<size_t>(pValues[1]);
+    range.defined = true;
+    return range.first<=range.last;
+}
@@ -11,6 +11,10 @@ classdef test_asciipar_loader< TestCase
             [~,tdp] = herbert_root();
             obj.test_data_path = tdp;
         end
+        function obj=setUp(obj)
+            % every test parses the files it loads
+            detpar_cache.instance().clear_cache();
+        end
 
         function test_constructors(obj)
             par_file = 'missing_par_file.par';
@@ -310,6 +314,50 @@ classdef test_asciipar_loader< TestCase
             assertEqual(al,al_rec)
         end
 
+        function test_loaders_share_cached_detpar(obj)
+            cache = detpar_cache.instance();
+            par_file = fullfile(tmp_dir,'test_loaders_share_cached_detpar.par');
+            clob = onCleanup(@()delete(par_file));
+            copyfile(fullfile(obj.test_data_path,obj.test_par_file),par_file,'f');
+
+            al1 = asciipar_loader(par_file);
+            [par1,al1] = al1.load_par();
+            assertEqual(1,cache.n_entries);
+            al2 = asciipar_loader(par_file);
+            [par2,al2] = al2.load_par();
+            assertEqual(1,cache.n_entries);
+            assertEqual(par1,par2);
+            assertEqual(al1.det_par,al2.det_par);
+            assertEqual(obj.EXPECTED_DET_NUM,al2.n_det_in_par);
+
+            % a changed file is parsed again
+            copyfile(fullfile(obj.test_data_path,'map_4to1_jul09.par'),par_file,'f');
+            al3 = asciipar_loader(par_file);
+            par3 = al3.load_par('-nohor');
+            assertEqual(36864,size(par3,2));
+            assertEqual(1,cache.n_entries);
+
+            cache.clear_cache();
+            assertEqual(0,cache.n_entries);
+        end
+
+        function test_cached_detpar_rewritten_within_second_is_reloaded(~)
+            par_file = fullfile(tmp_dir,'test_cached_detpar_rewritten.par');
+            clob = onCleanup(@()delete(par_file));
+            write_par = @(x2)write_text_file(par_file,...
+                sprintf('2\n %6.3f 10.000 0.000 0.025 0.012 1\n  4.000 20.000 0.000 0.025 0.012 2\n',x2));
+            write_par(4.1);
+            al1 = asciipar_loader(par_file);
+            par1 = al1.load_par('-nohor');
+            assertElementsAlmostEqual(4.1,par1(1,1));
+
+            % same size and, very likely, the same modification time
+            write_par(4.7);
+            al2 = asciipar_loader(par_file);
+            par2 = al2.load_par('-nohor');
+            assertElementsAlmostEqual(4.7,par2(1,1));
+        end
+
         function test_load_phx_nomex(obj)
             hcfg=herbert_config();
             current = hcfg.use_mex;
@@ -331,3 +379,9 @@ classdef test_asciipar_loader< TestCase
     end
 end
 
+function write_text_file(file_name,contents)
+% write the text into the file, replacing its contents
+fh = fopen(file_name,'w');
+clob = onCleanup(@()fclose(fh));
+fprintf(fh,'%s',contents);
+end
@@ -376,5 +376,139 @@ classdef test_loader_ascii< TestCase
             assertEqual(detMex,detNom);
 
         end
+        function test_mex_ascii_cache(obj)
+            if isempty(which('get_ascii_file'))
+                skipTest('no get_ascii_file.mex found so the test has been disabled')
+            end
+            spe_file = fullfile(tmp_dir,'test_mex_ascii_cache.spe');
+            copyfile(fullfile(obj.test_data_path,'MAP10001.spe'),spe_file,'f');
+            cache_file = [spe_file,'.hcache'];
+            clob = onCleanup(@()delete(spe_file,cache_file));
+
+            [S,ERR,en] = get_ascii_file(spe_file,'spe');
+            assertFalse(is_file(cache_file));
+
+            [Sc,ERRc,enc] = get_ascii_file(spe_file,'spe','-cache');
+            assertTrue(is_file(cache_file));
+            assertEqual(S,Sc);
+            assertEqual(ERR,ERRc);
+            assertEqual(en,enc);
+
+            % second call reads the cache
+            [Sc,ERRc,enc] = get_ascii_file(spe_file,'-cache');
+            assertEqual(S,Sc);
+            assertEqual(ERR,ERRc);
+            assertEqual(en,enc);
+        end
+        function test_mex_put_ascii_file(obj)
+            if isempty(which('put_ascii_file'))
+                skipTest('no put_ascii_file.mex found so the test has been disabled')
+            end
+            par_file = fullfile(tmp_dir,'test_mex_put_ascii_file.par');
+            ref_file = fullfile(tmp_dir,'test_mex_put_ascii_file_ref.par');
+            spe_file = fullfile(tmp_dir,'test_mex_put_ascii_file.spe');
+            clob = onCleanup(@()delete(par_file,ref_file,spe_file));
+
+            par = get_ascii_file(fullfile(obj.test_data_path,'demo_par.PAR'),'par');
+            arr = [par;1:size(par,2)];
+            put_ascii_file(par_file,'par',arr);
+            fid=fopen(ref_file,'wt');
+            fprintf(fid,'%d \n',size(arr,2));
+            fprintf(fid,'%10.4f %10.4f %10.4f %10.4f %10.4f %8d \n',arr);
+            fclose(fid);
+            assertEqual(fileread(par_file),fileread(ref_file));
+
+            [S,ERR,en] = get_ascii_file(fullfile(obj.test_data_path,'MAP10001.spe'),'spe');
+            S(~isfinite(S)) = -1.e30;
+            ERR(~isfinite(ERR)) = 0;
+            put_ascii_file(spe_file,'spe',S,ERR,en);
+            [Sw,ERRw,enw] = get_ascii_file(spe_file,'spe');
+            assertElementsAlmostEqual(Sw,S,'relative',1.e-3);
+            assertElementsAlmostEqual(ERRw,ERR,'relative',1.e-3);
+            assertElementsAlmostEqual(enw,en,'absolute',1.e-4);
+        end
+        function test_mex_header_info(obj)
+            if isempty(which('get_ascii_file'))
+                skipTest('no get_ascii_file.mex found so the test has been disabled')
+            end
+            spe_file = fullfile(obj.test_data_path,'MAP10001.spe');
+            par_file = fullfile(obj.test_data_path,'demo_par.PAR');
+            [S,~,en] = get_ascii_file(spe_file,'spe');
+
+            info = get_ascii_file(spe_file,'-info');
+            assertEqual(info.file_type,'spe');
+            assertEqual(info.n_detectors,size(S,2));
+            assertEqual(info.n_energies,size(S,1));
+            assertEqual(info.en,en);
+
+            infos = get_ascii_file({spe_file;par_file},'-info');
+            assertEqual(size(infos),[2,1]);
+            assertEqual(infos(1),info);
+            par = get_ascii_file(par_file,'par');
+            assertEqual(infos(2).file_type,'par');
+            assertEqual(infos(2).n_detectors,size(par,2));
+            assertTrue(isempty(infos(2).en));
+        end
+        function test_mex_spe_ranges(obj)
+            if isempty(which('get_ascii_file'))
+                skipTest('no get_ascii_file.mex found so the test has been disabled')
+            end
+            spe_file = fullfile(obj.test_data_path,'MAP10001.spe');
+            [S,ERR,en] = get_ascii_file(spe_file,'spe');
+
+            [Sr,ERRr,enr] = get_ascii_file(spe_file,'spe',...
+                '-detectors',[100,250],'-energies',[3,17]);
+            assertEqual(Sr,S(3:17,100:250));
+            assertEqual(ERRr,ERR(3:17,100:250));
+            assertEqual(enr,en(3:18));
+
+            [Sr,ERRr,enr] = get_ascii_file(spe_file,'-detectors',[1,1]);
+            assertEqual(Sr,S(:,1));
+            assertEqual(ERRr,ERR(:,1));
+            assertEqual(enr,en);
+
+            thrown = false;
+            try
+                [~,~,~] = get_ascii_file(spe_file,'-detectors',[1,size(S,2)+1]);
+            catch
+                thrown = true;
+            end
+            assertTrue(thrown,'detectors outside of the file should not be loaded');
+        end
+        function test_mex_single_precision(obj)
+            if isempty(which('get_ascii_file'))
+                skipTest('no get_ascii_file.mex found so the test has been disabled')
+            end
+            spe_file = fullfile(obj.test_data_path,'MAP10001.spe');
+            [S,ERR,en] = get_ascii_file(spe_file,'spe');
+            [Ss,ERRs,ens] = get_ascii_file(spe_file,'spe','-single');
+            assertTrue(isa(Ss,'single'));
+            assertTrue(isa(ERRs,'single'));
+            assertEqual(Ss,single(S));
+            assertEqual(ERRs,single(ERR));
+            assertEqual(ens,en);
+
+            [Sb,ERRb,~] = get_ascii_file({spe_file,spe_file},'spe','-single');
+            assertEqual(Sb{2},Ss);
+            assertEqual(ERRb{1},ERRs);
+        end
+        function test_load_single_precision(obj)
+            loader = loader_ascii(fullfile(obj.test_data_path,'spe_with_NANs.spe'));
+            [S0,ERR0] = load_data(loader);
+
+            loader.single_precision = true;
+            [S,ERR,en] = load_data(loader);
+            assertTrue(isa(S,'single'));
+            assertTrue(isa(ERR,'single'));
+            assertTrue(isa(en,'double'));
+            valid = ~isnan(S0);
+            assertEqual(isnan(S),~valid);
+            assertElementsAlmostEqual(double(S(valid)),S0(valid),'absolute',1.e-4);
+            assertElementsAlmostEqual(double(ERR),ERR0,'absolute',1.e-4);
+
+            % data set in memory follow the precision of the loader
+            loader.S = S0;
+            assertTrue(isa(loader.S,'single'));
+        end
     end
 end
@@ -291,6 +291,60 @@ classdef test_loader_nxspe< TestCase
             assertEqual(mask(:,1:2),logical(ones(30,2)))
             assertEqual(mask(1:2,5),logical([1;1]));
         end
+        function test_mex_reader_matches_h5read(obj)
+            if isempty(which('get_nxspe'))
+                skipTest('no get_nxspe.mex found so the test has been disabled')
+            end
+            file = f_name(obj,'test_nxspe_withNANS.nxspe');
+            loader=loader_nxspe(file);
+            root = loader.root_nexus_dir;
+            [S,ERR,en] = get_nxspe(file,root);
+
+            S0   = h5read(file,[root,'/data/data']);
+            ERR0 = h5read(file,[root,'/data/error']);
+            nans = S0<-1.e+29;
+            S0(nans)   = NaN;
+            ERR0(nans) = 0;
+            assertEqual(S,double(S0));
+            assertEqual(ERR,double(ERR0));
+            assertEqual(en,double(h5read(file,[root,'/data/energy'])));
+
+            [Sr,ERRr,enr] = get_nxspe(file,root,'-detectors',[2,4],'-energies',[5,20]);
+            assertEqual(Sr,S(5:20,2:4));
+            assertEqual(ERRr,ERR(5:20,2:4));
+            assertEqual(enr,en(5:21));
+
+            [Ss,ERRs,ens] = get_nxspe(file,root,'-single');
+            assertTrue(isa(Ss,'single'));
+            assertEqual(Ss,single(S0));
+            assertEqual(ERRs,single(ERR0));
+            assertEqual(ens,en);
+        end
+        function test_single_precision_loads_single(obj)
+            file = f_name(obj,'test_nxspe_withNANS.nxspe');
+            loader = loader_nxspe(file);
+            [S0,ERR0] = load_data(loader);
+
+            loader.single_precision = true;
+            loader = loader.load_data();
+            assertTrue(isa(loader.S,'single'));
+            assertTrue(isa(loader.ERR,'single'));
+            assertTrue(isa(loader.en,'double'));
+            assertEqual(isnan(loader.S),isnan(S0));
+            assertEqual(loader.S,single(S0));
+            assertEqual(loader.ERR,single(ERR0));
+
+            % conversion back on request
+            loader.single_precision = false;
+            assertTrue(isa(loader.S,'double'));
+            assertEqual(loader.ERR,double(single(ERR0)));
+
+            run = rundata(file,'single_precision',true);
+            run = run.load();
+            assertTrue(run.single_precision);
+            assertTrue(isa(run.S,'single'));
+            assertEqual(run.S,single(S0));
+        end
         % -----------
         function test_get_data_info(obj)
             nxspe_file_name = fullfile(obj.test_data_path,'MAP11014v2.nxspe');
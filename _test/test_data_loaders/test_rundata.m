@@ -542,6 +542,74 @@ classdef test_rundata< TestCase
             assertEqual(1044,id);
         end
         %
+        function test_load_runs_in_batches_delivers_in_order(obj)
+            spe_file = f_name(obj,'spe_info_correspondent2demo_par.spe');
+            par_file = f_name(obj,'demo_par.PAR');
+            runs = rundata.gen_runfiles({spe_file,spe_file,spe_file},par_file,'efix',200.);
+            sample = runs{1}.load();
+
+            delivered = containers.Map('KeyType','double','ValueType','any');
+            consumer = @(run,irun)subsasgn(delivered,substruct('()',{irun}),...
+                {run.S,run.ERR,run.en});
+            % the memory fits two runs per batch
+            run_bytes = 16*numel(sample.S);
+            runs = rundata.load_runs(runs,consumer,'-memory',2*run_bytes);
+
+            assertEqual(cell2mat(keys(delivered)),[1,2,3]);
+            for i=1:3
+                data = delivered(i);
+                assertEqual(data{1},sample.S);
+                assertEqual(data{2},sample.ERR);
+                assertEqual(data{3},sample.en);
+                % delivered runs are released but keep their detectors
+                assertFalse(runs{i}.is_loaded());
+                assertEqual(runs{i}.det_par,sample.det_par);
+            end
+
+            runs = rundata.load_runs(runs,'-reload');
+            for i=1:3
+                assertTrue(runs{i}.is_loaded());
+                assertEqual(runs{i}.S,sample.S);
+                assertEqual(runs{i}.ERR,sample.ERR);
+            end
+        end
+        %
+        function test_save_nxspe_runs_together(obj)
+            spe_file = f_name(obj,'spe_info_correspondent2demo_par.spe');
+            par_file = f_name(obj,'demo_par.PAR');
+            runs = rundata.gen_runfiles({spe_file,spe_file},par_file,[200,150]);
+            runs{2} = runs{2}.load();
+            runs{2}.S = 2*runs{2}.S;
+            files = {fullfile(tmp_dir,'test_save_nxspe_runs_1.nxspe'),...
+                fullfile(tmp_dir,'test_save_nxspe_runs_2.nxspe')};
+            clob_files = onCleanup(@()delete(files{:}));
+
+            hc = herbert_config;
+            [use_mex,force_mex] = get(hc,'use_mex','force_mex_if_use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex,'force_mex_if_use_mex',force_mex));
+            modes = {false};
+            if ~isempty(which('put_nxspe'))
+                modes{end+1} = true;
+            end
+            for i=1:numel(modes)
+                set(hc,'use_mex',modes{i},'force_mex_if_use_mex',modes{i});
+                rundata.save_nxspe_runs(runs,files,'w','-compress');
+                for j=1:2
+                    run = runs{j}.load();
+                    ld = loader_nxspe(files{j});
+                    ld = ld.load();
+                    assertEqual(ld.S,run.S);
+                    assertEqual(ld.ERR,run.ERR);
+                    assertEqual(ld.en,run.en);
+                    assertEqual(ld.efix,run.efix);
+                    assertEqual(ld.det_par.phi,run.det_par.phi);
+                end
+                % the files exist, so the default access mode throws
+                f = @()rundata.save_nxspe_runs(runs,files);
+                assertExceptionThrown(f,'A_LOADER:invalid_argument');
+            end
+        end
+        %
         function test_extract_runid_empty(~)
             fname = 'nlalflalel';
             id = rundata.extract_id_from_filename(fname);
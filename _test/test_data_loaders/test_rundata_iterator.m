@@ -0,0 +1,121 @@
+classdef test_rundata_iterator< TestCase
+    %
+    properties
+        log_level;
+        test_data_path;
+        spe_files = {};
+        par_file;
+    end
+    methods
+        %
+        function obj=test_rundata_iterator(name)
+            if ~exist('name', 'var')
+                name = 'test_rundata_iterator';
+            end
+            obj = obj@TestCase(name);
+            [~,tdp] = herbert_root();
+            obj.test_data_path = tdp;
+            obj.par_file = fullfile(tdp,'demo_par.PAR');
+            source = fullfile(tdp,'spe_info_correspondent2demo_par.spe');
+            for i=1:3
+                obj.spe_files{i} = fullfile(tmp_dir,sprintf('test_rundata_iterator_run%d.spe',i));
+                copyfile(source,obj.spe_files{i},'f');
+            end
+        end
+        function delete(obj)
+            for i=1:numel(obj.spe_files)
+                if is_file(obj.spe_files{i})
+                    delete(obj.spe_files{i});
+                end
+            end
+        end
+        function obj=setUp(obj)
+            obj.log_level = get(herbert_config,'log_level');
+            set(herbert_config,'log_level',-1,'-buffer');
+        end
+        function obj=tearDown(obj)
+            set(herbert_config,'log_level',obj.log_level,'-buffer');
+        end
+        %
+        function test_invalid_arguments_throw(obj)
+            runs = rundata.gen_runfiles(obj.spe_files,obj.par_file,'efix',200.);
+            assertExceptionThrown(@()rundata_iterator(runs,'-depth',-1),...
+                'HERBERT:rundata_iterator:invalid_argument');
+            assertExceptionThrown(@()rundata_iterator(runs,'-memory',0),...
+                'HERBERT:rundata_iterator:invalid_argument');
+            assertExceptionThrown(@()rundata_iterator({runs{1},'spe'}),...
+                'HERBERT:rundata_iterator:invalid_argument');
+            assertExceptionThrown(@()rundata_iterator({rundata()}),...
+                'HERBERT:rundata_iterator:invalid_argument');
+
+            iter = rundata_iterator(runs(1));
+            iter.next();
+            assertFalse(iter.has_next());
+            assertExceptionThrown(@()iter.next(),...
+                'HERBERT:rundata_iterator:runtime_error');
+        end
+        %
+        function test_runs_are_returned_in_order_without_mex(obj)
+            hc = herbert_config;
+            use_mex = get(hc,'use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex));
+            set(hc,'use_mex',false);
+
+            obj.check_iteration('-depth',2);
+        end
+        %
+        function test_prefetched_runs_equal_loaded_runs(obj)
+            hc = herbert_config;
+            [use_mex,force_mex] = get(hc,'use_mex','force_mex_if_use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex,'force_mex_if_use_mex',force_mex));
+            set(hc,'use_mex',true,'force_mex_if_use_mex',true);
+            try
+                get_ascii_file({},'spe','-prefetch',0);
+            catch ME
+                skipTest(['get_ascii_file mex is not available: ',ME.message]);
+            end
+
+            obj.check_iteration('-depth',2);
+            % one run fits the memory: the others are loaded on request
+            sample = rundata(obj.spe_files{1},obj.par_file,'efix',200.);
+            sample = sample.load();
+            obj.check_iteration('-memory',16*numel(sample.S)+1);
+        end
+        %
+        function test_reset_restarts_iteration(obj)
+            runs = rundata.gen_runfiles(obj.spe_files,obj.par_file,'efix',200.);
+            iter = rundata_iterator(runs);
+            iter.next();
+            iter.reset();
+            assertEqual(iter.n_runs,2);
+            assertEqual(iter.current,0);
+
+            iter.reset(runs);
+            assertEqual(iter.n_runs,3);
+            [~,irun] = iter.next();
+            assertEqual(irun,1);
+        end
+    end
+    methods(Access=private)
+        function check_iteration(obj,varargin)
+            runs = rundata.gen_runfiles(obj.spe_files,obj.par_file,'efix',200.);
+            sample = runs{1}.load();
+
+            iter = rundata_iterator(runs,varargin{:});
+            assertEqual(iter.n_runs,3);
+            n_done = 0;
+            while iter.has_next()
+                [run,irun] = iter.next();
+                n_done = n_done+1;
+                assertEqual(irun,n_done);
+                assertEqual(iter.current,n_done);
+                assertEqual(run.data_file_name,runs{irun}.data_file_name);
+                assertTrue(run.is_loaded());
+                assertEqual(run.S,sample.S);
+                assertEqual(run.ERR,sample.ERR);
+                assertEqual(run.en,sample.en);
+            end
+            assertEqual(n_done,3);
+        end
+    end
+end
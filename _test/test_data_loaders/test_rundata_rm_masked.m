@@ -101,6 +101,49 @@ classdef test_rundata_rm_masked< TestCase
             assertEqual(numel(det.width),4);
         end
         
+        function test_single_precision_kept(~)
+            run=rundata();
+            run.S=single(ones(3,5));
+            run.ERR=single(ones(3,5));
+            run.en = 1:4;
+            run.det_par=get_hor_format(ones(6,5),'fffff');
+            run.S(1,1)=NaN;
+
+            [s,err,det]=rm_masked(run);
+
+            assertTrue(isa(s,'single'));
+            assertTrue(isa(err,'single'));
+            assertEqual(size(s),[3,4]);
+            assertEqual(numel(det.width),4);
+        end
+        function test_mex_and_matlab_masking_equal(~)
+            hc = herbert_config;
+            [use_mex,force_mex] = get(hc,'use_mex','force_mex_if_use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex,'force_mex_if_use_mex',force_mex));
+
+            ndet = 1000;
+            run=rundata();
+            run.S=rand(10,ndet);
+            run.ERR=rand(10,ndet);
+            run.en = 1:11;
+            run.det_par=get_hor_format(rand(6,ndet),'fffff');
+            run.S(3,7:7:ndet)=NaN;
+            run.S(5,11:11:ndet)=-Inf;
+
+            set(hc,'use_mex',false);
+            [s0,err0,det0,kept0]=rm_masked(run);
+            try
+                set(hc,'use_mex',true,'force_mex_if_use_mex',true);
+                [s,err,det,kept]=rm_masked(run);
+            catch ME
+                skipTest(['c_rm_masked mex is not available: ',ME.message]);
+            end
+            assertEqual(kept,kept0);
+            assertEqual(s,s0);
+            assertEqual(err,err0);
+            assertEqual(det,det0);
+        end
+        
         
     end
 end
@@ -85,6 +85,22 @@ catch
 end
 if ~ok, assertTrue(false,'Map constructor should have failed but did not'), end
     
+% -----------------------------------------------------------------------------
+% Test C++ and Matlab readers give the same maps
+% ----------------------------------------------
+hc = herbert_config;
+[use_mex,force_mex] = get(hc,'use_mex','force_mex_if_use_mex');
+clob = onCleanup(@()set(hc,'use_mex',use_mex,'force_mex_if_use_mex',force_mex));
+map_files = {'map_1_empty.map','map_14.map','map_15_1st_empty.map','map_15_last_empty.map'};
+for i=1:numel(map_files)
+    set(hc,'use_mex',false);
+    wmat=IX_map(map_files{i});
+    set(hc,'use_mex',true);
+    wmex=IX_map(map_files{i});
+    if ~isequal(wmat,wmex), assertTrue(false,['C++ and Matlab readers differ for ',map_files{i}]), end
+end
+clear clob
+
 % -----------------------------------------------------------------------------
 % Test combine
 % ------------
@@ -130,6 +146,38 @@ wcomb=combine(m1,m2,m3);
 if ~isequal(mtot,wcomb), assertTrue(false,'Error combining three maps'), end
 
 
+% -----------------------------------------------------------------------------
+% Test spectrum to workspace lookup, grouping and section
+% -------------------------------------------------------
+m=IX_map({[5,3,4],[10,1],7},'wkno',[4,3,2]);
+[iw,wk]=spec_to_workspace(m,[1,2,3,7,10,11,4.5]);
+if ~isequal(iw,[2,0,1,3,2,0,0]), assertTrue(false,'Error finding workspace indicies of spectra'), end
+if ~isequal(wk,[3,0,4,2,3,0,0]), assertTrue(false,'Error finding workspace numbers of spectra'), end
+if ~isequal(group_spectra(m,1:10),[12,11,7]), assertTrue(false,'Error grouping spectra'), end
+if ~isequal(group_spectra(m,single(1:10)),single([12,11,7])), assertTrue(false,'Error grouping single precision spectra'), end
+
+% Remap single precision data: the same values as for double, in single precision
+S=reshape(1:30,3,10);
+ERR=0.1*S;
+sd=spe(struct('filename','','filepath','','S',single(S),'ERR',single(ERR),'en',(0:3)'));
+dd=spe(struct('filename','','filepath','','S',S,'ERR',ERR,'en',(0:3)'));
+rs=remap(sd,m);
+rd=remap(dd,m);
+if ~isa(rs.S,'single') || ~isa(rs.ERR,'single'), assertTrue(false,'Error remapping single precision spe data'), end
+if max(abs(double(rs.S(:))-rd.S(:)))>1e-5*max(abs(rd.S(:))) || max(abs(double(rs.ERR(:))-rd.ERR(:)))>1e-5*max(abs(rd.ERR(:)))
+    assertTrue(false,'Error remapping single precision spe data')
+end
+if ~isequal(section(m,[3,1]),IX_map({7,[3,4,5]},'wkno',[2,4])), assertTrue(false,'Error taking section of map'), end
+
+w=IX_map('map_15_1st_empty.map');
+iw_ref=zeros(1,numel(w.s));
+nend=cumsum(w.ns);
+for i=1:numel(w.ns)
+    iw_ref(nend(i)-w.ns(i)+1:nend(i))=i;
+end
+if ~isequal(spec_to_workspace(w,w.s),iw_ref), assertTrue(false,'Error finding workspace indicies of spectra'), end
+if ~isequal(section(w,2:15),IX_map('map_14.map')), assertTrue(false,'Error taking section of map'), end
+
 % -----------------------------------------------------------------------------
 % Test mask_map
 % -------------
@@ -48,6 +48,23 @@ wtmp=read(IX_mask,tmpfile);
 if ~isequal(w2,wtmp), assertTrue(false,'Write+read does not make an identity'), end
 
 
+%------------------------------------------------------------------------------
+% Test C++ and Matlab readers give the same masks
+% -----------------------------------------------
+hc = herbert_config;
+[use_mex,force_mex] = get(hc,'use_mex','force_mex_if_use_mex');
+clob = onCleanup(@()set(hc,'use_mex',use_mex,'force_mex_if_use_mex',force_mex));
+msk_files = {'msk_1.msk','msk_2.msk'};
+for i=1:numel(msk_files)
+    set(hc,'use_mex',false);
+    wmat=IX_mask(msk_files{i});
+    set(hc,'use_mex',true);
+    wmex=IX_mask(msk_files{i});
+    if ~isequal(wmat,wmex), assertTrue(false,['C++ and Matlab readers differ for ',msk_files{i}]), end
+end
+clear clob
+
+
 %------------------------------------------------------------------------------
 % Test combine two masks, which have some shared elements
 % -------------------------------------------------------
@@ -61,6 +78,28 @@ c2=combine(w1,w2);
 c2ref=IX_mask([2:5,19:23,30:60]);
 if ~isequal(c2,c2ref), assertTrue(false,'Error combining masks'), end
 
+%------------------------------------------------------------------------------
+% Test combine and intersect of masks with ranges of spectra, and membership
+% --------------------------------------------------------------------------
+m1=IX_mask([1:1000,5001:6000,7]);
+m2=IX_mask([995:1010,3000,6001:6010]);
+c=combine(m1,m2,[],12000);
+cref=IX_mask([1:1010,3000,5001:6010,12000]);
+if ~isequal(c,cref), assertTrue(false,'Error combining masks'), end
+
+c=intersect(m1,m2);
+if ~isequal(c,IX_mask(995:1000)), assertTrue(false,'Error intersecting masks'), end
+c=intersect(m1,IX_mask(2e4));
+if ~isequal(c,IX_mask), assertTrue(false,'Error intersecting masks'), end
+
+isp=[0,1,1000,1001,3000,5000.5;6000,6001,12000,2e7,-1,1e8];
+tf_ref=ismember(isp,cref.msk);
+if ~isequal(ismasked(cref,isp),tf_ref), assertTrue(false,'Error finding masked spectra'), end
+big=combine(cref,[1e8-5:1e8,1.5e8]);   % spectrum numbers too large for the bitset
+tf_ref=ismember(isp,big.msk);
+if ~isequal(ismasked(big,isp),tf_ref), assertTrue(false,'Error finding masked spectra'), end
+if any(ismasked(IX_mask,isp(:))), assertTrue(false,'Error finding masked spectra'), end
+
 %------------------------------------------------------------------------------
 % Success announcement
 % --------------------
@@ -7,5 +7,11 @@ classdef MFTester<MessagesFilebased
         function mess_fname = job_stat_fname(obj,job_id,mess_name)
             mess_fname  = obj.job_stat_fname_(job_id,mess_name);
         end
+        function seq = get_messages_sequence(obj)
+            seq = obj.messages_sequence();
+        end
+        function seq = wait_messages(obj,seq,timeout)
+            seq = obj.wait_for_messages(seq,timeout);
+        end
     end
 end
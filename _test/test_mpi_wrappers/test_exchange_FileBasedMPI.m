@@ -702,6 +702,29 @@ classdef test_exchange_FileBasedMPI < exchange_common_tests & FakeJenkins4Tests
             assertTrue(isempty(mid_from))
         end
         
+        function test_wait_for_messages_without_mex(obj)
+            hc = herbert_config;
+            use_mex = get(hc,'use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex));
+            set(hc,'use_mex',false);
+            
+            obj.check_wait_for_messages('test_wait_nomex');
+        end
+        
+        function test_wait_for_messages_with_mex(obj)
+            hc = herbert_config;
+            [use_mex,force_mex] = get(hc,'use_mex','force_mex_if_use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex,'force_mex_if_use_mex',force_mex));
+            set(hc,'use_mex',true,'force_mex_if_use_mex',true);
+            try
+                c_wait_for_change();
+            catch ME
+                skipTest(['c_wait_for_change mex is not available: ',ME.message]);
+            end
+            
+            obj.check_wait_for_messages('test_wait_mex');
+        end
+        
         function test_message(this)
             fiis = iMessagesFramework.build_worker_init(this.working_dir, ...
                 'test_message', 'MessagesFilebased', 0, 3);
@@ -761,6 +784,43 @@ classdef test_exchange_FileBasedMPI < exchange_common_tests & FakeJenkins4Tests
         
         %------------------------------------------------------------------
         
+        function check_wait_for_messages(obj,job_name)
+            % the receiver is woken by the message sent to it and waits
+            % until the timeout if nothing has been sent
+            css1 = iMessagesFramework.build_worker_init(obj.working_dir, ...
+                job_name, 'MessagesFilebased', 1, 3);
+            sender = MFTester(iMessagesFramework.deserialize_par(css1));
+            clob = onCleanup(@()sender.finalize_all());
+            css2 = iMessagesFramework.build_worker_init(obj.working_dir, ...
+                job_name, 'MessagesFilebased', 2, 3);
+            receiver = MFTester(iMessagesFramework.deserialize_par(css2));
+            
+            seq0 = receiver.get_messages_sequence();
+            assertEqual(seq0,-1);
+            t0 = tic;
+            seq = receiver.wait_messages(seq0,0.3);
+            assertEqual(seq,seq0);
+            assertTrue(toc(t0)>=0.25);
+            
+            [ok, err] = sender.send_message(2, 'started');
+            assertEqual(ok, MESS_CODES.ok, err);
+            seq1 = receiver.get_messages_sequence();
+            assertTrue(seq1>seq0);
+            % the messages to the other labs do not change the sequence
+            [ok, err] = sender.send_message(3, 'started');
+            assertEqual(ok, MESS_CODES.ok, err);
+            assertEqual(receiver.get_messages_sequence(),seq1);
+            
+            t0 = tic;
+            seq = receiver.wait_messages(seq0,10);
+            assertEqual(seq,seq1);
+            assertTrue(toc(t0)<5);
+            
+            [ok, err, mess] = receiver.receive_message(1, 'started');
+            assertEqual(ok, MESS_CODES.ok, err);
+            assertEqual(mess.mess_name,'started');
+        end
+        
         function test_next_job_id_text(~)
             mf = MessagesFilebased('test_next_job_id');
             clObj = onCleanup(@()finalize_all(mf));
@@ -264,6 +264,42 @@ classdef test_cpp_deserialise < TestCase
             assertEqual(test_obj, test_obj_rec)
         end
 
+        %------------------------------------------------------------------
+        function test_ser_complex_single_array(this)
+            if ~this.use_mex
+              skipTest('MEX not enabled');
+            end
+            test_obj = single([3+4i, 5+7i, 1; 2+1i, 1-1i, 2i; 6, -3i, 0.5+0.25i]);
+            ser =  c_serialise(test_obj);
+            test_obj_rec = c_deserialise(ser);
+            assertEqual(test_obj, test_obj_rec)
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_complex_int_array(this)
+            if ~this.use_mex
+              skipTest('MEX not enabled');
+            end
+            test_obj = complex(int16([1, -2, 3; 4, 5, -6]), int16([7, 8, -9; 10, -11, 12]));
+            ser =  c_serialise(test_obj);
+            test_obj_rec = c_deserialise(ser);
+            assertEqual(test_obj, test_obj_rec)
+        end
+
+        %------------------------------------------------------------------
+        function test_deser_dim64_header(this)
+            if ~this.use_mex
+              skipTest('MEX not enabled');
+            end
+            % dimensions written as uint64 (flag 128 in the dims byte)
+            test_obj = [1, 2, 3; 4, 5, 6];
+            ser = [uint8(3); uint8(128+2); typecast(uint64([2, 3]), 'uint8')'; ...
+                typecast(test_obj(:)', 'uint8')'];
+            [test_obj_rec,nBytes] = c_deserialise(ser);
+            assertEqual(test_obj, test_obj_rec)
+            assertEqual(numel(ser),nBytes);
+        end
+
         %% Test Structs
         %------------------------------------------------------------------
         function test_ser_struct_null(this)
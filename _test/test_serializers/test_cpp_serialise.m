@@ -254,6 +254,28 @@ classdef test_cpp_serialise < TestCase
             assertEqual(test_obj, test_obj_rec)
         end
 
+        %------------------------------------------------------------------
+        function test_ser_complex_single_array(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            test_obj = single([3+4i, 5+7i, 1; 2+1i, 1-1i, 2i; 6, -3i, 0.5+0.25i]);
+            ser =  c_serialise(test_obj);
+            test_obj_rec = hlp_deserialise(ser);
+            assertEqual(test_obj, test_obj_rec)
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_complex_int_array(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            test_obj = complex(int16([1, -2, 3; 4, 5, -6]), int16([7, 8, -9; 10, -11, 12]));
+            ser =  c_serialise(test_obj);
+            test_obj_rec = hlp_deserialise(ser);
+            assertEqual(test_obj, test_obj_rec)
+        end
+
         %% Test Structs
         %------------------------------------------------------------------
         function test_ser_struct_null(this)
@@ -310,6 +332,38 @@ classdef test_cpp_serialise < TestCase
             assertEqual(test_struct, test_struct_rec)
         end
 
+        %------------------------------------------------------------------
+        function test_ser_struct_array_by_column(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            inner = arrayfun(@(i)struct('x',i,'y',{{i,'a'}}),1:6);
+            test_struct = struct('sig', num2cell(rand(3,6),1), ...
+                'cmplx', num2cell(complex(rand(2,6),rand(2,6)),1),...
+                'name', {'abc','def','ghi','jkl','mno','pqr'},...
+                'mixed', {1, 'a', [], {2}, int8(3), true},...
+                'inner', num2cell(inner));
+            test_struct = reshape(test_struct,2,3);
+            ser = c_serialise(test_struct);
+            assertEqual(ser, hlp_serialise(test_struct))
+            assertEqual(numel(ser), c_serial_size(test_struct))
+            assertEqual(test_struct, c_deserialise(ser))
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_struct_array_complex_columns(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            test_struct = struct(...
+                'csingle', num2cell(single(complex(rand(3,4),rand(3,4))),1),...
+                'cint16', num2cell(complex(int16(1:4),int16(-4:-1))));
+            ser = c_serialise(test_struct);
+            assertEqual(ser, hlp_serialise(test_struct))
+            assertEqual(numel(ser), c_serial_size(test_struct))
+            assertEqual(test_struct, c_deserialise(ser))
+        end
+
         %% Test Sparse
         %------------------------------------------------------------------
         function test_ser_real_sparse_null(this)
@@ -340,8 +394,6 @@ classdef test_cpp_serialise < TestCase
             end
             test_sparse = sparse(eye(1));
             ser =  c_serialise(test_sparse);
-            % Adjust C [0] -> MATLAB [1] indexing
-            ser(15:8:23) = ser(15:8:23) + 1;
             test_sparse_rec = hlp_deserialise(ser);
             assertEqual(test_sparse, test_sparse_rec)
         end
@@ -353,8 +405,6 @@ classdef test_cpp_serialise < TestCase
             end
             test_sparse = speye(10);
             ser =  c_serialise(test_sparse);
-            % Adjust C [0] -> MATLAB [1] indexing
-            ser(15:8:168) = ser(15:8:168) + 1;
             test_sparse_rec = hlp_deserialise(ser);
             assertEqual(test_sparse, test_sparse_rec)
         end
@@ -388,8 +438,6 @@ classdef test_cpp_serialise < TestCase
             end
             test_sparse = sparse(1, 1, 1i);
             ser =  c_serialise(test_sparse);
-            % Adjust C [0] -> MATLAB [1] indexing
-            ser(15:8:23) = ser(15:8:23) + 1;
             test_sparse_rec = hlp_deserialise(ser);
             assertEqual(test_sparse, test_sparse_rec)
         end
@@ -401,12 +449,21 @@ classdef test_cpp_serialise < TestCase
             end
             test_sparse = sparse(1:10, 1, 1i);
             ser =  c_serialise(test_sparse);
-            % Adjust C [0] -> MATLAB [1] indexing
-            ser(15:8:168) = ser(15:8:168) + 1;
             test_sparse_rec = hlp_deserialise(ser);
             assertEqual(test_sparse, test_sparse_rec)
         end
 
+        %------------------------------------------------------------------
+        function test_ser_sparse_same_as_matlab(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            test_sparse = sprand(20, 15, 0.2) + 1i*sprand(20, 15, 0.1);
+            ser =  c_serialise(test_sparse);
+            assertEqual(ser, hlp_serialise(test_sparse))
+            assertEqual(numel(ser), c_serial_size(test_sparse))
+        end
+
         %% Test Function handle
         function test_ser_function_handle(this)
             if ~this.use_mex
@@ -544,5 +601,39 @@ classdef test_cpp_serialise < TestCase
             assertEqual(test_cell, test_cell_rec)
         end
 
+        %% Test hashing
+        %------------------------------------------------------------------
+        function test_ser_hash_equal_for_equal_objects(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            test_obj = struct('a', {1, 'b'}, 'c', {{1, 2}, sparse(eye(3))});
+            hash = c_serialise(test_obj, '-hash');
+            assertEqual(size(hash), [1, 16])
+            assertTrue(isa(hash, 'uint8'))
+            assertEqual(hash, c_serialise(test_obj, '-hash'))
+
+            test_obj(2).a = 'c';
+            assertFalse(isequal(hash, c_serialise(test_obj, '-hash')))
+        end
+
+        %------------------------------------------------------------------
+        function test_serial_hash_throws_without_mex(~)
+            hc = herbert_config;
+            use_mex = get(hc,'use_mex');
+            clob = onCleanup(@()set(hc,'use_mex',use_mex));
+            set(hc,'use_mex',false);
+            % no hash of a different kind is returned without mex
+            assertExceptionThrown(@() serial_hash(1), 'HERBERT:serial_hash:runtime_error');
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_hash_bad_option_throws(this)
+            if ~this.use_mex
+                skipTest('MEX not enabled');
+            end
+            assertExceptionThrown(@() c_serialise(1, '-md5'), 'MATLAB:c_serialise:badRHS');
+        end
+
     end
 end
\ No newline at end of file
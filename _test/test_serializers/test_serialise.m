@@ -282,6 +282,51 @@ classdef test_serialise < TestCase
 
         end
 
+        %------------------------------------------------------------------
+        function test_deser_dim64_header(~)
+            % dimensions written as uint64 (flag 128 in the dims byte)
+            % decode to the same array as the standard uint32 ones
+            test_obj = [1, 2, 3; 4, 5, 6];
+            ser = [uint8(3); uint8(128+2); typecast(uint64([2, 3]), 'uint8')'; ...
+                typecast(test_obj(:)', 'uint8')'];
+            [test_obj_rec,nBytes] = hlp_deserialise(ser);
+            assertEqual(test_obj, test_obj_rec)
+            assertEqual(numel(ser),nBytes);
+        end
+
+        %------------------------------------------------------------------
+        function test_deser_dim64_sparse(~)
+            test_sparse = sparse([1, 3], [2, 2], [5, 7], 4, 3);
+            ser = [uint8(30); uint8(128+2); typecast(uint64([4, 3, 2]), 'uint8')'; ...
+                typecast(uint64([1, 3, 2, 2]), 'uint8')'; ...
+                typecast([5, 7], 'uint8')'];
+            [test_sparse_rec,nBytes] = hlp_deserialise(ser);
+            assertEqual(test_sparse, test_sparse_rec)
+            assertEqual(numel(ser),nBytes);
+        end
+
+        %------------------------------------------------------------------
+        function test_deser_sparse_old_format(~)
+            % streams written before compressed sparse column form hold
+            % uint64 row and column indices for each non-zero element
+            test_sparse = sparse([1, 3], [2, 2], [5, 7], 4, 3);
+            ser = [uint8(30); uint8(2); typecast(uint32([4, 3, 2]), 'uint8')'; ...
+                typecast(uint64([1, 3, 2, 2]), 'uint8')'; ...
+                typecast([5, 7], 'uint8')'];
+            [test_sparse_rec,nBytes] = hlp_deserialise(ser);
+            assertEqual(test_sparse, test_sparse_rec)
+            assertEqual(numel(ser),nBytes);
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_sparse_csc_size(~)
+            % 4 bytes per non-zero and column for indices, 8 for data
+            test_sparse = speye(100);
+            ser =  hlp_serialise(test_sparse);
+            assertEqual(numel(ser), 2+3*4+(101+100)*4+100*8);
+            assertEqual(test_sparse, hlp_deserialise(ser))
+        end
+
         % Test Structs
         %------------------------------------------------------------------
         function test_ser_struct_null(~)
@@ -343,6 +388,51 @@ classdef test_serialise < TestCase
 
         end
 
+        %------------------------------------------------------------------
+        function test_ser_struct_array_by_column(~)
+            % dense, complex, char, mixed, unset and nested struct columns
+            inner = arrayfun(@(i)struct('x',i,'y',{{i,'a'}}),1:6);
+            test_struct = struct('sig', num2cell(rand(3,6),1), ...
+                'cmplx', num2cell(complex(rand(2,6),rand(2,6)),1),...
+                'name', {'abc','def','ghi','jkl','mno','pqr'},...
+                'mixed', {1, 'a', [], {2}, int8(3), true},...
+                'inner', num2cell(inner));
+            test_struct = reshape(test_struct,2,3);
+            ser = hlp_serialise(test_struct);
+            assertEqual(bitand(ser(2),hlp_serial_types.struct_columns_flag),...
+                uint8(hlp_serial_types.struct_columns_flag));
+            test_struct_rec = hlp_deserialise(ser);
+            assertEqual(test_struct, test_struct_rec)
+
+            size = hlp_serial_sise(test_struct);
+            assertEqual(size,numel(ser));
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_struct_array_complex_columns(~)
+            % complex single and complex integer fields are dense columns
+            test_struct = struct(...
+                'csingle', num2cell(single(complex(rand(3,4),rand(3,4))),1),...
+                'cint16', num2cell(complex(int16(1:4),int16(-4:-1))));
+            ser = hlp_serialise(test_struct);
+            test_struct_rec = hlp_deserialise(ser);
+            assertEqual(test_struct, test_struct_rec)
+
+            size = hlp_serial_sise(test_struct);
+            assertEqual(size,numel(ser));
+        end
+
+        %------------------------------------------------------------------
+        function test_ser_struct_array_no_fields(~)
+            test_struct = repmat(struct(), 2, 3);
+            ser = hlp_serialise(test_struct);
+            test_struct_rec = hlp_deserialise(ser);
+            assertEqual(test_struct, test_struct_rec)
+
+            size = hlp_serial_sise(test_struct);
+            assertEqual(size,numel(ser));
+        end
+
         % Test Sparse
         %------------------------------------------------------------------
         function test_ser_real_sparse_null(~)
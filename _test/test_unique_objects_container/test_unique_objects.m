@@ -141,6 +141,26 @@ classdef test_unique_objects < TestCase
             %}
         end
         %----------------------------------------------------------------
+        function test_serial_hash_deduplicates(~)
+            disp('Test: test_serial_hash_deduplicates');
+            try
+                serial_hash(1);
+            catch ME
+                skipTest(['serial_hash is not available: ',ME.message]);
+            end
+            li = let_instrument(5, 240, 80, 20, 1);
+            mi = merlin_instrument(180, 600, 'g');
+            uoc = unique_objects_container('type','{}','convert_to_stream',@serial_hash);
+            uoc = uoc.add(li);
+            uoc = uoc.add(mi);
+            uoc = uoc.add(li);
+            uoc = uoc.add(mi);
+            assertEqual( numel(uoc.idx), 4);
+            assertEqual( numel(uoc.stored_objects), 2);
+            assertEqual( uoc.n_duplicates, [2 2]);
+            assertEqual( size(uoc.stored_hashes), [2 16]);
+        end
+        %----------------------------------------------------------------
         function test_constructor_arguments(~)
             disp('Test: test_constructor_arguments');
             disp('NB This test WILL emit warningS');
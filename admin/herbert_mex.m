@@ -65,13 +65,20 @@ try
     if build_c
         % build C++ files
         mex_single_c(fullfile(herbert_C_code_dir,'get_ascii_file'), herbert_mex_target_dir,...
-            'get_ascii_file.cpp','IIget_ascii_file.cpp')
+            'get_ascii_file.cpp','IIget_ascii_file.cpp','ascii_cache.cpp','ascii_prefetch.cpp',...
+            'mapped_file.cpp','map_file.cpp')
+        mex_single_c(fullfile(herbert_C_code_dir,'put_ascii_file'), herbert_mex_target_dir,...
+            'put_ascii_file.cpp','IIput_ascii_file.cpp')
+        mex_single_c(fullfile(herbert_C_code_dir,'rm_masked'), herbert_mex_target_dir,...
+            'c_rm_masked.cpp','IIrm_masked.cpp')
+        mex_single_c(fullfile(herbert_C_code_dir,'file_notify'), herbert_mex_target_dir,...
+            'c_wait_for_change.cpp','IIfile_notify.cpp')
         mex_single_c(fullfile(herbert_C_code_dir,'serialiser'), herbert_mex_target_dir,...
-            'c_serialise.cpp')
+            'c_serialise.cpp','serialise.cpp','deserialise.cpp','serial_size.cpp')
         mex_single_c(fullfile(herbert_C_code_dir,'serialiser'), herbert_mex_target_dir,...
-            'c_deserialise.cpp')
+            'c_deserialise.cpp','serialise.cpp','deserialise.cpp','serial_size.cpp')
         mex_single_c(fullfile(herbert_C_code_dir,'serialiser'), herbert_mex_target_dir,...
-            'c_serial_size.cpp')
+            'c_serial_size.cpp','serialise.cpp','deserialise.cpp','serial_size.cpp')
         
 
         try % failure in using this routine does not affect use_mex option as the routine is not checking it and
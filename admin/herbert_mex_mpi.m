@@ -12,7 +12,9 @@ else
     verbose = false;
 end
 % the files, contributing into the communicator.
-input_files = {'cpp_communicator.cpp', 'input_parser.cpp', 'MPI_wrapper.cpp'};
+% (labReceive deserialises messages straight from the MPI receive buffer)
+input_files = {'cpp_communicator.cpp', 'input_parser.cpp', 'MPI_wrapper.cpp',...
+    fullfile('..','serialiser','deserialise.cpp')};
 % Dependency set-up part
 opt_file = '';
 
@@ -0,0 +1,33 @@
+% The function removes the detectors with failed (NaN or Inf) signal from
+% the signal, error and detector parameters arrays of a run
+%%
+%  usage:
+%
+%  [S_m,ERR_m,not_masked,det1_m,det2_m,...] = ...
+%           c_rm_masked(S,ERR,ignore_nan,ignore_inf,det1,det2,...)
+%
+%%
+%  input arguments:
+%   S(ne,ndet)     signal; ndet=no. detectors, ne=no. energy bins
+%   ERR(ne,ndet)   errors of the same class as the signal (double or
+%                  single)
+%   ignore_nan     if true, remove the detectors which signal contains NaN
+%   ignore_inf     if true, remove the detectors which signal contains
+%                  +-Inf
+%   det1,det2,...  optional detector parameters arrays (e.g. the numeric
+%                  fields of det_par) with one value per detector or
+%                  (n,ndet) arrays of n values per detector
+%%
+% output parameters:
+%   S_m(ne,nkept)    signal of the detectors kept, of the input class
+%   ERR_m(ne,nkept)  errors of the detectors kept, of the input class
+%   not_masked       logical (1,ndet) array, true for the detectors kept
+%   det1_m,...       detector arrays of the detectors kept, of the same
+%                    orientation as the input arrays
+%
+%   The signal is scanned and the arrays are compacted in one pass on all
+%   available threads. Used by rundata.rm_masked.
+%
+%% -----------------------------------------------------------------------
+% Help file:   $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
+%%
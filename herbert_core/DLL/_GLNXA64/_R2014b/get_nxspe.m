@@ -0,0 +1,35 @@
+% The function loads into the memory the signal, error and energy bins of
+% an NXSPE file
+%%
+%  usage:
+%
+%  [S,ERR,en] = get_nxspe(fileName,root_folder,...
+%                         ['-detectors',[first,last]],['-energies',[first,last]],...
+%                         ['-single'])
+%
+%%
+%  input arguments:
+% 	file_name   -- a string which specifies the name of the NXSPE file
+% 	root_folder -- the name of the NXSPE entry in the file, e.g. '/11014.spe'
+%   '-detectors',[first,last]
+%               -- optional key and range. Load only detectors first:last
+%   '-energies',[first,last]
+%               -- optional key and range. Load only energy bins
+%                  first:last. en then contains the last-first+2
+%                  boundaries of these bins
+%   '-single'   -- optional key. Return S and ERR as single precision
+%                  arrays, converted while they are read from the file
+%%
+%  output parameters:
+%     S(ne,ndet)     signal; ndet=no. detectors, ne=no. energy bins.
+%                    Values below -1e29 (null data) are returned as NaN
+%     ERR(ne,ndet)   errors; 0 where the signal is null data
+%     en(ne+1,1)     energy bin boundaries
+%
+%  Only the detectors and energy bins requested are read from the file.
+%  Compressed chunks of the datasets are decompressed on all available
+%  threads.
+%
+%% -----------------------------------------------------------------------
+% Help file:   $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
+%%
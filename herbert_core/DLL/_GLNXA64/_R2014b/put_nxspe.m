@@ -0,0 +1,40 @@
+% The function writes runs into NXSPE files with the layout written by
+% the Matlab code of a_loader.saveNXSPE
+%%
+%  usage:
+%
+%  put_nxspe(runs,['-deflate',level],['-shuffle'],['-chunk',bytes])
+%
+%%
+%  input arguments:
+% 	runs        -- structure or structure array, every element of which
+%                  describes an NXSPE file with the fields:
+%      file_name       -- the name of the file to write. An existing
+%                         file is overwritten
+%      root_folder     -- the name of the NXentry group of the file
+%      S(ne,ndet)      -- signal; ndet=no. detectors, ne=no. energy bins
+%      ERR(ne,ndet)    -- errors
+%      en(ne+1)        -- energy bin boundaries
+%      polar, azimuthal, distance, polar_width, azimuthal_width
+%                      -- ndet values each, the detector parameters
+%      efix, psi       -- incident energy and the rotation angle of the
+%                         crystal
+%      nxspe_version   -- the version of the NXSPE definition, e.g. '1.2'
+%      program_version -- the version of Herbert
+%   '-deflate',level
+%               -- optional key and compression level 1-9. Compress the
+%                  signal and error
+%   '-shuffle'  -- optional key. Apply the shuffle filter to the signal
+%                  and error before deflate
+%   '-chunk',bytes
+%               -- optional key and approximate size of the chunks of
+%                  the signal and error. Default: 1MB
+%%
+%  The signal and error are stored in chunks of all energy bins of a
+%  block of detectors, which can be decompressed in parallel when they are
+%  read by get_nxspe. The chunks of all runs are compressed on all
+%  available threads, so many small files are written in parallel too.
+%
+%% -----------------------------------------------------------------------
+% Help file:   $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
+%%
@@ -0,0 +1,31 @@
+% The function waits until the sequence of a sentinel file, which the senders
+% of filebased messages append a byte to, differs from the sequence seen last
+%%
+%  usage:
+%
+%  [seq,notified] = c_wait_for_change(file_name,last_seq,timeout,[poll_interval])
+%
+%%
+%  input arguments:
+%   file_name      the name of the sentinel file
+%   last_seq       the sequence of the file seen last: its size in bytes
+%                  or -1 if the file did not exist
+%   timeout        the longest time to wait, in seconds
+%   poll_interval  optional time between the checks of the file where the
+%                  kernel does not notify about its changes (0.1 sec by
+%                  default)
+%%
+% output parameters:
+%   seq       the sequence of the file on return, equal to last_seq if the
+%             wait has timed out
+%   notified  true if the folder of the file was watched with inotify and
+%             false if the file was polled
+%
+%   On Linux, the folder of the file on a local file system is watched with
+%   inotify, so the function returns as soon as the file is written or the
+%   folder is removed. The file is polled on network file systems (NFS, SMB,
+%   Lustre...) and other operating systems. Used by MessagesFilebased.
+%
+%% -----------------------------------------------------------------------
+% Help file:   $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
+%%
@@ -2,22 +2,67 @@
 %%
 %  usage:
 %
-%  [result] = get_ascii_file(fileName,[file_type])
+%  [result] = get_ascii_file(fileName,[file_type],['-cache'],...)
+%                             ['-detectors',[first,last]],['-energies',[first,last]],...
+%                             ['-single'])
+%  info     = get_ascii_file(fileName,[file_type],'-info')
+%  n_queued = get_ascii_file(fileName,[file_type],'-prefetch',max_bytes)
 %
 %%
 %  input arguments:
 % 	file_name -- a string which specifies the name of the input data file.
 %                The file has to be an ascii file of one of formats
-%                specified below
+%                specified below.
+%                If it is a cell array of file names, the files are loaded
+%                concurrently and each output is a cell array of the same
+%                shape, containing the results for every file.
 % 	file_type -- optional string, defining the file format
-% 	             three values for this string are currently possible:
-% 				 spe, par or  phx. It can also be omitted.
+% 	             five values for this string are currently possible:
+% 				 spe, par, phx, map or msk. It can also be omitted.
 % 				 If omitted, the program tries to identify the file type  
-%                from the file format.
+%                from the file format (map and msk files are read only
+%                when their type is requested).
 % 				 If the file type option is specified and the file format differs 
 % 				 from the requested, the error is thrown
+%   '-cache'  -- optional key. If present, the parsed file is kept in the
+%                binary file <fileName>.hcache next to it and later calls
+%                with this key read the data from there while the cache
+%                is valid (the file size, modification time and first and
+%                last 64KB of the file are unchanged). Enabled in loaders by
+%                herbert_config.use_ascii_cache
+%   '-detectors',[first,last]
+%             -- optional key and range. Load only detectors first:last
+%                of an spe file, without reading the other detectors
+%   '-energies',[first,last]
+%             -- optional key and range. Load only energy bins
+%                first:last of an spe file. en then contains the
+%                last-first+2 boundaries of these bins
+%   '-single' -- optional key. Return the signal and error of spe files
+%                (file type 'spe' has to be requested) as single precision
+%                arrays, converted while the files are parsed or copied
+%                from the cache. Energy bins remain double precision. The
+%                cache holds double precision data, so valid caches are
+%                read, but the files parsed are not written to the cache
+%   '-prefetch',max_bytes
+%             -- optional key and size. Queue the files for parsing by a
+%                background thread and return the number of files queued.
+%                The parsed data are kept until the file is loaded by a
+%                later call (without ranges) and are used only if the file
+%                has not changed. The data kept never exceed max_bytes;
+%                the files which do not fit are parsed when they are
+%                loaded. max_bytes=0 drops all prefetched data.
+%                Used by rundata_iterator
+%   '-info'   -- optional key. Read only the header of the file (and the
+%                energy grid of an spe file) and return the structure
+%                (structure array of the shape of the cell array of files)
+%                with the fields:
+%                file_type   -- 'par', 'phx' or 'spe'
+%                n_detectors -- number of detectors in the file
+%                n_energies  -- number of energy bins (0 for par and phx)
+%                en          -- energy bin boundaries of an spe file
+%                               (empty for par and phx files)
 %%
-% output parameters:    three forms are possible:
+% output parameters:    five forms are possible:
 %% ------------------------------------------------------------------------
 % 1) an ASCII Tobyfit par file
 %      Syntax:
@@ -63,6 +108,23 @@
 %      data_ERR(ne,ndet)   Error array
 %      en(ne+1,1)          energy bin boundaries
 %
+%% -----------------------------------------------------------------------
+% 4) an ASCII map file (or the old VMS map file), as read by IX_map
+%
+%      Syntax:
+%      >> [ns, s, wkno] = get_ascii_file(filename,'map')
+%
+%      ns(1,nw)            number of spectra in each of nw workspaces
+%      s(1,sum(ns))        spectrum numbers of the workspaces, concatenated
+%      wkno(1,nw)          workspace numbers (zeros(1,0) for VMS map files)
+%
+%% -----------------------------------------------------------------------
+% 5) an ASCII mask file, as read by IX_mask
+%
+%      Syntax:
+%      >> msk = get_ascii_file(filename,'msk')
+%
+%      msk(1,nmsk)         masked spectra, in the order they are listed
 %
 %% -----------------------------------------------------------------------
 % Help file:   $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
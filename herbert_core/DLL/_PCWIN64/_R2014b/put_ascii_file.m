@@ -0,0 +1,40 @@
+% The function writes an ASCII file of a specific format
+%%
+%  usage:
+%
+%  put_ascii_file(fileName,'spe',data_S,data_ERR,en)
+%  put_ascii_file(fileName,'par',par)
+%  put_ascii_file(fileName,'phx',phx)
+%
+%%
+%  input arguments:
+% 	file_name -- a string which specifies the name of the output file.
+%                An existing file is overwritten.
+% 	file_type -- string, defining the file format: spe, par or phx
+%
+%   The text is the same as the one written by the Matlab functions
+%   write_spe_, put_parObject and put_phxObject; the detector blocks are
+%   formatted on all available threads.
+%
+%%
+%1) an ASCII spe file
+%     data_S(ne,ndet)     signal; ndet=no. detectors, ne=no. energy bins
+%     data_ERR(ne,ndet)   errors
+%     en(ne+1)            energy bin boundaries (written rounded to 1e-5)
+%
+%     Values larger than 1e30 are written as 1e30 and values smaller than
+%     1e-30 by modulo as 0. NaN-s should be replaced by the null data value
+%     -1e30 before the call, as put_spe does.
+%-----------------------------------------------------------------------
+%2) an ASCII par file
+%     par(6,ndet)         columns of the file: [x2;phi;azim;width;height;group]
+%                         (azim has the sign convention of the par file)
+%-----------------------------------------------------------------------
+%3) an ASCII phx file
+%     phx(7,ndet)         columns of the file: [10;0;phi;azim;dphi;danght;group]
+%
+%     The detector groups (last row) of par and phx data have to be integers.
+%
+%% -----------------------------------------------------------------------
+% Help file:   $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
+%%
\ No newline at end of file
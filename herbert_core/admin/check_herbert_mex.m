@@ -17,13 +17,17 @@ function [rez, n_errors] = check_herbert_mex()
 % function
 functions_name_list = {
     'get_ascii_file    : ', ...
+    'put_ascii_file    : ', ...
+    'c_rm_masked       : ', ...
+    'c_wait_for_change : ', ...
     'cpp_communicator  : ', ...
     'c_serialise       : ', ...    
     'c_deserialise     : ', ...    
     'c_serial_sise     : ', ...        
 };
 % list of the mex files handles used by Horace and verified by this script.
-functions_handle_list = {@get_ascii_file, @cpp_communicator,...
+functions_handle_list = {@get_ascii_file, @put_ascii_file, @c_rm_masked,@c_wait_for_change,...
+    @cpp_communicator,...
     @c_serialise,@c_deserialise,@c_serial_size};
 
 rez = cell(numel(functions_name_list), 1);
@@ -34,11 +34,13 @@ else
 end
 
 % C++ code checks for interrupt internaly, so no checks in Matlab code is
-% necessary
+% necessary. The message is deserialised by the C++ code straight from the
+% buffer it is received into, so its serialised form never becomes a
+% Matlab array.
 try
-    [obj.mpi_framework_holder_,mess_data]=cpp_communicator('labReceive',...
+    [obj.mpi_framework_holder_,mess]=cpp_communicator('labReceive',...
         obj.mpi_framework_holder_,int32(from_task_id),int32(mess_tag),...
-        uint8(is_blocking));
+        uint8(is_blocking),uint8(true));
 catch ERR
     if strcmpi(ERR.identifier,'MPI_MEX_COMMUNICATOR:runtime_error')
         error('MESSAGES_FRAMEWORK:runtime_error',...
@@ -47,9 +49,7 @@ catch ERR
         rethrow(ERR);
     end
 end
-if isempty(mess_data) % no message present at asynchronous receive.
+if isempty(mess) % no message present at asynchronous receive.
     mess  = [];
-else
-    mess = deserialise(mess_data);
 end
 obj.set_interrupt(mess,from_task_id);
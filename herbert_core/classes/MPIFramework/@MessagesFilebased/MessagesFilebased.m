@@ -52,6 +52,13 @@ classdef MessagesFilebased < iMessagesFramework
         receive_data_messages_count_;
         % Holder for initial framework information
         initial_framework_info_
+        % The longest time (sec) a receiver waits for the notification
+        % about a message sent to it before listing the exchange folder
+        % again, in case the notification has been missed.
+        notify_timeout_ = 1;
+        % false if c_wait_for_change have failed, so the arrivals of the
+        % messages are polled in Matlab
+        use_wait_mex_ = true;
     end
     %----------------------------------------------------------------------
     methods
@@ -486,6 +493,26 @@ classdef MessagesFilebased < iMessagesFramework
             %
             [ok,err_mess,message] = receive_message_(obj,from_task_id,mess_name,is_blocking);
         end
+        %
+        function seq = messages_sequence(obj)
+            % Return the sequence number of the messages sent to this lab:
+            % the size of the sentinel file, senders append a byte to when
+            % they send a message to the lab, or -1 if no message has been
+            % sent to it yet.
+            seq = mess_sequence_(build_sentinel_fname_(obj,obj.labIndex));
+        end
+        %
+        function seq = wait_for_messages(obj,seq,timeout)
+            % Wait until a message is sent to this lab after the sequence
+            % seq was obtained, or timeout (but not more than
+            % notify_timeout_) seconds pass, and return the current
+            % sequence of the messages.
+            %
+            % Receivers are woken by inotify when the exchange folder is
+            % on a local Linux file system and check the single sentinel
+            % file instead of listing the exchange folder otherwise.
+            seq = wait_for_messages_(obj,seq,timeout);
+        end
     end
     methods(Static,Access=protected)
         function mess_fname = mess_fname_(obj,lab_to,mess_name,lab_from,is_sender)
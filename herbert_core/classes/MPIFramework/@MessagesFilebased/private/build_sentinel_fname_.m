@@ -0,0 +1,9 @@
+function sentinel = build_sentinel_fname_(obj,lab_to)
+% Builds the name of the sentinel file, which senders append a byte to when
+% they send a message to the lab lab_to, so the size of the file is the
+% sequence number of the messages sent to this lab.
+%
+% The name does not start with the message prefix, so the file is never
+% taken for a message when the exchange folder is listed.
+
+sentinel = fullfile(obj.mess_exchange_folder,sprintf('arrivals_ToN%d.seq',lab_to));
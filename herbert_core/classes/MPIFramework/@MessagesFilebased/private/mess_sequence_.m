@@ -0,0 +1,15 @@
+function seq = mess_sequence_(sentinel)
+% Return the sequence number of the messages sent to a lab, i.e. the size
+% of its sentinel file, or -1 if no message has been sent to the lab yet.
+%
+% The file is opened rather than listed, as opening it revalidates its
+% cached attributes on NFS.
+
+fh = fopen(sentinel,'r');
+if fh<0
+    seq = -1;
+    return;
+end
+fseek(fh,0,'eof');
+seq = ftell(fh);
+fclose(fh);
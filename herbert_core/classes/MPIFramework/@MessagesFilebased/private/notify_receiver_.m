@@ -0,0 +1,13 @@
+function notify_receiver_(obj,task_id)
+% Wake the lab task_id waiting for messages by appending a byte to its
+% sentinel file.
+%
+% The notification is a hint only: the receivers still list the messages,
+% so the message is not lost if the sentinel can not be written.
+
+fh = fopen(build_sentinel_fname_(obj,task_id),'a');
+if fh<0
+    return;
+end
+fwrite(fh,uint8(1));
+fclose(fh);
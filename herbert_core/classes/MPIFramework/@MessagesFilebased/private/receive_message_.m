@@ -20,6 +20,11 @@ end
 
 mess_present= false;
 t0 = tic;
+if is_blocking
+    % obtained before the messages are listed, so a message sent while they
+    % are listed wakes the wait below
+    seq = obj.messages_sequence();
+end
 while ~mess_present
     % may return failed or cancelled message
     mess_name_present = obj.probe_all(from_task_id,mess_name);
@@ -47,7 +52,7 @@ while ~mess_present
                 mess_name,obj.labIndex);
             
         else
-            pause(obj.time_to_react_);
+            seq = obj.wait_for_messages(seq,obj.time_to_fail_-t_passed);
             [is,~,err_mess] = check_job_cancelled_(obj); % only framework dead
             %  returns cancelled, cancelled message still can and should be received later.
             if is; error('MESSAGE_FRAMEWORK:cancelled',err_mess);
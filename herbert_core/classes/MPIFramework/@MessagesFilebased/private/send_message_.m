@@ -82,4 +82,6 @@ end
 wlock_obj = unlock_(wlock_file,mess_fname);
 if ~isempty(wlock_obj)
     ok = MESS_CODES.write_lock_persists;
-end
\ No newline at end of file
+end
+% wake the receiver, if it waits for messages
+notify_receiver_(obj,task_id);
\ No newline at end of file
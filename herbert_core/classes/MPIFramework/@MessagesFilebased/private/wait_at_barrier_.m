@@ -4,6 +4,7 @@ function [ok,err,all_present]=wait_at_barrier_(obj,nothrow)
 %
 if obj.labIndex == 1
     tasks = 2:obj.numLabs;
+    seq = obj.messages_sequence();
     [ok,err,~,task_present] = list_messages_wrapper(obj,tasks,nothrow);
     if ~ok; return; end
     
@@ -11,7 +12,7 @@ if obj.labIndex == 1
     t0 = tic;
     % wait unill all barrier messages from slaves would appear
     while ~all_present
-        pause(obj.time_to_react_);
+        seq = obj.wait_for_messages(seq,obj.time_to_fail-toc(t0));
         [ok,err,~,task_present] = list_messages_wrapper(obj,tasks,nothrow);
         if ~ok; return; end
         
@@ -48,12 +49,13 @@ else
     % send barrier message to master;
     obj.send_message(1,'barrier');
     % wait for master replying with barrier message
+    seq = obj.messages_sequence();
     [ok,err,reply_present] = list_messages_wrapper(obj,1,nothrow);
     if ~ok; return; end
     
     t0 = tic;
     while ~reply_present
-        pause(obj.time_to_react_);
+        seq = obj.wait_for_messages(seq,obj.time_to_fail-toc(t0));
         [ok,err,reply_present] = list_messages_wrapper(obj,1,nothrow);
         if ~ok; return; end
         
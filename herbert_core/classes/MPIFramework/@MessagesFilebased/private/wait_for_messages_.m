@@ -0,0 +1,50 @@
+function seq = wait_for_messages_(obj,seq,timeout)
+% Wait until a message is sent to this lab after the sequence seq of the
+% messages sent to it was obtained, or the timeout (sec) expires. Returns
+% the current sequence of the messages.
+%
+% The wait is never longer than notify_timeout_, so the receiver lists the
+% exchange folder regularly even if a notification has been missed.
+%
+% With use_mex, c_wait_for_change is woken by inotify on a local Linux
+% folder and polls the sentinel file on network file systems; otherwise
+% the sentinel is checked every time_to_react_ seconds.
+
+timeout = max(0,min(timeout,obj.notify_timeout_));
+sentinel = build_sentinel_fname_(obj,obj.labIndex);
+if obj.use_wait_mex_
+    use_mex = config_store.instance().get_value('herbert_config','use_mex');
+    if use_mex
+        try
+            seq = c_wait_for_change(sentinel,seq,timeout,obj.time_to_react_);
+            return;
+        catch ME
+            force_mex = config_store.instance().get_value('herbert_config','force_mex_if_use_mex');
+            if force_mex
+                error('HERBERT:MessagesFilebased:runtime_error',...
+                    ' Can not wait for messages using C++ routines \n Reason: %s',ME.message);
+            end
+            if config_store.instance().get_value('herbert_config','log_level')>-1
+                warning('HERBERT:MessagesFilebased:runtime_error',...
+                    ' Can not wait for messages using C++ routines -- reverted to polling in Matlab\n Reason: %s',...
+                    ME.message);
+            end
+            % do not try again and do not repeat the warning for every wait
+            obj.use_wait_mex_ = false;
+        end
+    end
+end
+
+t0 = tic;
+while true
+    new_seq = mess_sequence_(sentinel);
+    if new_seq ~= seq
+        seq = new_seq;
+        return;
+    end
+    t_left = timeout - toc(t0);
+    if t_left <= 0
+        return;
+    end
+    pause(min(obj.time_to_react_,t_left));
+end
@@ -783,6 +783,31 @@ classdef iMessagesFramework < handle
             [receive_now,message_names_array,n_steps] = check_whats_coming_(obj,task_ids,mess_name,mess_array,n_steps);
         end
 
+        function seq = messages_sequence(obj)
+            % Return the number, which changes when a message is sent to
+            % this lab. Obtained before the messages are probed and given
+            % to wait_for_messages, it allows the framework to wake the
+            % receiver, waiting for a message, as soon as one is sent.
+            %
+            % The frameworks, which are not notified about the messages
+            % sent, return 0.
+            seq = 0;
+        end
+
+        function seq = wait_for_messages(obj,seq,timeout)
+            % Wait until a message may have been sent to this lab after
+            % the sequence seq was returned by messages_sequence.
+            %
+            % timeout -- the longest time to wait (sec). The framework
+            %            may return earlier, so the caller has to probe
+            %            the messages again anyway.
+            % Returns the current sequence of the messages.
+            %
+            % The frameworks, which are not notified about the messages
+            % sent, wait for time_to_react_.
+            pause(obj.time_to_react_);
+        end
+
     end
 
 end
@@ -27,6 +27,11 @@ all_messages = cell(1,n_requested);
 mess_received = false(1,n_requested);
 tid_received_from = zeros(1,n_requested);
 
+if lock_until_received
+    % obtained before the messages are probed, so a message sent meanwhile
+    % wakes the wait for messages
+    seq = obj.messages_sequence();
+end
 [message_names,tid_from] = obj.probe_all(task_ids,mess_name);
 %
 present_now = ismember(task_ids,tid_from);
@@ -90,7 +95,12 @@ while ~all_received
                 error('MESSAGES_FRAMEWORK:runtime_error',...
                     'Issued request for missing blocking message in test mode');
             end
-            pause(obj.time_to_react_);
+            if any(present_now)
+                pause(obj.time_to_react_);
+            else
+                % nothing to receive: wait until messages are sent
+                seq = obj.wait_for_messages(seq,obj.time_to_fail_-t1);
+            end
         end
     else
         break;
@@ -33,6 +33,10 @@ classdef a_loader < a_detpar_loader_interface
         % the variable which describes the file from which main part or
         % all data should be loaded
         file_name
+        % if true, signal and error are loaded and kept in memory as
+        % single precision arrays, which halves the memory they occupy.
+        % Setting it to false converts loaded data back to double precision
+        single_precision
     end
     properties(Dependent,Hidden)
         % property exposing detpar loader and giving possibility to set it
@@ -60,6 +64,8 @@ classdef a_loader < a_detpar_loader_interface
         % the service property, whcih describes the validity of a_loader
         % object
         isvalid_ = true;
+        % keep signal and error in single precision
+        single_precision_ = false;
     end
     properties(Constant,Access=protected)
         fext_to_parloader_map_ = containers.Map({'.par','.phx','.nxspe'},...
@@ -321,6 +327,8 @@ classdef a_loader < a_detpar_loader_interface
             %              Existing file in write mode will be silently
             %              overwritten.
             %  readwrite mode is assumed by  default
+            % -compress -- compress the signal and error in the file with
+            %              the shuffle and deflate filters
             options = {'-reload'};
             % rw_mode is default, just for the future, it is not currently used
             [ok,mess,reload,remaining]=parse_char_options(varargin,options);
@@ -399,6 +407,28 @@ classdef a_loader < a_detpar_loader_interface
             obj = set_consistent_array(obj,'ERR_',value);
         end
         %
+        function is = get.single_precision(obj)
+            is = obj.single_precision_;
+        end
+        %
+        function obj = set.single_precision(obj,val)
+            % set the precision of the signal and error, converting the
+            % data already loaded in memory
+            if ~((islogical(val) || isnumeric(val)) && isscalar(val))
+                error('HERBERT:a_loader:invalid_argument',...
+                    'single_precision should be a logical scalar. Actually it is %s',...
+                    class(val))
+            end
+            obj.single_precision_ = logical(val);
+            if obj.single_precision_
+                obj.S_   = single(obj.S_);
+                obj.ERR_ = single(obj.ERR_);
+            else
+                obj.S_   = double(obj.S_);
+                obj.ERR_ = double(obj.ERR_);
+            end
+        end
+        %
         function en = get.en(obj)
             % get energy bins
             en = obj.en_;
@@ -600,6 +630,37 @@ classdef a_loader < a_detpar_loader_interface
         %------------------------------------------------------------------
     end
     methods(Static)
+        function loaders=save_nxspe_batch(loaders,filenames,efix,psi,varargin)
+            % save the data of many loaders into nxspe files at once
+            %
+            %>>loaders = a_loader.save_nxspe_batch(loaders,filenames,efix,psi,[options])
+            %
+            % loaders   -- cell array of loaders
+            % filenames -- cell array of the names of the files to write,
+            %              one per loader
+            % efix, psi -- arrays or cell arrays of incident energies and
+            %              rotation angles, one per loader
+            % options   -- the options of saveNXSPE
+            %
+            % If use_mex is set, the files are written by the put_nxspe mex
+            % in one call, which compresses the data of all files on all
+            % available threads.
+            %
+            % Returns the loaders with their data loaded in memory
+            [ok,mess,reload,remaining]=parse_char_options(varargin,{'-reload'});
+            if ~ok
+                error('HERBERT:a_loader:invalid_argument',mess);
+            end
+            for i=1:numel(loaders)
+                if reload
+                    loaders{i}=loaders{i}.load();
+                else
+                    loaders{i}=loaders{i}.load('-keep');
+                end
+            end
+            save_nxspe_internal(loaders,filenames,efix,psi,remaining{:});
+        end
+        %
         function [ndet,varargout]=get_par_info(par_file_name)
             % get number of detectors and other detrcotrs methadata defined by
             % par,phx nxspe or other supported file
@@ -1,13 +1,16 @@
-function save_nxspe_internal(this,filename,efix,psi,varargin)
-% internal function to save loader's data in nxspe format
+function save_nxspe_internal(loaders,filenames,efix,psi,varargin)
+% internal function to save loaders' data in nxspe format
 % inputs:
-% filename -- the name of the file to write data to. Should not exist
+% loaders  -- a loader or cell array of loaders with the data to save
+% filenames -- the name of the file or cell array of the names of the files
+%             to write data to, one per loader. Should not exist
 % efix     -- incident energy for direct or indirect instrument. Only
 %             direct is currently supported through NEXUS instrument as
-%             I've newer seen indirect nxspe (though it can work)
+%             I've newer seen indirect nxspe (though it can work).
+%             Array of energies, one per loader, for many loaders.
 % Optional variables:
-% psi      -- the rotation angle of crystal. will write NaN into file if
-%             this variable is absent
+% psi      -- the rotation angle of crystal (one per loader). will write
+%             NaN into file if this variable is absent
 %
 % file_access -- w, a options define readwrite or write access to the
 %                file. (see Matlab manual for details of these options)
@@ -17,6 +20,12 @@ function save_nxspe_internal(this,filename,efix,psi,varargin)
 %
 %                Existing file in write mode will be silently
 %                overwritten.
+% -compress   -- compress the signal and error with the shuffle and
+%                deflate filters
+%
+% The signal and error are stored in chunks of all energy bins of blocks of
+% detectors. If use_mex is set, all files are written by the put_nxspe mex,
+% which compresses the chunks of all files on all available threads.
 %
 % $Author: Alex Buts; 05/01/2014
 %
@@ -24,13 +33,11 @@ function save_nxspe_internal(this,filename,efix,psi,varargin)
 % $Revision:: 840 ($Date:: 2020-02-10 16:05:56 +0000 (Mon, 10 Feb 2020) $)
 %
 % file access options
-options={'w', 'a'};
-[ok,mess,write_access,ap]=parse_char_options(varargin,options);
+options={'w', 'a','-compress'};
+[ok,mess,write_access,ap,compress]=parse_char_options(varargin,options);
 if ~ok
     error('A_LOADER:invalid_argument',mess);
 end
-[filepath,fname]=fileparts(filename);
-filename = fullfile(filepath,[fname,'.nxspe']);
 
 readwrite_access = true;
 if ap
@@ -39,6 +46,75 @@ end
 if write_access
     readwrite_access =false;
 end
+if ~iscell(loaders)
+    loaders = {loaders};
+end
+if ~iscell(filenames)
+    filenames = {filenames};
+end
+n_files = numel(loaders);
+if numel(filenames) ~= n_files
+    error('A_LOADER:invalid_argument',...
+        'number of files to save (%d) differs from the number of runs (%d)',...
+        numel(filenames),n_files);
+end
+if ~exist('psi', 'var')
+    psi = [];
+end
+if ~exist('efix', 'var')
+    efix = [];
+end
+
+records = cell(1,n_files);
+for i=1:n_files
+    records{i} = nxspe_record(loaders{i},filenames{i},...
+        value_of_run(efix,i,n_files),value_of_run(psi,i,n_files),readwrite_access);
+end
+
+% write the files
+use_mex=config_store.instance().get_value('herbert_config','use_mex');
+if use_mex
+    keys = {};
+    if compress
+        keys = {'-shuffle','-deflate',1};
+    end
+    try
+        put_nxspe([records{:}],keys{:});
+    catch err
+        force_mex = get(herbert_config,'force_mex_if_use_mex');
+        if force_mex
+            error('A_LOADER:runtime_error',' Cannot write nxspe files using C++ routines \n Reason: %s',err.message);
+        end
+        if get(herbert_config,'log_level')>-1
+            warning('A_LOADER:runtime_error',' Cannot write nxspe files using C++ routines -- reverted to Matlab\n Reason: %s',err.message);
+        end
+        use_mex = false;
+    end
+end
+if ~use_mex
+    for i=1:n_files
+        write_nxspe_file(records{i},compress);
+    end
+end
+end
+
+%%-------------------------------------------------------------------------
+function val = value_of_run(vals,i,n_files)
+% the value of efix or psi for the run i
+if iscell(vals)
+    val = vals{i};
+elseif n_files > 1 && numel(vals) == n_files
+    val = vals(i);
+else
+    val = vals;
+end
+end
+%
+function rec = nxspe_record(this,filename,efix,psi,readwrite_access)
+% check the data of the loader and return the structure, describing the
+% nxspe file to write, in the form accepted by put_nxspe
+[filepath,fname]=fileparts(filename);
+filename = fullfile(filepath,[fname,'.nxspe']);
 
 % check inputs and set defaults.
 if is_file(filename)
@@ -60,7 +136,7 @@ if emode<0 || emode>2
     error('A_LOADER:invalid_argument',...
         'attempt to save with unsupported emode %d; emode has to be from 0 to 2',emode);
 end
-if ~exist('efix', 'var')
+if isempty(efix)
     try
         efix = this.efix;
     catch
@@ -76,13 +152,6 @@ if ~isnumeric(efix)
     error('A_LOADER:invalid_argument',...
         ' expecting efix to have digita value but it has %s: ',efix);
 end
-if ~exist('psi', 'var')
-    try
-        psi = this.psi;
-    catch
-        psi = NaN;
-    end
-end
 if isempty(psi) || ~isreal(psi)
     psi =NaN;
 end
@@ -102,10 +171,27 @@ if isempty(this.n_detectors) || ischar(this.n_detectors)
     error('A_LOADER:invalid_argument',...
         'data do not contain correct detector information or detectors are not consistent with signal and error arrays');
 end
+if isfield(this,'nxspe_version') && isempty(this.par_file_name)
+    version = this.nxspe_version;
+else
+    version = '1.2';
+end
+det = this.det_par;
+[polar_width,azim_width]=get_angular_width(det);
 
-%--------------------------------------------------------------------------
-
-
+rec = struct('file_name',filename,'root_folder',mfilename('class'),...
+    'S',double(this.S),'ERR',double(this.ERR),'en',double(this.en),...
+    'polar',double(det.phi),'azimuthal',double(det.azim),...
+    'distance',double(det.x2),'polar_width',double(polar_width),...
+    'azimuthal_width',double(azim_width),...
+    'efix',double(efix),'psi',double(psi),...
+    'nxspe_version',version,'program_version',herbert_version());
+end
+%
+function write_nxspe_file(rec,compress)
+% write the nxspe file, described by the structure rec, using Matlab hdf5
+% functions
+filename = rec.file_name;
 [v1,v2,v3]= H5.get_libversion();
 datem=[datestr(now,31),'+00:00'];
 datem(11)='T';
@@ -130,29 +216,21 @@ end
 write_attr_group(fid,file_attr);
 
 % nexus data
-group_name = mfilename('class');
-group_id = H5G.create(fid,group_name,1000);
+group_id = H5G.create(fid,rec.root_folder,1000);
 write_attr_group(group_id,struct('NX_class','NXentry'));
 %-------------------------------------------------------------------------
 % write nxspe dataset definition
-if isfield(this,'nxspe_version') && isempty(this.par_file_name)
-    version = this.nxspe_version;
-else
-    version = '1.2';
-end
-
-write_string_sign(group_id,'definition','NXSPE','version',version);
-hv = herbert_version();
-write_string_sign(group_id,'program_name','herbert','version',hv);
+write_string_sign(group_id,'definition','NXSPE','version',rec.nxspe_version);
+write_string_sign(group_id,'program_name','herbert','version',rec.program_version);
 %-------------------------------------------------------------------------
 % write nxspe info
-write_info(group_id,efix,psi);
+write_info(group_id,rec.efix,rec.psi);
 %-------------------------------------------------------------------------
 % write signal/error/det_inf  &etc
-write_data(this,group_id);
+write_data(rec,group_id,compress);
 %-------------------------------------------------------------------------
 % write other data, typical for NeXus class
-write_instrument(group_id,efix);
+write_instrument(group_id,rec.efix);
 write_sample(group_id);
 % close all and finish
 H5G.close(group_id);
@@ -205,7 +283,7 @@ H5G.close(group2_id);
 H5G.close(group_id);
 end
 %
-function write_data(this,fid)
+function write_data(rec,fid,compress)
 % write all nxspe data;
 
 group_id = H5G.create(fid,'data',100);
@@ -213,48 +291,70 @@ write_attr_group(group_id,struct('NX_class','NXdata'));
 double_id = H5T.copy('H5T_NATIVE_DOUBLE');
 
 
-ds_id = write_double_dataset(group_id,'energy',this.en,double_id);
+ds_id = write_double_dataset(group_id,'energy',rec.en,double_id);
 write_attr_group(ds_id,struct('units','meV'));
 H5D.close(ds_id);
-ds_id=write_double_dataset(group_id,'data',this.S,double_id);
+% signal and error are stored in chunks of all energy bins of a block of
+% detectors, as put_nxspe stores them
+dcpl = data_create_plist(size(rec.S),compress);
+ds_id=write_double_dataset(group_id,'data',rec.S,double_id,dcpl);
 H5D.close(ds_id);
-ds_id=write_double_dataset(group_id,'error',this.ERR,double_id);
+ds_id=write_double_dataset(group_id,'error',rec.ERR,double_id,dcpl);
 H5D.close(ds_id);
+H5P.close(dcpl);
 
 %-------------------------------------------------------------------------
-det = this.det_par;
-%
-ds_id=write_double_dataset(group_id,'polar',det.phi,double_id);
+ds_id=write_double_dataset(group_id,'polar',rec.polar,double_id);
 H5D.close(ds_id);
 
-ds_id=write_double_dataset(group_id,'azimuthal',det.azim,double_id);
+ds_id=write_double_dataset(group_id,'azimuthal',rec.azimuthal,double_id);
 H5D.close(ds_id);
 
-ds_id=write_double_dataset(group_id,'distance',det.x2,double_id);
+ds_id=write_double_dataset(group_id,'distance',rec.distance,double_id);
 H5D.close(ds_id);
 
-[polar_width,azim_width]=get_angular_width(det);
-ds_id=write_double_dataset(group_id,'azimuthal_width',azim_width,double_id);
+ds_id=write_double_dataset(group_id,'azimuthal_width',rec.azimuthal_width,double_id);
 H5D.close(ds_id);
-ds_id=write_double_dataset(group_id,'polar_width',polar_width,double_id);
+ds_id=write_double_dataset(group_id,'polar_width',rec.polar_width,double_id);
 H5D.close(ds_id);
 %
 H5T.close(double_id);
 H5G.close(group_id);
 end
 %
-function dset_id=write_double_dataset(group_id,ds_name,dataset,double_id)
+function dcpl = data_create_plist(dims,compress)
+% the dataset creation property list for the (ne,ndet) signal or error:
+% chunks of about 1MB, holding all energy bins of a block of detectors
+ne = dims(1);
+ndet = dims(2);
+chunk_det = max(1,min(ndet,floor(2^20/(8*ne))));
+dcpl = H5P.create('H5P_DATASET_CREATE');
+if ne == 1 || ndet == 1 % the dataset is written as one dimensional
+    H5P.set_chunk(dcpl,chunk_det*ne);
+else
+    H5P.set_chunk(dcpl,[chunk_det,ne]);
+end
+if compress
+    H5P.set_shuffle(dcpl);
+    H5P.set_deflate(dcpl,1);
+end
+end
+%
+function dset_id=write_double_dataset(group_id,ds_name,dataset,double_id,dcpl)
 
+if ~exist('dcpl', 'var')
+    dcpl = 'H5P_DEFAULT';
+end
 dims = size(dataset);
 h5_dims = fliplr(dims);
 h5_maxdims = h5_dims;
 nds = numel(dataset);
 if dims(1) == 1 || dims(2)==1
     space_id = H5S.create_simple(1,nds,nds);
-    dset_id = H5D.create(group_id,ds_name,double_id,space_id,'H5P_DEFAULT');
+    dset_id = H5D.create(group_id,ds_name,double_id,space_id,dcpl);
 else
     space_id = H5S.create_simple(2,h5_dims,h5_maxdims);
-    dset_id = H5D.create(group_id,ds_name,double_id,space_id,'H5P_DEFAULT');
+    dset_id = H5D.create(group_id,ds_name,double_id,space_id,dcpl);
 end
 H5D.write(dset_id,'H5ML_DEFAULT','H5S_ALL','H5S_ALL','H5P_DEFAULT',dataset);
 H5S.close(space_id);
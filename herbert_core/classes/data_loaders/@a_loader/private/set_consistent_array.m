@@ -15,6 +15,9 @@ if isempty(value)
     return
 end
 
+if obj.single_precision_ && ~strcmp(field_name,'en_')
+    value = single(value);
+end
 obj.(field_name) = value;
 %this.file_name_ = '';
 
@@ -46,8 +46,12 @@ filename=strtrim(filename);
 
 use_mex = get(herbert_config,'use_mex');
 if use_mex
+    cache_key = {};
+    if get(herbert_config,'use_ascii_cache')
+        cache_key = {'-cache'};
+    end
     try     %using C routine
-        par=get_ascii_file(filename,'par');
+        par=get_ascii_file(filename,'par',cache_key{:});
     catch   %using matlab routine
         force_mex = get(herbert_config,'force_mex_if_use_mex');
         if ~force_mex
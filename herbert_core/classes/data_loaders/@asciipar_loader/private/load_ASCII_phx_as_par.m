@@ -45,8 +45,12 @@ filename=strtrim(filename);
 
 use_mex = get(herbert_config,'use_mex');
 if use_mex
+    cache_key = {};
+    if get(herbert_config,'use_ascii_cache')
+        cache_key = {'-cache'};
+    end
     try     %using C routine
-        phx=get_ascii_file(filename,'phx');
+        phx=get_ascii_file(filename,'phx',cache_key{:});
         [ncol,ndata]=size(phx);
         phx=[phx(1,:);phx(3:6,:);1:ndata];
     catch   %using matlab routine
@@ -37,31 +37,49 @@ if ~isempty(obj.det_par_) &&(~force_reload)
     end
 end
 %
-switch lext
-    case '.par'
-        rez  =  load_ASCII_par(obj.par_file_name);
-        is_phx=false;
-    case '.phx'
-        rez  =  load_ASCII_phx(obj.par_file_name);
-        is_phx = true;
-    otherwise
+% the files shared by many runs are parsed once and taken from the
+% detector parameters cache afterwards
+cache = detpar_cache.instance();
+[cached,found] = cache.get_detpar(obj.par_file_name);
+if found && ~force_reload
+    rez    = cached.rez;
+    is_phx = cached.is_phx;
+    ndet   = size(rez,2);
+else
+    switch lext
+        case '.par'
+            rez  =  load_ASCII_par(obj.par_file_name);
+            is_phx=false;
+        case '.phx'
+            rez  =  load_ASCII_phx(obj.par_file_name);
+            is_phx = true;
+        otherwise
+            error('HERBERT:asciipar_loader:invalid_argument',...
+                'unknown file extension for file %s',obj.par_file_name);
+    end
+    %
+    %
+    size_par = size(rez);
+    ndet=size_par(2);
+    if get(herbert_config,'log_level')>0
+        disp(['ASCIIPAR_LOADER:load_ascii_par::loaded ' num2str(ndet) ' detector(s)']);
+    end
+    %
+    if size_par(1)==5
+        det_id = 1:ndet;
+        rez = [rez;det_id];
+    elseif(size_par(1)~=6)
         error('HERBERT:asciipar_loader:invalid_argument',...
-            'unknown file extension for file %s',obj.par_file_name);
-end
-%
-%
-size_par = size(rez);
-ndet=size_par(2);
-if get(herbert_config,'log_level')>0
-    disp(['ASCIIPAR_LOADER:load_ascii_par::loaded ' num2str(ndet) ' detector(s)']);
-end
-%
-if size_par(1)==5
-    det_id = 1:ndet;
-    rez = [rez;det_id];
-elseif(size_par(1)~=6)
-     error('HERBERT:asciipar_loader:invalid_argument',...
-        ' proper par file has to have 5 or 6 column but this one has %d',size_par(1));
+            ' proper par file has to have 5 or 6 column but this one has %d',size_par(1));
+    end
+    if is_phx
+        par = a_detpar_loader_interface.convert_phx2par(rez);
+    else
+        par = rez;
+    end
+    cached = struct('rez',rez,'is_phx',is_phx,...
+        'det',get_hor_format(par,obj.par_file_name));
+    cache.put_detpar(obj.par_file_name,cached);
 end
 %
 if return_array
@@ -80,12 +98,7 @@ if return_array
     end
     loader_defined=false;
 else
-    if is_phx
-        par = a_detpar_loader_interface.convert_phx2par(rez);
-    else
-        par = rez;
-    end
-    det =  get_hor_format(par,obj.par_file_name);
+    det = cached.det;
     obj.det_par_    = det;
     obj.n_det_in_par_ = ndet;
     loader_defined=true;
@@ -93,21 +106,7 @@ end
 
 % define loader in Horace format
 if nargout >1 && ~loader_defined
-    if isstruct(det)
-        det_i = det;
-    else
-        if is_phx
-            if getphx
-                par = a_detpar_loader_interface.convert_phx2par(rez);
-            else
-                par = det;
-            end            
-        else
-            par =rez;
-        end
-        det_i =  get_hor_format(par,obj.par_file_name);
-    end
-    obj.det_par_    = det_i;
+    obj.det_par_    = cached.det;
     obj.n_det_in_par_ = ndet;
     
 end
@@ -0,0 +1,82 @@
+function loaders = load_batch(loaders)
+% Load signal, error and energy bins of several ASCII spe files into their
+% loaders, reading the files concurrently.
+%
+%>> loaders = loader_ascii.load_batch(loaders)
+%
+% Input:
+% loaders -- cell array of loader_ascii objects with the spe file names
+%            defined.
+% Output:
+% loaders -- the same loaders with the data of their spe files loaded in
+%            memory, as the loaders would have after load_data.
+%
+% If herbert_config.use_mex is true, all files are parsed by a single call to
+% get_ascii_file, which processes them on its pool of threads. Otherwise, or if
+% the C++ code fails and force_mex_if_use_mex is false, the files are loaded
+% one by one.
+%
+% The signal and error of the loaders with single_precision set are returned
+% as single precision arrays.
+%
+if ~iscell(loaders)
+    loaders = num2cell(loaders);
+end
+n_files = numel(loaders);
+if n_files == 0
+    return;
+end
+file_names = cell(1,n_files);
+for i=1:n_files
+    if ~isa(loaders{i},'loader_ascii') || isempty(loaders{i}.file_name)
+        error('HERBERT:loader_ascii:invalid_argument',...
+            'input N%d is not a loader_ascii with a defined spe file',i)
+    end
+    file_names{i} = loaders{i}.file_name;
+end
+
+use_mex=config_store.instance().get_value('herbert_config','use_mex');
+if use_mex
+    cache_key = {};
+    if config_store.instance().get_value('herbert_config','use_ascii_cache')
+        cache_key = {'-cache'};
+    end
+    % the files are parsed by one call, so the C++ code converts the data
+    % only if all loaders request single precision
+    single_precision = cellfun(@(ldr)ldr.single_precision,loaders);
+    if all(single_precision)
+        cache_key = [cache_key,{'-single'}];
+    end
+    try
+        [S,ERR,en] = get_ascii_file(file_names,'spe',cache_key{:});
+    catch err
+        force_mex = get(herbert_config,'force_mex_if_use_mex');
+        if ~force_mex
+            if get(herbert_config,'log_level')>-1
+                warning('HERBERT:loader_ascii:runtime_error',' Cannot read data using C++ routines -- reverted to Matlab\n Reason: %s',err.message);
+            end
+            use_mex=false;
+        else
+            error('HERBERT:loader_ascii:runtime_error',' Cannot read data using C++ routines \n Reason: %s',err.message);
+        end
+    end
+end
+if ~use_mex
+    for i=1:n_files
+        loaders{i} = loaders{i}.load_data();
+    end
+    return;
+end
+
+accuracy = loader_ascii.ASCII_DATA_ACCURACY;
+for i=1:n_files
+    ldr = loaders{i};
+    if single_precision(i)
+        S{i}   = single(S{i});
+        ERR{i} = single(ERR{i});
+    end
+    [ldr.S_,ldr.ERR_,ldr.en_] = convert_spe_data_(S{i},ERR{i},en{i},accuracy);
+    S{i} = [];
+    ERR{i} = [];
+    loaders{i} = ldr;
+end
@@ -10,6 +10,9 @@ function [varargout]=load_data(obj,new_file_name)
 %>>[S,ERR,en]      = load_data(this,[new_file_name])
 %>>[S,ERR,en,this] = load_data(this,[new_file_name])
 %>>this            = load_data(this,[new_file_name])
+%
+% If obj.single_precision is true, signal and error are returned as single
+% precision arrays.
 
 %
 
@@ -30,8 +33,15 @@ file_name  = obj.file_name;
 
 use_mex=config_store.instance().get_value('herbert_config','use_mex');
 if use_mex
+    cache_key = {};
+    if config_store.instance().get_value('herbert_config','use_ascii_cache')
+        cache_key = {'-cache'};
+    end
+    if obj.single_precision
+        cache_key = [cache_key,{'-single'}];
+    end
     try
-        [S,ERR,en] = get_ascii_file(file_name ,'spe');
+        [S,ERR,en] = get_ascii_file(file_name ,'spe',cache_key{:});
     catch err
         force_mex = get(herbert_config,'force_mex_if_use_mex');
         if ~force_mex
@@ -47,37 +57,36 @@ if use_mex
 end
 if ~use_mex
     [S,ERR,en] = get_spe_(file_name);
+    if obj.single_precision
+        S   = single(S);
+        ERR = single(ERR);
+    end
 end
 
-% Convert symbolic NaN-s into ISO NaN-s
-nans      = (S(:,:)<-1.e+29);
-S(nans)   = NaN;
-ERR(nans) = 0;
-
-accuracy = obj.ASCII_DATA_ACCURACY;
+% Convert symbolic NaN-s into ISO NaN-s and round to the data accuracy
+[S,ERR,en] = convert_spe_data_(S,ERR,en,obj.ASCII_DATA_ACCURACY);
 % Fill output argument(s)
 if nargout == 1
     % set also all dependent on S variables
-    obj.S_  =round(S,accuracy );
-    obj.ERR_=round(ERR,accuracy );
-    obj.en_ =round(en,accuracy );
+    obj.S_  =S;
+    obj.ERR_=ERR;
+    obj.en_ =en;
 
     varargout{1}=obj;
 elseif nargout ==2
-    varargout{1}=round(S,accuracy );
-    varargout{2}=round(ERR,accuracy );
+    varargout{1}=S;
+    varargout{2}=ERR;
 elseif nargout == 3
-    varargout{1}=round(S,accuracy );
-    varargout{2}=round(ERR,accuracy );
-    varargout{3}=round(en,accuracy );
+    varargout{1}=S;
+    varargout{2}=ERR;
+    varargout{3}=en;
 elseif nargout == 4
-    obj.S_  =round(S,accuracy );
-    obj.ERR_=round(ERR,accuracy);
-    obj.en_ =round(en,accuracy);
+    obj.S_  =S;
+    obj.ERR_=ERR;
+    obj.en_ =en;
 
     varargout{1}=obj.S_ ;
     varargout{2}=obj.ERR_;
     varargout{3}=obj.en_;
     varargout{4}=obj;
 end
-
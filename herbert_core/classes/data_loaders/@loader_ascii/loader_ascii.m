@@ -11,6 +11,10 @@ classdef loader_ascii < a_loader
 
 
     methods(Static)
+        % Load the data of several spe files into their loaders, reading
+        % the files concurrently
+        loaders = load_batch(loaders);
+        %
         function fext=get_file_extension()
             % return the file extension used by this loader
             fext='.spe';
@@ -81,7 +85,20 @@ classdef loader_ascii < a_loader
             end
             %
             % get info about ascii spe file;
-            [ne,ndet,en]= get_spe_(full_file_name,'-info_only');
+            use_mex=config_store.instance().get_value('herbert_config','use_mex');
+            if use_mex
+                try % reads the header and the energy grid only
+                    info = get_ascii_file(full_file_name,'spe','-info');
+                    ne   = info.n_energies;
+                    ndet = info.n_detectors;
+                    en   = info.en;
+                catch
+                    use_mex = false;
+                end
+            end
+            if ~use_mex
+                [ne,ndet,en]= get_spe_(full_file_name,'-info_only');
+            end
             if numel(en) ~= ne+1
                 error('HERBERT:loader_ascii:invalid_argument',...
                     ' Ill formatted ascii spe file %s',file_name);
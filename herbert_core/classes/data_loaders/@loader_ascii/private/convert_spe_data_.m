@@ -0,0 +1,18 @@
+function [S,ERR,en] = convert_spe_data_(S,ERR,en,accuracy)
+% Convert the arrays, read from an ASCII spe file, into the form, used by
+% the loader.
+%
+%>> [S,ERR,en] = convert_spe_data_(S,ERR,en,accuracy)
+%
+% The symbolic NaN-s of the file (signal below -1e+29) are replaced by
+% ISO NaN-s with zero error and all arrays are rounded to the specified
+% number of digits after decimal point to obtain consistent results on
+% different operating systems.
+%
+nans      = (S(:,:)<-1.e+29);
+S(nans)   = NaN;
+ERR(nans) = 0;
+
+S   = round(S,accuracy);
+ERR = round(ERR,accuracy);
+en  = round(en,accuracy);
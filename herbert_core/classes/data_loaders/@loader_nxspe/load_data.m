@@ -12,7 +12,8 @@ function [varargout]=load_data(this,new_file_name)
 %>>[S,ERR,en,this] = load_data(this,[new_file_name])
 %>>this            = load_data(this,[new_file_name])
 %
-%
+% If this.single_precision is true, signal and error are returned as single
+% precision arrays, converted while they are read from the file.
 %
 
 if exist('new_file_name', 'var')
@@ -30,20 +31,48 @@ file_name  = this.file_name;
 root_folder= this.root_nexus_dir;
 
 data=cell(1,3);
+precision_key = {};
+if this.single_precision
+    precision_key = {'-single'};
+end
 
 %
-data{1}  = h5read(file_name,[root_folder,'/data/data']);
-data{2}  = h5read(file_name,[root_folder,'/data/error']);
-if isempty(this.en)
-    this.en_ =h5read(file_name,[root_folder,'/data/energy']);
+use_mex=config_store.instance().get_value('herbert_config','use_mex');
+if use_mex
+    try % C++ reader converts symbolic NaN-s while reading the data
+        [data{1},data{2},en] = get_nxspe(file_name,root_folder,precision_key{:});
+        if isempty(this.en)
+            this.en_ = en;
+        end
+    catch err
+        force_mex = get(herbert_config,'force_mex_if_use_mex');
+        if force_mex
+            error('HERBERT:loader_nxspe:runtime_error',' Cannot read data using C++ routines \n Reason: %s',err.message);
+        end
+        if get(herbert_config,'log_level')>-1
+            warning('HERBERT:loader_nxspe:runtime_error',' Cannot read data using C++ routines -- reverted to Matlab\n Reason: %s',err.message);
+        end
+        use_mex=false;
+    end
+end
+if ~use_mex
+    data{1}  = h5read(file_name,[root_folder,'/data/data']);
+    data{2}  = h5read(file_name,[root_folder,'/data/error']);
+    if this.single_precision % NXSPE data are usually float32 already
+        data{1} = single(data{1});
+        data{2} = single(data{2});
+    end
+    if isempty(this.en)
+        this.en_ =h5read(file_name,[root_folder,'/data/energy']);
+    end
+    % convert symbolic NaN-s (build according to ASCII agreement) to ISO
+    % NaN-s
+    S = data{1};
+    nans = (S(:,:)<-1.e+29);
+    data{1}(nans) = NaN;
+    data{2}(nans) = 0;
 end
 data{3} = this.en;
-% convert symbolic NaN-s (build according to ASCII agreement) to ISO
-% NaN-s
-S = data{1};
-nans = (S(:,:)<-1.e+29);
-data{1}(nans) = NaN;
-data{2}(nans) = 0;
 
 
 this.S_   = data{1};
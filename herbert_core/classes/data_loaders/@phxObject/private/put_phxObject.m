@@ -33,10 +33,12 @@ filepath=[path,filesep];
 try
     ndet=numel(data.group);
     arr=[10*ones(1,ndet);zeros(1,ndet);data.phi;data.azim;data.dphi;data.danght;data.group];    % note sign change of azimuthal angle
-    fid=fopen(file_tmp,'wt');
-    fprintf(fid,'%d \n',ndet);
-    fprintf(fid,'%5.3g %5.3g %10.4f %10.4f %10.4f %10.4f %8d \n',arr);
-    fclose(fid);
+    if ~write_with_mex(file_tmp,'phx',arr)
+        fid=fopen(file_tmp,'wt');
+        fprintf(fid,'%d \n',ndet);
+        fprintf(fid,'%5.3g %5.3g %10.4f %10.4f %10.4f %10.4f %8d \n',arr);
+        fclose(fid);
+    end
     disp(['Saved information for ' num2str(ndet) ' detectors to .phx file : ' file_tmp]);
 catch
     if exist('fid', 'var') && fid>0 && ~isempty(fopen(fid)) % close file, if open
@@ -47,3 +49,21 @@ catch
     filename='';
     filepath='';
 end
+
+%--------------------------------------------------------------------------
+function done=write_with_mex(file,type,arr)
+% Write the file by the C++ routine put_ascii_file if use_mex is set.
+% Returns false if the file has to be written by Matlab
+done=false;
+if ~get(herbert_config,'use_mex')
+    return
+end
+try
+    put_ascii_file(file,type,arr);
+    done=true;
+catch err
+    if get(herbert_config,'force_mex_if_use_mex')
+        rethrow(err);
+    end
+    warning('HERBERT:put_phxObject:runtime_error',' Cannot write .phx file using C++ routines -- reverted to Matlab\n Reason: %s',err.message);
+end
@@ -0,0 +1,121 @@
+function runs = load_runs(runs,varargin)
+% Load data of a list of runs in memory, reading the data files of several
+% runs concurrently and, if requested, delivering the loaded runs in order
+% to a consumer function.
+%
+%>> runs = rundata.load_runs(runs)
+%>> runs = rundata.load_runs(runs,consumer)
+%>> runs = rundata.load_runs(...,'-memory',max_bytes)
+%>> runs = rundata.load_runs(...,'-reload')
+%
+% Input:
+% runs      -- array or cell array (e.g. produced by gen_runfiles) of
+%              rundata objects with data files defined.
+% consumer  -- optional function handle, called as consumer(run,irun) for
+%              every run in the order of runs, as soon as the run is loaded.
+%              After the call, the signal and error of the run are removed
+%              from memory, so only the runs of one batch are in memory at
+%              any time.
+% '-memory',max_bytes
+%           -- the memory the signal and error arrays of the runs, loaded
+%              at once, may occupy. The runs are loaded in consecutive
+%              batches, each fitting this size or containing one run.
+%              Default: 1GB
+% '-reload' -- reload data from the files even if they are already in
+%              memory.
+%
+% Output:
+% runs      -- the input runs with their data loaded in memory or, if a
+%              consumer is provided, with their metadata and detectors only.
+%
+% The ASCII spe files of a batch are parsed concurrently by
+% loader_ascii.load_batch (the thread pool of get_ascii_file); the runs with
+% other loaders are loaded one by one.
+%
+keyval_def = struct('memory',2^30,'reload',false);
+opt = struct('prefix','-','keys_exact',true);
+[par,keyval,~,~,ok,mess] = parse_arguments(varargin,0,1,keyval_def,{'reload'},opt);
+if ~ok
+    error('HERBERT:rundata:invalid_argument',mess);
+end
+consumer = [];
+if ~isempty(par)
+    consumer = par{1};
+    if ~isa(consumer,'function_handle')
+        error('HERBERT:rundata:invalid_argument',...
+            'the consumer of the loaded runs has to be a function handle')
+    end
+end
+max_bytes = keyval.memory;
+if ~(isnumeric(max_bytes) && isscalar(max_bytes) && max_bytes>0)
+    error('HERBERT:rundata:invalid_argument',...
+        'the memory, available for loaded runs, has to be a positive number of bytes')
+end
+reload = logical(keyval.reload);
+
+is_cell = iscell(runs);
+n_runs = numel(runs);
+run_size = zeros(1,n_runs);
+for i=1:n_runs
+    run = get_run(runs,i,is_cell);
+    if isempty(run.loader_)
+        error('HERBERT:rundata:runtime_error',...
+            'attempt to load run N%d in memory when its data file is not defined',i)
+    end
+    run_size(i) = 16*run.loader_.n_detectors*max(numel(run.loader_.en)-1,0);
+end
+
+first = 1;
+while first <= n_runs
+    % the batch of runs fitting the memory limit
+    last = first;
+    batch_size = run_size(first);
+    while last < n_runs && batch_size+run_size(last+1) <= max_bytes
+        last = last+1;
+        batch_size = batch_size+run_size(last);
+    end
+    batch = first:last;
+    % read the ascii files of the batch together
+    is_ascii = false(1,numel(batch));
+    ldrs = cell(1,numel(batch));
+    for j=1:numel(batch)
+        run = get_run(runs,batch(j),is_cell);
+        is_ascii(j) = isa(run.loader_,'loader_ascii') && (reload || ~run.loader_.is_loaded());
+        ldrs{j} = run.loader_;
+    end
+    if sum(is_ascii) > 1
+        ldrs(is_ascii) = loader_ascii.load_batch(ldrs(is_ascii));
+    else
+        is_ascii(:) = false;
+    end
+    for j=1:numel(batch)
+        irun = batch(j);
+        run = get_run(runs,irun,is_cell);
+        if is_ascii(j)
+            run.loader_ = ldrs{j};
+            run = run.load_all_(false);
+        else
+            run = run.load_all_(reload);
+        end
+        if ~isempty(consumer)
+            consumer(run,irun);
+            run.loader_.S = []; % release signal and error
+        end
+        runs = set_run(runs,irun,run,is_cell);
+    end
+    first = last+1;
+end
+
+function run = get_run(runs,i,is_cell)
+if is_cell
+    run = runs{i};
+else
+    run = runs(i);
+end
+
+function runs = set_run(runs,i,run,is_cell)
+if is_cell
+    runs{i} = run;
+else
+    runs(i) = run;
+end
@@ -40,14 +40,43 @@ if ~(ignore_nan || ignore_inf)
     return
 end
 
-if ignore_nan && ignore_inf
-    index_masked = isnan(obj.S)| isinf(obj.S); % masked pixels
-elseif ignore_nan
-    index_masked = isnan(obj.S);
-elseif ignore_inf
-    index_masked = isinf(obj.S);
+det = obj.det_par;
+det_fields = fields(det);
+is_array = ~cellfun(@(fld)ischar(det.(fld)),det_fields);
+
+use_mex = config_store.instance().get_value('herbert_config','use_mex');
+if use_mex
+    % find the failed detectors and compact all arrays in one pass
+    array_fields = det_fields(is_array);
+    det_arrays = cellfun(@(fld)det.(fld),array_fields,'UniformOutput',false);
+    det_arrays_m = cell(size(det_arrays));
+    try
+        [S_m,Err_m,line_notmasked,det_arrays_m{:}] = c_rm_masked(obj.S,obj.ERR,...
+            ignore_nan,ignore_inf,det_arrays{:});
+    catch err
+        force_mex = get(herbert_config,'force_mex_if_use_mex');
+        if ~force_mex
+            if get(herbert_config,'log_level')>-1
+                warning('HERBERT:rm_masked:runtime_error',' Cannot mask detectors using C++ routines -- reverted to Matlab\n Reason: %s',err.message);
+            end
+            use_mex=false;
+        else
+            error('HERBERT:rm_masked:runtime_error',' Cannot mask detectors using C++ routines \n Reason: %s',err.message);
+        end
+    end
+end
+if ~use_mex
+    if ignore_nan && ignore_inf
+        index_masked = isnan(obj.S)| isinf(obj.S); % masked pixels
+    elseif ignore_nan
+        index_masked = isnan(obj.S);
+    elseif ignore_inf
+        index_masked = isinf(obj.S);
+    end
+    line_notmasked= ~any(index_masked,1);   % masked detectors (for any energy)
+    S_m  = obj.S(:,line_notmasked);
+    Err_m= obj.ERR(:,line_notmasked);
 end
-line_notmasked= ~any(index_masked,1);   % masked detectors (for any energy)
 
 if get(herbert_config,'log_level')> 1
     [ne,ndet]=size(obj.S);
@@ -61,16 +90,18 @@ if get(herbert_config,'log_level')> 1
     end
 end
 
-S_m  = obj.S(:,line_notmasked);
-Err_m= obj.ERR(:,line_notmasked);
-det = obj.det_par;
-det_fields = fields(det);
 det_m = struct();
+n_array = 0;
 for i=1:numel(det_fields)
     field = det_fields{i};
-    if ~ischar(det.(field))
-        array = det.(field);
-        det_m.(field) = array(line_notmasked);
+    if is_array(i)
+        if use_mex
+            n_array = n_array+1;
+            det_m.(field) = det_arrays_m{n_array};
+        else
+            array = det.(field);
+            det_m.(field) = array(line_notmasked);
+        end
     else
         det_m.(field) = det.(field);
     end
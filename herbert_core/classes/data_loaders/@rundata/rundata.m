@@ -24,6 +24,7 @@ classdef rundata < serializable
         S         ;     % Array of signal [ne x ndet]   -- obtained from speFile or equivalent
         ERR       ;     % Array of errors  [ne x ndet]  -- obtained from speFile or equivalent
         en        ;     % Column vector of energy bin boundaries   -- obtained from speFile or equivalent
+        single_precision; % if true, S and ERR are loaded and kept as single precision arrays
         %
         % Detector parameters:
         det_par   ;   % Horace structure of par-values, describing detectors angular positions   -- usually obtained from parFile or equivalent
@@ -135,6 +136,13 @@ classdef rundata < serializable
             %       provided, overrides the information contained in the the "spe" file.
             [runfiles_list,defined]= rundata.gen_runfiles_of_type('rundata',spe_files,varargin{:});
         end
+        % Load data of a list of runs in memory, reading the data files of
+        % several runs concurrently within the memory limit and delivering
+        % the loaded runs in order to an optional consumer
+        runs = load_runs(runs,varargin);
+        % Save a list of runs into nxspe files at once, compressing the data
+        % of all files in parallel when mex code is enabled
+        save_nxspe_runs(runs,filenames,varargin);
         %
         function [id,filename] = extract_id_from_filename(file_name)
             % Extract run id from a filename, if run-number is
@@ -427,6 +435,17 @@ classdef rundata < serializable
         function this = set.det_par(this,val)
             this=set_loader_field(this,'det_par',val);
         end
+        function is=get.single_precision(this)
+            is = get_loader_field_(this,'single_precision');
+            if isempty(is)
+                is = false;
+            end
+        end
+        function this = set.single_precision(this,val)
+            % set precision of the signal and error of the loader; the
+            % data already in memory are converted
+            this=set_loader_field(this,'single_precision',val);
+        end
         function en=get.en(this)
             en=get_loader_field_(this,'en');
         end
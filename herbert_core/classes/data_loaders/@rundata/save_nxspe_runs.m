@@ -0,0 +1,50 @@
+function save_nxspe_runs(runs,filenames,varargin)
+% Save a list of runs into nxspe files at once.
+%
+%>> rundata.save_nxspe_runs(runs,filenames)
+%>> rundata.save_nxspe_runs(runs,filenames,[options])
+%
+% Input:
+% runs      -- array or cell array (e.g. produced by gen_runfiles) of
+%              rundata objects with data defined in memory or in files.
+% filenames -- cell array of the names of the nxspe files to save the runs
+%              to, one per run.
+% options   -- the options of saveNXSPE: '-reload', 'w', 'a' and
+%              '-compress'.
+%
+% The data of the runs, which are not in memory, are loaded first. With
+% use_mex set, all files are written by one call to the put_nxspe mex,
+% which stores the signal and error in chunks of all energy bins of a block
+% of detectors and compresses (if requested) the chunks of all files on all
+% available threads. Otherwise the files are written one by one.
+%
+if ~iscell(filenames)
+    filenames = {filenames};
+end
+n_runs = numel(runs);
+if numel(filenames) ~= n_runs
+    error('HERBERT:rundata:invalid_argument',...
+        'number of file names (%d) differs from the number of runs (%d)',...
+        numel(filenames),n_runs);
+end
+is_cell = iscell(runs);
+ldrs = cell(1,n_runs);
+efix = cell(1,n_runs);
+psi  = nan(1,n_runs);
+for i=1:n_runs
+    if is_cell
+        run = runs{i};
+    else
+        run = runs(i);
+    end
+    if isempty(run.loader_)
+        error('HERBERT:rundata:invalid_argument',...
+            'run N%d has no data to save',i)
+    end
+    ldrs{i} = run.loader_;
+    efix{i} = run.efix;
+    if ~isempty(run.lattice)
+        psi(i) = run.lattice.psi;
+    end
+end
+a_loader.save_nxspe_batch(ldrs,filenames,efix,psi,varargin{:});
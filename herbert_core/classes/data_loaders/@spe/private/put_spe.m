@@ -41,17 +41,35 @@ data.S(abs(data.S)<small_data)=0;
 data.ERR(abs(data.ERR)<small_data)=0;
 
 % Write to file
-try     % matlab write
-    if get(herbert_config,'log_level')>-1	
-        disp(['Matlab writing of .spe file : ' file_tmp]);
+use_mex = get(herbert_config,'use_mex');
+if use_mex
+    try     % C++ write
+        put_ascii_file(file_tmp,'spe',data.S,data.ERR,data.en);
+    catch err
+        if get(herbert_config,'force_mex_if_use_mex')
+            ok=false;
+            mess=['Error writing spe data to ',file_tmp,'; Reason: ',err.message];
+            filename='';
+            filepath='';
+            return
+        end
+        warning('HERBERT:put_spe:runtime_error',' Cannot write data using C++ routines -- reverted to Matlab\n Reason: %s',err.message);
+        use_mex = false;
     end
-    [ok,mess] = write_spe_(data,file_tmp);
-    if ~ok
-        error(mess)
+end
+if ~use_mex
+    try     % matlab write
+        if get(herbert_config,'log_level')>-1
+            disp(['Matlab writing of .spe file : ' file_tmp]);
+        end
+        [ok,mess] = write_spe_(data,file_tmp);
+        if ~ok
+            error(mess)
+        end
+    catch
+        ok=false;
+        mess=['Error writing spe data to ',file_tmp]';
+        filename='';
+        filepath='';
     end
-catch
-    ok=false;
-    mess=['Error writing spe data to ',file_tmp]';
-    filename='';
-    filepath='';
 end
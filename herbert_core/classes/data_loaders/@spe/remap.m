@@ -40,32 +40,14 @@ end
 % ---------------
 ne=size(spe_data.S,1);
 ndet=size(spe_data.S,2);
-nw=numel(map.ns);
 if ndet<max(map.s)
     error('Number of detectors in spe data incompatible with maximum spectrum number in map')
 end
 
-% Initialise output signal and error arrays
-% -----------------------------------------
-S_out=zeros(ne,nw);
-ERR_out=zeros(ne,nw);
-
 % Accumulate data in output arrays
 % --------------------------------
-S=spe_data.S;
-ERRsqr=(spe_data.ERR).^2;
-s=map.s;
-nend=cumsum(map.ns);
-nbeg=nend-map.ns+1;
-w=zeros(1,numel(map.s));
-for i=1:nw
-    w(nbeg(i):nend(i))=i;
-end
-for i=1:numel(map.s)
-    S_out(:,w(i))=S_out(:,w(i))+S(:,s(i));
-    ERR_out(:,w(i))=ERR_out(:,w(i))+ERRsqr(:,s(i));
-end
-ERR_out=sqrt(ERR_out);
+S_out=group_spectra(map,spe_data.S);
+ERR_out=sqrt(group_spectra(map,(spe_data.ERR).^2));
 
 % Normalise by spectrum count if required
 if normalise
@@ -0,0 +1,175 @@
+classdef detpar_cache < handle
+    % The class keeps the detector parameters, loaded from ASCII par and
+    % phx files, to share them between all loaders using the same file.
+    %
+    % Many runs of an experiment usually refer to the same par or phx file.
+    % Instead of parsing the file for every run, the loaders take the
+    % detector arrays from this cache. As Matlab copies arrays only when they
+    % are modified, all loaders referring to the same file share the memory
+    % of the cached arrays.
+    %
+    % The cache entries are identified by the full name of the file and are
+    % valid while the size, the modification time and the first and last
+    % bytes of the file remain unchanged. The modification time, returned by
+    % dir, has one second resolution, so the ends of the file are kept to
+    % see a file rewritten within the same second. Small files are compared
+    % in full; an edit which keeps the size of a large file and falls between
+    % its ends within the same second is not noticed.
+    %
+    % The cache deduplicates parsing within a Matlab session only. A rundata
+    % object still carries its own det_par when it is serialised, e.g. to
+    % the workers of a parallel job, as the object has to be restored where
+    % the par file is not available or has changed since.
+    %
+    % Usage:
+    %>> cache = detpar_cache.instance();
+    %>> [entry,found] = cache.get_detpar(full_file_name);
+    %>> cache.put_detpar(full_file_name,entry);
+    %>> cache.clear_cache();
+    %
+    properties(Dependent)
+        % number of files, which detector parameters are currently cached
+        n_entries;
+        % maximal number of files to keep in the cache. When a new file is
+        % added to the full cache, the least recently used entry is removed
+        max_entries;
+    end
+    properties(Access=private)
+        % map of the full file names to cache entries
+        cache_;
+        % the full file names in the order of their use, the most recently
+        % used -- last
+        use_order_ = {};
+        max_entries_ = 32;
+    end
+    properties(Constant,Access=private)
+        % number of bytes at each end of the file, kept to check that the
+        % contents of the file have not changed
+        content_span_ = 16384;
+    end
+
+    methods(Access=private)
+        % Guard the constructor against external invocation.  We only want
+        % to allow a single instance of this class.  See description in
+        % Singleton superclass.
+        function newObj = detpar_cache()
+            newObj.cache_ = containers.Map('KeyType','char','ValueType','any');
+        end
+    end
+
+    methods(Static)
+        % Concrete implementation.  See Singleton superclass.
+        function obj = instance()
+            persistent uniqueDetpar_cache_Instance
+            if isempty(uniqueDetpar_cache_Instance) || ~isvalid(uniqueDetpar_cache_Instance)
+                obj = detpar_cache();
+                uniqueDetpar_cache_Instance = obj;
+            else
+                obj = uniqueDetpar_cache_Instance;
+            end
+        end
+    end
+
+    methods % Public Access
+        function [data,found] = get_detpar(obj,file_name)
+            % return the detector parameters, stored for the file
+            % file_name, if the file has not changed since they were stored.
+            %
+            % data  -- the data, provided to put_detpar for this file or
+            %          empty if the file is not in the cache
+            % found -- true if the data are found and valid
+            data = [];
+            found = false;
+            if ~isKey(obj.cache_,file_name)
+                return;
+            end
+            entry = obj.cache_(file_name);
+            finfo = dir(file_name);
+            if numel(finfo) ~= 1 || finfo.bytes ~= entry.bytes || finfo.datenum ~= entry.datenum || ...
+                    ~isequal(detpar_cache.file_ends_(file_name,finfo.bytes),entry.ends)
+                obj.remove_entry_(file_name);
+                return;
+            end
+            data = entry.data;
+            found = true;
+            obj.use_order_ = [obj.use_order_(~strcmp(obj.use_order_,file_name)),{file_name}];
+        end
+        %
+        function put_detpar(obj,file_name,data)
+            % store the detector parameters, loaded from the file file_name
+            % in the cache
+            finfo = dir(file_name);
+            if numel(finfo) ~= 1 || obj.max_entries_ == 0
+                return;
+            end
+            [ends,ok] = detpar_cache.file_ends_(file_name,finfo.bytes);
+            if ~ok
+                return;
+            end
+            if isKey(obj.cache_,file_name)
+                obj.remove_entry_(file_name);
+            end
+            while numel(obj.use_order_) >= obj.max_entries_
+                obj.remove_entry_(obj.use_order_{1});
+            end
+            obj.cache_(file_name) = struct('bytes',finfo.bytes,...
+                'datenum',finfo.datenum,'ends',ends,'data',data);
+            obj.use_order_{end+1} = file_name;
+        end
+        %
+        function clear_cache(obj)
+            % remove all detector parameters from the cache
+            obj.cache_ = containers.Map('KeyType','char','ValueType','any');
+            obj.use_order_ = {};
+        end
+        %
+        function n = get.n_entries(obj)
+            n = obj.cache_.Count;
+        end
+        %
+        function n = get.max_entries(obj)
+            n = obj.max_entries_;
+        end
+        %
+        function set.max_entries(obj,val)
+            if ~(isnumeric(val) && isscalar(val) && val >= 0 && round(val) == val)
+                error('HERBERT:detpar_cache:invalid_argument',...
+                    'maximal number of cached files has to be a non-negative integer')
+            end
+            obj.max_entries_ = val;
+            while numel(obj.use_order_) > val
+                obj.remove_entry_(obj.use_order_{1});
+            end
+        end
+    end
+
+    methods(Access=private)
+        function remove_entry_(obj,file_name)
+            remove(obj.cache_,file_name);
+            obj.use_order_ = obj.use_order_(~strcmp(obj.use_order_,file_name));
+        end
+    end
+    methods(Static,Access=private)
+        function [ends,ok] = file_ends_(file_name,n_bytes)
+            % the first and the last content_span_ bytes of the file of
+            % n_bytes size, as uint8 row (the whole file if it is smaller
+            % than two spans). ok is false if the file can not be read.
+            ends = zeros(1,0,'uint8');
+            fh = fopen(file_name,'rb');
+            ok = fh >= 0;
+            if ~ok
+                return;
+            end
+            clob = onCleanup(@()fclose(fh));
+            span = detpar_cache.content_span_;
+            if n_bytes <= 2*span
+                ends = fread(fh,[1,n_bytes],'*uint8');
+            else
+                head = fread(fh,[1,span],'*uint8');
+                fseek(fh,-span,'eof');
+                ends = [head,fread(fh,[1,span],'*uint8')];
+            end
+            ok = numel(ends) == min(n_bytes,2*span);
+        end
+    end
+end
@@ -122,10 +122,8 @@ else
     end
 end
 %
-if save_nxspe
-    for i=1:n_files
-        runfiles{i}.saveNXSPE(nxspe_file{i});
-    end
+if save_nxspe % all files are written together
+    rundata.save_nxspe_runs(runfiles,nxspe_file);
 end
 %
 if nargout == 0
@@ -0,0 +1,187 @@
+classdef rundata_iterator < handle
+    % The class walks through a list of runs, loading the data of each run
+    % in memory when it is requested, while the data files of the following
+    % runs are parsed in the background.
+    %
+    % The ASCII spe files of the next prefetch_depth runs are given to the
+    % prefetch store of the get_ascii_file mex, which parses them in a
+    % background thread while the caller processes the current run. The
+    % store never holds more than memory_cap bytes of parsed data; a file,
+    % which does not fit, is read when its run is requested, as are the
+    % files of the runs with other loaders (nxspe files are read by the
+    % HDF library, which can not be used from a background thread).
+    % Without mex code the runs are loaded one by one when requested.
+    %
+    % Usage:
+    %>> iter = rundata_iterator(runs);
+    %>> iter = rundata_iterator(runs,'-depth',2,'-memory',max_bytes);
+    %>> while iter.has_next()
+    %>>     [run,irun] = iter.next();
+    %>>     ... process the run
+    %>> end
+    %
+    % runs  -- array or cell array (e.g. produced by gen_runfiles) of
+    %          rundata objects with data files defined.
+    % '-depth',n
+    %       -- number of runs following the current one to parse in the
+    %          background. Default: 1
+    % '-memory',max_bytes
+    %       -- the memory the parsed data of the following runs may occupy.
+    %          Default: 1GB
+    %
+    properties(Dependent)
+        % number of runs to iterate over
+        n_runs;
+        % number of the run, returned by the last call to next (0 before
+        % the first call)
+        current;
+        % number of runs following the current one, parsed in the background
+        prefetch_depth;
+        % the memory, the data parsed in the background may occupy
+        memory_cap;
+    end
+    properties(Access=private)
+        runs_ = {};
+        current_ = 0;
+        depth_ = 1;
+        max_bytes_ = 2^30;
+        % the last run given to the prefetch store
+        queued_ = 0;
+        use_prefetch_ = false;
+    end
+
+    methods
+        function obj = rundata_iterator(runs,varargin)
+            keyval_def = struct('depth',1,'memory',2^30);
+            opt = struct('prefix','-','keys_exact',true);
+            [~,keyval,~,~,ok,mess] = parse_arguments(varargin,0,0,keyval_def,{},opt);
+            if ~ok
+                error('HERBERT:rundata_iterator:invalid_argument',mess);
+            end
+            depth = keyval.depth;
+            if ~(isnumeric(depth) && isscalar(depth) && depth >= 0 && round(depth) == depth)
+                error('HERBERT:rundata_iterator:invalid_argument',...
+                    'prefetch depth has to be a non-negative integer')
+            end
+            max_bytes = keyval.memory;
+            if ~(isnumeric(max_bytes) && isscalar(max_bytes) && max_bytes > 0)
+                error('HERBERT:rundata_iterator:invalid_argument',...
+                    'the memory, available for prefetched runs, has to be a positive number of bytes')
+            end
+            if ~iscell(runs)
+                if ~isa(runs,'rundata')
+                    error('HERBERT:rundata_iterator:invalid_argument',...
+                        'runs have to be an array or a cell array of rundata objects')
+                end
+                runs = num2cell(runs);
+            end
+            for i=1:numel(runs)
+                if ~isa(runs{i},'rundata')
+                    error('HERBERT:rundata_iterator:invalid_argument',...
+                        'run N%d is not a rundata object but %s',i,class(runs{i}))
+                end
+                if isempty(runs{i}.loader)
+                    error('HERBERT:rundata_iterator:invalid_argument',...
+                        'the data file of run N%d is not defined',i)
+                end
+            end
+            obj.runs_ = reshape(runs,1,numel(runs));
+            obj.depth_ = depth;
+            obj.max_bytes_ = max_bytes;
+            obj.use_prefetch_ = depth > 0 && ...
+                config_store.instance().get_value('herbert_config','use_mex');
+        end
+        %
+        function is = has_next(obj)
+            % true if there are runs, which have not been returned by next
+            is = obj.current_ < numel(obj.runs_);
+        end
+        %
+        function [run,irun] = next(obj)
+            % return the next run with its data loaded in memory and its
+            % number in the list of runs
+            if ~obj.has_next()
+                error('HERBERT:rundata_iterator:runtime_error',...
+                    'all %d runs have been already returned',numel(obj.runs_))
+            end
+            obj.current_ = obj.current_+1;
+            irun = obj.current_;
+            obj.prefetch_(irun);
+            run = obj.runs_{irun};
+            obj.runs_{irun} = []; % the caller holds the run from now on
+            run = run.load();
+        end
+        %
+        function reset(obj,runs)
+            % start the iteration again, from the first of the runs given
+            % or, if no runs are given, of the runs not returned yet
+            obj.clear_prefetch_();
+            if nargin > 1
+                obj.runs_ = rundata_iterator(runs).runs_;
+            else
+                obj.runs_ = obj.runs_(obj.current_+1:end);
+            end
+            obj.current_ = 0;
+        end
+        %
+        function delete(obj)
+            obj.clear_prefetch_();
+        end
+        %
+        function n = get.n_runs(obj)
+            n = numel(obj.runs_);
+        end
+        function n = get.current(obj)
+            n = obj.current_;
+        end
+        function n = get.prefetch_depth(obj)
+            n = obj.depth_;
+        end
+        function n = get.memory_cap(obj)
+            n = obj.max_bytes_;
+        end
+    end
+
+    methods(Access=private)
+        function prefetch_(obj,irun)
+            % give the spe files of the runs following the run irun to the
+            % background parser
+            if ~obj.use_prefetch_
+                return;
+            end
+            last = min(irun+obj.depth_,numel(obj.runs_));
+            files = {};
+            for i=max(irun,obj.queued_)+1:last
+                ldr = obj.runs_{i}.loader;
+                if isa(ldr,'loader_ascii') && ~ldr.is_loaded()
+                    files{end+1} = ldr.file_name;
+                end
+            end
+            obj.queued_ = max(obj.queued_,last);
+            if isempty(files)
+                return;
+            end
+            try
+                get_ascii_file(files,'spe','-prefetch',obj.max_bytes_);
+            catch err
+                if get(herbert_config,'log_level')>-1
+                    warning('HERBERT:rundata_iterator:runtime_error',...
+                        ' Cannot parse the next runs in background -- loading them on request\n Reason: %s',...
+                        err.message);
+                end
+                obj.use_prefetch_ = false;
+            end
+        end
+        %
+        function clear_prefetch_(obj)
+            % drop the files parsed in the background and not requested
+            if obj.queued_ > obj.current_ && obj.use_prefetch_
+                try
+                    get_ascii_file({},'spe','-prefetch',0);
+                catch
+                end
+            end
+            obj.queued_ = 0;
+        end
+    end
+end
@@ -0,0 +1,33 @@
+function sig_out=group_spectra(map,sig)
+% Add together the data of the spectra in each workspace of a map
+%
+%   >> sig_out=group_spectra(map,sig)
+%
+% Input:
+% ------
+%   map     Mapping (IX_map object)
+%   sig     Array size (n,nspec), where column i contains the data for spectrum i.
+%          nspec must be at least as large as the largest spectrum number in the map
+%
+% Output:
+% -------
+%   sig_out Array size (n,nw), where column i is the sum of the columns of sig
+%          of the spectra in workspace i (zeros for a workspace without spectra)
+%
+% All spectra are added in a single sparse matrix product, so the time is
+% proportional to the size of the data. Sparse matrices are double only, so
+% other data (e.g. single precision signal) is added in double precision and
+% returned in its own class.
+
+nw=numel(map.ns);
+nsp=numel(map.s);
+if nsp>0 && size(sig,2)<max(map.s)
+    error('Number of spectra in the data is smaller than the maximum spectrum number in map')
+end
+iw=workspace_index(map.ns);
+grouping=sparse(1:nsp,iw,1,nsp,nw);
+if isa(sig,'double')
+    sig_out=full(sig(:,map.s)*grouping);
+else
+    sig_out=cast(full(double(sig(:,map.s))*grouping),class(sig));
+end
@@ -38,12 +38,9 @@ end
 
 % Remove masked spectra
 map_out=map;
-keep=~ismember(map.s,mask.msk);
+keep=~ismasked(mask,map.s);
 nw=numel(map.ns);
-ns_out=zeros(1,nw);
-ok=mat2cell(keep,1,map.ns);
-for i=1:nw
-    ns_out(i)=sum(ok{i});
-end
-map_out.ns=ns_out;
+iw=workspace_index(map.ns);
+nmasked=accumarray(iw(~keep)',1,[nw,1])';
+map_out.ns=map.ns-nmasked;
 map_out.s=map_out.s(keep);
@@ -67,7 +67,7 @@ if isequal(fieldnames(w),fields)
             message='The number of spectra in each workspace and the length of the list of spectrum indicies are inconsistent';
             return
         end
-        if numel(wout.s)~=numel(unique(wout.s))
+        if any(diff(sort(wout.s))==0)
             message='A spectrum in a spectrum-to-workspace map can only appear once';
             return
         end
@@ -95,16 +95,12 @@ if isequal(fieldnames(w),fields)
         wout.wkno=zeros(1,0);
     end
     
-    % Sort spectra
-    do_sort=find(wout.ns>1);    % those spectra that need sorting
-    if any(do_sort)
-        nend=cumsum(wout.ns);
-        nbeg=nend-wout.ns+1;
-        s=wout.s;
-        for i=do_sort
-            s(nbeg(i):nend(i))=sort(s(nbeg(i):nend(i)));
-        end
-        wout.s=s;
+    % Sort spectra within each workspace (all workspaces at once, by
+    % sorting on workspace index and then spectrum number)
+    if any(wout.ns>1)
+        iw=workspace_index(wout.ns);
+        [dummy,ind]=sortrows([iw',wout.s(:)]);
+        wout.s=wout.s(ind');
     end
     
 else
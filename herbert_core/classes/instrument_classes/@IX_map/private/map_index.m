@@ -0,0 +1,40 @@
+function ind=map_index(map)
+% Compressed index of the spectra of a map, for fast spectrum to workspace lookup
+%
+%   >> ind=map_index(map)
+%
+% Input:
+% ------
+%   map     IX_map object
+%
+% Output:
+% -------
+%   ind     Structure with fields:
+%           s       Row vector of the spectrum numbers of the map sorted into
+%                  numerically increasing order
+%           iw      Workspace index (1 to nw) of each spectrum in s
+%           pos     Position of each spectrum of s in the spectrum array of the map
+%                  i.e. ind.s==map.s(ind.pos)
+%           run_lo  Run-length encoding of ind.s: first and last spectrum of
+%           run_hi  each run of consecutive spectrum numbers belonging to the same
+%           run_iw  workspace, and the index of the workspace. Usually there are
+%                  only a few runs for each workspace, so a spectrum is found
+%                  in O(log(number of runs))
+
+iw_all=workspace_index(map.ns);
+[ind.s,ind.pos]=sort(map.s);
+ind.iw=iw_all(ind.pos);
+
+n=numel(ind.s);
+if n==0
+    ind.run_lo=zeros(1,0);
+    ind.run_hi=zeros(1,0);
+    ind.run_iw=zeros(1,0);
+    return
+end
+brk=find(diff(ind.s)~=1 | diff(ind.iw)~=0);
+run_beg=[1,brk+1];
+run_end=[brk,n];
+ind.run_lo=ind.s(run_beg);
+ind.run_hi=ind.s(run_end);
+ind.run_iw=ind.iw(run_beg);
@@ -0,0 +1,23 @@
+function iw=workspace_index(ns)
+% Workspace index of each element of the concatenated spectrum array of a map
+%
+%   >> iw=workspace_index(ns)
+%
+% Input:
+% ------
+%   ns      Row vector of number of spectra in each workspace
+%
+% Output:
+% -------
+%   iw      Row vector with the same number of elements as the spectrum
+%          array s of the map; iw(i) is the index (in the range 1 to nw) of
+%          the workspace which contains s(i)
+
+iw=zeros(1,sum(ns));
+filled=find(ns>0);
+if isempty(filled)
+    return
+end
+nbeg=cumsum(ns)-ns+1;
+iw(nbeg(filled))=diff([0,filled]);  % increment of workspace index where each workspace starts
+iw=cumsum(iw);
@@ -21,23 +21,17 @@ function map_out=section(map,index)
 ns=map.ns;
 nw=numel(ns);
 if numel(index)>0 && min(index)>=1 && max(index)<=nw && numel(unique(index))==numel(index)
-    % Get indices into spectrum array that are to be retained
-    nend=cumsum(ns);
-    nbeg=nend-ns+1;
-    nend=nend(index);
-    nbeg=nbeg(index);
-    s=map.s;
-    % Get corresponding indicies into output spectrum array
+    % Get indices into spectrum array that are to be retained: the output
+    % spectrum k of output workspace j is the spectrum nbeg(index(j))+k-1
+    index=index(:)';
+    nbeg=cumsum(ns)-ns+1;
     ns_out=ns(index);
-    nend_out=cumsum(ns_out);
-    nbeg_out=nend_out-ns_out+1;
-    s_out=zeros(1,sum(ns_out));
-    for i=1:numel(nbeg)
-        s_out(nbeg_out(i):nend_out(i))=s(nbeg(i):nend(i));
-    end
+    iw_out=workspace_index(ns_out);
+    nbeg_out=cumsum(ns_out)-ns_out+1;
+    ind=(1:sum(ns_out))-nbeg_out(iw_out)+nbeg(index(iw_out));
     % Make output map
     map_out.ns=ns_out;
-    map_out.s=s_out;
+    map_out.s=map.s(ind);
     if ~isempty(map.wkno)
         map_out.wkno=map.wkno(index);
     else
@@ -0,0 +1,40 @@
+function [iw,wkno]=spec_to_workspace(map,isp)
+% Find the workspaces which contain the given spectra
+%
+%   >> [iw,wkno]=spec_to_workspace(map,isp)
+%
+% Input:
+% ------
+%   map     Mapping (IX_map object)
+%   isp     Array of spectrum numbers
+%
+% Output:
+% -------
+%   iw      Array with the size of isp, containing the index (in the range 1
+%          to nw) of the workspace which contains each spectrum, or zero if the
+%          spectrum is not in the map
+%   wkno    Workspace numbers of these workspaces (zero if the spectrum is not
+%          in the map). If the workspace numbers of the map are undefined, then
+%          wkno is equal to iw
+%
+% The spectra are found in the run-length encoded index of the map, so the
+% time is O(numel(isp)*log(number of runs of consecutive spectra)).
+
+if ~isnumeric(isp)
+    error('Spectrum numbers must be numeric')
+end
+ind=map_index(map);
+iw=zeros(size(isp));
+if ~isempty(ind.run_lo) && ~isempty(isp)
+    isp_row=isp(:)';
+    [dummy,irun]=histc(isp_row,[ind.run_lo,Inf]);   % run with run_lo(irun)<=isp<run_lo(irun+1)
+    found=find(irun>0);
+    found=found(isp_row(found)<=ind.run_hi(irun(found)) & rem(isp_row(found),1)==0);
+    iw(found)=ind.run_iw(irun(found));
+end
+if nargout>1
+    wkno=iw;
+    if ~isempty(map.wkno)
+        wkno(iw>0)=map.wkno(iw(iw>0));
+    end
+end
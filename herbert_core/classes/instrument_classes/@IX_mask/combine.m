@@ -15,18 +15,34 @@ function mask_out = combine(varargin)
 %   mask_out    Combined mask object, with duplicate masked elemets removed
 
 classname='IX_mask';
-c=cell(1,numel(varargin));
-for i=1:numel(c)
+
+% The masks are combined as lists of ranges of consecutive spectra, which
+% are usually much shorter than the lists of the spectra themselves
+lo=cell(1,numel(varargin));
+hi=cell(1,numel(varargin));
+for i=1:numel(lo)
     if isa(varargin{i},classname)
-        c{i}=varargin{i}.msk;
+        [lo{i},hi{i}]=mask_ranges(varargin{i}.msk);
     else
         try
             tmp=IX_mask(varargin{i});
-            c{i}=tmp.msk;
+            [lo{i},hi{i}]=mask_ranges(tmp.msk);
         catch
             error('Check all input arguments form a valid mask object if passed to IX_mask')
         end
     end
 end
+lo=cell2mat(lo);
+hi=cell2mat(hi);
 
-mask_out=IX_mask(cell2mat(c));
+% Merge overlapping or adjacent ranges
+if ~isempty(lo)
+    [lo,ix]=sort(lo);
+    hi=cummax(hi(ix));
+    start=[true,lo(2:end)>hi(1:end-1)+1];
+    last=[find(start(2:end)),numel(lo)];
+    msk=ranges_to_array(lo(start),hi(last));
+else
+    msk=zeros(1,0);
+end
+mask_out=IX_mask(struct('msk',msk));
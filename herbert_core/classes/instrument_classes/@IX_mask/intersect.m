@@ -0,0 +1,36 @@
+function mask_out = intersect(varargin)
+% Form the mask of the spectra masked in all of the input masks
+%
+%   >> mask_out = intersect(mask1, mask2,...)
+%
+% Input:
+% ------
+%   mask1       Mask object, name of .msk file, or array (see >> help IX_mask for details)
+%   mask2           :
+%     :             :
+%
+% Output:
+% -------
+%   mask_out    Mask object, containing the spectra common to all the masks
+
+classname='IX_mask';
+if nargin==0
+    error('At least one mask must be given')
+end
+for i=1:numel(varargin)
+    if isa(varargin{i},classname)
+        mask=varargin{i};
+    else
+        try
+            mask=IX_mask(varargin{i});
+        catch
+            error('Check all input arguments form a valid mask object if passed to IX_mask')
+        end
+    end
+    if i==1
+        msk=mask.msk;
+    else
+        msk=msk(ismasked(mask,msk));
+    end
+end
+mask_out=IX_mask(struct('msk',msk));
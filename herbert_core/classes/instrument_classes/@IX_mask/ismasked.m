@@ -0,0 +1,39 @@
+function tf=ismasked(mask,isp)
+% Determine which spectra are masked
+%
+%   >> tf=ismasked(mask,isp)
+%
+% Input:
+% ------
+%   mask    Mask (IX_mask object)
+%   isp     Array of spectrum numbers
+%
+% Output:
+% -------
+%   tf      Logical array with the size of isp, true where the spectrum is
+%          in the mask. For example, the spectra of data arrays S(ne,ndet)
+%          which are not masked are S(:,~ismasked(mask,1:ndet))
+%
+% The spectra are looked up in a bitset of the mask, or in the list of ranges
+% of consecutive masked spectra if the spectrum numbers are very large, so the
+% time is O(numel(isp)) or O(numel(isp)*log(number of ranges)) respectively.
+
+max_bitset=1e7;     % largest spectrum number for the bitset lookup
+
+tf=false(size(isp));
+if isempty(mask.msk) || isempty(isp)
+    return
+end
+smax=mask.msk(end);
+valid=find(isp>=1 & isp<=smax & rem(isp,1)==0);
+if smax<=max_bitset
+    bits=false(1,smax);
+    bits(mask.msk)=true;
+    tf(valid)=bits(isp(valid));
+else
+    [lo,hi]=mask_ranges(mask.msk);
+    [dummy,irange]=histc(reshape(isp(valid),1,[]),[lo,Inf]);  % range with lo(irange)<=isp<lo(irange+1)
+    in_range=irange>0;
+    in_range(in_range)=isp(valid(in_range))<=hi(irange(in_range));
+    tf(valid(in_range))=true;
+end
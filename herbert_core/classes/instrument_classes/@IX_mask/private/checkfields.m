@@ -38,7 +38,7 @@ if isequal(fieldnames(w),fields)
         if ~isnumeric(wout.msk) || any(rem(wout.msk,1)~=0) || (numel(wout.msk)>0 && min(wout.msk)<1)    % must allow for wout.s being empty
             message='The spectrum indicies must all be integers greater than or equal to one';
             return
-        else
+        elseif ~all(diff(wout.msk)>0)   % already sorted lists need not be sorted again
             wout.msk=unique(wout.msk);
         end
     else
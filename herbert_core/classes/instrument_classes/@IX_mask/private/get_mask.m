@@ -34,7 +34,26 @@ if ~ok
     return
 end
 
-% Read file (use matlab, as files are generally small, so C++ code not really necessary)
+% Read file with C++ code if enabled; large files (e.g. with tens of thousands
+% of spectra) are parsed much faster than by the Matlab code below
+use_mex = get(herbert_config,'use_mex');
+if use_mex
+    cache_key = {};
+    if get(herbert_config,'use_ascii_cache')
+        cache_key = {'-cache'};
+    end
+    try
+        w.msk = get_ascii_file(file_tmp,'msk',cache_key{:});
+        return
+    catch ME
+        if get(herbert_config,'force_mex_if_use_mex')
+            w=[]; ok=false; mess=['Cannot read mask file using C++ routines. Reason: ',ME.message]; return
+        end
+        % otherwise read the file with Matlab, which also reports format errors
+    end
+end
+
+% Read file
 str=strtrim(textcell(file_tmp));
 nline=numel(str);
 if nline==0
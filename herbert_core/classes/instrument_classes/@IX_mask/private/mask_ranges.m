@@ -0,0 +1,23 @@
+function [lo,hi]=mask_ranges(msk)
+% Run-length encoding of a mask list into ranges of consecutive spectra
+%
+%   >> [lo,hi]=mask_ranges(msk)
+%
+% Input:
+% ------
+%   msk     Row vector of spectrum numbers, sorted into increasing order
+%          with duplicates removed (as in an IX_mask object)
+%
+% Output:
+% -------
+%   lo      Row vectors with the first and last spectrum of each range of
+%   hi     consecutive spectra, so msk==[lo(1):hi(1),lo(2):hi(2),...]
+
+if isempty(msk)
+    lo=zeros(1,0);
+    hi=zeros(1,0);
+    return
+end
+brk=find(diff(msk)~=1);
+lo=msk([1,brk+1]);
+hi=msk([brk,numel(msk)]);
@@ -0,0 +1,24 @@
+function msk=ranges_to_array(lo,hi)
+% Expand ranges of spectra into the list of all spectra in the ranges
+%
+%   >> msk=ranges_to_array(lo,hi)
+%
+% Input:
+% ------
+%   lo      Row vectors with the first and last spectrum of each range.
+%   hi     Ranges must have lo(i)<=hi(i)
+%
+% Output:
+% -------
+%   msk     Row vector [lo(1):hi(1),lo(2):hi(2),...]
+
+n=hi-lo+1;
+msk=ones(1,sum(n));
+if isempty(msk)
+    return
+end
+nbeg=cumsum(n)-n+1;
+% increment from the last spectrum of the previous range to the first one of the next
+msk(nbeg)=lo-[0,hi(1:end-1)];
+msk(1)=lo(1);
+msk=cumsum(msk);
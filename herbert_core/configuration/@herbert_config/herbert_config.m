@@ -30,6 +30,10 @@ classdef herbert_config<config_base
     %                                   :
     %                       The larger the value, the more information is printed
     %   init_tests          Enable the unit test functions
+    %   use_ascii_cache     Keep binary copies of the par, phx and spe files
+    %                       read by the mex loader next to them (as
+    %                       <file>.hcache) and read these copies, while
+    %                       they are valid, instead of parsing the files
     %
     % Type >> herbert_config  to see the list of current configuration option values.
     
@@ -49,6 +53,9 @@ classdef herbert_config<config_base
         log_level
         % add unit test folders to search path (option for Herbert testing)
         init_tests;
+        % keep the ASCII par, phx and spe files read by get_ascii_file
+        % in binary caches, used while the files do not change
+        use_ascii_cache;
     end
     properties(Dependent,SetAccess=private)
         % location of the folder with unit tests
@@ -58,7 +65,7 @@ classdef herbert_config<config_base
     %
     properties(Constant,Access=private)
         saved_properties_list_={'use_mex','force_mex_if_use_mex',...
-            'log_level','init_tests'};
+            'log_level','init_tests','use_ascii_cache'};
     end
     properties(Access=private)
         % these values provide defaults for the properties above
@@ -66,6 +73,7 @@ classdef herbert_config<config_base
         force_mex_if_use_mex_ = false;
         log_level_            = 1;
         init_tests_           = false;
+        use_ascii_cache_      = false;
     end
     methods
         function this = herbert_config()
@@ -86,6 +94,9 @@ classdef herbert_config<config_base
         function doinit=get.init_tests(this)
             doinit = get_or_restore_field(this,'init_tests');
         end
+        function use = get.use_ascii_cache(this)
+            use = get_or_restore_field(this,'use_ascii_cache');
+        end
         
         %-----------------------------------------------------------------
         % overloaded setters
@@ -105,6 +116,14 @@ classdef herbert_config<config_base
             end
             config_store.instance().store_config(this,'force_mex_if_use_mex',use);
         end
+        function this = set.use_ascii_cache(this,val)
+            if val>0
+                use = true;
+            else
+                use = false;
+            end
+            config_store.instance().store_config(this,'use_ascii_cache',use);
+        end
         function this = set.log_level(this,val)
             if ~isnumeric(val)
                 error('HERBERT_CONFIG:set_log_level',' log level should be a number')
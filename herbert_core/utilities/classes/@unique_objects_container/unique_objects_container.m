@@ -113,6 +113,12 @@ classdef unique_objects_container < serializable
             % Output:
             % - hash : the resulting has, a row vector of uint8's
             %
+            % serial_hash returns the hash itself, computed by
+            % c_serialise without building the byte stream
+            if strcmp(func2str(self.convert_to_stream_),'serial_hash')
+                hash = serial_hash(obj);
+                return;
+            end
             Engine = java.security.MessageDigest.getInstance('MD5');
             %convert_to_stream_ = @getByteStreamFromArray;
             Engine.update(self.convert_to_stream_(obj));
@@ -156,7 +162,10 @@ classdef unique_objects_container < serializable
             % - parameter: 'basecase' - charstring name of basecase of
             %                           contained objects
             % - parameter: 'convert_to_stream' - function doing the stream
-            %                                    conversion for hashify
+            %                                    conversion for hashify.
+            %                                    @serial_hash hashes the
+            %                                    object directly (needs
+            %                                    the c_serialise mex)
 
             p = inputParser;
             addParameter(p,'type','',@ischar);
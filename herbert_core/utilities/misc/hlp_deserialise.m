@@ -125,10 +125,15 @@ end
 % Sparse data types
 function [v, pos] = deserialise_sparse(m, pos)
 % second value, nDims should be always 2
-[type, ~,sze,pos] = hlp_serial_types.unpack_data_tag(m,pos);
+[type, ~,sze,pos,is_large,is_csc] = hlp_serial_types.unpack_data_tag(m,pos);
 
-
-[nElem, pos] = read_bytes(m, pos, 'uint32', 1);
+if is_large
+    idx_format = 'uint64';
+else
+    idx_format = 'uint32';
+end
+[nElem, pos] = read_bytes(m, pos, idx_format, 1);
+nElem = double(nElem);
 if isempty(sze)
     v = sparse([],[],[]);
     return;
@@ -141,13 +146,20 @@ switch type.name
         data_format = type.name(8:end);
 end
 
-
-[i, pos] = read_bytes(m, pos, 'uint64', nElem);
-[j, pos] = read_bytes(m, pos, 'uint64', nElem);
-% beware that C API which indexes from 0, not 1. Better to do alignment in
-% API itself, as C would do it quicker
-i = double(i);
-j = double(j);
+if is_csc
+    % zero-based column pointers and row indices
+    [jc, pos] = read_bytes(m, pos, idx_format, sze(2)+1);
+    [i, pos] = read_bytes(m, pos, idx_format, nElem);
+    i = double(i)+1;
+    j = repelem(1:sze(2), diff(double(jc)));
+else
+    [i, pos] = read_bytes(m, pos, 'uint64', nElem);
+    [j, pos] = read_bytes(m, pos, 'uint64', nElem);
+    % beware that C API which indexes from 0, not 1. Better to do alignment in
+    % API itself, as C would do it quicker
+    i = double(i);
+    j = double(j);
+end
 [data, pos] = read_bytes(m, pos, data_format, nElem);
 
 switch type.name
@@ -181,7 +193,7 @@ end
 end
 
 function [v, pos] = deserialise_struct(m, pos)
-[~, nDims,fh_size,pos] = hlp_serial_types.unpack_data_tag(m,pos);
+[~, nDims,fh_size,pos,~,by_columns] = hlp_serial_types.unpack_data_tag(m,pos);
 
 nElems = prod(fh_size);
 if nDims == 0 && isempty(fh_size)
@@ -202,7 +214,7 @@ end
 [nFields, pos] = read_bytes(m, pos, 'uint32', 1);
 nFields = double(nFields);
 if nFields == 0
-    v = reshape(struct(), fh_size);
+    v = repmat(struct(), fh_size);
     return;
 end
 
@@ -217,11 +229,59 @@ splits = [0, cumsum(fnLengths)];
 fieldNames = arrayfun(@(start,size)(fnChars(start+1:start+size)),...
     splits(1:end-1),fnLengths,'UniformOutput',false);
 %
+if by_columns
+    % Struct array written by field
+    contents = cell(nFields,nElems);
+    for i=1:nFields
+        [contents(i,:),pos] = deserialise_struct_column(m,pos,nElems);
+    end
+    v = reshape(cell2struct(contents,fieldNames,1),fh_size);
+    return;
+end
 % using struct2cell
 [contents,pos] = deserialise_value(m,pos);
 v = cell2struct(contents,fieldNames,1);
 end
 
+function [vals, pos] = deserialise_struct_column(m, pos, nElems)
+% Values of one field over all elements of a struct array, as 1xnElems cell
+kind = m(pos);
+pos = pos + 1;
+switch kind
+    case hlp_serial_types.column_cell
+        vals = cell(1,nElems);
+        for i=1:nElems
+            [vals{i}, pos] = deserialise_value(m, pos);
+        end
+    case hlp_serial_types.column_dense
+        [type, ~,sze,pos] = hlp_serial_types.unpack_data_tag(m,pos);
+        nPer = prod(sze);
+        nData = nPer*nElems;
+        switch type.name
+            case {'logical', 'char'}
+                [data, pos] = read_bytes(m, pos, 'uint8', nData);
+                if strcmp(type.name,'logical')
+                    data = logical(data);
+                else
+                    data = char(data);
+                end
+            otherwise
+                [data, pos] = read_bytes(m, pos, type.name, nData);
+                if startsWith(type.name, 'complex')
+                    data = complex(data(1:nData), data(nData+1:end));
+                end
+        end
+        vals = num2cell(reshape(data,nPer,nElems),1);
+        vals = cellfun(@(x)(reshape(x,sze)),vals,'UniformOutput',false);
+    case hlp_serial_types.column_struct
+        [s, pos] = deserialise_struct(m, pos);
+        vals = reshape(num2cell(s),1,nElems);
+    otherwise
+        error('MATLAB:deserialise_struct:unrecognised_column',...
+            'Cannot deserialise struct column of kind %d.', kind);
+end
+end
+
 function [v, pos] = deserialise_function_handle(m, pos)
 [~, ~,fTag,pos] = hlp_serial_types.unpack_data_tag(m,pos);
 
@@ -52,20 +52,32 @@ end
 % Sparse data types
 function siz = serial_sise_sparse_data(v, type_str)
 nElem = nnz(v);
-siz = hlp_serial_types.calc_tag_size(size(v),type_str,1)+...
-    hlp_serial_types.dim_size + ... % add size for number of elements
-    2*8*nElem +... % i,j of 64-bit indexes
+if hlp_serial_types.needs_dim64(size(v),nElem)
+    idx_size = hlp_serial_types.dim64_size;
+else
+    idx_size = hlp_serial_types.dim_size;
+end
+siz = hlp_serial_types.calc_tag_size(size(v),type_str,nElem)+...
+    idx_size; % add size for number of elements
+if numel(v) == 0 % Null element, no indices
+    return;
+end
+siz = siz + ...
+    (size(v,2)+1+nElem)*idx_size +... % jc and ir of compressed sparse column form
     nElem*type_str.size; % data
-%typecast(uint32(nElem), 'uint8')'; ... % is 32 bytes enough for all elements?
-%typecast(uint64(i(:))', 'uint8')'; ...
-%typecast(uint64(j(:))', 'uint8')'; ...
-%typecast(data(:)', 'uint8')'];
 
 end
 
 % Struct array
 function siz = serial_sise_struct(v, type_str)
 % Tag, Field Count, Field name lengths, Field name char data, #dimensions, dimensions
+siz = hlp_serial_types.calc_tag_size(size(v),type_str);
+nElem = numel(v);
+if nElem == 0 % Null element
+    % Tag; 0
+    return
+end
+
 fieldNames = fieldnames(v);
 nFields = numel(fieldNames);
 
@@ -73,23 +85,35 @@ nFields = numel(fieldNames);
 fn_siz = hlp_serial_types.dim_size*(nFields+1) + ... Lengths of each field, +1 for nFields
     sum(cellfun('length', fieldNames)); % Each fieldname string
 
-if ~isempty(fieldNames)
+if isempty(fieldNames)
+    % Otherwise, no data
+    data_siz = 0;
+elseif nElem == 1
     % Convert to cell, and calculate its size
     data_siz = serial_sise_cell(struct2cell(v), hlp_serial_types.get_details('cell'));
 else
-    % Otherwise, no data
-    data_siz = 0;
+    % Written by field: column kind and column of each field
+    data_siz = nFields;
+    for i=1:nFields
+        data_siz = data_siz + serial_sise_struct_column({v.(fieldNames{i})});
+    end
+end
+% Tag; FieldName block size; data size
+siz = siz + fn_siz + data_siz;
 end
 
-nElem = numel(v);
-
-siz = hlp_serial_types.calc_tag_size(size(v),type_str);
-if nElem == 0 % Null element
-    % Tag; 0
-    return
-else
-    % Tag; FieldName block size; data size
-    siz = siz + fn_siz + data_siz;
+function siz = serial_sise_struct_column(vals)
+% Size of the values of one field of a struct array, without the column kind
+switch hlp_serial_types.column_kind(vals)
+    case hlp_serial_types.column_dense
+        first = vals{1};
+        type_str = hlp_serial_types.type_mapping(first);
+        siz = hlp_serial_types.calc_tag_size(size(first),type_str) + ...
+            numel(vals)*numel(first)*type_str.size;
+    case hlp_serial_types.column_struct
+        siz = serial_sise_struct([vals{:}], hlp_serial_types.get_details('struct'));
+    otherwise
+        siz = sum(cellfun(@hlp_serial_sise,vals));
 end
 end
 
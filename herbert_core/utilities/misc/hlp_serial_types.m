@@ -55,6 +55,34 @@ classdef hlp_serial_types
         tag_size = 2;  % Size of standard tag (uint8) in bytes
         ndims_size = 1;% Size of standard num dimensions (uint8) in bytes
         dim_size   = 4;  % Size of standard dimension (uint32) in bytes
+        % Arrays with dimensions, number of elements or number of
+        % non-zeros not fitting uint32 are written with this bit set in the
+        % num dimensions byte and with all these fields as uint64. The bit
+        % is never set for smaller arrays, so old streams still decode.
+        dim64_flag = 128;
+        dim64_size = 8;  % Size of extended dimension (uint64) in bytes
+        dim32_max  = double(intmax('uint32'));
+        % Sparse arrays are written in compressed sparse column form
+        % (zero-based column pointers and row indices of dimension width)
+        % if this bit is set in the num dimensions byte. Otherwise they
+        % hold uint64 row and column indices for every non-zero element.
+        sparse_csc_flag = 64;
+        % Struct arrays of more than one element with fields are written
+        % by field if this bit is set in the num dimensions byte: after the
+        % field names, each field is written as a column of its values over
+        % all elements, starting with one of the column kinds below.
+        % Scalar structs are written as the cell struct2cell returns.
+        struct_columns_flag = 64;
+        % Values one after another, as the elements of a cell
+        column_cell   = 0;
+        % Non-empty full arrays of one of dense_types with the same size
+        % and complexity: header of one value, then the data of all values
+        % (all real parts then all imaginary parts for complex values)
+        column_dense  = 1;
+        % Scalar structs with the same fields, written as 1xN struct array
+        column_struct = 2;
+        dense_types = {'logical', 'char', 'double', 'single', 'int8', 'uint8',...
+            'int16', 'uint16', 'int32', 'uint32', 'int64', 'uint64'};
     end
 
     methods(Static)
@@ -99,7 +127,33 @@ classdef hlp_serial_types
             end
         end
 
-        function [type_str, nDims,size_or_fhid,pos] = unpack_data_tag(head_bytes,pos)
+        function kind = column_kind(vals)
+            % Column kind used to write the values of one field of a
+            % struct array, provided as a cell array
+            first = vals{1};
+            if ismember(class(first),hlp_serial_types.dense_types) && ...
+                    ~issparse(first) && ~isempty(first)
+                sz = size(first);
+                is_real = isreal(first);
+                same = cellfun(@(x)(strcmp(class(x),class(first)) && ...
+                    ~issparse(x) && isreal(x) == is_real && isequal(size(x),sz)),vals);
+                if all(same)
+                    kind = hlp_serial_types.column_dense;
+                    return;
+                end
+            elseif isstruct(first) && isscalar(first) && ~isempty(fieldnames(first))
+                fn = fieldnames(first);
+                same = cellfun(@(x)(isstruct(x) && isscalar(x) && ...
+                    isequal(fieldnames(x),fn)),vals);
+                if all(same)
+                    kind = hlp_serial_types.column_struct;
+                    return;
+                end
+            end
+            kind = hlp_serial_types.column_cell;
+        end
+
+        function [type_str, nDims,size_or_fhid,pos,is_large,type_flag] = unpack_data_tag(head_bytes,pos)
             % unpack data tag, previously generated by pack_data_tag
             % function
             % Inputs:
@@ -117,7 +171,14 @@ classdef hlp_serial_types
             %               field contains the type of the function handle
             %               code if type of header is a function_handle
             % pos
+            % is_large   -- true if dimensions (and nnz of sparse arrays)
+            %               are written as uint64
+            % type_flag  -- true if sparse data are written in compressed
+            %               sparse column form or a struct array is
+            %               written by field
             tag = uint8(head_bytes(pos));
+            is_large = false;
+            type_flag = false;
 
             % ugly. But optimization is always ugly.
             if tag>63 || tag == 25 % function handle specific types.
@@ -133,15 +194,31 @@ classdef hlp_serial_types
             type_str = hlp_serial_types.type_details(tag + 1);
             nDims = double(head_bytes(pos+1));
             pos = pos + 2;
+            if tag >= 29 && tag <= 31 && bitand(nDims,hlp_serial_types.sparse_csc_flag)
+                type_flag = true;
+                nDims = nDims - hlp_serial_types.sparse_csc_flag;
+            elseif tag == 24 && bitand(nDims,hlp_serial_types.struct_columns_flag)
+                type_flag = true;
+                nDims = nDims - hlp_serial_types.struct_columns_flag;
+            end
+            if nDims >= hlp_serial_types.dim64_flag
+                is_large = true;
+                nDims = nDims - hlp_serial_types.dim64_flag;
+                dim_type = 'uint64';
+                dim_size = hlp_serial_types.dim64_size;
+            else
+                dim_type = 'uint32';
+                dim_size = hlp_serial_types.dim_size;
+            end
             if nDims == 0
                 size_or_fhid = [];
             elseif nDims == 1
-                nElem = double(typecast(head_bytes(pos:pos+3), 'uint32'));
+                nElem = double(typecast(head_bytes(pos:pos+dim_size-1), dim_type));
                 size_or_fhid = [1,nElem];
-                pos = pos+4;
+                pos = pos+dim_size;
             else
-                nBytes = nDims*4;
-                size_or_fhid   = double(typecast(head_bytes(pos:pos+nBytes-1), 'uint32')');
+                nBytes = nDims*dim_size;
+                size_or_fhid   = double(typecast(head_bytes(pos:pos+nBytes-1), dim_type)');
                 pos    = pos+nBytes;
             end
 
@@ -158,7 +235,8 @@ classdef hlp_serial_types
             % varargin   -- additional information on the type of the function
             %               handle to process or indicator to write full data.
             %               header, used for preparing full data header in
-            %               case of sparse data.
+            %               case of sparse data. For sparse data it is
+            %               the number of non-zero elements.
             %               Ignored in all other cases.
             %
             % Returns:
@@ -196,19 +274,42 @@ classdef hlp_serial_types
             end
 
             % all other cases
+            if hlp_serial_types.needs_dim64(data_size,varargin{:})
+                dim_flag = hlp_serial_types.dim64_flag;
+                to_dim = @uint64;
+            else
+                dim_flag = 0;
+                to_dim = @uint32;
+            end
             if nElem == 0
                 comb_tag = [tag;hlp_serial_types.dims_tag(0)];
             elseif nElem == 1  && nargin == 2 % avoid writing 2 dimensions for scalars
-                comb_tag = [tag;hlp_serial_types.dims_tag(1);...
-                    typecast(uint32(1),'uint8')'];
+                comb_tag = [tag;hlp_serial_types.dims_tag(1+dim_flag);...
+                    typecast(to_dim(1),'uint8')'];
             elseif nDims == 2 && data_size(1) == 1 && nargin == 2
                 % some saving in writing rows if 2D array arranged in rows.
                 % If this incorrect, use general case.
-                comb_tag = [tag;hlp_serial_types.dims_tag(1);...
-                    typecast(uint32(nElem),'uint8')'];
+                comb_tag = [tag;hlp_serial_types.dims_tag(1+dim_flag);...
+                    typecast(to_dim(nElem),'uint8')'];
             else
-                comb_tag = [tag;hlp_serial_types.dims_tag(nDims);...
-                    typecast(uint32(data_size),'uint8')'];
+                comb_tag = [tag;hlp_serial_types.dims_tag(nDims+dim_flag);...
+                    typecast(to_dim(data_size),'uint8')'];
+            end
+        end
+
+        function is = needs_dim64(data_size,nnz)
+            % check if the dimensions of an array have to be written as
+            % uint64 rather than uint32.
+            % Inputs:
+            % data_size -- size of the array
+            % nnz       -- if present, the array is sparse and this is
+            %              its number of non-zero elements. Sparse arrays
+            %              are written with full dimensions and nnz.
+            if nargin > 1
+                is = any(data_size > hlp_serial_types.dim32_max) || ...
+                    nnz > hlp_serial_types.dim32_max;
+            else
+                is = prod(data_size) > hlp_serial_types.dim32_max;
             end
         end
 
@@ -225,7 +326,11 @@ classdef hlp_serial_types
                 nElem = 0;
             else
                 nElem = prod(data_size);
-                dim_size = hlp_serial_types.dim_size;
+                if hlp_serial_types.needs_dim64(data_size,varargin{:})
+                    dim_size = hlp_serial_types.dim64_size;
+                else
+                    dim_size = hlp_serial_types.dim_size;
+                end
             end
 
             if nElem == 0
@@ -44,9 +44,9 @@ function m = hlp_serialise(v)
 %    adapted from serialize.m
 %    (C) 2010 Tim Hutt
 
-if any(size(v) > intmax('uint32'))
+if ndims(v) >= hlp_serial_types.dim64_flag
     error("MATLAB:serialise:bad_size",...
-        "Dimensions of array exceed limit of uint32, cannot serialise.")
+        "Number of array dimensions exceeds limit of 127, cannot serialise.")
 end
 
 type = hlp_serial_types.type_mapping(v);
@@ -121,7 +121,13 @@ function m = serialise_sparse_data(v, type)
 %elements but will deserialize the matrix without these elements
 nElem = nnz(v);
 %
-comb_tag = hlp_serial_types.pack_data_tag(size(v),type,1);
+comb_tag = hlp_serial_types.pack_data_tag(size(v),type,nElem);
+if hlp_serial_types.needs_dim64(size(v),nElem)
+    to_idx = @uint64;
+else
+    to_idx = @uint32;
+end
+nElem_bytes = typecast(to_idx(nElem), 'uint8')';
 
 switch type.name
     case 'sparse_logical'
@@ -130,10 +136,20 @@ switch type.name
         data = [real(data(:)); imag(data(:))];
 end
 
+if numel(v) == 0 % Null element, no indices
+    m = [comb_tag; nElem_bytes];
+    return;
+end
+% Compressed sparse column form, as MATLAB and the mex code hold it:
+% zero-based column pointers and row indices
+comb_tag(2) = comb_tag(2) + hlp_serial_types.sparse_csc_flag;
+jc = [0; cumsum(accumarray(j(:), 1, [size(v,2), 1]))];
+ir = i(:) - 1;
+
 m = [comb_tag; ...
-    typecast(uint32(nElem), 'uint8')'; ... % is 32 bytes enough for all elements?
-    typecast(uint64(i(:))', 'uint8')'; ...
-    typecast(uint64(j(:))', 'uint8')'; ...
+    nElem_bytes; ...
+    typecast(to_idx(jc)', 'uint8')'; ...
+    typecast(to_idx(ir)', 'uint8')'; ...
     typecast(data(:)', 'uint8')'];
 end
 
@@ -141,28 +157,62 @@ end
 function m = serialise_struct(v, type)
 
 nElem = numel(v);
-if nElem>0
-    fieldNames = fieldnames(v);
-    %fnInfo = serialize_cell(fieldNames',hlp_serial_types.get_details('cell'));
-    fnLengths = [length(fieldNames); cellfun('length',fieldNames)];
-    fnChars = [fieldNames{:}];
-
-    %Content.
-    fnInfo = [typecast(uint32(fnLengths)','uint8')'; uint8(fnChars')];
-else
-    fieldNames ={};
+comb_tag = hlp_serial_types.pack_data_tag(size(v),type);
+if nElem == 0 % Null element
+    m = comb_tag;
+    return;
 end
+fieldNames = fieldnames(v);
+%fnInfo = serialize_cell(fieldNames',hlp_serial_types.get_details('cell'));
+fnLengths = [length(fieldNames); cellfun('length',fieldNames)];
+fnChars = [fieldNames{:}];
+
+%Content.
+fnInfo = [typecast(uint32(fnLengths)','uint8')'; uint8(fnChars')];
+
 if isempty(fieldNames)
-    data = [];
-else
+    m = [comb_tag; fnInfo];
+elseif nElem == 1
     data = serialise_cell(struct2cell(v), hlp_serial_types.get_details('cell'));
+    m = [comb_tag; fnInfo; data];
+else
+    % Written by field, see hlp_serial_types.struct_columns_flag
+    if ndims(v) >= hlp_serial_types.struct_columns_flag
+        error("MATLAB:serialise:bad_size",...
+            "Struct arrays of more than 63 dimensions cannot be serialised.")
+    end
+    comb_tag(2) = comb_tag(2) + hlp_serial_types.struct_columns_flag;
+    data = cell(numel(fieldNames),1);
+    for i=1:numel(fieldNames)
+        data{i} = serialise_struct_column({v.(fieldNames{i})});
+    end
+    m = [comb_tag; fnInfo; vertcat(data{:})];
+end
 end
 
-comb_tag = hlp_serial_types.pack_data_tag(size(v),type);
-if nElem == 0 % Null element
-    m = comb_tag;
-else
-    m = [comb_tag; fnInfo; data];
+function m = serialise_struct_column(vals)
+% Values of one field over all elements of a struct array
+kind = hlp_serial_types.column_kind(vals);
+switch kind
+    case hlp_serial_types.column_dense
+        first = vals{1};
+        comb_tag = hlp_serial_types.pack_data_tag(size(first),...
+            hlp_serial_types.type_mapping(first));
+        vals = cellfun(@(x)(x(:)),vals,'UniformOutput',false);
+        vals = vertcat(vals{:});
+        if islogical(vals) || ischar(vals)
+            data = uint8(vals);
+        elseif isreal(vals)
+            data = typecast(vals, 'uint8');
+        else
+            data = [typecast(real(vals), 'uint8'); typecast(imag(vals), 'uint8')];
+        end
+        m = [uint8(kind); comb_tag; data];
+    case hlp_serial_types.column_struct
+        m = [uint8(kind); serialise_struct([vals{:}], hlp_serial_types.get_details('struct'))];
+    otherwise
+        data = cellfun(@hlp_serialise,vals,'UniformOutput',false);
+        m = [uint8(kind); vertcat(data{:})];
 end
 end
 
@@ -0,0 +1,25 @@
+function hash = serial_hash(a)
+% Hash of an object for identifying equal objects, as a 1x16 uint8 row
+%
+% The hash is the 128-bit MurmurHash3 of the serialised object, computed
+% by c_serialise while it walks the object without building the byte
+% stream. Serializable objects are hashed by walking the structure their
+% to_struct method returns.
+%
+% There is no Matlab implementation of the hash, so the function throws
+% if mex is disabled or c_serialise fails, rather than returning a hash
+% of a different kind, which would not match the hashes made by mex.
+%
+% Can be used as the 'convert_to_stream' function of
+% unique_objects_container.
+use_mex = config_store.instance().get_value('herbert_config','use_mex');
+if ~use_mex
+    error('HERBERT:serial_hash:runtime_error',...
+        'serial_hash needs the c_serialise mex but use_mex is disabled');
+end
+try
+    hash = c_serialise(a,'-hash');
+catch ME
+    error('HERBERT:serial_hash:runtime_error',...
+        'Can not hash the object using c_serialise. Reason: %s',ME.message);
+end